@@ -0,0 +1,44 @@
+#version 120
+
+// Draws the lines of rviz::Grid on a single quad.
+//
+// Lines run every cell_length, starting at -extent, and are line_width wide
+// in world units but never thinner than one pixel.  Edges are anti-aliased
+// over one pixel.  Once cells get only a few pixels wide, the lines blend
+// into their average coverage instead of breaking up into moire.
+
+uniform vec4 color;
+uniform float cell_length;
+uniform float extent;
+uniform float line_width;
+
+varying vec2 grid_pos;
+
+void main()
+{
+  vec2 coord = ( grid_pos + extent ) / cell_length;
+  vec2 pixel = fwidth( coord );
+  vec2 half_width = max( vec2( 0.5 * line_width / cell_length ), 0.5 * pixel );
+
+  // Nothing is drawn past the outermost lines.
+  vec2 limit = vec2( 2.0 * extent / cell_length ) + half_width;
+  if( any( lessThan( coord, -half_width )) || any( greaterThan( coord, limit )))
+  {
+    discard;
+  }
+
+  vec2 dist = abs( fract( coord + 0.5 ) - 0.5 );
+  vec2 line = 1.0 - smoothstep( half_width - 0.5 * pixel, half_width + 0.5 * pixel, dist );
+  float alpha = max( line.x, line.y );
+
+  vec2 coverage = min( 2.0 * half_width, vec2( 1.0 ));
+  float average = 1.0 - ( 1.0 - coverage.x ) * ( 1.0 - coverage.y );
+  float fade = clamp( ( 1.0 / max( pixel.x, pixel.y ) - 2.0 ) / 4.0, 0.0, 1.0 );
+  alpha = mix( average, alpha, fade );
+
+  if( alpha <= 0.0 )
+  {
+    discard;
+  }
+  gl_FragColor = vec4( color.rgb, color.a * alpha );
+}
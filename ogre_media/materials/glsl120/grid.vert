@@ -0,0 +1,11 @@
+#version 120
+
+// Passes the position on the grid plane (object space XZ) to grid.frag.
+
+varying vec2 grid_pos;
+
+void main()
+{
+  gl_Position = ftransform();
+  grid_pos = gl_Vertex.xz;
+}
@@ -0,0 +1,78 @@
+#version 120
+
+// Converts raw image data uploaded by ROSImageTexture into RGB.
+//
+// mode 0: single channel, value * scale + offset, shown as gray.
+// mode 1: Bayer mosaic, demosaiced with bilinear interpolation.
+//         red_offset moves the red pixel of the 2x2 tile to (0,0).
+// mode 2: YUV422 (UYVY), uploaded as one RGBA texel per two pixels.
+
+uniform sampler2D raw_image;
+uniform int mode;
+uniform vec2 size;
+uniform vec2 red_offset;
+uniform float scale;
+uniform float offset;
+
+varying vec2 UV;
+
+float raw( vec2 pixel )
+{
+  vec2 p = clamp( pixel, vec2( 0.0 ), size - 1.0 );
+  return texture2D( raw_image, (p + 0.5) / size ).x * scale + offset;
+}
+
+vec3 demosaic( vec2 pixel )
+{
+  float c = raw( pixel );
+  float edges = 0.25 * ( raw( pixel + vec2( -1.0, 0.0 )) + raw( pixel + vec2( 1.0, 0.0 )) +
+                         raw( pixel + vec2( 0.0, -1.0 )) + raw( pixel + vec2( 0.0, 1.0 )));
+  float corners = 0.25 * ( raw( pixel + vec2( -1.0, -1.0 )) + raw( pixel + vec2( 1.0, -1.0 )) +
+                           raw( pixel + vec2( -1.0, 1.0 )) + raw( pixel + vec2( 1.0, 1.0 )));
+  float horiz = 0.5 * ( raw( pixel + vec2( -1.0, 0.0 )) + raw( pixel + vec2( 1.0, 0.0 )));
+  float vert = 0.5 * ( raw( pixel + vec2( 0.0, -1.0 )) + raw( pixel + vec2( 0.0, 1.0 )));
+
+  vec2 tile = mod( pixel + red_offset, 2.0 );
+  if( tile.x < 0.5 && tile.y < 0.5 )
+  {
+    return vec3( c, edges, corners ); // red
+  }
+  else if( tile.x > 0.5 && tile.y > 0.5 )
+  {
+    return vec3( corners, edges, c ); // blue
+  }
+  else if( tile.y < 0.5 )
+  {
+    return vec3( horiz, c, vert ); // green on a red row
+  }
+  return vec3( vert, c, horiz ); // green on a blue row
+}
+
+vec3 yuv422( vec2 pixel )
+{
+  vec2 texel = vec2( floor( pixel.x * 0.5 ) + 0.5, pixel.y + 0.5 );
+  vec4 uyvy = texture2D( raw_image, texel / vec2( ceil( size.x * 0.5 ), size.y ));
+  float y = mod( pixel.x, 2.0 ) < 0.5 ? uyvy.y : uyvy.w;
+  float u = uyvy.x - 0.5;
+  float v = uyvy.z - 0.5;
+  return clamp( vec3( y + 1.402 * v, y - 0.344 * u - 0.714 * v, y + 1.772 * u ), 0.0, 1.0 );
+}
+
+void main()
+{
+  vec2 pixel = floor( UV * size );
+  vec3 color;
+  if( mode == 1 )
+  {
+    color = clamp( demosaic( pixel ), 0.0, 1.0 );
+  }
+  else if( mode == 2 )
+  {
+    color = yuv422( pixel );
+  }
+  else
+  {
+    color = vec3( clamp( raw( pixel ), 0.0, 1.0 ));
+  }
+  gl_FragColor = vec4( color, 1.0 );
+}
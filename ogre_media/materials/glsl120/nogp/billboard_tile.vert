@@ -5,6 +5,12 @@
 // Texture coords are used to determine which corner
 // of the billboard we compute.
 
+// Named attributes rather than built-ins, so that PointCloud can also
+// feed vertex and colour per instance and uv0 per corner.
+attribute vec4 vertex;
+attribute vec4 colour;
+attribute vec4 uv0;
+
 uniform mat4 worldviewproj_matrix;
 uniform vec4 size;
 uniform vec4 normal;
@@ -19,15 +25,15 @@ void main()
 {
   vec3 right = cross(up.xyz, normal.xyz);
   
-  vec4 s = gl_MultiTexCoord0 * size;
+  vec4 s = uv0 * size;
   vec3 r = s.xxx * right;
   vec3 u = s.yyy * up.xyz;
   
-  vec4 pos = gl_Vertex + vec4( r + u, 0.0 );
+  vec4 pos = vertex + vec4( r + u, 0.0 );
   
   gl_Position = worldviewproj_matrix * pos;
-  gl_TexCoord[0] = gl_MultiTexCoord0 + vec4(0.5,0.5,0.0,0.0);
-  gl_FrontColor = gl_Color;
+  gl_TexCoord[0] = uv0 + vec4(0.5,0.5,0.0,0.0);
+  gl_FrontColor = colour;
 
 #ifdef WITH_DEPTH
   passDepth( pos );
@@ -3,6 +3,12 @@
 // Computes the position of a box vertex from its texture coords.
 // Used in case that geometry shaders are not supported.
 
+// Named attributes rather than built-ins, so that PointCloud can also
+// feed vertex and colour per instance and uv0 per corner.
+attribute vec4 vertex;
+attribute vec4 colour;
+attribute vec4 uv0;
+
 uniform mat4 worldviewproj_matrix;
 uniform vec4 camera_pos;
 uniform vec4 size;
@@ -15,15 +21,15 @@ uniform vec4 auto_size;
 
 void main()
 {
-  // if auto_size == 1, then size_factor == size*gl_Vertex.z
+  // if auto_size == 1, then size_factor == size*vertex.z
   // if auto_size == 0, then size_factor == size
-  vec4 size_factor = (1-auto_size.x+(auto_size.x*gl_Vertex.z))*size;
+  vec4 size_factor = (1-auto_size.x+(auto_size.x*vertex.z))*size;
 
-  vec4 s = gl_MultiTexCoord0 * size_factor;
-  vec4 pos = gl_Vertex - s;
+  vec4 s = uv0 * size_factor;
+  vec4 pos = vertex - s;
   gl_Position = worldviewproj_matrix * pos;
-  gl_TexCoord[0] = gl_MultiTexCoord0;
-  gl_FrontColor = gl_Color;
+  gl_TexCoord[0] = uv0;
+  gl_FrontColor = colour;
 
 #ifdef WITH_DEPTH
   passDepth( pos );
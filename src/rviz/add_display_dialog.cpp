@@ -29,6 +29,7 @@
 
 #include <map>
 
+#include <boost/bind.hpp>
 #include <boost/filesystem.hpp>
 
 #include <ros/package.h>
@@ -48,6 +49,7 @@
 
 #include "add_display_dialog.h"
 #include "rviz/load_resource.h"
+#include "rviz/topic_cache.h"
 
 #include "display_factory.h"
 
@@ -117,8 +119,7 @@ void getPluginGroups( const QMap<QString, QString> &datatype_plugins,
                       QList<PluginGroup> *groups,
                       QList<ros::master::TopicInfo> *unvisualizable )
 {
-  ros::master::V_TopicInfo all_topics;
-  ros::master::getTopics( all_topics );
+  ros::master::V_TopicInfo all_topics = TopicCache::instance()->getTopics();
   std::sort( all_topics.begin(), all_topics.end(), LexicalTopicInfo() );
   ros::master::V_TopicInfo::iterator topic_it;
 
@@ -429,6 +430,7 @@ void DisplayTypeTree::fillTree( Factory *factory )
 }
 
 TopicDisplayWidget::TopicDisplayWidget()
+  : factory_( NULL )
 {
   tree_ = new QTreeWidget;
   tree_->setHeaderHidden( true );
@@ -463,11 +465,16 @@ TopicDisplayWidget::TopicDisplayWidget()
   setLayout( layout );
 }
 
+TopicDisplayWidget::~TopicDisplayWidget()
+{
+  TopicCache::instance()->removeListener( this );
+}
+
 void TopicDisplayWidget::onCurrentItemChanged( QTreeWidgetItem* curr )
 {
   // If plugin is selected, populate selection data.  Otherwise, clear data.
   SelectionData sd;
-  if ( curr->data( 1, Qt::UserRole ).isValid() )
+  if ( curr && curr->data( 1, Qt::UserRole ).isValid() )
   {
     QTreeWidgetItem *parent = curr->parent();
     sd.whats_this = curr->whatsThis( 0 );
@@ -512,7 +519,36 @@ void TopicDisplayWidget::stateChanged( int state )
 
 void TopicDisplayWidget::fill( DisplayFactory *factory )
 {
+  factory_ = factory;
   findPlugins( factory );
+  fillTree();
+
+  // Listeners run on the cache's thread, so rebuild on the GUI thread.
+  TopicCache* cache = TopicCache::instance();
+  cache->addListener( this, boost::bind( &TopicDisplayWidget::queueFillTree, this ));
+  cache->requestRefresh();
+}
+
+void TopicDisplayWidget::queueFillTree()
+{
+  QMetaObject::invokeMethod( this, "fillTree", Qt::QueuedConnection );
+}
+
+void TopicDisplayWidget::fillTree()
+{
+  DisplayFactory* factory = factory_;
+
+  // Remember the selection, to select the same plugin and topic again.
+  QString selected_topic;
+  QString selected_plugin;
+  QTreeWidgetItem* selected = tree_->currentItem();
+  if ( selected && selected->parent() && selected->data( 1, Qt::UserRole ).isValid() )
+  {
+    selected_topic = selected->parent()->data( 0, Qt::UserRole ).toString();
+    selected_plugin = selected->data( 0, Qt::UserRole ).toString();
+  }
+  QTreeWidgetItem* reselect = NULL;
+  tree_->clear();
 
   QList<PluginGroup> groups;
   QList<ros::master::TopicInfo> unvisualizable;
@@ -539,6 +575,10 @@ void TopicDisplayWidget::fill( DisplayFactory *factory )
       row->setWhatsThis( 0, factory->getClassDescription( plugin_name ) );
       row->setData( 0, Qt::UserRole, plugin_name );
       row->setData( 1, Qt::UserRole, info.datatypes[0] );
+      if ( pg.base_topic == selected_topic && plugin_name == selected_plugin )
+      {
+        reselect = row;
+      }
 
       if ( info.topic_suffixes.size() > 1 )
       {
@@ -564,6 +604,11 @@ void TopicDisplayWidget::fill( DisplayFactory *factory )
 
   // Hide unvisualizable topics if necessary
   stateChanged( enable_hidden_box_->isChecked() );
+
+  if ( reselect )
+  {
+    tree_->setCurrentItem( reselect );
+  }
 }
 
 void TopicDisplayWidget::findPlugins( DisplayFactory *factory )
@@ -170,6 +170,10 @@ class TopicDisplayWidget : public QWidget {
 Q_OBJECT
 public:
   TopicDisplayWidget();
+  virtual ~TopicDisplayWidget();
+
+  /** Fill the tree with the topics which are currently published, and
+   * keep it up to date as topics come and go. */
   void fill(DisplayFactory *factory);
 
 Q_SIGNALS:
@@ -181,9 +185,15 @@ private Q_SLOTS:
   void onCurrentItemChanged( QTreeWidgetItem *curr );
   void onComboBoxClicked( QTreeWidgetItem *curr );
 
+  /** Rebuild the tree from the TopicCache, keeping the selection. */
+  void fillTree();
+
 private:
   void findPlugins( DisplayFactory* );
 
+  /** Call fillTree() on the GUI thread; called by the TopicCache. */
+  void queueFillTree();
+
   /** Insert a topic into the tree
    *
    * @param topic Topic to be inserted
@@ -193,6 +203,7 @@ private:
 
   QTreeWidget *tree_;
   QCheckBox *enable_hidden_box_;
+  DisplayFactory *factory_;
 
   // Map from ROS topic type to all displays that can visualize it.
   // One key may have multiple values.
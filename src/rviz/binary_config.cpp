@@ -0,0 +1,541 @@
+/*
+ * Copyright (c) 2012, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+
+#include <deque>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include <QFile>
+#include <QHash>
+#include <QVector>
+
+#include "rviz/binary_config.h"
+
+// File format, all numbers are 32 bit in host byte order:
+//
+//   Header     magic, version, byte order mark, counts and sizes
+//   Strings    num_strings x { offset, size } into the string data
+//   Nodes      num_nodes x { kind, key, a, b }
+//   Data       UTF-8 string data
+//
+// Keys and string values are interned in the string table.  Node 0 is
+// the root.  The children of a map or list are the b consecutive
+// nodes starting at index a, always after their parent.  Map children
+// have the string index of their key in key.  Value nodes keep their
+// value in a and b, depending on the kind.
+
+namespace rviz
+{
+
+static const char MAGIC[ 8 ] = { 'R', 'V', 'I', 'Z', 'C', 'F', 'G', '\n' };
+static const quint32 VERSION = 1;
+static const quint32 BYTE_ORDER_MARK = 0x01020304;
+static const quint32 NO_KEY = 0xffffffff;
+
+enum NodeKind
+{
+  EMPTY_NODE,
+  MAP_NODE,
+  LIST_NODE,
+  STRING_NODE,
+  BOOL_NODE,
+  INT_NODE,
+  FLOAT_NODE,
+  DOUBLE_NODE
+};
+
+struct FileHeader
+{
+  char magic[ 8 ];
+  quint32 version;
+  quint32 byte_order;
+  quint32 num_strings;
+  quint32 num_nodes;
+  quint32 string_data_size;
+  quint32 reserved;
+};
+
+struct StringEntry
+{
+  quint32 offset;
+  quint32 size;
+};
+
+struct FileNode
+{
+  quint32 kind;
+  quint32 key;
+  quint32 a;
+  quint32 b;
+};
+
+// Reader
+
+BinaryConfigReader::BinaryConfigReader()
+  : error_( false )
+{}
+
+bool BinaryConfigReader::isBinaryConfigFile( const QString& filename )
+{
+  QFile file( filename );
+  char magic[ sizeof( MAGIC ) ];
+  return file.open( QIODevice::ReadOnly ) &&
+    file.read( magic, sizeof( magic )) == (qint64) sizeof( magic ) &&
+    memcmp( magic, MAGIC, sizeof( MAGIC )) == 0;
+}
+
+void BinaryConfigReader::readFile( Config& config, const QString& filename )
+{
+  QFile file( filename );
+  if( !file.open( QIODevice::ReadOnly ))
+  {
+    error_ = true;
+    message_ = "Failed to open " + filename + " for reading.";
+    return;
+  }
+  qint64 size = file.size();
+  uchar* data = file.map( 0, size );
+  if( data )
+  {
+    read( config, data, size, filename );
+    file.unmap( data );
+  }
+  else
+  {
+    // Mapping is not supported everywhere.
+    QByteArray bytes = file.readAll();
+    read( config, reinterpret_cast<const uchar*>( bytes.constData() ), bytes.size(), filename );
+  }
+}
+
+void BinaryConfigReader::readData( Config& config, const QByteArray& data, const QString& filename )
+{
+  read( config, reinterpret_cast<const uchar*>( data.constData() ), data.size(), filename );
+}
+
+namespace
+{
+
+/** Builds the Config tree from the mapped file. */
+class NodeReader
+{
+public:
+  NodeReader( const FileNode* nodes, quint32 num_nodes,
+              const StringEntry* strings, quint32 num_strings,
+              const char* string_data )
+    : nodes_( nodes )
+    , num_nodes_( num_nodes )
+    , strings_( strings )
+    , string_data_( string_data )
+    , decoded_( num_strings )
+    , is_decoded_( num_strings, false )
+  {}
+
+  bool readNode( Config config, quint32 index )
+  {
+    const FileNode& node = nodes_[ index ];
+    switch( node.kind )
+    {
+    case EMPTY_NODE:
+      return true;
+    case MAP_NODE:
+    case LIST_NODE:
+    {
+      // Children always come after their parent, so there are no cycles.
+      if( node.a <= index || node.a > num_nodes_ || node.b > num_nodes_ - node.a )
+      {
+        return false;
+      }
+      config.setType( node.kind == MAP_NODE ? Config::Map : Config::List );
+      for( quint32 i = node.a; i < node.a + node.b; i++ )
+      {
+        Config child;
+        if( node.kind == MAP_NODE )
+        {
+          QString key;
+          if( !getString( nodes_[ i ].key, &key ))
+          {
+            return false;
+          }
+          child = config.mapMakeChild( key );
+        }
+        else
+        {
+          child = config.listAppendNew();
+        }
+        if( !readNode( child, i ))
+        {
+          return false;
+        }
+      }
+      return true;
+    }
+    case STRING_NODE:
+    {
+      QString value;
+      if( !getString( node.a, &value ))
+      {
+        return false;
+      }
+      config.setValue( value );
+      return true;
+    }
+    case BOOL_NODE:
+      config.setValue( node.a != 0 );
+      return true;
+    case INT_NODE:
+      config.setValue( (int) node.a );
+      return true;
+    case FLOAT_NODE:
+    {
+      float value;
+      memcpy( &value, &node.a, sizeof( value ));
+      config.setValue( value );
+      return true;
+    }
+    case DOUBLE_NODE:
+    {
+      quint64 bits = ( (quint64) node.b << 32 ) | node.a;
+      double value;
+      memcpy( &value, &bits, sizeof( value ));
+      config.setValue( value );
+      return true;
+    }
+    default:
+      return false;
+    }
+  }
+
+private:
+  /** Decode each string once; copies share the data. */
+  bool getString( quint32 index, QString* value )
+  {
+    if( index >= (quint32) decoded_.size() )
+    {
+      return false;
+    }
+    if( !is_decoded_[ index ] )
+    {
+      decoded_[ index ] = QString::fromUtf8( string_data_ + strings_[ index ].offset, strings_[ index ].size );
+      is_decoded_[ index ] = true;
+    }
+    *value = decoded_[ index ];
+    return true;
+  }
+
+  const FileNode* nodes_;
+  quint32 num_nodes_;
+  const StringEntry* strings_;
+  const char* string_data_;
+  QVector<QString> decoded_;
+  std::vector<bool> is_decoded_;
+};
+
+} // namespace
+
+void BinaryConfigReader::read( Config& config, const uchar* data, qint64 size, const QString& filename )
+{
+  error_ = true;
+  message_ = filename + " is not a valid binary config file.";
+
+  if( size < (qint64) sizeof( FileHeader ))
+  {
+    return;
+  }
+  FileHeader header;
+  memcpy( &header, data, sizeof( header ));
+  if( memcmp( header.magic, MAGIC, sizeof( MAGIC )) != 0 )
+  {
+    return;
+  }
+  if( header.version != VERSION || header.byte_order != BYTE_ORDER_MARK )
+  {
+    message_ = filename + " was written by an incompatible version or on a different machine type.";
+    return;
+  }
+
+  qint64 strings_offset = sizeof( FileHeader );
+  qint64 nodes_offset = strings_offset + (qint64) header.num_strings * sizeof( StringEntry );
+  qint64 data_offset = nodes_offset + (qint64) header.num_nodes * sizeof( FileNode );
+  if( header.num_nodes == 0 || data_offset + header.string_data_size > size )
+  {
+    return;
+  }
+
+  // All sections are 4 byte aligned in the file.  Mapped files start
+  // on a page; copy anything else, like QByteArray data, to be safe.
+  QByteArray aligned_copy;
+  if( reinterpret_cast<quintptr>( data ) % sizeof( quint32 ) != 0 )
+  {
+    aligned_copy = QByteArray( reinterpret_cast<const char*>( data ), size );
+    data = reinterpret_cast<const uchar*>( aligned_copy.constData() );
+  }
+
+  const StringEntry* strings = reinterpret_cast<const StringEntry*>( data + strings_offset );
+  for( quint32 i = 0; i < header.num_strings; i++ )
+  {
+    if( strings[ i ].offset > header.string_data_size ||
+        strings[ i ].size > header.string_data_size - strings[ i ].offset )
+    {
+      return;
+    }
+  }
+
+  const FileNode* nodes = reinterpret_cast<const FileNode*>( data + nodes_offset );
+  NodeReader reader( nodes, header.num_nodes, strings, header.num_strings,
+                     reinterpret_cast<const char*>( data + data_offset ));
+  if( !reader.readNode( config, 0 ))
+  {
+    return;
+  }
+
+  error_ = false;
+  message_ = "";
+}
+
+bool BinaryConfigReader::error()
+{
+  return error_;
+}
+
+QString BinaryConfigReader::errorMessage()
+{
+  return message_;
+}
+
+// Writer
+
+BinaryConfigWriter::BinaryConfigWriter()
+  : error_( false )
+{}
+
+namespace
+{
+
+/** Collects the string table and the nodes. */
+class NodeWriter
+{
+public:
+  QByteArray write( const Config& root )
+  {
+    // Breadth first, so the children of each node are consecutive.
+    std::deque<std::pair<Config, quint32> > queue;
+    nodes_.push_back( makeNode( root, NO_KEY ));
+    queue.push_back( std::make_pair( root, 0 ));
+    while( !queue.empty() )
+    {
+      Config config = queue.front().first;
+      quint32 index = queue.front().second;
+      queue.pop_front();
+
+      if( config.getType() == Config::Map )
+      {
+        nodes_[ index ].a = nodes_.size();
+        Config::MapIterator it = config.mapIterator();
+        while( it.isValid() )
+        {
+          queue.push_back( std::make_pair( it.currentChild(), (quint32) nodes_.size() ));
+          nodes_.push_back( makeNode( it.currentChild(), intern( it.currentKey() )));
+          it.advance();
+        }
+        nodes_[ index ].b = nodes_.size() - nodes_[ index ].a;
+      }
+      else if( config.getType() == Config::List )
+      {
+        nodes_[ index ].a = nodes_.size();
+        int length = config.listLength();
+        for( int i = 0; i < length; i++ )
+        {
+          queue.push_back( std::make_pair( config.listChildAt( i ), (quint32) nodes_.size() ));
+          nodes_.push_back( makeNode( config.listChildAt( i ), NO_KEY ));
+        }
+        nodes_[ index ].b = length;
+      }
+    }
+
+    FileHeader header;
+    memcpy( header.magic, MAGIC, sizeof( MAGIC ));
+    header.version = VERSION;
+    header.byte_order = BYTE_ORDER_MARK;
+    header.num_strings = strings_.size();
+    header.num_nodes = nodes_.size();
+    header.string_data_size = string_data_.size();
+    header.reserved = 0;
+
+    QByteArray data;
+    data.reserve( sizeof( header ) + strings_.size() * sizeof( StringEntry ) +
+                  nodes_.size() * sizeof( FileNode ) + string_data_.size() );
+    data.append( reinterpret_cast<const char*>( &header ), sizeof( header ));
+    if( !strings_.empty() )
+    {
+      data.append( reinterpret_cast<const char*>( &strings_[ 0 ] ), strings_.size() * sizeof( StringEntry ));
+    }
+    data.append( reinterpret_cast<const char*>( &nodes_[ 0 ] ), nodes_.size() * sizeof( FileNode ));
+    data.append( string_data_ );
+    return data;
+  }
+
+private:
+  FileNode makeNode( const Config& config, quint32 key )
+  {
+    FileNode node;
+    node.kind = EMPTY_NODE;
+    node.key = key;
+    node.a = 0;
+    node.b = 0;
+
+    switch( config.getType() )
+    {
+    case Config::Map:
+      node.kind = MAP_NODE;
+      break;
+    case Config::List:
+      node.kind = LIST_NODE;
+      break;
+    case Config::Value:
+    {
+      QVariant value = config.getValue();
+      switch( (int) value.type() )
+      {
+      case QMetaType::Bool:
+        node.kind = BOOL_NODE;
+        node.a = value.toBool();
+        break;
+      case QMetaType::Int:
+        node.kind = INT_NODE;
+        node.a = (quint32) value.toInt();
+        break;
+      case QMetaType::Float:
+      {
+        float f = value.toFloat();
+        node.kind = FLOAT_NODE;
+        memcpy( &node.a, &f, sizeof( f ));
+        break;
+      }
+      case QMetaType::Double:
+      {
+        double d = value.toDouble();
+        quint64 bits;
+        memcpy( &bits, &d, sizeof( bits ));
+        node.kind = DOUBLE_NODE;
+        node.a = (quint32) bits;
+        node.b = (quint32)( bits >> 32 );
+        break;
+      }
+      default:
+        // Everything else is written like YamlConfigWriter does.
+        node.kind = STRING_NODE;
+        node.a = intern( value.toString() );
+        break;
+      }
+      break;
+    }
+    default:
+      break;
+    }
+    return node;
+  }
+
+  quint32 intern( const QString& string )
+  {
+    QHash<QString, quint32>::const_iterator it = string_indices_.find( string );
+    if( it != string_indices_.end() )
+    {
+      return it.value();
+    }
+    QByteArray utf8 = string.toUtf8();
+    StringEntry entry;
+    entry.offset = string_data_.size();
+    entry.size = utf8.size();
+    string_data_.append( utf8 );
+
+    quint32 index = strings_.size();
+    strings_.push_back( entry );
+    string_indices_.insert( string, index );
+    return index;
+  }
+
+  std::vector<FileNode> nodes_;
+  std::vector<StringEntry> strings_;
+  QByteArray string_data_;
+  QHash<QString, quint32> string_indices_;
+};
+
+} // namespace
+
+QByteArray BinaryConfigWriter::writeData( const Config& config )
+{
+  error_ = false;
+  message_ = "";
+  NodeWriter writer;
+  return writer.write( config );
+}
+
+void BinaryConfigWriter::writeFile( const Config& config, const QString& filename )
+{
+  QByteArray data = writeData( config );
+
+  // Write a temporary file and rename it over the old one.
+  QString temp_filename = filename + ".tmp";
+  QFile file( temp_filename );
+  if( !file.open( QIODevice::WriteOnly | QIODevice::Truncate ) ||
+      file.write( data ) != data.size() || !file.flush() )
+  {
+    error_ = true;
+    message_ = "Failed to write " + temp_filename + ".";
+    file.close();
+    file.remove();
+    return;
+  }
+  file.close();
+
+  boost::system::error_code error;
+  boost::filesystem::rename( temp_filename.toStdString(), filename.toStdString(), error );
+  if( error )
+  {
+    error_ = true;
+    message_ = "Failed to replace " + filename + ": " + QString::fromStdString( error.message() );
+    QFile::remove( temp_filename );
+  }
+}
+
+bool BinaryConfigWriter::error()
+{
+  return error_;
+}
+
+QString BinaryConfigWriter::errorMessage()
+{
+  return message_;
+}
+
+} // end namespace rviz
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2012, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RVIZ_BINARY_CONFIG_H
+#define RVIZ_BINARY_CONFIG_H
+
+#include <QByteArray>
+#include <QString>
+
+#include "rviz/config.h"
+#include "rviz/rviz_export.h"
+
+namespace rviz
+{
+
+/** @brief Reads Config trees written by BinaryConfigWriter.
+ *
+ * The file is memory mapped and read in one pass, without a parser;
+ * much faster than YamlConfigReader for large configs.  The format is
+ * described in binary_config.cpp. */
+class RVIZ_EXPORT BinaryConfigReader
+{
+public:
+  /** @brief Constructor.  Object begins in a no-error state. */
+  BinaryConfigReader();
+
+  /** @brief Read config data from a file.  This potentially changes the return values of error() and errorMessage(). */
+  void readFile( Config& config, const QString& filename );
+
+  /** @brief Read config data from memory.  This potentially changes the return values of error() and errorMessage(). */
+  void readData( Config& config, const QByteArray& data, const QString& filename = "data" );
+
+  /** @brief Return true if the latest read call had an error. */
+  bool error();
+
+  /** @brief Return an error message if the latest read call had an
+   * error, or the empty string if not. */
+  QString errorMessage();
+
+  /** @brief Return true if @a filename starts like a binary config file. */
+  static bool isBinaryConfigFile( const QString& filename );
+
+private:
+  void read( Config& config, const uchar* data, qint64 size, const QString& filename );
+
+  QString message_;
+  bool error_;
+};
+
+/** @brief Writes Config trees in a compact binary format.
+ *
+ * Values are stored with their type, so reading gives back the same
+ * QVariants, and writing the result with YamlConfigWriter gives the
+ * same text as writing the original. */
+class RVIZ_EXPORT BinaryConfigWriter
+{
+public:
+  /** @brief Constructor.  Writer starts in a non-error state. */
+  BinaryConfigWriter();
+
+  /** @brief Write config data to a file.  The file is replaced
+   * atomically, so readers never see a partial file.  This
+   * potentially changes the return values of error() and
+   * errorMessage(). */
+  void writeFile( const Config& config, const QString& filename );
+
+  /** @brief Return config data in the binary format. */
+  QByteArray writeData( const Config& config );
+
+  /** @brief Return true if the latest write operation had an error. */
+  bool error();
+
+  /** @brief Return an error message if the latest write call had an
+   * error, or the empty string if there was no error. */
+  QString errorMessage();
+
+private:
+  QString message_;
+  bool error_;
+};
+
+} // end namespace rviz
+
+#endif // RVIZ_BINARY_CONFIG_H
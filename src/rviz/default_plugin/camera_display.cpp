@@ -97,6 +97,8 @@ CameraDisplay::CameraDisplay()
   , new_caminfo_( false )
   , caminfo_ok_(false)
   , force_render_( false )
+  , render_needed_( true )
+  , last_render_request_count_( 0 )
 {
   image_position_property_ = new EnumProperty( "Image Rendering", BOTH,
                                                "Render the image behind all other geometry or overlay it on top, or both.",
@@ -348,12 +350,29 @@ void CameraDisplay::clear()
 
 void CameraDisplay::update( float wall_dt, float ros_dt )
 {
+  // The projection depends on the window aspect ratio, so a resize (or
+  // the panel being shown again) needs a camera update as well.
+  QSize panel_size = render_panel_->isVisible() ? render_panel_->size() : QSize();
+  if( panel_size != last_panel_size_ )
+  {
+    last_panel_size_ = panel_size;
+    force_render_ = true;
+  }
+
+  bool new_caminfo;
+  {
+    boost::mutex::scoped_lock lock( caminfo_mutex_ );
+    new_caminfo = new_caminfo_;
+    new_caminfo_ = false;
+  }
+
   try
   {
-    if( texture_.update() || force_render_ )
+    if( texture_.update() || force_render_ || new_caminfo )
     {
       caminfo_ok_ = updateCamera();
       force_render_ = false;
+      render_needed_ = true;
     }
   }
   catch( UnsupportedImageEncoding& e )
@@ -361,7 +380,27 @@ void CameraDisplay::update( float wall_dt, float ros_dt )
     setStatus( StatusProperty::Error, "Image", e.what() );
   }
 
+  renderIfNeeded();
+}
+
+void CameraDisplay::renderIfNeeded()
+{
+  // Anything that changes the shared 3D scene or the main view queues a
+  // render, so a changed count means the overlay may be out of date.
+  uint64_t render_request_count = context_->getRenderRequestCount();
+  if( render_request_count != last_render_request_count_ )
+  {
+    last_render_request_count_ = render_request_count;
+    render_needed_ = true;
+  }
+
+  if( !render_needed_ || last_panel_size_.isEmpty() )
+  {
+    return;
+  }
+
   render_panel_->getRenderWindow()->update();
+  render_needed_ = false;
 }
 
 bool CameraDisplay::updateCamera()
@@ -552,6 +591,7 @@ void CameraDisplay::fixedFrameChanged()
   std::string targetFrame = fixed_frame_.toStdString();
   caminfo_tf_filter_->setTargetFrame(targetFrame);
   ImageDisplayBase::fixedFrameChanged();
+  force_render_ = true;
 }
 
 void CameraDisplay::reset()
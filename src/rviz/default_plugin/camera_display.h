@@ -33,6 +33,7 @@
 #include <memory>
 
 #include <QObject>
+#include <QSize>
 
 #ifndef Q_MOC_RUN
 #include <OgreMaterial.h>
@@ -115,6 +116,10 @@ private:
 
   bool updateCamera();
 
+  /** @brief Render the panel if the image, camera or scene changed
+   * since the last render; otherwise keep presenting the last frame. */
+  void renderIfNeeded();
+
   void clear();
   void updateStatus();
 
@@ -144,6 +149,15 @@ private:
 
   bool force_render_;
 
+  /** @brief True if the panel contents are stale and must be rendered. */
+  bool render_needed_;
+
+  /** @brief DisplayContext::getRenderRequestCount() at the last render. */
+  uint64_t last_render_request_count_;
+
+  /** @brief Panel size used for the current projection, empty while hidden. */
+  QSize last_panel_size_;
+
   uint32_t vis_bit_;
 };
 
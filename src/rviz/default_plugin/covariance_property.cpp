@@ -33,15 +33,34 @@
 #include "rviz/properties/color_property.h"
 #include "rviz/properties/float_property.h"
 #include "rviz/properties/enum_property.h"
+#include "rviz/ogre_helpers/glyph_ring.h"
+#include "rviz/validate_quaternions.h"
 
 #include <QColor>
 
 #include <OgreSceneManager.h>
 #include <OgreSceneNode.h>
 
+#include <ros/console.h>
+
 namespace rviz
 {
 
+namespace
+{
+
+Ogre::Vector3 toOgre( const CovarianceShapes::Vector3& v )
+{
+  return Ogre::Vector3( v.x(), v.y(), v.z() );
+}
+
+Ogre::Quaternion toOgre( const CovarianceShapes::Quaternion& q )
+{
+  return Ogre::Quaternion( q.w(), q.x(), q.y(), q.z() );
+}
+
+}
+
 CovarianceProperty::CovarianceProperty( const QString& name,
                             bool default_value,
                             const QString& description,
@@ -50,6 +69,10 @@ CovarianceProperty::CovarianceProperty( const QString& name,
                             QObject* receiver )
   // NOTE: changed_slot and receiver aren't passed to BoolProperty here, but initialized at the end of this constructor
   : BoolProperty( name, default_value, description, parent )
+  , instance_capacity_( 0 )
+  , position_ring_( NULL )
+  , orientation_ring_( NULL )
+  , orientation_2d_ring_( NULL )
 {
 
   position_property_ = new BoolProperty( "Position", true,
@@ -124,6 +147,9 @@ CovarianceProperty::CovarianceProperty( const QString& name,
 
 CovarianceProperty::~CovarianceProperty()
 {
+  delete position_ring_;
+  delete orientation_ring_;
+  delete orientation_2d_ring_;
 }
 
 void CovarianceProperty::updateColorStyleChoice()
@@ -139,6 +165,7 @@ void CovarianceProperty::updateColorAndAlphaAndScaleAndOffset()
   D_Covariance::iterator end_cov = covariances_.end();
   for ( ; it_cov != end_cov; ++it_cov )
     updateColorAndAlphaAndScaleAndOffset(*it_cov);
+  rebuildInstances();
 }
 
 void CovarianceProperty::updateColorAndAlphaAndScaleAndOffset(const CovarianceVisualPtr& visual)
@@ -171,6 +198,7 @@ void CovarianceProperty::updateVisibility()
   D_Covariance::iterator end_cov = covariances_.end();
   for ( ; it_cov != end_cov; ++it_cov )
     updateVisibility(*it_cov);
+  updateInstanceVisibility();
 }
 
 void CovarianceProperty::updateVisibility(const CovarianceVisualPtr& visual)
@@ -195,6 +223,7 @@ void CovarianceProperty::updateOrientationFrame()
   D_Covariance::iterator end_cov = covariances_.end();
   for ( ; it_cov != end_cov; ++it_cov )
     updateOrientationFrame(*it_cov);
+  rebuildInstances();
 }
 
 void CovarianceProperty::updateOrientationFrame(const CovarianceVisualPtr& visual)
@@ -229,6 +258,218 @@ CovarianceProperty::CovarianceVisualPtr CovarianceProperty::createAndPushBackVis
   return visual;
 }
 
+void CovarianceProperty::createInstances( Ogre::SceneManager* scene_manager, Ogre::SceneNode* parent_node )
+{
+  if( position_ring_ )
+  {
+    return;
+  }
+
+  position_ring_ = new GlyphRing( scene_manager, parent_node, instance_capacity_ );
+  position_ring_->setGlyph( GlyphRing::makeSphere() );
+  orientation_ring_ = new GlyphRing( scene_manager, parent_node, 3 * instance_capacity_ );
+  orientation_ring_->setGlyph( GlyphRing::makeCylinder() );
+  orientation_2d_ring_ = new GlyphRing( scene_manager, parent_node, instance_capacity_ );
+  orientation_2d_ring_->setGlyph( GlyphRing::makeCone() );
+
+  updateInstanceVisibility();
+}
+
+void CovarianceProperty::pushBackInstance( const Ogre::Vector3& position, const Ogre::Quaternion& orientation,
+                                           const geometry_msgs::PoseWithCovariance& pose )
+{
+  Instance instance;
+  instance.position = position;
+  instance.orientation = orientation;
+  normalizeQuaternion( pose.pose.orientation, instance.pose_orientation );
+  pending_.push_back( instance );
+  pending_covariances_.push_back( pose.covariance );
+}
+
+void CovarianceProperty::prepareInstances()
+{
+  if( pending_.empty() || pending_shapes_.size() == pending_.size() )
+  {
+    return;
+  }
+
+  pending_shapes_.resize( pending_.size() );
+  computeCovarianceShapes( &pending_covariances_[ 0 ], pending_covariances_.size(), &pending_shapes_[ 0 ] );
+}
+
+void CovarianceProperty::flushInstances( std::vector<bool>* valid )
+{
+  if( valid )
+  {
+    valid->clear();
+  }
+  if( pending_.empty() )
+  {
+    return;
+  }
+
+  prepareInstances();
+
+  for( size_t i = 0; i < pending_.size(); i++ )
+  {
+    if( valid )
+    {
+      valid->push_back( pending_shapes_[ i ].valid );
+    }
+    if( !pending_shapes_[ i ].valid )
+    {
+      ROS_WARN_THROTTLE(1, "covariance contains NaN");
+      continue;
+    }
+    pending_[ i ].shapes = pending_shapes_[ i ];
+    instances_.push_back( pending_[ i ] );
+    if( position_ring_ )
+    {
+      pushInstance( pending_[ i ] );
+    }
+  }
+  pending_.clear();
+  pending_covariances_.clear();
+  pending_shapes_.clear();
+
+  while( instance_capacity_ > 0 && instances_.size() > instance_capacity_ )
+  {
+    instances_.pop_front();
+  }
+}
+
+void CovarianceProperty::setInstanceCapacity( size_t capacity )
+{
+  if( capacity == instance_capacity_ )
+  {
+    return;
+  }
+  instance_capacity_ = capacity;
+
+  while( instance_capacity_ > 0 && instances_.size() > instance_capacity_ )
+  {
+    instances_.pop_front();
+  }
+  if( position_ring_ )
+  {
+    position_ring_->setCapacity( instance_capacity_ );
+    orientation_ring_->setCapacity( 3 * instance_capacity_ );
+    orientation_2d_ring_->setCapacity( instance_capacity_ );
+  }
+}
+
+void CovarianceProperty::clearInstances()
+{
+  instances_.clear();
+  pending_.clear();
+  pending_covariances_.clear();
+  pending_shapes_.clear();
+  if( position_ring_ )
+  {
+    position_ring_->clear();
+    orientation_ring_->clear();
+    orientation_2d_ring_->clear();
+  }
+}
+
+void CovarianceProperty::pushInstance( const Instance& instance )
+{
+  // These are the transforms of the scene node hierarchy of
+  // CovarianceVisual, folded into one transform per shape.
+  const CovarianceShapes& shapes = instance.shapes;
+  Ogre::Quaternion fixed_orientation = instance.orientation * instance.pose_orientation.Inverse();
+
+  float pos_scale = position_scale_property_->getFloat();
+  Ogre::Vector3 position_scale = toOgre( shapes.position_scale ) *
+    Ogre::Vector3( pos_scale, pos_scale, shapes.pose_2d ? 1.0f : pos_scale );
+  if( position_scale.isNaN() )
+  {
+    position_scale = Ogre::Vector3::ZERO;
+  }
+  Ogre::ColourValue position_color = position_color_property_->getOgreColor();
+  position_color.a = position_alpha_property_->getFloat();
+  position_ring_->push( instance.position, fixed_orientation * toOgre( shapes.position_orientation ),
+                        position_scale, position_color );
+
+  // 3D poses get a disc along each axis, 2D poses a cone for the yaw.
+  // The hidden kind is pushed with a zero scale so the rings age together.
+  bool use_rotating_frame = ( orientation_frame_property_->getOptionInt() == Local );
+  Ogre::Quaternion base = use_rotating_frame ? instance.orientation : fixed_orientation;
+  float offset = orientation_offset_property_->getFloat();
+  float ori_scale = orientation_scale_property_->getFloat();
+  bool use_rgb = ( orientation_colorstyle_property_->getOptionInt() == RGB );
+  float ori_alpha = orientation_alpha_property_->getFloat();
+  Ogre::ColourValue ori_color = orientation_color_property_->getOgreColor();
+  ori_color.a = ori_alpha;
+
+  const Ogre::Vector3 axes[] = { Ogre::Vector3::UNIT_X, Ogre::Vector3::UNIT_Y, Ogre::Vector3::UNIT_Z };
+  const Ogre::Quaternion disc_orientations[] = {
+    Ogre::Quaternion( Ogre::Degree( 90 ), Ogre::Vector3::UNIT_X ) * Ogre::Quaternion( Ogre::Degree( 90 ), Ogre::Vector3::UNIT_Z ),
+    Ogre::Quaternion( Ogre::Degree( 90 ), Ogre::Vector3::UNIT_Y ),
+    Ogre::Quaternion( Ogre::Degree( 90 ), Ogre::Vector3::UNIT_X )
+  };
+  const Ogre::ColourValue rgb_colors[] = {
+    Ogre::ColourValue( 1.0, 0.0, 0.0, ori_alpha ),
+    Ogre::ColourValue( 0.0, 1.0, 0.0, ori_alpha ),
+    Ogre::ColourValue( 0.0, 0.0, 1.0, ori_alpha )
+  };
+
+  for( int i = CovarianceShapes::kRoll; i <= CovarianceShapes::kYaw; i++ )
+  {
+    Ogre::Vector3 scale = toOgre( shapes.orientation_scale[ i ] );
+    scale.x = radianScaleToMetricScaleBounded( scale.x * ori_scale, CovarianceVisual::max_degrees ) * offset;
+    scale.z = radianScaleToMetricScaleBounded( scale.z * ori_scale, CovarianceVisual::max_degrees ) * offset;
+    if( shapes.pose_2d || scale.isNaN() )
+    {
+      scale = Ogre::Vector3::ZERO;
+    }
+    orientation_ring_->push( instance.position + base * ( offset * axes[ i ] ),
+                             base * disc_orientations[ i ] * toOgre( shapes.orientation_orientation[ i ] ),
+                             scale, use_rgb ? rgb_colors[ i ] : ori_color );
+  }
+
+  // The tip of the cone is at the pose origin.
+  Ogre::Vector3 scale = toOgre( shapes.orientation_scale[ CovarianceShapes::kYaw2D ] );
+  scale.x = radianScaleToMetricScaleBounded( scale.x * ori_scale, CovarianceVisual::max_degrees ) * offset;
+  scale.y *= offset;
+  if( !shapes.pose_2d || scale.isNaN() )
+  {
+    scale = Ogre::Vector3::ZERO;
+  }
+  orientation_2d_ring_->push( instance.position + base * ( 0.5f * offset * Ogre::Vector3::UNIT_X ),
+                              base * Ogre::Quaternion( Ogre::Degree( 90 ), Ogre::Vector3::UNIT_Z ),
+                              scale, use_rgb ? rgb_colors[ CovarianceShapes::kYaw ] : ori_color );
+}
+
+void CovarianceProperty::rebuildInstances()
+{
+  if( !position_ring_ )
+  {
+    return;
+  }
+
+  position_ring_->clear();
+  orientation_ring_->clear();
+  orientation_2d_ring_->clear();
+  for( size_t i = 0; i < instances_.size(); i++ )
+  {
+    pushInstance( instances_[ i ] );
+  }
+}
+
+void CovarianceProperty::updateInstanceVisibility()
+{
+  if( !position_ring_ )
+  {
+    return;
+  }
+
+  bool show_covariance = getBool();
+  position_ring_->setVisible( show_covariance && position_property_->getBool() );
+  orientation_ring_->setVisible( show_covariance && orientation_property_->getBool() );
+  orientation_2d_ring_->setVisible( show_covariance && orientation_property_->getBool() );
+}
+
 bool CovarianceProperty::getPositionBool()
 {
   return position_property_->getBool();
@@ -30,11 +30,19 @@
 #ifndef COVARIANCE_PROPERTY_H
 #define COVARIANCE_PROPERTY_H
 
+#include <deque>
+#include <vector>
+
 #include <QColor>
 
 #include <OgreColourValue.h>
+#include <OgreQuaternion.h>
+#include <OgreVector3.h>
+
+#include <geometry_msgs/PoseWithCovariance.h>
 
 #include "rviz/properties/bool_property.h"
+#include "covariance_shapes.h"
 
 namespace Ogre
 {
@@ -50,6 +58,7 @@ class ColorProperty;
 class FloatProperty;
 class EnumProperty;
 class CovarianceVisual;
+class GlyphRing;
 
 /** @brief Property specialized to provide getter for booleans. */
 class CovarianceProperty: public rviz::BoolProperty
@@ -88,6 +97,33 @@ public:
   void clearVisual();
   size_t sizeVisual();
 
+  /** @name Instanced history
+   *
+   * Displays keeping a history of covariances, like OdometryDisplay, use
+   * these instead of one CovarianceVisual per pose.  All ellipsoids,
+   * discs and cones are drawn from three GlyphRings, so a pose costs no
+   * Ogre objects.  Poses are queued by pushBackInstance(), their
+   * covariances decomposed together by prepareInstances() from the
+   * display's prepareUpdate(), and the shapes pushed to the rings by
+   * flushInstances() from its update(). */
+  /** @{ */
+  void createInstances( Ogre::SceneManager* scene_manager, Ogre::SceneNode* parent_node );
+  void pushBackInstance( const Ogre::Vector3& position, const Ogre::Quaternion& orientation,
+                         const geometry_msgs::PoseWithCovariance& pose );
+  /** @brief Decompose the queued covariances.  Touches neither Ogre nor
+   * Qt, so it may run on a worker thread. */
+  void prepareInstances();
+  /** @brief Push the queued poses to the rings, decomposing them first
+   * unless prepareInstances() already did.
+   * @param valid If not NULL, gets one entry per queued pose, in order;
+   * false for the ones whose covariance contained NaNs, which are dropped. */
+  void flushInstances( std::vector<bool>* valid = NULL );
+  /** @brief Keep at most @a capacity poses, dropping the oldest.  0 means keep all. */
+  void setInstanceCapacity( size_t capacity );
+  void clearInstances();
+  size_t sizeInstances() const { return instances_.size() + pending_.size(); }
+  /** @} */
+
 public Q_SLOTS:
   void updateVisibility();
 
@@ -101,9 +137,36 @@ private:
   void updateOrientationFrame( const CovarianceVisualPtr& visual );
   void updateVisibility( const CovarianceVisualPtr& visual );
 
+  struct Instance
+  {
+    Ogre::Vector3 position;
+    Ogre::Quaternion orientation;
+    /** Orientation of the pose in the message, undone by the fixed orientation frame. */
+    Ogre::Quaternion pose_orientation;
+    CovarianceShapes shapes;
+  };
+
+  /** @brief Push the shapes of @a instance to the rings. */
+  void pushInstance( const Instance& instance );
+  /** @brief Re-push all instances, after a property they depend on changed. */
+  void rebuildInstances();
+  void updateInstanceVisibility();
+
   typedef std::deque<CovarianceVisualPtr> D_Covariance;
   D_Covariance covariances_;
 
+  std::deque<Instance> instances_;
+  /** Instances waiting for flushInstances(); shapes not computed yet. */
+  std::vector<Instance> pending_;
+  std::vector<boost::array<double, 36> > pending_covariances_;
+  /** Shapes of pending_ once prepareInstances() ran, else empty. */
+  std::vector<CovarianceShapes> pending_shapes_;
+  size_t instance_capacity_;
+
+  GlyphRing* position_ring_;
+  GlyphRing* orientation_ring_;     ///< Three discs per 3D pose
+  GlyphRing* orientation_2d_ring_;  ///< One cone per 2D pose
+
   rviz::BoolProperty*  position_property_;
   rviz::ColorProperty* position_color_property_;
   rviz::FloatProperty* position_alpha_property_;
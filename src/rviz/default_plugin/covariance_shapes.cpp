@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) 2012, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "covariance_shapes.h"
+
+#include <cmath>
+
+#include <Eigen/Eigenvalues>
+
+namespace rviz
+{
+
+namespace
+{
+
+typedef Eigen::Matrix<double,6,6,Eigen::RowMajor> Matrix6d;
+
+double deg2rad (double degrees)
+{
+    return degrees * 4.0 * atan (1.0) / 180.0;
+}
+
+// Local function to force the axis to be right handed for 3D. Taken from ecl_statistics
+void makeRightHanded( Eigen::Matrix3d& eigenvectors, Eigen::Vector3d& eigenvalues)
+{
+  // Note that sorting of eigenvalues may end up with left-hand coordinate system.
+  // So here we correctly sort it so that it does end up being righ-handed and normalised.
+  Eigen::Vector3d c0 = eigenvectors.block<3,1>(0,0);  c0.normalize();
+  Eigen::Vector3d c1 = eigenvectors.block<3,1>(0,1);  c1.normalize();
+  Eigen::Vector3d c2 = eigenvectors.block<3,1>(0,2);  c2.normalize();
+  Eigen::Vector3d cc = c0.cross(c1);
+  if (cc.dot(c2) < 0) {
+    eigenvectors << c1, c0, c2;
+    double e = eigenvalues[0];  eigenvalues[0] = eigenvalues[1];  eigenvalues[1] = e;
+  } else {
+    eigenvectors << c0, c1, c2;
+  }
+}
+
+// Local function to force the axis to be right handed for 2D. Based on the one from ecl_statistics
+void makeRightHanded( Eigen::Matrix2d& eigenvectors, Eigen::Vector2d& eigenvalues)
+{
+  // Note that sorting of eigenvalues may end up with left-hand coordinate system.
+  // So here we correctly sort it so that it does end up being righ-handed and normalised.
+  Eigen::Vector3d c0;  c0.setZero();  c0.head<2>() = eigenvectors.col(0);  c0.normalize();
+  Eigen::Vector3d c1;  c1.setZero();  c1.head<2>() = eigenvectors.col(1);  c1.normalize();
+  Eigen::Vector3d cc = c0.cross(c1);
+  if (cc[2] < 0) {
+    eigenvectors << c1.head<2>(), c0.head<2>();
+    double e = eigenvalues[0];  eigenvalues[0] = eigenvalues[1];  eigenvalues[1] = e;
+  } else {
+    eigenvectors << c0.head<2>(), c1.head<2>();
+  }
+}
+
+void computeShapeScaleAndOrientation3D(const Eigen::Matrix3d& covariance, CovarianceShapes::Vector3& scale, CovarianceShapes::Quaternion& orientation)
+{
+  // NOTE: The SelfAdjointEigenSolver only references the lower triangular part of the covariance matrix.
+  // computeDirect() uses the closed-form solution for 3x3 matrices, which always succeeds.
+  Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> eigensolver;
+  eigensolver.computeDirect(covariance);
+  Eigen::Vector3d eigenvalues = eigensolver.eigenvalues();
+  Eigen::Matrix3d eigenvectors = eigensolver.eigenvectors();
+
+  // Be sure we have a right-handed orientation system
+  makeRightHanded(eigenvectors, eigenvalues);
+
+  // Define the rotation
+  orientation = CovarianceShapes::Quaternion(Eigen::Quaterniond(eigenvectors).cast<float>());
+
+  // Define the scale. eigenvalues are the variances, so we take the sqrt to draw the standard deviation
+  scale.x() = 2*std::sqrt (eigenvalues[0]);
+  scale.y() = 2*std::sqrt (eigenvalues[1]);
+  scale.z() = 2*std::sqrt (eigenvalues[2]);
+}
+
+enum Plane {
+  YZ_PLANE, // normal is x-axis
+  XZ_PLANE, // normal is y-axis
+  XY_PLANE  // normal is z-axis
+};
+
+void computeShapeScaleAndOrientation2D(const Eigen::Matrix2d& covariance, CovarianceShapes::Vector3& scale, CovarianceShapes::Quaternion& orientation, Plane plane = XY_PLANE)
+{
+  // NOTE: The SelfAdjointEigenSolver only references the lower triangular part of the covariance matrix
+  Eigen::SelfAdjointEigenSolver<Eigen::Matrix2d> eigensolver;
+  eigensolver.computeDirect(covariance);
+  Eigen::Vector2d eigenvalues = eigensolver.eigenvalues();
+  Eigen::Matrix2d eigenvectors = eigensolver.eigenvectors();
+
+  // Be sure we have a right-handed orientation system
+  makeRightHanded(eigenvectors, eigenvalues);
+
+  // Define the rotation and scale of the plane
+  // The Eigenvalues are the variances. The scales are two times the standard
+  // deviation. The scale of the missing dimension is set to zero.
+  Eigen::Matrix3d rotation;
+  if(plane == YZ_PLANE)
+  {
+    rotation << 1,        0,                 0,
+                0, eigenvectors(0,0), eigenvectors(0,1),
+                0, eigenvectors(1,0), eigenvectors(1,1);
+
+    scale.x() = 0;
+    scale.y() = 2*std::sqrt (eigenvalues[0]);
+    scale.z() = 2*std::sqrt (eigenvalues[1]);
+  }
+  else if(plane == XZ_PLANE)
+  {
+    rotation << eigenvectors(0,0), 0, eigenvectors(0,1),
+                       0,          1,        0,
+                eigenvectors(1,0), 0, eigenvectors(1,1);
+
+    scale.x() = 2*std::sqrt (eigenvalues[0]);
+    scale.y() = 0;
+    scale.z() = 2*std::sqrt (eigenvalues[1]);
+  }
+  else // plane == XY_PLANE
+  {
+    rotation << eigenvectors(0,0), eigenvectors(0,1), 0,
+                eigenvectors(1,0), eigenvectors(1,1), 0,
+                       0,                 0,          1;
+
+    scale.x() = 2*std::sqrt (eigenvalues[0]);
+    scale.y() = 2*std::sqrt (eigenvalues[1]);
+    scale.z() = 0;
+  }
+  orientation = CovarianceShapes::Quaternion(Eigen::Quaterniond(rotation).cast<float>());
+}
+
+void computeOrientationShape( const Matrix6d& covariance, bool pose_2d, int index,
+                              CovarianceShapes::Vector3& shape_scale, CovarianceShapes::Quaternion& shape_orientation )
+{
+  if(pose_2d)
+  {
+    // 2D poses only depend on yaw.
+    shape_scale.x() = 2.0*sqrt(covariance(5,5));
+    // To display the cone shape properly the scale along y-axis has to be one.
+    shape_scale.y() = 1.0;
+    // Give a minimal height for the cone for better visualization
+    shape_scale.z() = 0.001;
+    shape_orientation = CovarianceShapes::Quaternion::Identity();
+  }
+  else
+  {
+    // Get the correct sub-matrix based on the index
+    Eigen::Matrix2d covarianceAxis;
+    if(index == CovarianceShapes::kRoll)
+    {
+      covarianceAxis = covariance.bottomRightCorner<2,2>();
+    }
+    else if(index == CovarianceShapes::kPitch)
+    {
+      covarianceAxis << covariance(3,3), covariance(3,5), covariance(5,3), covariance(5,5);
+    }
+    else // index == CovarianceShapes::kYaw
+    {
+      covarianceAxis = covariance.block<2,2>(3,3);
+    }
+
+    // NOTE: The cylinder mesh is oriented along its y axis, thus we want to flat it out into the XZ plane
+    computeShapeScaleAndOrientation2D(covarianceAxis, shape_scale, shape_orientation, XZ_PLANE);
+    // Give a minimal height for the cylinder for better visualization
+    shape_scale.y() = 0.001;
+  }
+}
+
+} // namespace
+
+void computeCovarianceShapes( const boost::array<double, 36>& covariance_data, CovarianceShapes& shapes )
+{
+  // check for NaN in covariance
+  shapes.valid = true;
+  for (unsigned i = 0; i < 3; ++i)
+  {
+    if(std::isnan(covariance_data[i]))
+    {
+      shapes.valid = false;
+      return;
+    }
+  }
+
+  shapes.pose_2d = covariance_data[14] <= 0 && covariance_data[21] <= 0 && covariance_data[28] <= 0;
+
+  // Map covariance to a Eigen::Matrix
+  Eigen::Map<const Matrix6d> covariance(covariance_data.data());
+
+  // Compute shape and orientation for the position part of covariance
+  if(shapes.pose_2d)
+  {
+    computeShapeScaleAndOrientation2D(covariance.topLeftCorner<2,2>(), shapes.position_scale, shapes.position_orientation, XY_PLANE);
+    // Make the scale in z minimal for better visualization
+    shapes.position_scale.z() = 0.001;
+  }
+  else
+  {
+    computeShapeScaleAndOrientation3D(covariance.topLeftCorner<3,3>(), shapes.position_scale, shapes.position_orientation);
+  }
+
+  // Only the shapes of the current mode are computed; the others are hidden.
+  for(int i = 0; i < CovarianceShapes::kNumOriShapes; i++)
+  {
+    if(shapes.pose_2d == (i == CovarianceShapes::kYaw2D))
+    {
+      computeOrientationShape(covariance, shapes.pose_2d, i, shapes.orientation_scale[i], shapes.orientation_orientation[i]);
+    }
+    else
+    {
+      shapes.orientation_scale[i].setZero();
+      shapes.orientation_orientation[i].setIdentity();
+    }
+  }
+}
+
+void computeCovarianceShapes( const boost::array<double, 36>* covariances, size_t count, CovarianceShapes* shapes )
+{
+  for( size_t i = 0; i < count; i++ )
+  {
+    computeCovarianceShapes( covariances[ i ], shapes[ i ] );
+  }
+}
+
+float radianScaleToMetricScaleBounded( float radian_scale, float max_degrees )
+{
+  radian_scale /= 2.0;
+  if(radian_scale > deg2rad(max_degrees)) radian_scale = deg2rad(max_degrees);
+  return 2.0 * tan(radian_scale);
+}
+
+} // namespace rviz
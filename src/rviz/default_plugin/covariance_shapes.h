@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2012, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef COVARIANCE_SHAPES_H
+#define COVARIANCE_SHAPES_H
+
+#include <cstddef>
+
+#include <boost/array.hpp>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+namespace rviz
+{
+
+/**
+ * \struct CovarianceShapes
+ * \brief Scale and orientation of the shapes representing a pose covariance.
+ *
+ * This is the render-independent part of CovarianceVisual: it holds the
+ * result of the eigen-decomposition of the covariance, which the visuals
+ * then turn into shape transforms.  The orientation scales are two times
+ * the standard deviation _in radians_; see radianScaleToMetricScaleBounded().
+ *
+ * Members do not require alignment, so the struct can be stored in
+ * standard containers.
+ */
+struct CovarianceShapes
+{
+  typedef Eigen::Matrix<float, 3, 1, Eigen::DontAlign> Vector3;
+  typedef Eigen::Quaternion<float, Eigen::DontAlign> Quaternion;
+
+  /** Same order as CovarianceVisual::ShapeIndex. */
+  enum ShapeIndex
+  {
+    kRoll=0,
+    kPitch=1,
+    kYaw=2,
+    kYaw2D=3,
+    kNumOriShapes
+  };
+
+  /** False if the covariance contained NaNs; nothing else is set then. */
+  bool valid;
+  /** True if the covariance has no roll, pitch and z components. */
+  bool pose_2d;
+
+  Vector3 position_scale;
+  Quaternion position_orientation;
+
+  Vector3 orientation_scale[ kNumOriShapes ];
+  Quaternion orientation_orientation[ kNumOriShapes ];
+};
+
+/** @brief Decompose one row-major 6x6 pose covariance. */
+void computeCovarianceShapes( const boost::array<double, 36>& covariance, CovarianceShapes& shapes );
+
+/**
+ * @brief Decompose @a count covariances at once.
+ *
+ * Uses the closed-form solver for the 2x2 and 3x3 blocks, which has no
+ * iterations or data-dependent branches and is much cheaper than the
+ * general one.  Displays collect the covariances of all the messages of
+ * a frame and decompose them in one call.
+ */
+void computeCovarianceShapes( const boost::array<double, 36>* covariances, size_t count, CovarianceShapes* shapes );
+
+/**
+ * @brief Convert an orientation scale in radians (two times the standard
+ * deviation) to the metric width of a shape at unit distance, bounding
+ * the angle to @a max_degrees.
+ */
+float radianScaleToMetricScaleBounded( float radian_scale, float max_degrees );
+
+} // namespace rviz
+
+#endif // COVARIANCE_SHAPES_H
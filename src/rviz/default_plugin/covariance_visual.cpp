@@ -46,153 +46,16 @@ namespace rviz
 namespace
 {
 
-double deg2rad (double degrees)
+Ogre::Vector3 toOgre( const CovarianceShapes::Vector3& v )
 {
-    return degrees * 4.0 * atan (1.0) / 180.0;
+  return Ogre::Vector3( v.x(), v.y(), v.z() );
 }
 
-// Local function to force the axis to be right handed for 3D. Taken from ecl_statistics
-void makeRightHanded( Eigen::Matrix3d& eigenvectors, Eigen::Vector3d& eigenvalues)
+Ogre::Quaternion toOgre( const CovarianceShapes::Quaternion& q )
 {
-  // Note that sorting of eigenvalues may end up with left-hand coordinate system.
-  // So here we correctly sort it so that it does end up being righ-handed and normalised.
-  Eigen::Vector3d c0 = eigenvectors.block<3,1>(0,0);  c0.normalize();
-  Eigen::Vector3d c1 = eigenvectors.block<3,1>(0,1);  c1.normalize();
-  Eigen::Vector3d c2 = eigenvectors.block<3,1>(0,2);  c2.normalize();
-  Eigen::Vector3d cc = c0.cross(c1);
-  if (cc.dot(c2) < 0) {
-    eigenvectors << c1, c0, c2;
-    double e = eigenvalues[0];  eigenvalues[0] = eigenvalues[1];  eigenvalues[1] = e;
-  } else {
-    eigenvectors << c0, c1, c2;
-  }
-}
-
-// Local function to force the axis to be right handed for 2D. Based on the one from ecl_statistics
-void makeRightHanded( Eigen::Matrix2d& eigenvectors, Eigen::Vector2d& eigenvalues)
-{
-  // Note that sorting of eigenvalues may end up with left-hand coordinate system.
-  // So here we correctly sort it so that it does end up being righ-handed and normalised.
-  Eigen::Vector3d c0;  c0.setZero();  c0.head<2>() = eigenvectors.col(0);  c0.normalize();
-  Eigen::Vector3d c1;  c1.setZero();  c1.head<2>() = eigenvectors.col(1);  c1.normalize();
-  Eigen::Vector3d cc = c0.cross(c1);
-  if (cc[2] < 0) {
-    eigenvectors << c1.head<2>(), c0.head<2>();
-    double e = eigenvalues[0];  eigenvalues[0] = eigenvalues[1];  eigenvalues[1] = e;
-  } else {
-    eigenvectors << c0.head<2>(), c1.head<2>();
-  }
-}
-
-void computeShapeScaleAndOrientation3D(const Eigen::Matrix3d& covariance, Ogre::Vector3& scale, Ogre::Quaternion& orientation)
-{
-  Eigen::Vector3d eigenvalues(Eigen::Vector3d::Identity());
-  Eigen::Matrix3d eigenvectors(Eigen::Matrix3d::Zero());
-
-  // NOTE: The SelfAdjointEigenSolver only references the lower triangular part of the covariance matrix
-  // FIXME: Should we use Eigen's pseudoEigenvectors() ?
-  Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> eigensolver(covariance);
-  // Compute eigenvectors and eigenvalues
-  if (eigensolver.info () == Eigen::Success)
-  {
-    eigenvalues = eigensolver.eigenvalues();
-    eigenvectors = eigensolver.eigenvectors();
-  }
-  else
-  {
-    ROS_WARN_THROTTLE(1, "failed to compute eigen vectors/values for position. Is the covariance matrix correct?");
-    eigenvalues = Eigen::Vector3d::Zero();      // Setting the scale to zero will hide it on the screen
-    eigenvectors = Eigen::Matrix3d::Identity();
-  }
-
-  // Be sure we have a right-handed orientation system
-  makeRightHanded(eigenvectors, eigenvalues);
-
-  // Define the rotation
-  orientation.FromRotationMatrix(Ogre::Matrix3(eigenvectors(0,0), eigenvectors(0,1), eigenvectors(0,2),
-                                               eigenvectors(1,0), eigenvectors(1,1), eigenvectors(1,2),
-                                               eigenvectors(2,0), eigenvectors(2,1), eigenvectors(2,2)));
-
-  // Define the scale. eigenvalues are the variances, so we take the sqrt to draw the standard deviation
-  scale.x = 2*std::sqrt (eigenvalues[0]);
-  scale.y = 2*std::sqrt (eigenvalues[1]);
-  scale.z = 2*std::sqrt (eigenvalues[2]);
-}
-
-enum Plane {
-  YZ_PLANE, // normal is x-axis
-  XZ_PLANE, // normal is y-axis
-  XY_PLANE  // normal is z-axis
-};
-
-void computeShapeScaleAndOrientation2D(const Eigen::Matrix2d& covariance, Ogre::Vector3& scale, Ogre::Quaternion& orientation, Plane plane = XY_PLANE)
-{
-  Eigen::Vector2d eigenvalues(Eigen::Vector2d::Identity());
-  Eigen::Matrix2d eigenvectors(Eigen::Matrix2d::Zero());
-
-  // NOTE: The SelfAdjointEigenSolver only references the lower triangular part of the covariance matrix
-  // FIXME: Should we use Eigen's pseudoEigenvectors() ?
-  Eigen::SelfAdjointEigenSolver<Eigen::Matrix2d> eigensolver(covariance);
-  // Compute eigenvectors and eigenvalues
-  if (eigensolver.info () == Eigen::Success)
-  {
-    eigenvalues = eigensolver.eigenvalues();
-    eigenvectors = eigensolver.eigenvectors();
-  }
-  else
-  {
-    ROS_WARN_THROTTLE(1, "failed to compute eigen vectors/values for position. Is the covariance matrix correct?");
-    eigenvalues = Eigen::Vector2d::Zero();      // Setting the scale to zero will hide it on the screen
-    eigenvectors = Eigen::Matrix2d::Identity();
-  }
-
-  // Be sure we have a right-handed orientation system
-  makeRightHanded(eigenvectors, eigenvalues);
-
-  // Define the rotation and scale of the plane
-  // The Eigenvalues are the variances. The scales are two times the standard
-  // deviation. The scale of the missing dimension is set to zero.
-  if(plane == YZ_PLANE)
-  {
-    orientation.FromRotationMatrix(Ogre::Matrix3(1,        0,                 0,
-                                                 0, eigenvectors(0,0), eigenvectors(0,1),
-                                                 0, eigenvectors(1,0), eigenvectors(1,1)));
-
-    scale.x = 0;
-    scale.y = 2*std::sqrt (eigenvalues[0]);
-    scale.z = 2*std::sqrt (eigenvalues[1]);
-
-  }
-  else if(plane == XZ_PLANE)
-  {
-    orientation.FromRotationMatrix(Ogre::Matrix3(eigenvectors(0,0), 0, eigenvectors(0,1),
-                                                        0,          1,        0,
-                                                 eigenvectors(1,0), 0, eigenvectors(1,1)));
-
-    scale.x = 2*std::sqrt (eigenvalues[0]);
-    scale.y = 0;
-    scale.z = 2*std::sqrt (eigenvalues[1]);
-  }
-  else // plane == XY_PLANE
-  {
-    orientation.FromRotationMatrix(Ogre::Matrix3(eigenvectors(0,0), eigenvectors(0,1), 0,
-                                                 eigenvectors(1,0), eigenvectors(1,1), 0,
-                                                        0,                 0,          1));
-
-    scale.x = 2*std::sqrt (eigenvalues[0]);
-    scale.y = 2*std::sqrt (eigenvalues[1]);
-    scale.z = 0;
-  }
+  return Ogre::Quaternion( q.w(), q.x(), q.y(), q.z() );
 }
 
-void radianScaleToMetricScaleBounded(Ogre::Real & radian_scale, float max_degrees)
-{
-  radian_scale /= 2.0;
-  if(radian_scale > deg2rad(max_degrees)) radian_scale = deg2rad(max_degrees);
-  radian_scale = 2.0 * tan(radian_scale);
-}
-
-
 }
 
 const float CovarianceVisual::max_degrees = 89.0;
@@ -282,20 +145,15 @@ CovarianceVisual::~CovarianceVisual()
 
 void CovarianceVisual::setCovariance( const geometry_msgs::PoseWithCovariance& pose )
 {
-  // check for NaN in covariance
-  for (unsigned i = 0; i < 3; ++i)
+  CovarianceShapes shapes;
+  computeCovarianceShapes( pose.covariance, shapes );
+  if( !shapes.valid )
   {
-      if(std::isnan(pose.covariance[i]))
-      {
-          ROS_WARN_THROTTLE(1, "covariance contains NaN");
-          return;
-      }
+    ROS_WARN_THROTTLE(1, "covariance contains NaN");
+    return;
   }
 
-  if(pose.covariance[14] <= 0 && pose.covariance[21] <= 0 && pose.covariance[28] <= 0 )
-    pose_2d_ = true;
-  else
-    pose_2d_ = false;
+  pose_2d_ = shapes.pose_2d;
 
   updateOrientationVisibility();
 
@@ -306,38 +164,25 @@ void CovarianceVisual::setCovariance( const geometry_msgs::PoseWithCovariance& p
   // Set the orientation of the fixed node. Since this node is attached to the root node, it's orientation will be the
   // inverse of pose's orientation.
   fixed_orientation_node_->setOrientation(ori.Inverse());
-  // Map covariance to a Eigen::Matrix
-  Eigen::Map<const Eigen::Matrix<double,6,6> > covariance(pose.covariance.data());
 
-  updatePosition(covariance);
+  updatePosition(shapes);
   if(!pose_2d_)
   {
-    updateOrientation(covariance, kRoll);
-    updateOrientation(covariance, kPitch);
-    updateOrientation(covariance, kYaw);
+    updateOrientation(shapes, kRoll);
+    updateOrientation(shapes, kPitch);
+    updateOrientation(shapes, kYaw);
   }
   else
   {
-    updateOrientation(covariance, kYaw2D);
+    updateOrientation(shapes, kYaw2D);
   }
 
 }
 
-void CovarianceVisual::updatePosition( const Eigen::Matrix6d& covariance )
+void CovarianceVisual::updatePosition( const CovarianceShapes& shapes )
 {
-  // Compute shape and orientation for the position part of covariance
-  Ogre::Vector3 shape_scale;
-  Ogre::Quaternion shape_orientation;
-  if(pose_2d_)
-  {
-    computeShapeScaleAndOrientation2D(covariance.topLeftCorner<2,2>(), shape_scale, shape_orientation, XY_PLANE);
-    // Make the scale in z minimal for better visualization
-    shape_scale.z = 0.001;
-  }
-  else
-  {
-    computeShapeScaleAndOrientation3D(covariance.topLeftCorner<3,3>(), shape_scale, shape_orientation);
-  }
+  Ogre::Vector3 shape_scale = toOgre( shapes.position_scale );
+  Ogre::Quaternion shape_orientation = toOgre( shapes.position_orientation );
   // Rotate and scale the position scene node
   position_node_->setOrientation(shape_orientation);
   if(!shape_scale.isNaN())
@@ -346,21 +191,14 @@ void CovarianceVisual::updatePosition( const Eigen::Matrix6d& covariance )
       ROS_WARN_STREAM("position shape_scale contains NaN: " << shape_scale);
 }
 
-void CovarianceVisual::updateOrientation( const Eigen::Matrix6d& covariance, ShapeIndex index )
+void CovarianceVisual::updateOrientation( const CovarianceShapes& shapes, ShapeIndex index )
 {
-  Ogre::Vector3 shape_scale;
-  Ogre::Quaternion shape_orientation;
-  // Compute shape and orientation for the orientation shape
+  Ogre::Vector3 shape_scale = toOgre( shapes.orientation_scale[index] );
+  Ogre::Quaternion shape_orientation = toOgre( shapes.orientation_orientation[index] );
   if(pose_2d_)
   {
     // We should only enter on this scope if the index is kYaw2D
     assert(index == kYaw2D);
-    // 2D poses only depend on yaw.
-    shape_scale.x = 2.0*sqrt(covariance(5,5));
-    // To display the cone shape properly the scale along y-axis has to be one.
-    shape_scale.y = 1.0;
-    // Give a minimal height for the cone for better visualization
-    shape_scale.z = 0.001;
     // Store the computed scale to be used if the user change the scale
     current_ori_scale_[index] = shape_scale;
     // Apply the current scale factor
@@ -368,31 +206,12 @@ void CovarianceVisual::updateOrientation( const Eigen::Matrix6d& covariance, Sha
     // The scale on x means twice the standard deviation, but _in radians_.
     // So we need to convert it to the linear scale of the shape using tan().
     // Also, we bound the maximum std
-    radianScaleToMetricScaleBounded(shape_scale.x, max_degrees);
+    shape_scale.x = radianScaleToMetricScaleBounded(shape_scale.x, max_degrees);
   }
   else
   {
     assert(index != kYaw2D);
 
-    // Get the correct sub-matrix based on the index
-    Eigen::Matrix2d covarianceAxis;
-    if(index == kRoll)
-    {
-      covarianceAxis = covariance.bottomRightCorner<2,2>();
-    }
-    else if(index == kPitch)
-    {
-      covarianceAxis << covariance(3,3), covariance(3,5), covariance(5,3), covariance(5,5);
-    }
-    else if(index == kYaw)
-    {
-      covarianceAxis = covariance.block<2,2>(3,3);
-    }
-
-    // NOTE: The cylinder mesh is oriented along its y axis, thus we want to flat it out into the XZ plane
-    computeShapeScaleAndOrientation2D(covarianceAxis, shape_scale, shape_orientation, XZ_PLANE);
-    // Give a minimal height for the cylinder for better visualization
-    shape_scale.y = 0.001;
     // Store the computed scale to be used if the user change the scale
     current_ori_scale_[index] = shape_scale;
     // Apply the current scale factor
@@ -401,8 +220,8 @@ void CovarianceVisual::updateOrientation( const Eigen::Matrix6d& covariance, Sha
     // The computed scale is equivalent to twice the standard deviation _in radians_.
     // So we need to convert it to the linear scale of the shape using tan().
     // Also, we bound the maximum std.
-    radianScaleToMetricScaleBounded(shape_scale.x, max_degrees);
-    radianScaleToMetricScaleBounded(shape_scale.z, max_degrees);
+    shape_scale.x = radianScaleToMetricScaleBounded(shape_scale.x, max_degrees);
+    shape_scale.z = radianScaleToMetricScaleBounded(shape_scale.z, max_degrees);
   }
 
   // Rotate and scale the scene node of the orientation part
@@ -466,7 +285,7 @@ void CovarianceVisual::setOrientationScale( float ori_scale )
       // Apply the current scale factor
       shape_scale.x *= current_ori_scale_factor_;
       // Convert from radians to meters
-      radianScaleToMetricScaleBounded(shape_scale.x, max_degrees);
+      shape_scale.x = radianScaleToMetricScaleBounded(shape_scale.x, max_degrees);
     }
     else
     {
@@ -475,8 +294,8 @@ void CovarianceVisual::setOrientationScale( float ori_scale )
       shape_scale.x *= current_ori_scale_factor_;
       shape_scale.z *= current_ori_scale_factor_;
       // Convert from radians to meters
-      radianScaleToMetricScaleBounded(shape_scale.x, max_degrees);
-      radianScaleToMetricScaleBounded(shape_scale.z, max_degrees);
+      shape_scale.x = radianScaleToMetricScaleBounded(shape_scale.x, max_degrees);
+      shape_scale.z = radianScaleToMetricScaleBounded(shape_scale.z, max_degrees);
     }
   // Apply the new scale
   orientation_shape_[i]->setScale(shape_scale);
@@ -38,7 +38,7 @@
 
 #include <geometry_msgs/PoseWithCovariance.h>
 
-#include <Eigen/Dense>
+#include "covariance_shapes.h"
 
 #include <OgreVector3.h>
 #include <OgreColourValue.h>
@@ -50,11 +50,6 @@ class SceneNode;
 class Any;
 }
 
-namespace Eigen
-{
-  typedef Matrix<double,6,6> Matrix6d;
-}
-
 namespace rviz
 {
 
@@ -198,8 +193,8 @@ public:
   virtual void setRotatingFrame( bool use_rotating_frame );
 
 private:
-  void updatePosition( const Eigen::Matrix6d& covariance );
-  void updateOrientation( const Eigen::Matrix6d& covariance, ShapeIndex index );
+  void updatePosition( const CovarianceShapes& shapes );
+  void updateOrientation( const CovarianceShapes& shapes, ShapeIndex index );
   void updateOrientationVisibility();
 
   Ogre::SceneNode* root_node_;
@@ -38,6 +38,8 @@
 #include "rviz/properties/bool_property.h"
 #include "rviz/properties/int_property.h"
 #include "rviz/frame_manager.h"
+#include "rviz/plugin_index.h"
+#include "rviz/topic_cache.h"
 
 #include <tf2_ros/buffer.h>
 
@@ -530,7 +532,8 @@ void DepthCloudDisplay::processMessage(sensor_msgs::ImageConstPtr depth_msg,
 void DepthCloudDisplay::scanForTransportSubscriberPlugins()
 {
   pluginlib::ClassLoader<image_transport::SubscriberPlugin> sub_loader("image_transport",
-                                                                       "image_transport::SubscriberPlugin");
+                                                                       "image_transport::SubscriberPlugin", "plugin",
+                                                                       PluginIndex::instance()->getPluginXmlPaths( "image_transport" ));
 
   BOOST_FOREACH( const std::string& lookup_name, sub_loader.getDeclaredClasses() )
   {
@@ -576,8 +579,7 @@ void DepthCloudDisplay::fillTransportOptionList(EnumProperty* property)
   choices.push_back("raw");
 
   // Loop over all current ROS topic names
-  ros::master::V_TopicInfo topics;
-  ros::master::getTopics(topics);
+  ros::master::V_TopicInfo topics = TopicCache::instance()->getTopics();
   ros::master::V_TopicInfo::iterator it = topics.begin();
   ros::master::V_TopicInfo::iterator end = topics.end();
   for (; it != end; ++it)
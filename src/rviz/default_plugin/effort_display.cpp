@@ -6,11 +6,10 @@
 #include <rviz/properties/float_property.h>
 #include <rviz/properties/int_property.h>
 #include <rviz/frame_manager.h>
+#include <rviz/ogre_helpers/glyph_ring.h>
 
 #include <boost/foreach.hpp>
 
-#include "effort_visual.h"
-
 #include "effort_display.h"
 
 #include <urdf/model.h>
@@ -75,8 +74,27 @@ namespace rviz
         return info;
     }
 
+    void getRainbowColor(float value, Ogre::ColourValue& color)
+    {
+        value = std::min(value, 1.0f);
+        value = std::max(value, 0.0f);
+
+        float h = value * 5.0f + 1.0f;
+        int i = floor(h);
+        float f = h - i;
+        if ( !(i&1) ) f = 1 - f; // if i is even
+        float n = 1 - f;
+
+        if      (i <= 1) color[0] = n, color[1] = 0, color[2] = 1;
+        else if (i == 2) color[0] = 0, color[1] = n, color[2] = 1;
+        else if (i == 3) color[0] = 0, color[1] = 1, color[2] = n;
+        else if (i == 4) color[0] = n, color[1] = 1, color[2] = 0;
+        else if (i >= 5) color[0] = 1, color[1] = n, color[2] = 0;
+    }
+
     ///
     EffortDisplay::EffortDisplay()
+      : efforts_( NULL )
     {
 	alpha_property_ =
 	    new rviz::FloatProperty( "Alpha", 1.0,
@@ -118,19 +136,23 @@ namespace rviz
     void EffortDisplay::onInitialize()
     {
         MFDClass::onInitialize();
+        efforts_ = new rviz::GlyphRing( context_->getSceneManager(), scene_node_ );
+        updateColorAndAlpha();
         updateHistoryLength();
     }
 
     EffortDisplay::~EffortDisplay()
     {
         //delete robot_model_; // sharead pointer
+        delete efforts_;
     }
 
-    // Clear the visuals by deleting their objects.
+    // Clear the history of efforts.
     void EffortDisplay::reset()
     {
         MFDClass::reset();
-        visuals_.clear();
+        history_.clear();
+        efforts_->clear();
     }
 
     void EffortDisplay::updateTfPrefix()
@@ -148,14 +170,36 @@ namespace rviz
     // Set the current color and alpha values for each visual.
     void EffortDisplay::updateColorAndAlpha()
     {
+        efforts_->clear();
+
+        // Effort glyph for a circle of unit radius around the joint axis:
+        // an arc starting at +Y and turning towards +X, with an arrow head
+        // at its start.  Instances are scaled by the effort; the tube and
+        // the head keep their width.
         float width = width_property_->getFloat();
-        float scale = scale_property_->getFloat();
+        rviz::GlyphRing::V_Vertex glyph = rviz::GlyphRing::makeArc( 1.0f, width,
+                                                                    Ogre::Math::HALF_PI,
+                                                                    Ogre::Math::HALF_PI - 29 * Ogre::Math::TWO_PI / 32 );
+        rviz::GlyphRing::appendUnscaledGlyph( glyph, rviz::GlyphRing::makeArrow( 0, 0, width * 2, width * 4 ),
+                                              Ogre::Vector3( 0, 1, 0 ),
+                                              Ogre::Quaternion( Ogre::Degree( 180 ), Ogre::Vector3::UNIT_Z ));
+        efforts_->setGlyph( glyph );
+
+        // Redraw the history with the new width, scale and alpha.
+        for ( size_t i = 0; i < history_.size(); i++ )
+        {
+            pushEffort( history_[i] );
+        }
+    }
 
-        for( size_t i = 0; i < visuals_.size(); i++ )
-            {
-                visuals_[ i ]->setWidth( width );
-                visuals_[ i ]->setScale( scale );
-            }
+    void EffortDisplay::pushEffort( const Effort& effort )
+    {
+        Ogre::ColourValue color;
+        getRainbowColor(effort.value, color);
+        color.a = alpha_property_->getFloat();
+
+        float radius = 0.05 + effort.value * scale_property_->getFloat() * 0.5;
+        efforts_->push( effort.position, effort.orientation, Ogre::Vector3( radius ), color );
     }
 
     void EffortDisplay::updateRobotDescription()
@@ -170,7 +214,10 @@ namespace rviz
     // Set the number of past visuals to show.
     void EffortDisplay::updateHistoryLength( )
     {
-        visuals_.rset_capacity(history_length_property_->getInt());
+        // One slot per revolute joint and message.
+        size_t joint_num = std::max( joints_.size(), (size_t) 1 );
+        history_.rset_capacity( history_length_property_->getInt() * joint_num );
+        efforts_->setCapacity( history_length_property_->getInt() * joint_num );
     }
 
     void EffortDisplay::load()
@@ -225,6 +272,7 @@ namespace rviz
                 joints_[joint_name]->setMaxEffort(limit->effort);
             }
         }
+        updateHistoryLength();
     }
 
     void EffortDisplay::onEnable()
@@ -278,18 +326,6 @@ namespace rviz
         {
             return;
         }
-        // We are keeping a circular buffer of visual pointers.  This gets
-        // the next one, or creates and stores it if the buffer is not full
-        boost::shared_ptr<EffortVisual> visual;
-        if (visuals_.full())
-        {
-            visual = visuals_.front();
-        }
-        else
-        {
-            visual.reset(new EffortVisual(context_->getSceneManager(), scene_node_, robot_model_));
-        }
-
         V_string joints;
         size_t joint_num = msg->name.size();
         if (joint_num != msg->effort.size())
@@ -346,21 +382,33 @@ namespace rviz
 		tf::Quaternion axis_orientation(orientation.x, orientation.y, orientation.z, orientation.w);
 		tf::Quaternion axis_rot = axis_orientation * axis_rotation;
 		Ogre::Quaternion joint_orientation(Ogre::Real(axis_rot.w()), Ogre::Real(axis_rot.x()), Ogre::Real(axis_rot.y()), Ogre::Real(axis_rot.z()));
-		visual->setFramePosition( joint_name, position );
-		visual->setFrameOrientation( joint_name, joint_orientation );
-                visual->setFrameEnabled( joint_name, joint_info->getEnabled() );
-	    }
-	}
 
+                if ( !joint_info->getEnabled() ) continue;
 
-	// Now set or update the contents of the chosen visual.
-        float scale = scale_property_->getFloat();
-        float width = width_property_->getFloat();
-        visual->setWidth( width );
-        visual->setScale( scale );
-	visual->setMessage( msg );
+                double effort = msg->effort[i];
+                double max_effort = joint->limits->effort, effort_value = 0.05;
+                if ( max_effort != 0.0 )
+                {
+                    effort_value = std::min(fabs(effort) / max_effort, 1.0) + 0.05;
+                } else {
+                    effort_value = fabs(effort) + 0.05;
+                }
 
-        visuals_.push_back(visual);
+                // Negative efforts turn the other way: mirror the glyph
+                // across the joint's YZ plane.
+                if ( effort < 0 )
+                {
+                    joint_orientation = joint_orientation * Ogre::Quaternion( Ogre::Degree( 180 ), Ogre::Vector3::UNIT_Y );
+                }
+
+                Effort entry;
+                entry.position = position;
+                entry.orientation = joint_orientation;
+                entry.value = effort_value;
+                history_.push_back( entry );
+                pushEffort( entry );
+	    }
+	}
     }
 
 } // end namespace rviz
@@ -5,17 +5,22 @@
 #include <boost/circular_buffer.hpp>
 #endif
 
+#include <OgreQuaternion.h>
+#include <OgreVector3.h>
+
 #include <sensor_msgs/JointState.h>
 #include <rviz/message_filter_display.h>
 
 namespace Ogre
 {
+    class ColourValue;
     class SceneNode;
 }
 
 namespace rviz
 {
     class FloatProperty;
+    class GlyphRing;
     class IntProperty;
     class StringProperty;
     class CategoryProperty;
@@ -656,6 +661,9 @@ protected:
 
 namespace rviz
 {
+    // Map an effort ratio in [0, 1] to a blue-to-red rainbow color.
+    void getRainbowColor(float value, Ogre::ColourValue& color);
+
     class JointInfo: public QObject {
         Q_OBJECT
         public:
@@ -685,8 +693,6 @@ namespace rviz
     typedef std::set<JointInfo*> S_JointInfo;
     typedef std::vector<std::string> V_string;
 
-    class EffortVisual;
-
     class EffortDisplay: public rviz::MessageFilterJointStateDisplay
     {
     Q_OBJECT
@@ -728,9 +734,24 @@ namespace rviz
     private:
 	void processMessage( const sensor_msgs::JointState::ConstPtr& msg );
 
-        // Storage for the list of visuals.  It is a circular buffer where
-        // data gets popped from the front (oldest) and pushed to the back (newest)
-        boost::circular_buffer<boost::shared_ptr<EffortVisual> > visuals_;
+        // The effort of one joint in one message, in the fixed frame.
+        struct Effort
+        {
+            Ogre::Vector3 position;
+            Ogre::Quaternion orientation;
+            double value;
+        };
+
+        // Push one effort into the ring, styled with the current properties.
+        void pushEffort( const Effort& effort );
+
+        // The efforts the ring shows, so that property changes can redraw
+        // the whole history.
+        boost::circular_buffer<Effort> history_;
+
+        // History of efforts, one entry per revolute joint and message,
+        // drawn in a single batch.
+        rviz::GlyphRing* efforts_;
 
         typedef std::map<std::string, JointInfo*> M_JointInfo;
         M_JointInfo joints_;
@@ -8,6 +8,7 @@
 #include <ros/ros.h>
 
 #include <urdf/model.h>
+#include "effort_display.h"
 #include "effort_visual.h"
 
 namespace rviz
@@ -56,20 +57,7 @@ namespace rviz
 
     void EffortVisual::getRainbowColor(float value, Ogre::ColourValue& color)
     {
-	value = std::min(value, 1.0f);
-	value = std::max(value, 0.0f);
-
-	float h = value * 5.0f + 1.0f;
-	int i = floor(h);
-	float f = h - i;
-	if ( !(i&1) ) f = 1 - f; // if i is even
-	float n = 1 - f;
-
-	if      (i <= 1) color[0] = n, color[1] = 0, color[2] = 1;
-	else if (i == 2) color[0] = 0, color[1] = n, color[2] = 1;
-	else if (i == 3) color[0] = 0, color[1] = 1, color[2] = n;
-	else if (i == 4) color[0] = n, color[1] = 1, color[2] = 0;
-	else if (i >= 5) color[0] = 1, color[1] = n, color[2] = 0;
+	rviz::getRainbowColor(value, color);
     }
 
     void EffortVisual::setMessage( const sensor_msgs::JointStateConstPtr& msg )
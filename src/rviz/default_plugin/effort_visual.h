@@ -24,6 +24,9 @@ namespace rviz
 {
 
 
+// Deprecated: EffortDisplay now draws its history with rviz::GlyphRing and no
+// longer uses this class.  It is kept for code built against it.
+//
 // Each instance of EffortVisual represents the visualization of a single
 // sensor_msgs::Effort message.  Currently it just shows an arrow with
 // the direction and magnitude of the acceleration vector, but could
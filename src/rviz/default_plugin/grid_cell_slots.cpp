@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2012, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "grid_cell_slots.h"
+
+namespace rviz
+{
+
+void GridCellSlots::clear()
+{
+  cell_slots_.clear();
+  slot_cells_.clear();
+}
+
+void GridCellSlots::rebuild( const std::vector<Cell>& cells )
+{
+  clear();
+  slot_cells_.reserve( cells.size() );
+  for( uint32_t i = 0; i < cells.size(); i++ )
+  {
+    if( cell_slots_.insert( std::make_pair( cells[ i ], (uint32_t)slot_cells_.size() )).second )
+    {
+      slot_cells_.push_back( cells[ i ] );
+    }
+  }
+}
+
+GridCellSlots::Update GridCellSlots::assign( const std::vector<Cell>& cells )
+{
+  const uint32_t NEW_CELL = uint32_t( -1 );
+
+  Update update;
+  update.rebuild = false;
+  update.removed = 0;
+  update.first_added = 0;
+
+  // Match the cells against the drawn ones.  Drawn cells still present are
+  // kept, new cells are queued and the rest leave holes.
+  std::vector<bool> keep( slot_cells_.size(), false );
+  std::vector<Cell> added;
+  for( uint32_t i = 0; i < cells.size(); i++ )
+  {
+    std::pair<M_CellToSlot::iterator, bool> result = cell_slots_.insert( std::make_pair( cells[ i ], NEW_CELL ));
+    if( result.second )
+    {
+      added.push_back( cells[ i ] );
+    }
+    else if( result.first->second != NEW_CELL )
+    {
+      keep[ result.first->second ] = true;
+    }
+  }
+
+  std::vector<uint32_t> holes;
+  for( uint32_t i = 0; i < slot_cells_.size(); i++ )
+  {
+    if( !keep[ i ] )
+    {
+      holes.push_back( i );
+    }
+  }
+
+  // Rewriting cells one by one only pays off while few of them change.
+  if( ( added.size() + holes.size() ) * 2 > slot_cells_.size() )
+  {
+    update.rebuild = true;
+    update.removed = slot_cells_.size();
+    rebuild( cells );
+    return update;
+  }
+
+  for( uint32_t i = 0; i < holes.size(); i++ )
+  {
+    cell_slots_.erase( slot_cells_[ holes[ i ]] );
+  }
+
+  // New cells go into the holes first.
+  uint32_t next_added = 0;
+  uint32_t next_hole = 0;
+  for( ; next_hole < holes.size() && next_added < added.size(); next_hole++, next_added++ )
+  {
+    uint32_t slot = holes[ next_hole ];
+    slot_cells_[ slot ] = added[ next_added ];
+    cell_slots_[ added[ next_added ]] = slot;
+    update.changed.push_back( slot );
+  }
+
+  // Close the remaining holes with cells from the end, then drop the end.
+  // Holes are visited in ascending order, so #changed stays sorted.
+  uint32_t count = slot_cells_.size();
+  uint32_t last_hole = holes.size();
+  while( next_hole < last_hole )
+  {
+    uint32_t last = count - 1;
+    if( holes[ last_hole - 1 ] == last )
+    {
+      last_hole--;
+    }
+    else
+    {
+      uint32_t slot = holes[ next_hole++ ];
+      slot_cells_[ slot ] = slot_cells_[ last ];
+      cell_slots_[ slot_cells_[ slot ]] = slot;
+      update.changed.push_back( slot );
+    }
+    count--;
+  }
+  update.removed = slot_cells_.size() - count;
+  slot_cells_.resize( count );
+
+  // Whatever is left goes at the end.
+  update.first_added = count;
+  for( ; next_added < added.size(); next_added++ )
+  {
+    cell_slots_[ added[ next_added ]] = slot_cells_.size();
+    slot_cells_.push_back( added[ next_added ] );
+  }
+
+  return update;
+}
+
+} // namespace rviz
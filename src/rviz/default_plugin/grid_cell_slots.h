@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2012, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RVIZ_GRID_CELL_SLOTS_H
+#define RVIZ_GRID_CELL_SLOTS_H
+
+#include <cstddef>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/unordered_map.hpp>
+
+namespace rviz
+{
+
+/**
+ * \class GridCellSlots
+ * \brief Assigns grid cells to the points of a cloud across messages.
+ *
+ * This is the render-independent part of GridCellsDisplay: it keeps the cell
+ * drawn by each point ("slot") of the cloud, and works out the smallest set
+ * of point writes that turns the cells of one message into the next.
+ * Cells that stay keep their slot, new cells fill the slots of removed ones,
+ * and remaining holes are closed with cells moved from the end.
+ */
+class GridCellSlots
+{
+public:
+  /** @brief Coordinates of one cell, used to match cells between messages. */
+  struct Cell
+  {
+    double x, y, z;
+
+    bool operator==( const Cell& other ) const
+    {
+      return x == other.x && y == other.y && z == other.z;
+    }
+
+    friend std::size_t hash_value( const Cell& cell )
+    {
+      std::size_t seed = 0;
+      boost::hash_combine( seed, cell.x );
+      boost::hash_combine( seed, cell.y );
+      boost::hash_combine( seed, cell.z );
+      return seed;
+    }
+  };
+
+  /** @brief The point writes needed after assign(). */
+  struct Update
+  {
+    /** True if every slot was reassigned; the cloud must be rebuilt from scratch. */
+    bool rebuild;
+    /** Number of points to drop from the end of the cloud. */
+    uint32_t removed;
+    /** Slots whose cell changed, in ascending order. */
+    std::vector<uint32_t> changed;
+    /** Slots from this one to size() are new and go at the end of the cloud. */
+    uint32_t first_added;
+  };
+
+  /** @brief Drop all cells. */
+  void clear();
+
+  /**
+   * @brief Make @a cells the cells drawn, and return the point writes that takes.
+   *
+   * Duplicate cells are drawn once.  When more than half of the slots would
+   * change, the slots are reassigned in message order and Update::rebuild is set.
+   */
+  Update assign( const std::vector<Cell>& cells );
+
+  /** @brief Number of slots, i.e. points in the cloud. */
+  uint32_t size() const { return slot_cells_.size(); }
+
+  /** @brief The cell drawn by point @a slot of the cloud. */
+  const Cell& operator[]( uint32_t slot ) const { return slot_cells_[ slot ]; }
+
+private:
+  typedef boost::unordered_map<Cell, uint32_t> M_CellToSlot;
+
+  void rebuild( const std::vector<Cell>& cells );
+
+  M_CellToSlot cell_slots_;         ///< Cell -> its slot
+  std::vector<Cell> slot_cells_;    ///< Slot -> its cell
+};
+
+} // namespace rviz
+
+#endif // RVIZ_GRID_CELL_SLOTS_H
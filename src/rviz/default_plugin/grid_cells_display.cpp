@@ -63,13 +63,21 @@
 namespace rviz
 {
 
+static PointCloud::Point makePoint( const GridCellSlots::Cell& cell, const Ogre::ColourValue& color )
+{
+  PointCloud::Point point;
+  point.position = Ogre::Vector3( cell.x, cell.y, cell.z );
+  point.color = color;
+  return point;
+}
+
 GridCellsDisplay::GridCellsDisplay()
   : Display()
   , messages_received_(0)
-  , last_frame_count_( uint64_t( -1 ))
 {
   color_property_ = new ColorProperty( "Color", QColor( 25, 255, 0 ),
-                                       "Color of the grid cells.", this );
+                                       "Color of the grid cells.",
+                                       this, SLOT( updateColor() ));
 
   alpha_property_ = new FloatProperty( "Alpha", 1.0,
                                        "Amount of transparency to apply to the cells.",
@@ -143,6 +151,8 @@ GridCellsDisplay::~GridCellsDisplay()
 void GridCellsDisplay::clear()
 {
   cloud_->clear();
+  slots_.clear();
+  latest_msg_.reset();
 
   messages_received_ = 0;
   setStatus( StatusProperty::Warn, "Topic", "No messages received" );
@@ -161,6 +171,23 @@ void GridCellsDisplay::updateAlpha()
   context_->queueRender();
 }
 
+void GridCellsDisplay::updateColor()
+{
+  Ogre::ColourValue color = qtToOgre( color_property_->getColor() );
+  std::vector<uint32_t> slots( slots_.size() );
+  std::vector<PointCloud::Point> points( slots_.size() );
+  for( uint32_t i = 0; i < slots_.size(); i++ )
+  {
+    slots[ i ] = i;
+    points[ i ] = makePoint( slots_[ i ], color );
+  }
+  if( !points.empty() )
+  {
+    cloud_->updatePoints( &slots.front(), &points.front(), points.size() );
+  }
+  context_->queueRender();
+}
+
 void GridCellsDisplay::subscribe()
 {
   if ( !isEnabled() )
@@ -220,16 +247,27 @@ void GridCellsDisplay::incomingMessage( const nav_msgs::GridCells::ConstPtr& msg
 
   ++messages_received_;
 
-  if( context_->getFrameCount() == last_frame_count_ )
+  // Only the newest message is drawn; it is picked up by the next update(),
+  // so a burst of messages within one frame still ends on the last one.
+  latest_msg_ = msg;
+}
+
+void GridCellsDisplay::update( float wall_dt, float ros_dt )
+{
+  if( latest_msg_ )
   {
-    return;
+    nav_msgs::GridCells::ConstPtr msg;
+    msg.swap( latest_msg_ );
+    processMessage( msg );
   }
-  last_frame_count_ = context_->getFrameCount();
-
-  cloud_->clear();
+}
 
+void GridCellsDisplay::processMessage( const nav_msgs::GridCells::ConstPtr& msg )
+{
   if( !validateFloats( *msg ))
   {
+    cloud_->clear();
+    slots_.clear();
     setStatus( StatusProperty::Error, "Topic", "Message contained invalid floating point values (nans or infs)" );
     return;
   }
@@ -258,25 +296,51 @@ void GridCellsDisplay::incomingMessage( const nav_msgs::GridCells::ConstPtr& msg
 
   cloud_->setDimensions(msg->cell_width, msg->cell_height, 0.0);
 
-  Ogre::ColourValue color_int = qtToOgre( color_property_->getColor() );
-  uint32_t num_points = msg->cells.size();
+  updateCells( *msg );
+  context_->queueRender();
+}
 
-  typedef std::vector< PointCloud::Point > V_Point;
-  V_Point points;
-  points.resize( num_points );
-  for(uint32_t i = 0; i < num_points; i++)
+void GridCellsDisplay::updateCells( const nav_msgs::GridCells& msg )
+{
+  std::vector<GridCellSlots::Cell> cells( msg.cells.size() );
+  for( uint32_t i = 0; i < cells.size(); i++ )
   {
-    PointCloud::Point& current_point = points[ i ];
-    current_point.position.x = msg->cells[i].x;
-    current_point.position.y = msg->cells[i].y;
-    current_point.position.z = msg->cells[i].z;
-    current_point.color = color_int;
+    GridCellSlots::Cell cell = { msg.cells[i].x, msg.cells[i].y, msg.cells[i].z };
+    cells[ i ] = cell;
   }
 
-  cloud_->clear();
+  GridCellSlots::Update update = slots_.assign( cells );
+  Ogre::ColourValue color = qtToOgre( color_property_->getColor() );
+  if( update.rebuild )
+  {
+    cloud_->clear();
+  }
+  else
+  {
+    cloud_->popBackPoints( update.removed );
+
+    std::vector<PointCloud::Point> points( update.changed.size() );
+    for( uint32_t i = 0; i < points.size(); i++ )
+    {
+      points[ i ] = makePoint( slots_[ update.changed[ i ]], color );
+    }
+    if( !points.empty() )
+    {
+      cloud_->updatePoints( &update.changed.front(), &points.front(), points.size() );
+    }
+  }
 
-  if ( !points.empty() )
+  if( update.first_added < slots_.size() )
   {
+    std::vector<PointCloud::Point> points( slots_.size() - update.first_added );
+    for( uint32_t i = 0; i < points.size(); i++ )
+    {
+      points[ i ] = makePoint( slots_[ update.first_added + i ], color );
+    }
+
+    // Leave room to grow, so cells added by later messages append to the
+    // same renderable instead of each batch creating one.
+    cloud_->reserve( slots_.size() + slots_.size() / 2 );
     cloud_->addPoints( &points.front(), points.size() );
   }
 }
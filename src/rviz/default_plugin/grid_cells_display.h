@@ -43,6 +43,8 @@
 
 #include <boost/shared_ptr.hpp>
 
+#include "grid_cell_slots.h"
+
 namespace Ogre
 {
 class ManualObject;
@@ -72,6 +74,7 @@ public:
   // Overrides from Display
   virtual void fixedFrameChanged();
   virtual void reset();
+  virtual void update( float wall_dt, float ros_dt );
 
 protected:
   // overrides from Display
@@ -80,6 +83,7 @@ protected:
 
 private Q_SLOTS:
   void updateAlpha();
+  void updateColor();
   void updateTopic();
 
 private:
@@ -87,8 +91,14 @@ private:
   void unsubscribe();
   void clear();
   void incomingMessage( const nav_msgs::GridCells::ConstPtr& msg );
+  void processMessage( const nav_msgs::GridCells::ConstPtr& msg );
+
+  /** @brief Bring #cloud_ in line with the cells of @a msg, rewriting as few points as possible. */
+  void updateCells( const nav_msgs::GridCells& msg );
 
   PointCloud* cloud_;
+  GridCellSlots slots_;             ///< The cell drawn by each point of #cloud_
+  nav_msgs::GridCells::ConstPtr latest_msg_; ///< Newest message not drawn yet
 
   message_filters::Subscriber<nav_msgs::GridCells> sub_;
   tf::MessageFilter<nav_msgs::GridCells>* tf_filter_;
@@ -98,7 +108,6 @@ private:
   FloatProperty* alpha_property_;
 
   uint32_t messages_received_;
-  uint64_t last_frame_count_;
 };
 
 } // namespace rviz
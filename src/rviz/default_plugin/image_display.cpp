@@ -84,6 +84,7 @@ ImageDisplay::ImageDisplay()
                                                   this, SLOT( updateNormalizeOptions() ) );
 
   got_float_image_ = false;
+  force_render_ = true;
 }
 
 void ImageDisplay::onInitialize()
@@ -179,6 +180,7 @@ void ImageDisplay::updateNormalizeOptions()
 
     texture_.setNormalizeFloatImage( normalize, min_property_->getFloat(), max_property_->getFloat());
     texture_.setMedianFrames( median_buffer_size_property_->getInt() );
+    force_render_ = true;
   }
   else
   {
@@ -192,6 +194,7 @@ void ImageDisplay::updateNormalizeOptions()
 void ImageDisplay::clear()
 {
   texture_.clear();
+  force_render_ = true;
 
   if( render_panel_->getCamera() )
   {
@@ -205,7 +208,23 @@ void ImageDisplay::update( float wall_dt, float ros_dt )
   Q_UNUSED(ros_dt)
   try
   {
-    texture_.update();
+    if( texture_.update() )
+    {
+      force_render_ = true;
+    }
+
+    QSize panel_size = render_panel_->isVisible() ? render_panel_->size() : QSize();
+    if( panel_size != last_panel_size_ )
+    {
+      last_panel_size_ = panel_size;
+      force_render_ = true;
+    }
+
+    // Nothing changed, or nobody can see it: keep presenting the last frame.
+    if( !force_render_ || last_panel_size_.isEmpty() )
+    {
+      return;
+    }
 
     //make sure the aspect ratio of the image is preserved
     float win_width = render_panel_->width();
@@ -230,6 +249,7 @@ void ImageDisplay::update( float wall_dt, float ros_dt )
     }
 
     render_panel_->getRenderWindow()->update();
+    force_render_ = false;
   }
   catch( UnsupportedImageEncoding& e )
   {
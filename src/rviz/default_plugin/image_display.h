@@ -32,6 +32,7 @@
 
 #ifndef Q_MOC_RUN  // See: https://bugreports.qt-project.org/browse/QTBUG-22829
 # include <QObject>
+# include <QSize>
 
 # include <OgreMaterial.h>
 # include <OgreRenderTargetListener.h>
@@ -102,6 +103,12 @@ private:
   FloatProperty* max_property_;
   IntProperty* median_buffer_size_property_;
   bool got_float_image_;
+
+  /** @brief True if the panel contents are stale and must be rendered. */
+  bool force_render_;
+
+  /** @brief Panel size used for the current layout, empty while hidden. */
+  QSize last_panel_size_;
 };
 
 } // namespace rviz
@@ -58,6 +58,9 @@
 namespace rviz
 {
 
+// reduceDetail() goes no coarser than this many cells per texel.
+static const unsigned int MAX_DETAIL_STRIDE = 16;
+
 // helper class to set alpha parameter on all renderables.
 class AlphaSetter: public Ogre::Renderable::Visitor
 {
@@ -172,21 +175,54 @@ void Swatch::updateAlpha(const Ogre::SceneBlendType sceneBlending, bool depthWri
   }
 }
 
+unsigned int Swatch::getTextureSize( unsigned int stride ) const
+{
+  return ((width_ + stride - 1) / stride) * ((height_ + stride - 1) / stride);
+}
+
 void Swatch::updateData()
 {
-  unsigned int pixels_size = width_ * height_;
+  unsigned int stride = parent_->detail_stride_;
+  unsigned int tex_width = (width_ + stride - 1) / stride;
+  unsigned int tex_height = (height_ + stride - 1) / stride;
+  unsigned int pixels_size = tex_width * tex_height;
   unsigned char* pixels = new unsigned char[pixels_size];
   memset(pixels, 255, pixels_size);
   unsigned char* ptr = pixels;
   int N = parent_->current_map_.data.size();
   unsigned int fw = parent_->current_map_.info.width;
 
-  for(unsigned int yy=y_; yy<y_+height_;yy++){
-    int index = yy * fw + x_;
-    int pixels_to_copy = std::min((int)width_, N-index);
-    memcpy(ptr, &parent_->current_map_.data[ index ], pixels_to_copy);
-    ptr+=pixels_to_copy;
-    if(index+pixels_to_copy>=N) break;
+  if( stride == 1 )
+  {
+    for(unsigned int yy=y_; yy<y_+height_;yy++){
+      int index = yy * fw + x_;
+      int pixels_to_copy = std::min((int)width_, N-index);
+      memcpy(ptr, &parent_->current_map_.data[ index ], pixels_to_copy);
+      ptr+=pixels_to_copy;
+      if(index+pixels_to_copy>=N) break;
+    }
+  }
+  else
+  {
+    // Each texel shows the highest value of its block of cells, so
+    // obstacles stay visible at lower detail.
+    const std::vector<int8_t>& data = parent_->current_map_.data;
+    for(unsigned int ty=0; ty<tex_height; ty++){
+      for(unsigned int tx=0; tx<tex_width; tx++, ptr++){
+        int8_t value = -1;
+        bool found = false;
+        for(unsigned int yy=y_+ty*stride; yy<std::min(y_+(ty+1)*stride, y_+height_); yy++){
+          for(unsigned int xx=x_+tx*stride; xx<std::min(x_+(tx+1)*stride, x_+width_); xx++){
+            int index = yy * fw + xx;
+            if(index < N){
+              value = found ? std::max(value, data[ index ]) : data[ index ];
+              found = true;
+            }
+          }
+        }
+        if(found) *ptr = (unsigned char) value;
+      }
+    }
   }
 
   Ogre::DataStreamPtr pixel_stream;
@@ -202,7 +238,7 @@ void Swatch::updateData()
   std::stringstream ss;
   ss << "MapTexture" << tex_count++;
   texture_ = Ogre::TextureManager::getSingleton().loadRawData( ss.str(), Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME,
-                                                                 pixel_stream, width_, height_, Ogre::PF_L8, Ogre::TEX_TYPE_2D,
+                                                                 pixel_stream, tex_width, tex_height, Ogre::PF_L8, Ogre::TEX_TYPE_2D,
                                                                  0);
 
   delete[] pixels;
@@ -215,7 +251,12 @@ MapDisplay::MapDisplay()
   , resolution_( 0.0f )
   , width_( 0 )
   , height_( 0 )
+  , detail_stride_( 1 )
+  , prepared_( false )
+  , prepared_transform_ok_( false )
 {
+  setPrepareUpdateThreadSafe( true );
+
   connect(this, SIGNAL( mapUpdated() ), this, SLOT( showMap() ));
   topic_property_ = new RosTopicProperty( "Topic", "",
                                           QString::fromStdString( ros::message_traits::datatype<nav_msgs::OccupancyGrid>() ),
@@ -537,6 +578,48 @@ void MapDisplay::clear()
   }
 
   loaded_ = false;
+  detail_stride_ = 1;
+  updateMemoryUsage();
+}
+
+uint64_t MapDisplay::getTextureBytes( unsigned int stride ) const
+{
+  uint64_t bytes = 0;
+  for (unsigned i=0; i < swatches.size(); i++){
+    bytes += swatches[i]->getTextureSize( stride );
+  }
+  return bytes;
+}
+
+void MapDisplay::updateMemoryUsage()
+{
+  uint64_t gpu_bytes = loaded_ ? getTextureBytes( detail_stride_ ) : 0;
+  getStatistics().setMemoryUsage( "map", current_map_.data.size(), gpu_bytes );
+}
+
+bool MapDisplay::reduceDetail( uint64_t max_bytes )
+{
+  if( !loaded_ )
+  {
+    return false;
+  }
+
+  // The map itself has to stay for updates, only the textures shrink.
+  uint64_t cpu_bytes = current_map_.data.size();
+  unsigned int stride = detail_stride_;
+  while( cpu_bytes + getTextureBytes( stride ) > max_bytes && stride < MAX_DETAIL_STRIDE )
+  {
+    stride *= 2;
+  }
+
+  if( stride != detail_stride_ )
+  {
+    ROS_INFO( "Map '%s' is over its memory budget, showing %ux%u cells per texel",
+              qPrintable( getName() ), stride, stride );
+    detail_stride_ = stride;
+    showMap();
+  }
+  return cpu_bytes + getTextureBytes( stride ) <= max_bytes;
 }
 
 bool validateFloats(const nav_msgs::OccupancyGrid& msg)
@@ -549,10 +632,12 @@ bool validateFloats(const nav_msgs::OccupancyGrid& msg)
 
 void MapDisplay::incomingMap(const nav_msgs::OccupancyGrid::ConstPtr& msg)
 {
+  ros::WallTime start = ros::WallTime::now();
   current_map_ = *msg;
   // updated via signal in case ros spinner is in a different thread
   Q_EMIT mapUpdated();
   loaded_ = true;
+  getStatistics().addMessage( ros::WallTime::now() - start, msg->data.size() );
 }
 
 
@@ -743,6 +828,7 @@ void MapDisplay::showMap()
   orientation_property_->setQuaternion( orientation );
 
   transformMap();
+  updateMemoryUsage();
 
   context_->queueRender();
 }
@@ -769,13 +855,8 @@ void MapDisplay::updatePalette()
   updateAlpha();
 }
 
-void MapDisplay::transformMap()
+bool MapDisplay::lookupTransform( Ogre::Vector3& position, Ogre::Quaternion& orientation ) const
 {
-  if (!loaded_)
-  {
-    return;
-  }
-
   ros::Time transform_time;
 
   if (transform_timestamp_property_->getBool())
@@ -783,10 +864,13 @@ void MapDisplay::transformMap()
     transform_time = current_map_.header.stamp;
   }
 
-  Ogre::Vector3 position;
-  Ogre::Quaternion orientation;
-  if (!context_->getFrameManager()->transform(frame_, transform_time, current_map_.info.origin, position, orientation) &&
-      !context_->getFrameManager()->transform(frame_, ros::Time(0), current_map_.info.origin, position, orientation))
+  return context_->getFrameManager()->transform(frame_, transform_time, current_map_.info.origin, position, orientation) ||
+         context_->getFrameManager()->transform(frame_, ros::Time(0), current_map_.info.origin, position, orientation);
+}
+
+void MapDisplay::applyTransform( bool ok, const Ogre::Vector3& position, const Ogre::Quaternion& orientation )
+{
+  if (!ok)
   {
     ROS_DEBUG( "Error transforming map '%s' from frame '%s' to frame '%s'",
                qPrintable( getName() ), frame_.c_str(), qPrintable( fixed_frame_ ));
@@ -799,8 +883,25 @@ void MapDisplay::transformMap()
     setStatus(StatusProperty::Ok, "Transform", "Transform OK");
   }
 
-  scene_node_->setPosition( position );
-  scene_node_->setOrientation( orientation );
+  if( position != scene_node_->getPosition() || orientation != scene_node_->getOrientation() )
+  {
+    scene_node_->setPosition( position );
+    scene_node_->setOrientation( orientation );
+    context_->queueRender();
+  }
+}
+
+void MapDisplay::transformMap()
+{
+  if (!loaded_)
+  {
+    return;
+  }
+
+  Ogre::Vector3 position;
+  Ogre::Quaternion orientation;
+  bool ok = lookupTransform( position, orientation );
+  applyTransform( ok, position, orientation );
 }
 
 void MapDisplay::fixedFrameChanged()
@@ -822,8 +923,25 @@ void MapDisplay::setTopic( const QString &topic, const QString &datatype )
   topic_property_->setString( topic );
 }
 
+void MapDisplay::prepareUpdate( float wall_dt, float ros_dt )
+{
+  prepared_ = loaded_;
+  if( prepared_ )
+  {
+    prepared_transform_ok_ = lookupTransform( prepared_position_, prepared_orientation_ );
+  }
+}
+
 void MapDisplay::update( float wall_dt, float ros_dt ) {
-  transformMap();
+  if( prepared_ && loaded_ )
+  {
+    applyTransform( prepared_transform_ok_, prepared_position_, prepared_orientation_ );
+  }
+  else
+  {
+    transformMap();
+  }
+  prepared_ = false;
 }
 
 } // namespace rviz
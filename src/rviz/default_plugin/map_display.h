@@ -35,6 +35,7 @@
 
 #include <OgreTexture.h>
 #include <OgreMaterial.h>
+#include <OgreQuaternion.h>
 #include <OgreVector3.h>
 #include <OgreSharedPtr.h>
 #endif
@@ -73,7 +74,11 @@ friend class MapDisplay;
     Swatch(MapDisplay* parent, unsigned int x, unsigned int y, unsigned int width, unsigned int height, float resolution);
     ~Swatch();
     void updateAlpha(const Ogre::SceneBlendType sceneBlending, bool depthWrite, AlphaSetter* alpha_setter);
+    /** @brief Upload the cells of parent_->current_map_ into texture_,
+     * every parent_->detail_stride_-th one in each direction. */
     void updateData();
+    /** @brief Return the texture bytes at the given detail stride. */
+    unsigned int getTextureSize( unsigned int stride ) const;
 
   protected:
     MapDisplay* parent_;
@@ -108,6 +113,10 @@ public:
 
   virtual void setTopic( const QString &topic, const QString &datatype );
 
+  /** @brief Show the map with coarser textures until it fits in @a max_bytes.
+   * The detail stays low until the display is reset. */
+  virtual bool reduceDetail( uint64_t max_bytes );
+
 Q_SIGNALS:
   /** @brief Emitted when a new map is received*/
   void mapUpdated();
@@ -128,8 +137,17 @@ protected:
 
   virtual void subscribe();
   virtual void unsubscribe();
+  /** @brief Looks up the map pose on a worker thread for update(). */
+  virtual void prepareUpdate( float wall_dt, float ros_dt );
   virtual void update( float wall_dt, float ros_dt );
 
+  /** @brief Look up the pose of current_map_ in the fixed frame.
+   * Touches neither Ogre nor Qt, so it may run on a worker thread. */
+  bool lookupTransform( Ogre::Vector3& position, Ogre::Quaternion& orientation ) const;
+
+  /** @brief Move the map to a pose from lookupTransform() and report whether it was found. */
+  void applyTransform( bool ok, const Ogre::Vector3& position, const Ogre::Quaternion& orientation );
+
   /** @brief Copy msg into current_map_ and call showMap(). */
   void incomingMap(const nav_msgs::OccupancyGrid::ConstPtr& msg);
 
@@ -140,6 +158,12 @@ protected:
 
   void createSwatches();
 
+  /** @brief Return the bytes of all swatch textures at the given detail stride. */
+  uint64_t getTextureBytes( unsigned int stride ) const;
+
+  /** @brief Report the map and its textures to getStatistics(). */
+  void updateMemoryUsage();
+
   std::vector<Swatch*> swatches;
   std::vector<Ogre::TexturePtr> palette_textures_;
   std::vector<bool> color_scheme_transparency_;
@@ -151,6 +175,12 @@ protected:
   int height_;
   std::string frame_;
   nav_msgs::OccupancyGrid current_map_;
+  unsigned int detail_stride_;      ///< Cells per texel in each direction, raised by reduceDetail()
+
+  bool prepared_;                   ///< True if prepareUpdate() looked up the pose for this frame
+  bool prepared_transform_ok_;
+  Ogre::Vector3 prepared_position_;
+  Ogre::Quaternion prepared_orientation_;
 
   ros::Subscriber map_sub_;
   ros::Subscriber update_sub_;
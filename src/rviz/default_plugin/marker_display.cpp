@@ -27,9 +27,11 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <algorithm>
 #include <sstream>
 
-#include <tf/transform_listener.h>
+#include <OgreQuaternion.h>
+#include <OgreVector3.h>
 
 #include "rviz/default_plugin/markers/marker_base.h"
 #include "rviz/default_plugin/marker_utils.h"
@@ -50,10 +52,28 @@
 namespace rviz
 {
 
+// Markers processed per unit of deferred work.
+static const size_t MARKERS_PER_BATCH = 1000;
+
+// The Ogre objects of a marker are built from its message, so the
+// message size stands in for both.
+static uint64_t markerBytes( const MarkerBasePtr& marker )
+{
+  if( !marker || !marker->getMessage() )
+  {
+    return 0;
+  }
+  return ros::serialization::serializationLength( *marker->getMessage() );
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 MarkerDisplay::MarkerDisplay()
   : Display()
+  , next_marker_sequence_( 0 )
+  , marker_bytes_( 0 )
+  , memory_usage_changed_( false )
+  , batch_queued_( false )
 {
   marker_topic_property_ = new RosTopicProperty( "Marker Topic", "visualization_marker",
                                                  QString::fromStdString( ros::message_traits::datatype<visualization_msgs::Marker>() ),
@@ -73,21 +93,10 @@ MarkerDisplay::MarkerDisplay()
 
 void MarkerDisplay::onInitialize()
 {
-  // TODO(wjwwood): remove this and use tf2 interface instead
-#ifndef _WIN32
-# pragma GCC diagnostic push
-# pragma GCC diagnostic ignored "-Wdeprecated-declarations"
-#endif
-
-  auto tf_client = context_->getTFClient();
-
-#ifndef _WIN32
-# pragma GCC diagnostic pop
-#endif
-  tf_filter_ = new tf::MessageFilter<visualization_msgs::Marker>( *tf_client,
-                                                                  fixed_frame_.toStdString(),
-                                                                  queue_size_property_->getInt(),
-                                                                  update_nh_ );
+  tf_filter_ = new TransformMessageFilter<visualization_msgs::Marker>( *context_->getFrameManager()->getTransformScheduler(),
+                                                                       fixed_frame_.toStdString(),
+                                                                       queue_size_property_->getInt(),
+                                                                       update_nh_ );
 
   tf_filter_->connectInput(sub_);
   tf_filter_->registerCallback(boost::bind(&MarkerDisplay::incomingMarker, this, _1));
@@ -123,9 +132,16 @@ void MarkerDisplay::load(const Config& config)
 
 void MarkerDisplay::clearMarkers()
 {
+  {
+    boost::mutex::scoped_lock lock(queue_mutex_);
+    message_queue_.clear();
+  }
   markers_.clear();
   markers_with_expiration_.clear();
   frame_locked_markers_.clear();
+  marker_sequence_.clear();
+  marker_bytes_ = 0;
+  memory_usage_changed_ = true;
   tf_filter_->clear();
   namespaces_category_->removeChildren();
   namespaces_.clear();
@@ -196,7 +212,10 @@ void MarkerDisplay::deleteMarker(MarkerID id)
   {
     markers_with_expiration_.erase(it->second);
     frame_locked_markers_.erase(it->second);
+    marker_bytes_ -= markerBytes( it->second );
     markers_.erase(it);
+    marker_sequence_.erase( id );
+    memory_usage_changed_ = true;
   }
 }
 
@@ -258,6 +277,7 @@ void MarkerDisplay::deleteMarkerStatus(MarkerID id)
 
 void MarkerDisplay::incomingMarkerArray(const visualization_msgs::MarkerArray::ConstPtr& array)
 {
+  ros::WallTime start = ros::WallTime::now();
   std::vector<visualization_msgs::Marker>::const_iterator it = array->markers.begin();
   std::vector<visualization_msgs::Marker>::const_iterator end = array->markers.end();
   for (; it != end; ++it)
@@ -265,6 +285,7 @@ void MarkerDisplay::incomingMarkerArray(const visualization_msgs::MarkerArray::C
     const visualization_msgs::Marker& marker = *it;
     tf_filter_->add(visualization_msgs::Marker::Ptr(new visualization_msgs::Marker(marker)));
   }
+  getStatistics().addMessage(ros::WallTime::now() - start, ros::serialization::serializationLength(*array));
 }
 
 void MarkerDisplay::incomingMarker( const visualization_msgs::Marker::ConstPtr& marker )
@@ -274,7 +295,7 @@ void MarkerDisplay::incomingMarker( const visualization_msgs::Marker::ConstPtr&
   message_queue_.push_back(marker);
 }
 
-void MarkerDisplay::failedMarker(const ros::MessageEvent<visualization_msgs::Marker>& marker_evt, tf::FilterFailureReason reason)
+void MarkerDisplay::failedMarker(const ros::MessageEvent<visualization_msgs::Marker>& marker_evt, tf2_ros::FilterFailureReason reason)
 {
   visualization_msgs::Marker::ConstPtr marker = marker_evt.getConstMessage();
   if (marker->action == visualization_msgs::Marker::DELETE ||
@@ -283,21 +304,11 @@ void MarkerDisplay::failedMarker(const ros::MessageEvent<visualization_msgs::Mar
     return this->processMessage(marker);
   }
   std::string authority = marker_evt.getPublisherName();
-// TODO(wjwwood): remove this and use tf2 interface instead
-#ifndef _WIN32
-# pragma GCC diagnostic push
-# pragma GCC diagnostic ignored "-Wdeprecated-declarations"
-#endif
-
   std::string error = context_->getFrameManager()->discoverFailureReason(
     marker->header.frame_id,
     marker->header.stamp,
     authority,
     reason);
-
-#ifndef _WIN32
-# pragma GCC diagnostic pop
-#endif
   setMarkerStatus(MarkerID(marker->ns, marker->id), StatusProperty::Error, error);
 }
 
@@ -311,6 +322,32 @@ bool validateFloats(const visualization_msgs::Marker& msg)
   return valid;
 }
 
+bool MarkerDisplay::processMessageBatch()
+{
+  V_MarkerMessage batch;
+  bool done;
+
+  {
+    boost::mutex::scoped_lock lock(queue_mutex_);
+
+    V_MarkerMessage::iterator batch_end = message_queue_.begin() + std::min( message_queue_.size(), MARKERS_PER_BATCH );
+    batch.assign( message_queue_.begin(), batch_end );
+    message_queue_.erase( message_queue_.begin(), batch_end );
+
+    done = message_queue_.empty();
+    batch_queued_ = !done;
+  }
+
+  V_MarkerMessage::iterator message_it = batch.begin();
+  V_MarkerMessage::iterator message_end = batch.end();
+  for ( ; message_it != message_end; ++message_it )
+  {
+    processMessage( *message_it );
+  }
+
+  return done;
+}
+
 void MarkerDisplay::processMessage( const visualization_msgs::Marker::ConstPtr& message )
 {
   if ( !validateFloats( *message ))
@@ -380,6 +417,7 @@ void MarkerDisplay::processAdd( const visualization_msgs::Marker::ConstPtr& mess
   {
     marker = it->second;
     markers_with_expiration_.erase(marker);
+    marker_bytes_ -= markerBytes( marker );
     if ( message->type == marker->getMessage()->type )
     {
       create = false;
@@ -402,6 +440,9 @@ void MarkerDisplay::processAdd( const visualization_msgs::Marker::ConstPtr& mess
   if (marker)
   {
     marker->setMessage(message);
+    marker_bytes_ += markerBytes( marker );
+    marker_sequence_[ MarkerID( message->ns, message->id ) ] = next_marker_sequence_++;
+    memory_usage_changed_ = true;
 
     if (message->lifetime.toSec() > 0.0001f)
     {
@@ -426,24 +467,21 @@ void MarkerDisplay::processDelete( const visualization_msgs::Marker::ConstPtr& m
 
 void MarkerDisplay::update(float wall_dt, float ros_dt)
 {
-  V_MarkerMessage local_queue;
+  bool queue_batch = false;
 
   {
     boost::mutex::scoped_lock lock(queue_mutex_);
 
-    local_queue.swap( message_queue_ );
+    if ( !message_queue_.empty() && !batch_queued_ )
+    {
+      batch_queued_ = true;
+      queue_batch = true;
+    }
   }
 
-  if ( !local_queue.empty() )
+  if ( queue_batch )
   {
-    V_MarkerMessage::iterator message_it = local_queue.begin();
-    V_MarkerMessage::iterator message_end = local_queue.end();
-    for ( ; message_it != message_end; ++message_it )
-    {
-      visualization_msgs::Marker::ConstPtr& marker = *message_it;
-
-      processMessage( marker );
-    }
+    queueWork( boost::bind( &MarkerDisplay::processMessageBatch, this ));
   }
 
   {
@@ -470,9 +508,54 @@ void MarkerDisplay::update(float wall_dt, float ros_dt)
     for (; it != end; ++it)
     {
       MarkerBasePtr marker = *it;
+      Ogre::Vector3 position = marker->getPosition();
+      Ogre::Quaternion orientation = marker->getOrientation();
       marker->updateFrameLocked();
+      if( marker->getPosition() != position || marker->getOrientation() != orientation )
+      {
+        context_->queueRender();
+      }
     }
   }
+
+  if ( memory_usage_changed_ )
+  {
+    updateMemoryUsage();
+  }
+}
+
+void MarkerDisplay::updateMemoryUsage()
+{
+  getStatistics().setMemoryUsage( "markers", marker_bytes_, 0 );
+  memory_usage_changed_ = false;
+}
+
+void MarkerDisplay::reduceMemoryUsage( uint64_t max_bytes )
+{
+  typedef std::pair<uint64_t, MarkerID> SequenceAndID;
+  if ( marker_bytes_ <= max_bytes )
+  {
+    updateMemoryUsage();
+    return;
+  }
+
+  std::vector<SequenceAndID> by_age;
+  by_age.reserve( markers_.size() );
+  M_IDToMarker::const_iterator it = markers_.begin();
+  M_IDToMarker::const_iterator end = markers_.end();
+  for ( ; it != end; ++it )
+  {
+    by_age.push_back( SequenceAndID( marker_sequence_[ it->first ], it->first ));
+  }
+  std::sort( by_age.begin(), by_age.end() );
+
+  for ( size_t i = 0; i < by_age.size() && marker_bytes_ > max_bytes; i++ )
+  {
+    deleteMarker( by_age[ i ].second );
+  }
+
+  updateMemoryUsage();
+  context_->queueRender();
 }
 
 void MarkerDisplay::fixedFrameChanged()
@@ -37,7 +37,6 @@
 #include <boost/shared_ptr.hpp>
 
 #ifndef Q_MOC_RUN
-#include <tf/message_filter.h>
 #include <message_filters/subscriber.h>
 #endif
 
@@ -47,6 +46,7 @@
 #include "rviz/display.h"
 #include "rviz/properties/bool_property.h"
 #include "rviz/selection/forwards.h"
+#include "rviz/transform_message_filter.h"
 
 namespace rviz
 {
@@ -91,6 +91,9 @@ public:
 
   virtual void setTopic( const QString &topic, const QString &datatype );
 
+  /** @brief Delete the markers added longest ago until the rest fit in @a max_bytes. */
+  virtual void reduceMemoryUsage( uint64_t max_bytes );
+
 protected:
   virtual void onEnable();
   virtual void onDisable();
@@ -131,6 +134,13 @@ private:
    * @param message The message to process
    */
   void processMessage( const visualization_msgs::Marker::ConstPtr& message );
+  /**
+   * \brief Processes the next batch of queued marker messages.  Runs as
+   * deferred work, so large marker arrays are spread over several frames
+   * when a frame budget is set.
+   * @return true when the queue is empty
+   */
+  bool processMessageBatch();
   /**
    * \brief Processes an "Add" marker message
    * @param message The message to process
@@ -147,20 +157,29 @@ private:
    */
   void incomingMarker(const visualization_msgs::Marker::ConstPtr& marker);
 
-  void failedMarker(const ros::MessageEvent<visualization_msgs::Marker>& marker_evt, tf::FilterFailureReason reason);
+  void failedMarker(const ros::MessageEvent<visualization_msgs::Marker>& marker_evt, tf2_ros::FilterFailureReason reason);
+
+  /** @brief Report the messages of all markers to getStatistics(). */
+  void updateMemoryUsage();
 
   typedef std::map<MarkerID, MarkerBasePtr> M_IDToMarker;
   typedef std::set<MarkerBasePtr> S_MarkerBase;
   M_IDToMarker markers_;                                ///< Map of marker id to the marker info structure
   S_MarkerBase markers_with_expiration_;
   S_MarkerBase frame_locked_markers_;
+  typedef std::map<MarkerID, uint64_t> M_IDToSequence;
+  M_IDToSequence marker_sequence_;                      ///< When each marker was last added, for reduceMemoryUsage()
+  uint64_t next_marker_sequence_;
+  uint64_t marker_bytes_;                               ///< Message bytes of all markers, kept up to date as they are added and deleted
+  bool memory_usage_changed_;                           ///< Markers were added or deleted since the last updateMemoryUsage()
   typedef std::vector<visualization_msgs::Marker::ConstPtr> V_MarkerMessage;
   V_MarkerMessage message_queue_;                       ///< Marker message queue.  Messages are added to this as they are received, and then processed
                                                         ///< in our update() function
+  bool batch_queued_;                                   ///< True while processMessageBatch() is scheduled
   boost::mutex queue_mutex_;
 
   message_filters::Subscriber<visualization_msgs::Marker> sub_;
-  tf::MessageFilter<visualization_msgs::Marker>* tf_filter_;
+  TransformMessageFilter<visualization_msgs::Marker>* tf_filter_;
 
   typedef QHash<QString, MarkerNamespace*> M_Namespace;
   M_Namespace namespaces_;
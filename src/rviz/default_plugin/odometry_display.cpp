@@ -27,8 +27,7 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include "rviz/ogre_helpers/arrow.h"
-#include "rviz/ogre_helpers/axes.h"
+#include "rviz/ogre_helpers/glyph_ring.h"
 #include "rviz/properties/enum_property.h"
 #include "rviz/properties/color_property.h"
 #include "rviz/properties/float_property.h"
@@ -41,13 +40,15 @@
 
 #include "odometry_display.h"
 #include "covariance_property.h"
-#include "covariance_visual.h"
 
 namespace rviz
 {
 
 OdometryDisplay::OdometryDisplay()
+  : arrows_( NULL )
+  , axes_( NULL )
 {
+  setPrepareUpdateThreadSafe( true );
 
   position_tolerance_property_ = new FloatProperty( "Position Tolerance", .1,
                                                     "Distance, in meters from the last arrow dropped, "
@@ -111,11 +112,20 @@ OdometryDisplay::~OdometryDisplay()
   {
     clear();
   }
+  delete arrows_;
+  delete axes_;
 }
 
 void OdometryDisplay::onInitialize()
 {
   MFDClass::onInitialize();
+
+  arrows_ = new GlyphRing( scene_manager_, scene_node_, keep_property_->getInt() );
+  axes_ = new GlyphRing( scene_manager_, scene_node_, keep_property_->getInt() );
+  covariance_property_->setInstanceCapacity( keep_property_->getInt() );
+  covariance_property_->createInstances( scene_manager_, scene_node_ );
+  updateArrowsGeometry();
+  updateAxisGeometry();
   updateShapeChoice();
 }
 
@@ -127,24 +137,13 @@ void OdometryDisplay::onEnable()
 
 void OdometryDisplay::clear()
 {
-  D_Arrow::iterator it = arrows_.begin();
-  D_Arrow::iterator end = arrows_.end();
-  for ( ; it != end; ++it )
-  {
-    delete *it;
-  }
-  arrows_.clear();
+  arrows_->clear();
 
   // covariances are stored in covariance_property_
-  covariance_property_->clearVisual();
+  covariance_property_->clearInstances();
+  pending_poses_.clear();
 
-  D_Axes::iterator it_axes = axes_.begin();
-  D_Axes::iterator end_axes = axes_.end();
-  for ( ; it_axes != end_axes; ++it_axes )
-  {
-    delete *it_axes;
-  }
-  axes_.clear();
+  axes_->clear();
 
   if( last_used_message_ )
   {
@@ -154,58 +153,29 @@ void OdometryDisplay::clear()
 
 void OdometryDisplay::updateColorAndAlpha()
 {
-  QColor color = color_property_->getColor();
-  float red   = color.redF();
-  float green = color.greenF();
-  float blue  = color.blueF();
-  float alpha = alpha_property_->getFloat();
-
-  D_Arrow::iterator it = arrows_.begin();
-  D_Arrow::iterator end = arrows_.end();
-  for( ; it != end; ++it )
-  {
-    Arrow* arrow = *it;
-    arrow->setColor( red, green, blue, alpha );
-  }
+  Ogre::ColourValue color = color_property_->getOgreColor();
+  color.a = alpha_property_->getFloat();
+
+  arrows_->setColor( color );
   context_->queueRender();
 }
 
 void OdometryDisplay::updateArrowsGeometry()
 {
-  D_Arrow::iterator it = arrows_.begin();
-  D_Arrow::iterator end = arrows_.end();
-  for ( ; it != end; ++it )
-  {
-    updateGeometry(*it);
-  }
+  arrows_->setGlyph( GlyphRing::makeArrow( shaft_length_property_->getFloat(),
+                                           shaft_radius_property_->getFloat(),
+                                           head_length_property_->getFloat(),
+                                           head_radius_property_->getFloat() ));
   context_->queueRender();
 }
 
 void OdometryDisplay::updateAxisGeometry()
 {
-  D_Axes::iterator it = axes_.begin();
-  D_Axes::iterator end = axes_.end();
-  for ( ; it != end; ++it )
-  {
-    updateGeometry(*it);
-  }
+  axes_->setGlyph( GlyphRing::makeAxes( axes_length_property_->getFloat(),
+                                        axes_radius_property_->getFloat() ));
   context_->queueRender();
 }
 
-void OdometryDisplay::updateGeometry( Axes* axes )
-{
-    axes->set( axes_length_property_->getFloat(),
-              axes_radius_property_->getFloat() );
-}
-
-void OdometryDisplay::updateGeometry( Arrow* arrow )
-{
-    arrow->set( shaft_length_property_->getFloat(),
-                shaft_radius_property_->getFloat(),
-                head_length_property_->getFloat(),
-                head_radius_property_->getFloat() );
-}
-
 void OdometryDisplay::updateShapeChoice()
 {
   bool use_arrow = ( shape_property_->getOptionInt() == ArrowShape );
@@ -229,19 +199,8 @@ void OdometryDisplay::updateShapeVisibility()
 {
   bool use_arrow = (shape_property_->getOptionInt() == ArrowShape);
 
-  D_Arrow::iterator it = arrows_.begin();
-  D_Arrow::iterator end = arrows_.end();
-  for ( ; it != end; ++it )
-  {
-    (*it)->getSceneNode()->setVisible( use_arrow );
-  }
-
-  D_Axes::iterator it_axes = axes_.begin();
-  D_Axes::iterator end_axes = axes_.end();
-  for ( ; it_axes != end_axes; ++it_axes )
-  {
-    (*it_axes)->getSceneNode()->setVisible( !use_arrow );
-  }
+  arrows_->setVisible( use_arrow );
+  axes_->setVisible( !use_arrow );
 }
 
 bool validateFloats(const nav_msgs::Odometry& msg)
@@ -256,8 +215,6 @@ bool validateFloats(const nav_msgs::Odometry& msg)
 
 void OdometryDisplay::processMessage( const nav_msgs::Odometry::ConstPtr& message )
 {
-  typedef CovarianceProperty::CovarianceVisualPtr CovarianceVisualPtr;
-
   if( !validateFloats( *message ))
   {
     setStatus( StatusProperty::Error, "Topic", "Message contained invalid floating point values (nans or infs)" );
@@ -299,71 +256,50 @@ void OdometryDisplay::processMessage( const nav_msgs::Odometry::ConstPtr& messag
 
   // If we arrive here, we're good. Continue...
 
-  // Create a scene node, and attach the arrow and the covariance to it
-  Axes* axes = new Axes( scene_manager_, scene_node_,
-                         axes_length_property_->getFloat(),
-                         axes_radius_property_->getFloat() );
-  Arrow* arrow = new Arrow( scene_manager_, scene_node_,
-                            shaft_length_property_->getFloat(),
-                            shaft_radius_property_->getFloat(),
-                            head_length_property_->getFloat(),
-                            head_radius_property_->getFloat() );
-  CovarianceVisualPtr cov = covariance_property_->createAndPushBackVisual(scene_manager_, scene_node_ );
-
-  // Position the axes
-  axes->setPosition( position );
-  axes->setOrientation( orientation );
-
-  // Position the arrow. Remember the arrow points in -Z direction, so rotate the orientation before display.
-  arrow->setPosition( position );
-  arrow->setOrientation( orientation * Ogre::Quaternion( Ogre::Degree( -90 ), Ogre::Vector3::UNIT_Y ));
-
-  // Position the frame where the covariance is attached covariance
-  cov->setPosition( position );
-  cov->setOrientation( orientation );
-
-  // Set up arrow color
-  QColor color = color_property_->getColor();
-  float alpha = alpha_property_->getFloat();
-  arrow->setColor( color.redF(), color.greenF(), color.blueF(), alpha);
-
-  // Set up the covariance based on the message
-  cov->setCovariance(message->pose);
-
-  // Show/Hide things based on current properties
-  bool use_arrow = (shape_property_->getOptionInt() == ArrowShape);
-  arrow->getSceneNode()->setVisible( use_arrow );
-  axes->getSceneNode()->setVisible( !use_arrow );
-
-  // store everything
-  axes_.push_back( axes );
-  arrows_.push_back( arrow );
+  // The pose and its covariance go into the histories in update(),
+  // after the covariances of this frame were decomposed together.
+  Pose pose;
+  pose.position = position;
+  pose.orientation = orientation;
+  pending_poses_.push_back( pose );
+  covariance_property_->pushBackInstance( position, orientation, message->pose );
 
   last_used_message_ = message;
   context_->queueRender();
 }
 
+void OdometryDisplay::prepareUpdate( float wall_dt, float ros_dt )
+{
+  covariance_property_->prepareInstances();
+}
+
 void OdometryDisplay::update( float wall_dt, float ros_dt )
 {
   size_t keep = keep_property_->getInt();
-  if( keep > 0 )
+  arrows_->setCapacity( keep );
+  axes_->setCapacity( keep );
+  covariance_property_->setInstanceCapacity( keep );
+
+  std::vector<bool> valid;
+  covariance_property_->flushInstances( &valid );
+  assert( valid.size() == pending_poses_.size() );
+
+  // Record the poses in both histories; once they are full this
+  // overwrites the oldest entry in place.  The arrow glyph points along +X.
+  Ogre::ColourValue color = color_property_->getOgreColor();
+  color.a = alpha_property_->getFloat();
+  for( size_t i = 0; i < pending_poses_.size(); i++ )
   {
-    while( arrows_.size() > keep )
+    if( !valid[ i ] )
     {
-      delete arrows_.front();
-      arrows_.pop_front();
-
-      // covariance visuals are stored into covariance_property_
-      covariance_property_->popFrontVisual();
-
-      delete axes_.front();
-      axes_.pop_front();
+      continue;
     }
+    arrows_->push( pending_poses_[ i ].position, pending_poses_[ i ].orientation, Ogre::Vector3::UNIT_SCALE, color );
+    axes_->push( pending_poses_[ i ].position, pending_poses_[ i ].orientation, Ogre::Vector3::UNIT_SCALE, Ogre::ColourValue::White );
   }
+  pending_poses_.clear();
 
-  assert(arrows_.size() == axes_.size());
-  assert(axes_.size() == covariance_property_->sizeVisual());
-
+  assert(arrows_->size() == axes_->size());
 }
 
 void OdometryDisplay::reset()
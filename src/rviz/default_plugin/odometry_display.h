@@ -31,12 +31,15 @@
 #ifndef RVIZ_ODOMETRY_DISPLAY_H_
 #define RVIZ_ODOMETRY_DISPLAY_H_
 
-#include <deque>
+#include <vector>
 
 #include <boost/shared_ptr.hpp>
 #include <boost/thread/mutex.hpp>
 
 #ifndef Q_MOC_RUN
+#include <OgreQuaternion.h>
+#include <OgreVector3.h>
+
 #include <message_filters/subscriber.h>
 #endif
 
@@ -45,14 +48,13 @@
 
 namespace rviz
 {
-class Arrow;
-class Axes;
 class ColorProperty;
 class FloatProperty;
 class IntProperty;
 class EnumProperty;
 
 class CovarianceProperty;
+class GlyphRing;
 
 /**
  * \class OdometryDisplay
@@ -75,6 +77,8 @@ public:
   virtual void onInitialize();
   virtual void reset();
   // Overides of Display
+  /** @brief Decomposes the covariances received this frame, on a worker thread. */
+  virtual void prepareUpdate( float wall_dt, float ros_dt );
   virtual void update( float wall_dt, float ros_dt );
 
 protected:
@@ -89,17 +93,24 @@ private Q_SLOTS:
   void updateAxisGeometry();
 
 private:
-  void updateGeometry( rviz::Arrow* arrow );
-  void updateGeometry( rviz::Axes* axes );
   void clear();
 
   virtual void processMessage( const nav_msgs::Odometry::ConstPtr& message );
 
-  typedef std::deque<rviz::Arrow*> D_Arrow;
-  typedef std::deque<rviz::Axes*> D_Axes;
+  /** History of poses, drawn as one batch per shape.  The Keep
+   * property is the capacity of both rings. */
+  GlyphRing* arrows_;
+  GlyphRing* axes_;
 
-  D_Arrow arrows_;
-  D_Axes axes_;
+  /** Poses received since the last update().  They go into the rings
+   * together with their covariances, so a pose whose covariance cannot
+   * be shown is left out of every ring. */
+  struct Pose
+  {
+    Ogre::Vector3 position;
+    Ogre::Quaternion orientation;
+  };
+  std::vector<Pose> pending_poses_;
 
   nav_msgs::Odometry::ConstPtr last_used_message_;
 
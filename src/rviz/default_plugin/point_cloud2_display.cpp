@@ -30,6 +30,11 @@
 #include <OgreSceneNode.h>
 #include <OgreSceneManager.h>
 
+#include <deque>
+
+#include <boost/thread/mutex.hpp>
+#include <boost/weak_ptr.hpp>
+
 #include <ros/time.h>
 
 #include "rviz/default_plugin/point_cloud_common.h"
@@ -45,9 +50,69 @@
 namespace rviz
 {
 
+namespace
+{
+
+/** Results of the NaN filter for the last few clouds.  Displays
+ * sharing a subscription get the same message pointer, and the first
+ * of them filters it for all. */
+class FilteredCloudCache
+{
+public:
+  sensor_msgs::PointCloud2ConstPtr find( const sensor_msgs::PointCloud2ConstPtr& cloud )
+  {
+    boost::mutex::scoped_lock lock( mutex_ );
+    for( std::deque<Entry>::iterator it = entries_.begin(); it != entries_.end(); ++it )
+    {
+      if( it->input.lock() == cloud )
+      {
+        return it->output.lock();
+      }
+    }
+    return sensor_msgs::PointCloud2ConstPtr();
+  }
+
+  void add( const sensor_msgs::PointCloud2ConstPtr& cloud, const sensor_msgs::PointCloud2ConstPtr& filtered )
+  {
+    Entry entry;
+    entry.input = cloud;
+    entry.output = filtered;
+
+    boost::mutex::scoped_lock lock( mutex_ );
+    entries_.push_back( entry );
+    if( entries_.size() > MAX_ENTRIES )
+    {
+      entries_.pop_front();
+    }
+  }
+
+private:
+  static const size_t MAX_ENTRIES = 8;
+
+  // Weak, so the cache never keeps a cloud alive.
+  struct Entry
+  {
+    boost::weak_ptr<const sensor_msgs::PointCloud2> input;
+    boost::weak_ptr<const sensor_msgs::PointCloud2> output;
+  };
+
+  boost::mutex mutex_;
+  std::deque<Entry> entries_;
+};
+
+FilteredCloudCache& filteredCloudCache()
+{
+  static FilteredCloudCache cache;
+  return cache;
+}
+
+} // namespace
+
 PointCloud2Display::PointCloud2Display()
   : point_cloud_common_( new PointCloudCommon( this ))
 {
+  setPrepareUpdateThreadSafe( true );
+
   queue_size_property_ = new IntProperty( "Queue Size", 10,
                                           "Advanced: set the size of the incoming PointCloud2 message queue. "
                                           " Increasing this is useful if your incoming TF data is delayed significantly "
@@ -57,10 +122,17 @@ PointCloud2Display::PointCloud2Display()
   // PointCloudCommon sets up a callback queue with a thread for each
   // instance.  Use that for processing incoming messages.
   update_nh_.setCallbackQueue( point_cloud_common_->getCallbackQueue() );
+
+  // The NaN filtering below depends only on the message, so displays
+  // of the same cloud can share it.
+  setSharedSubscription( true );
 }
 
 PointCloud2Display::~PointCloud2Display()
 {
+  // Stop the shared filter from queueing into the callback queue of
+  // point_cloud_common_ before deleting it.
+  unsubscribe();
   delete point_cloud_common_;
 }
 
@@ -72,10 +144,26 @@ void PointCloud2Display::onInitialize()
 
 void PointCloud2Display::updateQueueSize()
 {
-  tf_filter_->setQueueSize( (uint32_t) queue_size_property_->getInt() );
+  setQueueSize( (uint32_t) queue_size_property_->getInt() );
 }
 
 void PointCloud2Display::processMessage( const sensor_msgs::PointCloud2ConstPtr& cloud )
+{
+  sensor_msgs::PointCloud2ConstPtr filtered = filteredCloudCache().find( cloud );
+  if( !filtered )
+  {
+    filtered = filterNaNs( cloud );
+    if( !filtered )
+    {
+      return;
+    }
+    filteredCloudCache().add( cloud, filtered );
+  }
+
+  point_cloud_common_->addMessage( filtered );
+}
+
+sensor_msgs::PointCloud2ConstPtr PointCloud2Display::filterNaNs( const sensor_msgs::PointCloud2ConstPtr& cloud )
 {
   // Filter any nan values out of the cloud.  Any nan values that make it through to PointCloudBase
   // will get their points put off in lala land, but it means they still do get processed/rendered
@@ -87,7 +175,7 @@ void PointCloud2Display::processMessage( const sensor_msgs::PointCloud2ConstPtr&
 
   if (xi == -1 || yi == -1 || zi == -1)
   {
-    return;
+    return sensor_msgs::PointCloud2ConstPtr();
   }
 
   const uint32_t xoff = cloud->fields[xi].offset;
@@ -102,7 +190,7 @@ void PointCloud2Display::processMessage( const sensor_msgs::PointCloud2ConstPtr&
     ss << "Data size (" << cloud->data.size() << " bytes) does not match width (" << cloud->width
        << ") times height (" << cloud->height << ") times point_step (" << point_step << ").  Dropping message.";
     setStatusStd( StatusProperty::Error, "Message", ss.str() );
-    return;
+    return sensor_msgs::PointCloud2ConstPtr();
   }
 
   filtered->data.resize(cloud->data.size());
@@ -161,15 +249,25 @@ void PointCloud2Display::processMessage( const sensor_msgs::PointCloud2ConstPtr&
   filtered->point_step = point_step;
   filtered->row_step = output_count;
 
-  point_cloud_common_->addMessage( filtered );
+  return filtered;
 }
 
 
+void PointCloud2Display::prepareUpdate( float wall_dt, float ros_dt )
+{
+  point_cloud_common_->prepareUpdate( wall_dt, ros_dt );
+}
+
 void PointCloud2Display::update( float wall_dt, float ros_dt )
 {
   point_cloud_common_->update( wall_dt, ros_dt );
 }
 
+void PointCloud2Display::reduceMemoryUsage( uint64_t max_bytes )
+{
+  point_cloud_common_->reduceMemoryUsage( max_bytes );
+}
+
 void PointCloud2Display::reset()
 {
   MFDClass::reset();
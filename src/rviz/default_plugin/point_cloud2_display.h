@@ -57,8 +57,11 @@ public:
 
   virtual void reset();
 
+  virtual void prepareUpdate( float wall_dt, float ros_dt );
   virtual void update( float wall_dt, float ros_dt );
 
+  virtual void reduceMemoryUsage( uint64_t max_bytes );
+
 private Q_SLOTS:
   void updateQueueSize();
 
@@ -69,6 +72,10 @@ protected:
   /** @brief Process a single message.  Overridden from MessageFilterDisplay. */
   virtual void processMessage( const sensor_msgs::PointCloud2ConstPtr& cloud );
 
+  /** @brief Return a copy of @a cloud without the points with NaN
+   * coordinates, or a null pointer if the cloud is unusable. */
+  sensor_msgs::PointCloud2ConstPtr filterNaNs( const sensor_msgs::PointCloud2ConstPtr& cloud );
+
   IntProperty* queue_size_property_;
 
   PointCloudCommon* point_cloud_common_;
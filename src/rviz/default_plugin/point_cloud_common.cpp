@@ -27,6 +27,10 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <algorithm>
+
+#include <boost/bind.hpp>
+
 #include <QColor>
 
 #include <OgreSceneManager.h>
@@ -40,9 +44,11 @@
 #include "rviz/default_plugin/point_cloud_transformer.h"
 #include "rviz/default_plugin/point_cloud_transformers.h"
 #include "rviz/display.h"
+#include "rviz/deferred_work_queue.h"
 #include "rviz/display_context.h"
 #include "rviz/frame_manager.h"
 #include "rviz/ogre_helpers/point_cloud.h"
+#include "rviz/plugin_index.h"
 #include "rviz/properties/bool_property.h"
 #include "rviz/properties/enum_property.h"
 #include "rviz/properties/float_property.h"
@@ -55,6 +61,9 @@
 namespace rviz
 {
 
+// Points added to a PointCloud per unit of deferred work.
+static const size_t POINTS_PER_UPLOAD = 100000;
+
 struct IndexAndMessage
 {
   IndexAndMessage( int _index, const void* _message )
@@ -293,6 +302,7 @@ void PointCloudSelectionHandler::onDeselect(const Picked& obj)
 PointCloudCommon::CloudInfo::CloudInfo()
 : manager_(0)
 , scene_node_(0)
+, uploaded_points_(0)
 {}
 
 PointCloudCommon::CloudInfo::~CloudInfo()
@@ -312,11 +322,13 @@ void PointCloudCommon::CloudInfo::clear()
 PointCloudCommon::PointCloudCommon( Display* display )
 : spinner_(1, &cbqueue_)
 , auto_size_(false)
+, upload_queued_(false)
 , new_xyz_transformer_(false)
 , new_color_transformer_(false)
 , needs_retransform_(false)
-, transformer_class_loader_(NULL)
+, prepared_retransform_(false)
 , display_( display )
+, context_( 0 )
 {
   selectable_property_ = new BoolProperty( "Selectable", true,
                                            "Whether or not the points in this point cloud are selectable.",
@@ -367,7 +379,6 @@ PointCloudCommon::PointCloudCommon( Display* display )
 
 void PointCloudCommon::initialize( DisplayContext* context, Ogre::SceneNode* scene_node )
 {
-  transformer_class_loader_ = new pluginlib::ClassLoader<PointCloudTransformer>( "rviz", "rviz::PointCloudTransformer" );
   loadTransformers();
 
   context_ = context;
@@ -385,21 +396,34 @@ PointCloudCommon::~PointCloudCommon()
 {
   spinner_.stop();
 
-  if ( transformer_class_loader_ )
+  if ( context_ && context_->getDeferredWorkQueue() )
   {
-    delete transformer_class_loader_;
+    context_->getDeferredWorkQueue()->removeOwner( this );
   }
 }
 
+/** @brief Return the transformer class loader shared by all point cloud displays.
+ *
+ * It is never deleted, so transformer libraries stay loaded as long as
+ * any transformer exists. */
+static pluginlib::ClassLoader<PointCloudTransformer>* getTransformerClassLoader()
+{
+  static pluginlib::ClassLoader<PointCloudTransformer>* loader =
+    new pluginlib::ClassLoader<PointCloudTransformer>( "rviz", "rviz::PointCloudTransformer", "plugin",
+                                                       PluginIndex::instance()->getPluginXmlPaths( "rviz" ));
+  return loader;
+}
+
 void PointCloudCommon::loadTransformers()
 {
-  std::vector<std::string> classes = transformer_class_loader_->getDeclaredClasses();
+  pluginlib::ClassLoader<PointCloudTransformer>* transformer_class_loader = getTransformerClassLoader();
+  std::vector<std::string> classes = transformer_class_loader->getDeclaredClasses();
   std::vector<std::string>::iterator ci;
   
   for( ci = classes.begin(); ci != classes.end(); ci++ )
   {
     const std::string& lookup_name = *ci;
-    std::string name = transformer_class_loader_->getName( lookup_name );
+    std::string name = transformer_class_loader->getName( lookup_name );
 
     if( transformers_.count( name ) > 0 )
     {
@@ -407,7 +431,7 @@ void PointCloudCommon::loadTransformers()
       continue;
     }
 
-    PointCloudTransformerPtr trans( transformer_class_loader_->createUnmanagedInstance( lookup_name ));
+    PointCloudTransformerPtr trans( transformer_class_loader->createUnmanagedInstance( lookup_name ));
     trans->init();
     connect( trans.get(), SIGNAL( needRetransform() ), this, SLOT( causeRetransform() ));
 
@@ -433,6 +457,10 @@ void PointCloudCommon::setAutoSize( bool auto_size )
   {
     cloud_infos_[i]->cloud_->setAutoSize( auto_size );
   }
+  for ( unsigned i=0; i<uploading_cloud_infos_.size(); i++ )
+  {
+    uploading_cloud_infos_[i]->cloud_->setAutoSize( auto_size );
+  }
 }
 
 
@@ -444,6 +472,11 @@ void PointCloudCommon::updateAlpha()
     bool per_point_alpha = findChannelIndex(cloud_infos_[i]->message_, "rgba") != -1;
     cloud_infos_[i]->cloud_->setAlpha( alpha_property_->getFloat(), per_point_alpha );
   }
+  for ( unsigned i=0; i<uploading_cloud_infos_.size(); i++ )
+  {
+    bool per_point_alpha = findChannelIndex(uploading_cloud_infos_[i]->message_, "rgba") != -1;
+    uploading_cloud_infos_[i]->cloud_->setAlpha( alpha_property_->getFloat(), per_point_alpha );
+  }
 }
 
 void PointCloudCommon::updateSelectable()
@@ -485,6 +518,10 @@ void PointCloudCommon::updateStyle()
   {
     cloud_infos_[i]->cloud_->setRenderMode( mode );
   }
+  for( unsigned int i = 0; i < uploading_cloud_infos_.size(); i++ )
+  {
+    uploading_cloud_infos_[i]->cloud_->setRenderMode( mode );
+  }
   updateBillboardSize();
 }
 
@@ -502,14 +539,22 @@ void PointCloudCommon::updateBillboardSize()
     cloud_infos_[i]->cloud_->setDimensions( size, size, size );
     cloud_infos_[i]->selection_handler_->setBoxSize( getSelectionBoxSize() );
   }
+  for ( unsigned i=0; i<uploading_cloud_infos_.size(); i++ )
+  {
+    uploading_cloud_infos_[i]->cloud_->setDimensions( size, size, size );
+  }
   context_->queueRender();
 }
 
 void PointCloudCommon::reset()
 {
-  boost::mutex::scoped_lock lock(new_clouds_mutex_);
-  cloud_infos_.clear();
-  new_cloud_infos_.clear();
+  {
+    boost::mutex::scoped_lock lock(new_clouds_mutex_);
+    cloud_infos_.clear();
+    new_cloud_infos_.clear();
+    uploading_cloud_infos_.clear();
+  }
+  updateMemoryUsage();
 }
 
 void PointCloudCommon::causeRetransform()
@@ -517,6 +562,15 @@ void PointCloudCommon::causeRetransform()
   needs_retransform_ = true;
 }
 
+void PointCloudCommon::prepareUpdate(float wall_dt, float ros_dt)
+{
+  prepared_retransform_ = needs_retransform_;
+  if (prepared_retransform_)
+  {
+    transformClouds();
+  }
+}
+
 void PointCloudCommon::update(float wall_dt, float ros_dt)
 {
   PointCloud::RenderMode mode = (PointCloud::RenderMode) style_property_->getOptionInt();
@@ -524,9 +578,14 @@ void PointCloudCommon::update(float wall_dt, float ros_dt)
   float point_decay_time = decay_time_property_->getFloat();
   if (needs_retransform_)
   {
+    if (!prepared_retransform_)
+    {
+      transformClouds();
+    }
     retransform();
     needs_retransform_ = false;
   }
+  prepared_retransform_ = false;
 
   // instead of deleting cloud infos, we just clear them
   // and put them into obsolete_cloud_infos, so active selections
@@ -534,11 +593,11 @@ void PointCloudCommon::update(float wall_dt, float ros_dt)
 
   ros::Time now = ros::Time::now();
 
-  // if decay time == 0, clear the old cloud when we get a new one
-  // otherwise, clear all the outdated ones
+  // if decay time == 0, showCloud() clears the old cloud when a new
+  // one is uploaded, otherwise, clear all the outdated ones
   {
     boost::mutex::scoped_lock lock(new_clouds_mutex_);
-    if ( point_decay_time > 0.0 || !new_cloud_infos_.empty() )
+    if ( point_decay_time > 0.0 )
     {
       while( !cloud_infos_.empty() && now.toSec() - cloud_infos_.front()->receive_time_.toSec() > point_decay_time )
       {
@@ -562,50 +621,67 @@ void PointCloudCommon::update(float wall_dt, float ros_dt)
     }
   }
 
+  V_CloudInfo new_cloud_infos;
   {
     boost::mutex::scoped_lock lock(new_clouds_mutex_);
-    if( !new_cloud_infos_.empty() )
+    new_cloud_infos.swap( new_cloud_infos_ );
+  }
+
+  if( !new_cloud_infos.empty() )
+  {
+    float size;
+    if( mode == PointCloud::RM_POINTS ) {
+      size = point_pixel_size_property_->getFloat();
+    } else {
+      size = point_world_size_property_->getFloat();
+    }
+
+    V_CloudInfo::iterator it = new_cloud_infos.begin();
+    V_CloudInfo::iterator end = new_cloud_infos.end();
+    for (; it != end; ++it)
     {
-      float size;
-      if( mode == PointCloud::RM_POINTS ) {
-        size = point_pixel_size_property_->getFloat();
-      } else {
-        size = point_world_size_property_->getFloat();
+      CloudInfoPtr cloud_info = *it;
+
+      V_CloudInfo::iterator next = it; next++;
+      // ignore point clouds that are too old, but keep at least one
+      if ( next != end && now.toSec() - cloud_info->receive_time_.toSec() > point_decay_time ) {
+        continue;
       }
 
-      V_CloudInfo::iterator it = new_cloud_infos_.begin();
-      V_CloudInfo::iterator end = new_cloud_infos_.end();
-      for (; it != end; ++it)
+      // without decay only the newest cloud is shown, so drop the ones
+      // still waiting to be uploaded, but finish the one in progress
+      if ( point_decay_time <= 0.0 )
       {
-        CloudInfoPtr cloud_info = *it;
-
-        V_CloudInfo::iterator next = it; next++;
-        // ignore point clouds that are too old, but keep at least one
-        if ( next != end && now.toSec() - cloud_info->receive_time_.toSec() > point_decay_time ) {
-          continue;
+        while ( !uploading_cloud_infos_.empty() && uploading_cloud_infos_.back()->uploaded_points_ == 0 )
+        {
+          uploading_cloud_infos_.pop_back();
         }
+      }
 
-        bool per_point_alpha = findChannelIndex(cloud_info->message_, "rgba") != -1;
-
-        cloud_info->cloud_.reset( new PointCloud() );
-        cloud_info->cloud_->setRenderMode( mode );
-        cloud_info->cloud_->addPoints( &(cloud_info->transformed_points_.front()), cloud_info->transformed_points_.size() );
-        cloud_info->cloud_->setAlpha( alpha_property_->getFloat(), per_point_alpha);
-        cloud_info->cloud_->setDimensions( size, size, size );
-        cloud_info->cloud_->setAutoSize(auto_size_);
-
-        cloud_info->manager_ = context_->getSceneManager();
-
-        cloud_info->scene_node_ = scene_node_->createChildSceneNode( cloud_info->position_, cloud_info->orientation_ );
+      bool per_point_alpha = findChannelIndex(cloud_info->message_, "rgba") != -1;
 
-        cloud_info->scene_node_->attachObject( cloud_info->cloud_.get() );
+      cloud_info->cloud_.reset( new PointCloud() );
+      cloud_info->cloud_->setRenderMode( mode );
+      cloud_info->cloud_->setAlpha( alpha_property_->getFloat(), per_point_alpha);
+      cloud_info->cloud_->setDimensions( size, size, size );
+      cloud_info->cloud_->setAutoSize(auto_size_);
+      cloud_info->uploaded_points_ = 0;
 
-        cloud_info->selection_handler_.reset( new PointCloudSelectionHandler( getSelectionBoxSize(), cloud_info.get(), context_ ));
+      uploading_cloud_infos_.push_back( cloud_info );
+    }
 
-        cloud_infos_.push_back(*it);
+    if ( !upload_queued_ && !uploading_cloud_infos_.empty() )
+    {
+      upload_queued_ = true;
+      DeferredWorkQueue* queue = context_->getDeferredWorkQueue();
+      if ( queue )
+      {
+        queue->add( this, boost::bind( &PointCloudCommon::uploadClouds, this ));
+      }
+      else
+      {
+        while ( !uploadClouds() ) {}
       }
-
-      new_cloud_infos_.clear();
     }
   }
 
@@ -634,6 +710,82 @@ void PointCloudCommon::update(float wall_dt, float ros_dt)
   }
 
   updateStatus();
+  updateMemoryUsage();
+}
+
+uint64_t PointCloudCommon::getMemoryUsage( const CloudInfoPtr& cloud_info, uint64_t& gpu_bytes ) const
+{
+  uint64_t cpu_bytes = cloud_info->transformed_points_.capacity() * sizeof( PointCloud::Point );
+  if ( cloud_info->message_ )
+  {
+    cpu_bytes += cloud_info->message_->data.size();
+  }
+  if ( cloud_info->cloud_ )
+  {
+    cpu_bytes += cloud_info->cloud_->getCpuMemoryUsage();
+    gpu_bytes += cloud_info->cloud_->getGpuMemoryUsage();
+  }
+  return cpu_bytes;
+}
+
+void PointCloudCommon::updateMemoryUsage()
+{
+  uint64_t cpu_bytes = 0;
+  uint64_t gpu_bytes = 0;
+  {
+    boost::mutex::scoped_lock lock(new_clouds_mutex_);
+    for ( D_CloudInfo::const_iterator it = cloud_infos_.begin(); it != cloud_infos_.end(); ++it )
+    {
+      cpu_bytes += getMemoryUsage( *it, gpu_bytes );
+    }
+  }
+  for ( D_CloudInfo::const_iterator it = uploading_cloud_infos_.begin(); it != uploading_cloud_infos_.end(); ++it )
+  {
+    cpu_bytes += getMemoryUsage( *it, gpu_bytes );
+  }
+  for ( L_CloudInfo::const_iterator it = obsolete_cloud_infos_.begin(); it != obsolete_cloud_infos_.end(); ++it )
+  {
+    cpu_bytes += getMemoryUsage( *it, gpu_bytes );
+  }
+  display_->getStatistics().setMemoryUsage( "points", cpu_bytes, gpu_bytes );
+}
+
+void PointCloudCommon::reduceMemoryUsage( uint64_t max_bytes )
+{
+  {
+    boost::mutex::scoped_lock lock(new_clouds_mutex_);
+    uint64_t bytes = 0;
+    for ( D_CloudInfo::const_iterator it = cloud_infos_.begin(); it != cloud_infos_.end(); ++it )
+    {
+      uint64_t gpu_bytes = 0;
+      bytes += getMemoryUsage( *it, gpu_bytes ) + gpu_bytes;
+    }
+
+    while ( cloud_infos_.size() > 1 && bytes > max_bytes )
+    {
+      uint64_t gpu_bytes = 0;
+      bytes -= getMemoryUsage( cloud_infos_.front(), gpu_bytes ) + gpu_bytes;
+      cloud_infos_.front()->clear();
+      obsolete_cloud_infos_.push_back( cloud_infos_.front() );
+      cloud_infos_.pop_front();
+    }
+  }
+
+  // Obsolete clouds are only kept for their selections.
+  for ( L_CloudInfo::iterator it = obsolete_cloud_infos_.begin(); it != obsolete_cloud_infos_.end(); )
+  {
+    if ( !(*it)->selection_handler_.get() || !(*it)->selection_handler_->hasSelections() )
+    {
+      it = obsolete_cloud_infos_.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+
+  updateMemoryUsage();
+  context_->queueRender();
 }
 
 void PointCloudCommon::setPropertiesHidden( const QList<Property*>& props, bool hide )
@@ -789,19 +941,90 @@ PointCloudTransformerPtr PointCloudCommon::getColorTransformer( const sensor_msg
 }
 
 
-void PointCloudCommon::retransform()
+bool PointCloudCommon::uploadClouds()
+{
+  if ( !uploading_cloud_infos_.empty() )
+  {
+    CloudInfoPtr cloud_info = uploading_cloud_infos_.front();
+    std::vector<PointCloud::Point>& points = cloud_info->transformed_points_;
+
+    size_t count = std::min( POINTS_PER_UPLOAD, points.size() - cloud_info->uploaded_points_ );
+    if ( count > 0 )
+    {
+      cloud_info->cloud_->addPoints( &points[ cloud_info->uploaded_points_ ], count );
+      cloud_info->uploaded_points_ += count;
+    }
+
+    if ( cloud_info->uploaded_points_ == points.size() )
+    {
+      uploading_cloud_infos_.pop_front();
+      showCloud( cloud_info );
+    }
+  }
+
+  upload_queued_ = !uploading_cloud_infos_.empty();
+  return !upload_queued_;
+}
+
+void PointCloudCommon::showCloud(const CloudInfoPtr& cloud_info)
+{
+  // if decay time == 0, clear the old cloud now that the new one is ready
+  if ( decay_time_property_->getFloat() <= 0.0 )
+  {
+    while( !cloud_infos_.empty() )
+    {
+      cloud_infos_.front()->clear();
+      obsolete_cloud_infos_.push_back( cloud_infos_.front() );
+      cloud_infos_.pop_front();
+    }
+  }
+
+  cloud_info->manager_ = context_->getSceneManager();
+
+  cloud_info->scene_node_ = scene_node_->createChildSceneNode( cloud_info->position_, cloud_info->orientation_ );
+
+  cloud_info->scene_node_->attachObject( cloud_info->cloud_.get() );
+
+  cloud_info->selection_handler_.reset( new PointCloudSelectionHandler( getSelectionBoxSize(), cloud_info.get(), context_ ));
+
+  cloud_infos_.push_back(cloud_info);
+  context_->queueRender();
+}
+
+void PointCloudCommon::transformClouds()
 {
   boost::recursive_mutex::scoped_lock lock(transformers_mutex_);
 
+  D_CloudInfo::iterator it = cloud_infos_.begin();
+  D_CloudInfo::iterator end = cloud_infos_.end();
+  for (; it != end; ++it)
+  {
+    transformCloud(*it, false);
+  }
+  for ( it = uploading_cloud_infos_.begin(); it != uploading_cloud_infos_.end(); ++it )
+  {
+    transformCloud(*it, false);
+  }
+}
+
+void PointCloudCommon::retransform()
+{
   D_CloudInfo::iterator it = cloud_infos_.begin();
   D_CloudInfo::iterator end = cloud_infos_.end();
   for (; it != end; ++it)
   {
     const CloudInfoPtr& cloud_info = *it;
-    transformCloud(cloud_info, false);
     cloud_info->cloud_->clear();
     cloud_info->cloud_->addPoints(&cloud_info->transformed_points_.front(), cloud_info->transformed_points_.size());
   }
+
+  // clouds being uploaded start over with the new points
+  for ( it = uploading_cloud_infos_.begin(); it != uploading_cloud_infos_.end(); ++it )
+  {
+    const CloudInfoPtr& cloud_info = *it;
+    cloud_info->cloud_->clear();
+    cloud_info->uploaded_points_ = 0;
+  }
 }
 
 bool PointCloudCommon::transformCloud(const CloudInfoPtr& cloud_info, bool update_transformers)
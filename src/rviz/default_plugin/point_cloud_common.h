@@ -105,6 +105,7 @@ public:
     PointCloudSelectionHandlerPtr selection_handler_;
 
     std::vector<PointCloud::Point> transformed_points_;
+    size_t uploaded_points_;   ///< Number of transformed_points_ already added to cloud_
 
     Ogre::Quaternion orientation_;
     Ogre::Vector3 position_;
@@ -123,11 +124,22 @@ public:
 
   void fixedFrameChanged();
   void reset();
+  /**
+   * \brief Transforms the clouds again if the fixed frame changed.  Only
+   * computes, so the owning display may call it on a worker thread.
+   */
+  void prepareUpdate(float wall_dt, float ros_dt);
   void update(float wall_dt, float ros_dt);
 
   void addMessage(const sensor_msgs::PointCloudConstPtr& cloud);
   void addMessage(const sensor_msgs::PointCloud2ConstPtr& cloud);
 
+  /**
+   * \brief Drop the oldest clouds until at most max_bytes are used, but
+   * keep showing the newest one.  See Display::reduceMemoryUsage().
+   */
+  void reduceMemoryUsage( uint64_t max_bytes );
+
   ros::CallbackQueueInterface* getCallbackQueue() { return &cbqueue_; }
 
   Display* getDisplay() { return display_; }
@@ -168,9 +180,35 @@ private:
   void processMessage(const sensor_msgs::PointCloud2ConstPtr& cloud);
   void updateStatus();
 
+  /**
+   * \brief Returns the main memory bytes of one cloud and adds its vertex buffer bytes to gpu_bytes
+   */
+  uint64_t getMemoryUsage( const CloudInfoPtr& cloud_info, uint64_t& gpu_bytes ) const;
+
+  /**
+   * \brief Reports the memory of all clouds to the display statistics
+   */
+  void updateMemoryUsage();
+
+  /**
+   * \brief Adds the next chunk of points of the uploading clouds to their
+   * PointCloud.  Runs as deferred work, so big clouds are uploaded over
+   * several frames when a frame budget is set.
+   * @return true when all clouds are uploaded
+   */
+  bool uploadClouds();
+
+  /**
+   * \brief Attaches a fully uploaded cloud to the scene
+   */
+  void showCloud(const CloudInfoPtr& cloud_info);
+
   PointCloudTransformerPtr getXYZTransformer(const sensor_msgs::PointCloud2ConstPtr& cloud);
   PointCloudTransformerPtr getColorTransformer(const sensor_msgs::PointCloud2ConstPtr& cloud);
   void updateTransformers( const sensor_msgs::PointCloud2ConstPtr& cloud );
+  /** \brief Recompute transformed_points_ of all clouds, without touching Ogre */
+  void transformClouds();
+  /** \brief Load the points from transformClouds() into the renderables */
   void retransform();
   void onTransformerOptions(V_string& ops, uint32_t mask);
 
@@ -192,6 +230,9 @@ private:
 
   L_CloudInfo obsolete_cloud_infos_;
 
+  D_CloudInfo uploading_cloud_infos_;   ///< Clouds being added to their PointCloud, shown when complete
+  bool upload_queued_;                  ///< True while uploadClouds() is scheduled
+
   struct TransformerInfo
   {
     PointCloudTransformerPtr transformer;
@@ -208,8 +249,7 @@ private:
   bool new_xyz_transformer_;
   bool new_color_transformer_;
   bool needs_retransform_;
-
-  pluginlib::ClassLoader<PointCloudTransformer>* transformer_class_loader_;
+  bool prepared_retransform_; ///< prepareUpdate() already transformed the clouds for retransform()
 
   Display* display_;
   DisplayContext* context_;
@@ -46,6 +46,8 @@ namespace rviz
 PointCloudDisplay::PointCloudDisplay()
   : point_cloud_common_( new PointCloudCommon( this ))
 {
+  setPrepareUpdateThreadSafe( true );
+
   queue_size_property_ = new IntProperty( "Queue Size", 10,
                                           "Advanced: set the size of the incoming PointCloud message queue. "
                                           " Increasing this is useful if your incoming TF data is delayed significantly "
@@ -55,10 +57,14 @@ PointCloudDisplay::PointCloudDisplay()
   // PointCloudCommon sets up a callback queue with a thread for each
   // instance.  Use that for processing incoming messages.
   update_nh_.setCallbackQueue( point_cloud_common_->getCallbackQueue() );
+  setSharedSubscription( true );
 }
 
 PointCloudDisplay::~PointCloudDisplay()
 {
+  // Stop the shared filter from queueing into the callback queue of
+  // point_cloud_common_ before deleting it.
+  unsubscribe();
   delete point_cloud_common_;
 }
 
@@ -70,7 +76,7 @@ void PointCloudDisplay::onInitialize()
 
 void PointCloudDisplay::updateQueueSize()
 {
-  tf_filter_->setQueueSize( (uint32_t) queue_size_property_->getInt() );
+  setQueueSize( (uint32_t) queue_size_property_->getInt() );
 }
 
 void PointCloudDisplay::processMessage( const sensor_msgs::PointCloudConstPtr& cloud )
@@ -78,11 +84,21 @@ void PointCloudDisplay::processMessage( const sensor_msgs::PointCloudConstPtr& c
   point_cloud_common_->addMessage( cloud );
 }
 
+void PointCloudDisplay::prepareUpdate( float wall_dt, float ros_dt )
+{
+  point_cloud_common_->prepareUpdate( wall_dt, ros_dt );
+}
+
 void PointCloudDisplay::update( float wall_dt, float ros_dt )
 {
   point_cloud_common_->update( wall_dt, ros_dt );
 }
 
+void PointCloudDisplay::reduceMemoryUsage( uint64_t max_bytes )
+{
+  point_cloud_common_->reduceMemoryUsage( max_bytes );
+}
+
 void PointCloudDisplay::reset()
 {
   MFDClass::reset();
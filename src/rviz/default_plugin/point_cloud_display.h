@@ -61,8 +61,11 @@ public:
 
   virtual void reset();
 
+  virtual void prepareUpdate( float wall_dt, float ros_dt );
   virtual void update( float wall_dt, float ros_dt );
 
+  virtual void reduceMemoryUsage( uint64_t max_bytes );
+
 private Q_SLOTS:
   void updateQueueSize();
 
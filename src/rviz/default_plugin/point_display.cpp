@@ -7,8 +7,7 @@
 #include <rviz/properties/int_property.h>
 #include <rviz/frame_manager.h>
 #include <rviz/validate_floats.h>
-
-#include "point_visual.h"
+#include <rviz/ogre_helpers/glyph_ring.h>
 
 #include "point_display.h"
 
@@ -16,6 +15,7 @@ namespace rviz
 {
 
     PointStampedDisplay::PointStampedDisplay()
+      : points_( NULL )
     {
 	color_property_ =
 	    new rviz::ColorProperty( "Color", QColor(204, 41, 204),
@@ -43,38 +43,37 @@ namespace rviz
     void PointStampedDisplay::onInitialize()
     {
         MFDClass::onInitialize();
+        points_ = new rviz::GlyphRing( context_->getSceneManager(), scene_node_ );
+        updateColorAndAlpha();
         updateHistoryLength();
     }
 
     PointStampedDisplay::~PointStampedDisplay()
     {
+        delete points_;
     }
 
-    // Clear the visuals by deleting their objects.
+    // Clear the history of points.
     void PointStampedDisplay::reset()
     {
         MFDClass::reset();
-        visuals_.clear();
+        points_->clear();
     }
 
     // Set the current color and alpha values for each visual.
     void PointStampedDisplay::updateColorAndAlpha()
     {
-        float alpha = alpha_property_->getFloat();
-        float radius = radius_property_->getFloat();
         Ogre::ColourValue color = color_property_->getOgreColor();
+        color.a = alpha_property_->getFloat();
 
-        for( size_t i = 0; i < visuals_.size(); i++ )
-	{
-            visuals_[i]->setColor( color.r, color.g, color.b, alpha );
-            visuals_[i]->setRadius( radius );
-        }
+        points_->setGlyph( rviz::GlyphRing::makeSphere( radius_property_->getFloat() ));
+        points_->setColor( color );
     }
 
-    // Set the number of past visuals to show.
+    // Set the number of past points to show.
     void PointStampedDisplay::updateHistoryLength()
     {
-        visuals_.rset_capacity(history_length_property_->getInt());
+        points_->setCapacity( history_length_property_->getInt() );
     }
 
     // This is our callback to handle an incoming message.
@@ -101,32 +100,12 @@ namespace rviz
             return;
         }
 
-        // We are keeping a circular buffer of visual pointers.  This gets
-        // the next one, or creates and stores it if the buffer is not full
-        boost::shared_ptr<PointStampedVisual> visual;
-        if( visuals_.full() )
-            {
-                visual = visuals_.front();
-            }
-        else
-            {
-                visual.reset(new PointStampedVisual( context_->getSceneManager(), scene_node_ ));
-            }
-
-
-        // Now set or update the contents of the chosen visual.
-        visual->setMessage( msg );
-        visual->setFramePosition( position );
-        visual->setFrameOrientation( orientation );
-        float alpha = alpha_property_->getFloat();
-        float radius = radius_property_->getFloat();
+        // The ring overwrites its oldest point once it holds History
+        // Length of them, so this does not allocate in steady state.
+        Ogre::Vector3 point( msg->point.x, msg->point.y, msg->point.z );
         Ogre::ColourValue color = color_property_->getOgreColor();
-        visual->setColor( color.r,  color.g,  color.b, alpha);
-        visual->setRadius( radius );
-
-
-        // And send it to the end of the circular buffer
-        visuals_.push_back(visual);
+        color.a = alpha_property_->getFloat();
+        points_->push( position + orientation * point, orientation, Ogre::Vector3::UNIT_SCALE, color );
     }
 
 } // end namespace rviz
@@ -1,10 +1,6 @@
 #ifndef POINT_DISPLAY_H
 #define POINT_DISPLAY_H
 
-#ifndef Q_MOC_RUN
-#include <boost/circular_buffer.hpp>
-#endif
-
 #include <geometry_msgs/PointStamped.h>
 #include <rviz/message_filter_display.h>
 
@@ -18,14 +14,13 @@ namespace rviz
 {
     class ColorProperty;
     class FloatProperty;
+    class GlyphRing;
     class IntProperty;
 }
 
 namespace rviz
 {
 
-    class PointStampedVisual;
-
     class PointStampedDisplay: public rviz::MessageFilterDisplay<geometry_msgs::PointStamped>
     {
     Q_OBJECT
@@ -49,9 +44,9 @@ namespace rviz
     private:
 	void processMessage( const geometry_msgs::PointStamped::ConstPtr& msg );
 
-        // Storage for the list of visuals.  It is a circular buffer where
-        // data gets popped from the front (oldest) and pushed to the back (newest)
-        boost::circular_buffer<boost::shared_ptr<PointStampedVisual> > visuals_;
+        // History of points, drawn in a single batch.  Its capacity is
+        // the History Length property.
+        rviz::GlyphRing* points_;
 
 	// Property objects for user-editable properties.
 	rviz::ColorProperty *color_property_;
@@ -18,6 +18,9 @@ namespace rviz
 {
 
 
+// Deprecated: PointStampedDisplay now draws its history with rviz::GlyphRing and no
+// longer uses this class.  It is kept for code built against it.
+//
 // Each instance of PointStampedVisual represents the visualization of a single
 // sensor_msgs::Point message.  Currently it just shows an arrow with
 // the direction and magnitude of the acceleration vector, but could
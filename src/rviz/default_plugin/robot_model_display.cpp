@@ -53,11 +53,41 @@ void linkUpdaterStatusFunction( StatusProperty::Level level,
   display->setStatus( level, QString::fromStdString( link_name ), QString::fromStdString( text ));
 }
 
+class RobotModelDisplay::PreparedLinkUpdater: public LinkUpdater
+{
+public:
+  PreparedLinkUpdater( const M_LinkTransform& links )
+    : links_( links )
+  {
+  }
+
+  virtual bool getLinkTransforms( const std::string& link_name, Ogre::Vector3& visual_position, Ogre::Quaternion& visual_orientation,
+                                  Ogre::Vector3& collision_position, Ogre::Quaternion& collision_orientation ) const
+  {
+    M_LinkTransform::const_iterator it = links_.find( link_name );
+    if( it == links_.end() )
+    {
+      return false;
+    }
+    visual_position = it->second.visual_position;
+    visual_orientation = it->second.visual_orientation;
+    collision_position = it->second.collision_position;
+    collision_orientation = it->second.collision_orientation;
+    return true;
+  }
+
+private:
+  const M_LinkTransform& links_;
+};
+
 RobotModelDisplay::RobotModelDisplay()
   : Display()
   , has_new_transforms_( false )
   , time_since_last_transform_( 0.0f )
+  , prepared_( false )
 {
+  setPrepareUpdateThreadSafe( true );
+
   visual_enabled_property_ = new Property( "Visual Enabled", true,
                                            "Whether to display the visual representation of the robot.",
                                            this, SLOT( updateVisualVisible() ));
@@ -210,22 +240,68 @@ void RobotModelDisplay::onDisable()
   clear();
 }
 
+bool RobotModelDisplay::needsTransforms( float wall_dt ) const
+{
+  float rate = update_rate_property_->getFloat();
+  return has_new_transforms_ || rate < 0.0001f || time_since_last_transform_ + wall_dt >= rate;
+}
+
+void RobotModelDisplay::prepareUpdate( float wall_dt, float ros_dt )
+{
+  prepared_ = false;
+  prepared_links_.clear();
+
+  if( !needsTransforms( wall_dt ))
+  {
+    return;
+  }
+
+  // The status callback only touches the thread-safe status table.
+  TFLinkUpdater updater( context_->getFrameManager(),
+                         boost::bind( linkUpdaterStatusFunction, _1, _2, _3, this ),
+                         tf_prefix_property_->getStdString() );
+
+  const Robot::M_NameToLink& links = robot_->getLinks();
+  Robot::M_NameToLink::const_iterator it = links.begin();
+  Robot::M_NameToLink::const_iterator end = links.end();
+  for( ; it != end; ++it )
+  {
+    LinkTransform transform;
+    if( updater.getLinkTransforms( it->first, transform.visual_position, transform.visual_orientation,
+                                   transform.collision_position, transform.collision_orientation ))
+    {
+      prepared_links_[ it->first ] = transform;
+    }
+  }
+
+  prepared_ = true;
+}
+
 void RobotModelDisplay::update( float wall_dt, float ros_dt )
 {
+  bool update = needsTransforms( wall_dt );
   time_since_last_transform_ += wall_dt;
-  float rate = update_rate_property_->getFloat();
-  bool update = rate < 0.0001f || time_since_last_transform_ >= rate;
 
-  if( has_new_transforms_ || update )
+  if( update )
   {
-    robot_->update( TFLinkUpdater( context_->getFrameManager(),
-                                   boost::bind( linkUpdaterStatusFunction, _1, _2, _3, this ),
-                                   tf_prefix_property_->getStdString() ));
+    if( prepared_ )
+    {
+      robot_->update( PreparedLinkUpdater( prepared_links_ ));
+    }
+    else
+    {
+      robot_->update( TFLinkUpdater( context_->getFrameManager(),
+                                     boost::bind( linkUpdaterStatusFunction, _1, _2, _3, this ),
+                                     tf_prefix_property_->getStdString() ));
+    }
     context_->queueRender();
 
     has_new_transforms_ = false;
     time_since_last_transform_ = 0.0f;
   }
+
+  prepared_ = false;
+  prepared_links_.clear();
 }
 
 void RobotModelDisplay::fixedFrameChanged()
@@ -32,9 +32,11 @@
 
 #include "rviz/display.h"
 
+#include <OgreQuaternion.h>
 #include <OgreVector3.h>
 
 #include <map>
+#include <string>
 
 namespace Ogre
 {
@@ -68,6 +70,9 @@ public:
 
   // Overrides from Display
   virtual void onInitialize();
+  /** @brief Looks up the transforms of all links if update() is going
+   * to move them.  Runs on a worker thread. */
+  virtual void prepareUpdate( float wall_dt, float ros_dt );
   virtual void update( float wall_dt, float ros_dt );
   virtual void fixedFrameChanged();
   virtual void reset();
@@ -91,12 +96,31 @@ protected:
   virtual void onEnable();
   virtual void onDisable();
 
+  /** @brief Whether update() should move the links this frame. */
+  bool needsTransforms( float wall_dt ) const;
+
+  /** @brief The transforms of one link, as looked up by prepareUpdate(). */
+  struct LinkTransform
+  {
+    Ogre::Vector3 visual_position;
+    Ogre::Quaternion visual_orientation;
+    Ogre::Vector3 collision_position;
+    Ogre::Quaternion collision_orientation;
+  };
+  typedef std::map<std::string, LinkTransform> M_LinkTransform;
+
+  /** @brief Hands the transforms in prepared_links_ to Robot::update(). */
+  class PreparedLinkUpdater;
+
   Robot* robot_;                 ///< Handles actually drawing the robot
 
   bool has_new_transforms_;      ///< Callback sets this to tell our update function it needs to update the transforms
 
   float time_since_last_transform_;
 
+  bool prepared_;                 ///< True if prepareUpdate() filled prepared_links_ for this frame
+  M_LinkTransform prepared_links_; ///< Links with a transform, by name
+
   std::string robot_description_;
 
   Property* visual_enabled_property_;
@@ -161,8 +161,11 @@ typedef std::set<FrameInfo*> S_FrameInfo;
 TFDisplay::TFDisplay()
   : Display()
   , update_timer_( 0.0f )
+  , prepared_( false )
   , changing_single_frame_enabled_state_( false )
 {
+  setPrepareUpdateThreadSafe( true );
+
   show_names_property_ = new BoolProperty( "Show Names", true, "Whether or not names should be shown next to the frames.",
                                            this, SLOT( updateShowNames() ));
 
@@ -341,6 +344,56 @@ void TFDisplay::allEnabledChanged()
   }
 }
 
+TFDisplay::FrameTransform::FrameTransform()
+  : has_transform( false )
+  , position( Ogre::Vector3::ZERO )
+  , orientation( Ogre::Quaternion::IDENTITY )
+  , has_parent( false )
+  , relative_position( Ogre::Vector3::ZERO )
+  , relative_orientation( Ogre::Quaternion::IDENTITY )
+  , parent_position( Ogre::Vector3::ZERO )
+{
+}
+
+void TFDisplay::prepareUpdate(float wall_dt, float ros_dt)
+{
+  prepared_ = false;
+  prepared_frames_.clear();
+  prepared_transforms_.clear();
+
+  // Only look up frames if update() is going to use them.
+  float update_rate = update_rate_property_->getFloat();
+  if( update_rate >= 0.0001f && update_timer_ + wall_dt <= update_rate )
+  {
+    return;
+  }
+
+  // TODO(wjwwood): remove this and use tf2 interface instead
+#ifndef _WIN32
+# pragma GCC diagnostic push
+# pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+#endif
+
+  context_->getTFClient()->getFrameStrings( prepared_frames_ );
+
+#ifndef _WIN32
+# pragma GCC diagnostic pop
+#endif
+  std::sort(prepared_frames_.begin(), prepared_frames_.end());
+
+  std::vector<std::string>::const_iterator it = prepared_frames_.begin();
+  std::vector<std::string>::const_iterator end = prepared_frames_.end();
+  for ( ; it != end; ++it )
+  {
+    if ( !it->empty() )
+    {
+      lookupFrame( *it, prepared_transforms_[ *it ] );
+    }
+  }
+
+  prepared_ = true;
+}
+
 void TFDisplay::update(float wall_dt, float ros_dt)
 {
   update_timer_ += wall_dt;
@@ -368,20 +421,31 @@ void TFDisplay::updateFrames()
 {
   typedef std::vector<std::string> V_string;
   V_string frames;
-  // TODO(wjwwood): remove this and use tf2 interface instead
+  if ( prepared_ )
+  {
+    frames.swap( prepared_frames_ );
+  }
+  else
+  {
+    // TODO(wjwwood): remove this and use tf2 interface instead
 #ifndef _WIN32
 # pragma GCC diagnostic push
 # pragma GCC diagnostic ignored "-Wdeprecated-declarations"
 #endif
 
-  context_->getTFClient()->getFrameStrings( frames );
+    context_->getTFClient()->getFrameStrings( frames );
 
 #ifndef _WIN32
 # pragma GCC diagnostic pop
 #endif
-  std::sort(frames.begin(), frames.end());
+    std::sort(frames.begin(), frames.end());
+  }
 
   S_FrameInfo current_frames;
+  bool changed = false;
+
+  // Properties of new frames are added to the tree all at once.
+  QList<Property*> new_frame_properties;
 
   {
     V_string::iterator it = frames.begin();
@@ -399,16 +463,26 @@ void TFDisplay::updateFrames()
       if (!info)
       {
         info = createFrame(frame);
+        new_frame_properties.push_back( info->enabled_property_ );
+        changed = true;
       }
       else
       {
+        Ogre::Vector3 position = info->axes_->getPosition();
+        Ogre::Quaternion orientation = info->axes_->getOrientation();
         updateFrame(info);
+        if( info->axes_->getPosition() != position || info->axes_->getOrientation() != orientation )
+        {
+          changed = true;
+        }
       }
 
       current_frames.insert( info );
     }
   }
 
+  frames_category_->addChildren( new_frame_properties );
+
   {
     S_FrameInfo to_delete;
     M_FrameInfo::iterator frame_it = frames_.begin();
@@ -426,10 +500,17 @@ void TFDisplay::updateFrames()
     for ( ; delete_it != delete_end; ++delete_it )
     {
       deleteFrame( *delete_it, true );
+      changed = true;
     }
   }
 
-  context_->queueRender();
+  prepared_ = false;
+  prepared_transforms_.clear();
+
+  if( changed )
+  {
+    context_->queueRender();
+  }
 }
 
 static const Ogre::ColourValue ARROW_HEAD_COLOR(1.0f, 0.1f, 0.6f, 1.0f);
@@ -458,8 +539,9 @@ FrameInfo* TFDisplay::createFrame(const std::string& frame)
   info->parent_arrow_->setHeadColor(ARROW_HEAD_COLOR);
   info->parent_arrow_->setShaftColor(ARROW_SHAFT_COLOR);
 
+  // Not added to frames_category_ yet, updateFrames() adds all new frames at once.
   info->enabled_property_ = new BoolProperty( QString::fromStdString( info->name_ ), true, "Enable or disable this individual frame.",
-                                              frames_category_, SLOT( updateVisibilityFromFrame() ), info );
+                                              NULL, SLOT( updateVisibilityFromFrame() ), info );
 
   info->parent_property_ = new StringProperty( "Parent", "", "Parent of this frame.  (Not editable)",
                                                info->enabled_property_ );
@@ -502,7 +584,7 @@ Ogre::ColourValue lerpColor(const Ogre::ColourValue& start, const Ogre::ColourVa
   return start * t + end * (1 - t);
 }
 
-void TFDisplay::updateFrame( FrameInfo* frame )
+void TFDisplay::lookupFrame( const std::string& frame, FrameTransform& transform ) const
 {
   // TODO(wjwwood): remove this and use tf2 interface instead
 #ifndef _WIN32
@@ -516,9 +598,63 @@ void TFDisplay::updateFrame( FrameInfo* frame )
 # pragma GCC diagnostic pop
 #endif
 
+  tf->getLatestCommonTime( fixed_frame_.toStdString(), frame, transform.latest_time, 0 );
+
+  transform.has_transform = context_->getFrameManager()->getTransform( frame, ros::Time(), transform.position, transform.orientation );
+  if( !transform.has_transform )
+  {
+    return;
+  }
+
+  transform.has_parent = tf->getParent( frame, ros::Time(), transform.parent );
+  if( !transform.has_parent )
+  {
+    return;
+  }
+
+  try
+  {
+    tf::StampedTransform relative;
+    tf->lookupTransform( transform.parent, frame, ros::Time(0), relative );
+
+    transform.relative_position = Ogre::Vector3( relative.getOrigin().x(), relative.getOrigin().y(), relative.getOrigin().z() );
+    transform.relative_orientation = Ogre::Quaternion( relative.getRotation().w(), relative.getRotation().x(),
+                                                       relative.getRotation().y(), relative.getRotation().z() );
+  }
+  catch(tf::TransformException& e)
+  {
+    ROS_DEBUG( "Error transforming frame '%s' (parent of '%s') to frame '%s'",
+               transform.parent.c_str(), frame.c_str(), qPrintable( fixed_frame_ ));
+  }
+
+  if( show_arrows_property_->getBool() )
+  {
+    Ogre::Quaternion parent_orientation;
+    if (!context_->getFrameManager()->getTransform(transform.parent, ros::Time(), transform.parent_position, parent_orientation))
+    {
+      ROS_DEBUG( "Error transforming frame '%s' (parent of '%s') to frame '%s'",
+                 transform.parent.c_str(), frame.c_str(), qPrintable( fixed_frame_ ));
+    }
+  }
+}
+
+void TFDisplay::updateFrame( FrameInfo* frame )
+{
+  // Use the lookups done by prepareUpdate() if there are any.
+  FrameTransform looked_up;
+  const FrameTransform* transform = &looked_up;
+  M_FrameTransform::const_iterator prepared_it = prepared_transforms_.find( frame->name_ );
+  if( prepared_it != prepared_transforms_.end() )
+  {
+    transform = &prepared_it->second;
+  }
+  else
+  {
+    lookupFrame( frame->name_, looked_up );
+  }
+
   // Check last received time so we can grey out/fade out frames that have stopped being published
-  ros::Time latest_time;
-  tf->getLatestCommonTime( fixed_frame_.toStdString(), frame->name_, latest_time, 0 );
+  const ros::Time& latest_time = transform->latest_time;
 
   if(( latest_time != frame->last_time_to_fixed_ ) ||
      ( latest_time == ros::Time() ))
@@ -574,9 +710,9 @@ void TFDisplay::updateFrame( FrameInfo* frame )
 
   setStatusStd(StatusProperty::Ok, frame->name_, "Transform OK");
 
-  Ogre::Vector3 position;
-  Ogre::Quaternion orientation;
-  if( !context_->getFrameManager()->getTransform( frame->name_, ros::Time(), position, orientation ))
+  const Ogre::Vector3& position = transform->position;
+  const Ogre::Quaternion& orientation = transform->orientation;
+  if( !transform->has_transform )
   {
     std::stringstream ss;
     ss << "No transform from [" << frame->name_ << "] to frame [" << fixed_frame_.toStdString() << "]";
@@ -607,8 +743,8 @@ void TFDisplay::updateFrame( FrameInfo* frame )
   frame->orientation_property_->setQuaternion( orientation );
 
   std::string old_parent = frame->parent_;
-  frame->parent_.clear();
-  bool has_parent = tf->getParent( frame->name_, ros::Time(), frame->parent_ );
+  frame->parent_ = transform->parent;
+  bool has_parent = transform->has_parent;
   if( has_parent )
   {
     // If this frame has no tree property or the parent has changed,
@@ -635,44 +771,15 @@ void TFDisplay::updateFrame( FrameInfo* frame )
       }
     }
 
-    tf::StampedTransform transform;
-    try {
-      // TODO(wjwwood): remove this and use tf2 interface instead
-#ifndef _WIN32
-# pragma GCC diagnostic push
-# pragma GCC diagnostic ignored "-Wdeprecated-declarations"
-#endif
-
-      auto tf_client = context_->getFrameManager()->getTFClientPtr();
-
-#ifndef _WIN32
-# pragma GCC diagnostic pop
-#endif
-      tf_client->lookupTransform(frame->parent_,frame->name_,ros::Time(0),transform);
-    }
-    catch(tf::TransformException& e)
-    {
-      ROS_DEBUG( "Error transforming frame '%s' (parent of '%s') to frame '%s'",
-                 frame->parent_.c_str(), frame->name_.c_str(), qPrintable( fixed_frame_ ));
-    }
-
     // get the position/orientation relative to the parent frame
-    Ogre::Vector3 relative_position( transform.getOrigin().x(), transform.getOrigin().y(), transform.getOrigin().z() );
-    Ogre::Quaternion relative_orientation( transform.getRotation().w(), transform.getRotation().x(), transform.getRotation().y(), transform.getRotation().z() );
+    const Ogre::Vector3& relative_position = transform->relative_position;
+    const Ogre::Quaternion& relative_orientation = transform->relative_orientation;
     frame->rel_position_property_->setVector( relative_position );
     frame->rel_orientation_property_->setQuaternion( relative_orientation );
 
     if( show_arrows_property_->getBool() )
     {
-      Ogre::Vector3 parent_position;
-      Ogre::Quaternion parent_orientation;
-      if (!context_->getFrameManager()->getTransform(frame->parent_, ros::Time(), parent_position, parent_orientation))
-      {
-        ROS_DEBUG( "Error transforming frame '%s' (parent of '%s') to frame '%s'",
-                   frame->parent_.c_str(), frame->name_.c_str(), qPrintable( fixed_frame_ ));
-      }
-
-      Ogre::Vector3 direction = parent_position - position;
+      Ogre::Vector3 direction = transform->parent_position - position;
       float distance = direction.length();
       direction.normalise();
 
@@ -32,6 +32,8 @@
 
 #include <map>
 #include <set>
+#include <string>
+#include <vector>
 
 #include <OgreQuaternion.h>
 #include <OgreVector3.h>
@@ -68,6 +70,9 @@ public:
   TFDisplay();
   virtual ~TFDisplay();
 
+  /** @brief Looks up the transforms of all frames.  Runs on a worker
+   * thread, the results are applied to the scene by update(). */
+  virtual void prepareUpdate(float wall_dt, float ros_dt);
   virtual void update(float wall_dt, float ros_dt);
 
 protected:
@@ -84,6 +89,26 @@ private Q_SLOTS:
   void allEnabledChanged();
 
 private:
+  /** @brief Result of the tf lookups for one frame. */
+  struct FrameTransform
+  {
+    FrameTransform();
+
+    ros::Time latest_time;            ///< Latest common time with the fixed frame
+    bool has_transform;               ///< Whether position and orientation are valid
+    Ogre::Vector3 position;
+    Ogre::Quaternion orientation;
+    bool has_parent;
+    std::string parent;
+    Ogre::Vector3 relative_position;
+    Ogre::Quaternion relative_orientation;
+    Ogre::Vector3 parent_position;    ///< Only looked up when arrows are shown
+  };
+  typedef std::map<std::string, FrameTransform> M_FrameTransform;
+
+  /** @brief Do all tf lookups for @a frame.  Only reads tf and properties, so it is thread-safe. */
+  void lookupFrame(const std::string& frame, FrameTransform& transform) const;
+
   void updateFrames();
   FrameInfo* createFrame(const std::string& frame);
   void updateFrame(FrameInfo* frame);
@@ -110,6 +135,10 @@ private:
 
   float update_timer_;
 
+  bool prepared_;                               ///< True if prepareUpdate() did the lookups for the next updateFrames()
+  std::vector<std::string> prepared_frames_;
+  M_FrameTransform prepared_transforms_;
+
   BoolProperty* show_names_property_;
   BoolProperty* show_arrows_property_;
   BoolProperty* show_axes_property_;
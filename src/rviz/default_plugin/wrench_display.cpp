@@ -8,17 +8,36 @@
 #include <rviz/properties/int_property.h>
 #include <rviz/properties/parse_color.h>
 #include <rviz/validate_floats.h>
+#include <rviz/ogre_helpers/glyph_ring.h>
 
 #include <boost/foreach.hpp>
 
-#include "wrench_visual.h"
-
 #include "wrench_display.h"
 
 namespace rviz
 {
 
+namespace
+{
+
+// Rotation taking @a from onto @a direction, or identity if @a direction
+// is too short to define one.
+Ogre::Quaternion rotationTo( const Ogre::Vector3& from, const Ogre::Vector3& direction )
+{
+    Ogre::Quaternion rotation = from.getRotationTo( direction );
+    if( direction.isZeroLength() || rotation.isNaN() )
+    {
+        return Ogre::Quaternion::IDENTITY;
+    }
+    return rotation;
+}
+
+} // namespace
+
 WrenchStampedDisplay::WrenchStampedDisplay()
+  : force_arrows_( NULL )
+  , torque_arrows_( NULL )
+  , torque_arcs_( NULL )
 {
     force_color_property_ =
             new rviz::ColorProperty( "Force Color", QColor( 204, 51, 51 ),
@@ -68,45 +87,71 @@ WrenchStampedDisplay::WrenchStampedDisplay()
 void WrenchStampedDisplay::onInitialize()
 {
     MFDClass::onInitialize();
+
+    // Same proportions as the default rviz::Arrow; the message sets the
+    // length and width of each instance.
+    force_arrows_ = new rviz::GlyphRing( context_->getSceneManager(), scene_node_ );
+    force_arrows_->setGlyph( rviz::GlyphRing::makeArrow( 1.0f, 0.1f, 0.3f, 0.2f ));
+    torque_arrows_ = new rviz::GlyphRing( context_->getSceneManager(), scene_node_ );
+    torque_arrows_->setGlyph( rviz::GlyphRing::makeArrow( 1.0f, 0.1f, 0.3f, 0.2f ));
+    torque_arcs_ = new rviz::GlyphRing( context_->getSceneManager(), scene_node_ );
+
+    updateProperties();
     updateHistoryLength( );
 }
 
 WrenchStampedDisplay::~WrenchStampedDisplay()
 {
+    delete force_arrows_;
+    delete torque_arrows_;
+    delete torque_arcs_;
 }
 
 // Override rviz::Display's reset() function to add a call to clear().
 void WrenchStampedDisplay::reset()
 {
     MFDClass::reset();
-    visuals_.clear();
+    wrenches_.clear();
+    force_arrows_->clear();
+    torque_arrows_->clear();
+    torque_arcs_->clear();
 }
 
 void WrenchStampedDisplay::updateProperties()
 {
-    float alpha = alpha_property_->getFloat();
-    float force_scale = force_scale_property_->getFloat();
-    float torque_scale = torque_scale_property_->getFloat();
+    force_arrows_->clear();
+    torque_arrows_->clear();
+    torque_arcs_->clear();
+
+    // The torque arc, drawn for a torque of unit length: a circle of
+    // radius 1/4 at height 1/2 along the torque axis, with an arrow head
+    // showing the direction of rotation.  Instances are scaled uniformly
+    // by the torque length; the tube and the head keep their width.
     float width = width_property_->getFloat();
-    bool hide_small_values = hide_small_values_property_->getBool();
-    Ogre::ColourValue force_color = force_color_property_->getOgreColor();
-    Ogre::ColourValue torque_color = torque_color_property_->getOgreColor();
-
-    for( size_t i = 0; i < visuals_.size(); i++ )
+    rviz::GlyphRing::V_Vertex arc = rviz::GlyphRing::makeArc( 0.25f, width * 0.05f,
+                                                              Ogre::Math::PI / 4, Ogre::Math::TWO_PI );
+    rviz::GlyphRing::appendUnscaledGlyph( arc, rviz::GlyphRing::makeArrow( 0, 0, width * 0.1f, width * 0.2f ),
+                                          Ogre::Vector3( 0.25f, 0, 0 ),
+                                          Ogre::Quaternion( Ogre::Degree( 90 ), Ogre::Vector3::UNIT_Z ));
+    rviz::GlyphRing::V_Vertex torque_arc;
+    rviz::GlyphRing::appendGlyph( torque_arc, arc, Ogre::Vector3( 0, 0, 0.5f ), Ogre::Quaternion::IDENTITY );
+    torque_arcs_->setGlyph( torque_arc );
+
+    // Redraw the history with the new scales, width, colors and hiding.
+    for( size_t i = 0; i < wrenches_.size(); i++ )
     {
-        visuals_[i]->setForceColor( force_color.r, force_color.g, force_color.b, alpha );
-        visuals_[i]->setTorqueColor( torque_color.r, torque_color.g, torque_color.b, alpha );
-        visuals_[i]->setForceScale( force_scale );
-        visuals_[i]->setTorqueScale( torque_scale );
-        visuals_[i]->setWidth( width );
-        visuals_[i]->setHideSmallValues( hide_small_values );
+        pushWrench( wrenches_[i] );
     }
 }
 
-// Set the number of past visuals to show.
+// Set the number of past wrenches to show.
 void WrenchStampedDisplay::updateHistoryLength()
 {
-    visuals_.rset_capacity(history_length_property_->getInt());
+    size_t history_length = history_length_property_->getInt();
+    wrenches_.rset_capacity( history_length );
+    force_arrows_->setCapacity( history_length );
+    torque_arrows_->setCapacity( history_length );
+    torque_arcs_->setCapacity( history_length );
 }
 
 
@@ -144,36 +189,40 @@ void WrenchStampedDisplay::processMessage( const geometry_msgs::WrenchStamped::C
         return;
     }
 
-    // We are keeping a circular buffer of visual pointers.  This gets
-    // the next one, or creates and stores it if the buffer is not full
-    boost::shared_ptr<WrenchVisual> visual;
-    if( visuals_.full() )
-    {
-        visual = visuals_.front();
-    }
-    else
-    {
-        visual.reset(new WrenchVisual( context_->getSceneManager(), scene_node_ ));
-    }
+    Wrench wrench;
+    wrench.position = position;
+    wrench.orientation = orientation;
+    wrench.force = Ogre::Vector3( msg->wrench.force.x, msg->wrench.force.y, msg->wrench.force.z );
+    wrench.torque = Ogre::Vector3( msg->wrench.torque.x, msg->wrench.torque.y, msg->wrench.torque.z );
+    wrenches_.push_back( wrench );
+    pushWrench( wrench );
+}
 
-    // Now set or update the contents of the chosen visual.
-    visual->setWrench( msg->wrench );
-    visual->setFramePosition( position );
-    visual->setFrameOrientation( orientation );
-    float alpha = alpha_property_->getFloat();
-    float force_scale = force_scale_property_->getFloat();
-    float torque_scale = torque_scale_property_->getFloat();
+void WrenchStampedDisplay::pushWrench( const Wrench& wrench )
+{
+    float force_length = wrench.force.length() * force_scale_property_->getFloat();
+    float torque_length = wrench.torque.length() * torque_scale_property_->getFloat();
     float width = width_property_->getFloat();
+    bool hide_small_values = hide_small_values_property_->getBool();
+    bool show_force = ( force_length > width ) || !hide_small_values;
+    bool show_torque = ( torque_length > width ) || !hide_small_values;
+
     Ogre::ColourValue force_color = force_color_property_->getOgreColor();
     Ogre::ColourValue torque_color = torque_color_property_->getOgreColor();
-    visual->setForceColor( force_color.r, force_color.g, force_color.b, alpha );
-    visual->setTorqueColor( torque_color.r, torque_color.g, torque_color.b, alpha );
-    visual->setForceScale( force_scale );
-    visual->setTorqueScale( torque_scale );
-    visual->setWidth( width );
-
-    // And send it to the end of the circular buffer
-    visuals_.push_back(visual);
+    force_color.a = alpha_property_->getFloat();
+    torque_color.a = alpha_property_->getFloat();
+
+    // Every wrench takes one slot in each ring so that they all age out
+    // together; hidden parts are pushed with a zero scale.
+    force_arrows_->push( wrench.position, wrench.orientation * rotationTo( Ogre::Vector3::UNIT_X, wrench.force ),
+                         show_force ? Ogre::Vector3( force_length, width, width ) : Ogre::Vector3::ZERO,
+                         force_color );
+    torque_arrows_->push( wrench.position, wrench.orientation * rotationTo( Ogre::Vector3::UNIT_X, wrench.torque ),
+                          show_torque ? Ogre::Vector3( torque_length, width, width ) : Ogre::Vector3::ZERO,
+                          torque_color );
+    torque_arcs_->push( wrench.position, wrench.orientation * rotationTo( Ogre::Vector3::UNIT_Z, wrench.torque ),
+                        show_torque ? Ogre::Vector3( torque_length ) : Ogre::Vector3::ZERO,
+                        torque_color );
 }
 
 } // end namespace rviz
@@ -5,6 +5,9 @@
 #include <boost/circular_buffer.hpp>
 #endif
 
+#include <OgreQuaternion.h>
+#include <OgreVector3.h>
+
 #include <geometry_msgs/WrenchStamped.h>
 #include <rviz/message_filter_display.h>
 
@@ -18,14 +21,13 @@ namespace rviz
 class ColorProperty;
 class ROSTopicStringProperty;
 class FloatProperty;
+class GlyphRing;
 class IntProperty;
 }
 
 namespace rviz
 {
 
-class WrenchVisual;
-
 class WrenchStampedDisplay: public rviz::MessageFilterDisplay<geometry_msgs::WrenchStamped>
 {
     Q_OBJECT
@@ -49,10 +51,27 @@ private:
     // Function to handle an incoming ROS message.
     void processMessage( const geometry_msgs::WrenchStamped::ConstPtr& msg );
 
-    // Storage for the list of visuals par each joint intem
-    // Storage for the list of visuals.  It is a circular buffer where
-    // data gets popped from the front (oldest) and pushed to the back (newest)
-    boost::circular_buffer<boost::shared_ptr<WrenchVisual> > visuals_;
+    // A received wrench, in the fixed frame.
+    struct Wrench
+    {
+        Ogre::Vector3 position;
+        Ogre::Quaternion orientation;
+        Ogre::Vector3 force;
+        Ogre::Vector3 torque;
+    };
+
+    // Push one wrench into the rings, styled with the current properties.
+    void pushWrench( const Wrench& wrench );
+
+    // The last History Length wrenches, so that property changes can
+    // redraw the whole history.
+    boost::circular_buffer<Wrench> wrenches_;
+
+    // History of wrenches, one batch per glyph type.  Each ring holds
+    // History Length entries and overwrites the oldest one when full.
+    rviz::GlyphRing* force_arrows_;
+    rviz::GlyphRing* torque_arrows_;
+    rviz::GlyphRing* torque_arcs_;
 
     // Property objects for user-editable properties.
     rviz::ColorProperty *force_color_property_, *torque_color_property_;
@@ -19,6 +19,9 @@ namespace rviz
 {
 
 
+// Deprecated: WrenchStampedDisplay now draws its history with rviz::GlyphRing and no
+// longer uses this class.  It is kept for code built against it.
+//
 // Each instance of WrenchStampedVisual represents the visualization of a single
 // sensor_msgs::WrenchStamped message.  Currently it just shows an arrow with
 // the direction and magnitude of the acceleration vector, but could
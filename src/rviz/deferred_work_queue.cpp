@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2012, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "rviz/deferred_work_queue.h"
+
+namespace rviz
+{
+
+void DeferredWorkQueue::add( const void* owner, const WorkUnit& work, int priority )
+{
+  Unit unit;
+  unit.owner = owner;
+  unit.work = work;
+  units_[ priority ].push_back( unit );
+}
+
+void DeferredWorkQueue::removeOwner( const void* owner )
+{
+  std::map<int, L_Unit, std::greater<int> >::iterator it = units_.begin();
+  while( it != units_.end() )
+  {
+    L_Unit& units = it->second;
+    for( L_Unit::iterator unit_it = units.begin(); unit_it != units.end(); )
+    {
+      if( unit_it->owner == owner )
+      {
+        unit_it = units.erase( unit_it );
+      }
+      else
+      {
+        ++unit_it;
+      }
+    }
+
+    if( units.empty() )
+    {
+      units_.erase( it++ );
+    }
+    else
+    {
+      ++it;
+    }
+  }
+}
+
+void DeferredWorkQueue::run( ros::WallDuration budget )
+{
+  ros::WallTime deadline = ros::WallTime::now() + budget;
+  bool first = true;
+
+  while( !units_.empty() )
+  {
+    if( !first && !budget.isZero() && ros::WallTime::now() >= deadline )
+    {
+      break;
+    }
+    first = false;
+
+    // Take the unit out before running it, so it may add or remove
+    // units itself.
+    int priority = units_.begin()->first;
+    L_Unit& units = units_.begin()->second;
+    Unit unit = units.front();
+    units.pop_front();
+    if( units.empty() )
+    {
+      units_.erase( units_.begin() );
+    }
+
+    if( !unit.work() )
+    {
+      units_[ priority ].push_back( unit );
+    }
+  }
+}
+
+} // namespace rviz
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2012, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RVIZ_DEFERRED_WORK_QUEUE_H
+#define RVIZ_DEFERRED_WORK_QUEUE_H
+
+#include <functional>
+#include <list>
+#include <map>
+
+#include <boost/function.hpp>
+
+#include <ros/time.h>
+
+#include "rviz/rviz_export.h"
+
+namespace rviz
+{
+
+/** @brief Incremental work scheduled across frames within a time budget.
+ *
+ * Displays with a lot of work to do for one message, like uploading
+ * millions of points or creating thousands of markers, split it into
+ * work units and add them here instead of doing everything in
+ * Display::update().  VisualizationManager runs the queue after the
+ * display updates of each frame, for as long as the frame budget
+ * allows, so a single heavy display does not stall input and
+ * rendering of all the others.
+ *
+ * A work unit returns true when it is finished.  Units which return
+ * false are run again later, after the other units of the same
+ * priority had their turn.  Units with a higher priority run first.
+ *
+ * The queue is only used from the GUI thread. */
+class RVIZ_EXPORT DeferredWorkQueue
+{
+public:
+  typedef boost::function<bool ()> WorkUnit;
+
+  /** @brief Add a work unit.
+   * @param owner Identifies the units to drop with removeOwner(), typically the Display.
+   * @param work The work to do; returns true when finished.
+   * @param priority Units with higher priority run first. */
+  void add( const void* owner, const WorkUnit& work, int priority = 0 );
+
+  /** @brief Drop all units added by @a owner.  Must be called before the owner is destroyed. */
+  void removeOwner( const void* owner );
+
+  /** @brief Run work units until the queue is empty or @a budget is used up.
+   *
+   * At least one unit runs per call, so work makes progress even when
+   * the display updates already used the whole frame budget.  A zero
+   * budget runs everything to completion. */
+  void run( ros::WallDuration budget );
+
+  bool empty() const { return units_.empty(); }
+
+private:
+  struct Unit
+  {
+    const void* owner;
+    WorkUnit work;
+  };
+  typedef std::list<Unit> L_Unit;
+
+  std::map<int, L_Unit, std::greater<int> > units_;
+};
+
+} // namespace rviz
+
+#endif // RVIZ_DEFERRED_WORK_QUEUE_H
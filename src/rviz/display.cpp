@@ -29,16 +29,20 @@
 
 #include <stdio.h>
 
+#include <algorithm>
+
 #include <QApplication>
 #include <QColor>
 #include <QDockWidget>
 #include <QFont>
 #include <QMetaObject>
+#include <QTimer>
 #include <QWidget>
 
 #include <OgreSceneManager.h>
 #include <OgreSceneNode.h>
 
+#include "rviz/deferred_work_queue.h"
 #include "rviz/display_context.h"
 #include "rviz/ogre_helpers/apply_visibility_bits.h"
 #include "rviz/properties/property_tree_model.h"
@@ -48,11 +52,19 @@
 
 #include "display.h"
 
+#include <boost/bind.hpp>
 #include <boost/filesystem.hpp>
 
 namespace rviz
 {
 
+// Seconds between updates of the status shown in the property tree.
+static const double STATUS_UPDATE_INTERVAL = 0.25;
+
+// Config loading runs before other deferred work, so the displays
+// become usable first.
+static const int LOAD_PRIORITY = 100;
+
 Display::Display()
   : context_( 0 )
   , scene_node_( NULL )
@@ -61,6 +73,9 @@ Display::Display()
   , visibility_bits_( 0xFFFFFFFF )
   , associated_widget_( NULL )
   , associated_widget_panel_( NULL )
+  , prepare_update_thread_safe_( false )
+  , status_update_queued_( false )
+  , load_pending_( false )
 {
   // Needed for timeSignal (see header) to work across threads
   qRegisterMetaType<ros::Time>();
@@ -75,6 +90,10 @@ Display::Display()
 
 Display::~Display()
 {
+  if( context_ && context_->getDeferredWorkQueue() )
+  {
+    context_->getDeferredWorkQueue()->removeOwner( this );
+  }
   if( scene_node_ )
   {
     scene_manager_->destroySceneNode( scene_node_ );
@@ -89,6 +108,7 @@ void Display::initialize( DisplayContext* context )
 
   update_nh_.setCallbackQueue( context_->getUpdateQueue() );
   threaded_nh_.setCallbackQueue( context_->getThreadedQueue() );
+  receive_nh_.setCallbackQueue( context_->getReceiveQueue() );
   fixed_frame_ = context_->getFixedFrame();
 
   onInitialize();
@@ -96,6 +116,44 @@ void Display::initialize( DisplayContext* context )
   initialized_ = true;
 }
 
+void Display::queueInitializeAndLoad( DisplayContext* context, const Config& config )
+{
+  DeferredWorkQueue* queue = context->getDeferredWorkQueue();
+  if( !queue )
+  {
+    initializeAndLoad( context, config );
+    return;
+  }
+
+  load_pending_ = true;
+  pending_config_ = config;
+  if( model_ )
+  {
+    model_->emitDataChanged( this );
+  }
+  queue->add( this, boost::bind( &Display::initializeAndLoad, this, context, config ), LOAD_PRIORITY );
+}
+
+bool Display::initializeAndLoad( DisplayContext* context, Config config )
+{
+  ros::WallTime start = ros::WallTime::now();
+
+  load_pending_ = false;
+  pending_config_ = Config();
+  initialize( context );
+  load( config );
+
+  ros::WallDuration duration = ros::WallTime::now() - start;
+  statistics_.setLoadTime( duration );
+  ROS_DEBUG( "Loaded display '%s' in %.1f ms", qPrintable( getName() ), duration.toSec() * 1000.0 );
+
+  if( model_ )
+  {
+    model_->emitDataChanged( this );
+  }
+  return true;
+}
+
 void Display::queueRender()
 {
   if( context_ )
@@ -104,6 +162,19 @@ void Display::queueRender()
   }
 }
 
+void Display::queueWork( const boost::function<bool ()>& work, int priority )
+{
+  DeferredWorkQueue* queue = context_ ? context_->getDeferredWorkQueue() : 0;
+  if( queue )
+  {
+    queue->add( this, work, priority );
+  }
+  else
+  {
+    while( !work() ) {}
+  }
+}
+
 QVariant Display::getViewData( int column, int role ) const
 {
   switch( role )
@@ -170,62 +241,88 @@ QVariant Display::getViewData( int column, int role ) const
 
 Qt::ItemFlags Display::getViewFlags( int column ) const
 {
+  if( load_pending_ )
+  {
+    // Greyed out and not checkable until it is loaded.
+    return Qt::ItemIsSelectable;
+  }
   return BoolProperty::getViewFlags( column ) | Qt::ItemIsDragEnabled;
 }
 
 void Display::setStatus( StatusProperty::Level level, const QString& name, const QString& text )
 {
-  QMetaObject::invokeMethod( this, "setStatusInternal", Qt::QueuedConnection,
-                             Q_ARG( int, level ),
-                             Q_ARG( QString, name ),
-                             Q_ARG( QString, text ));
-}
-
-void Display::setStatusInternal( int level, const QString& name, const QString& text )
-{
-  if( !status_ )
-  {
-    status_ = new StatusList( "Status" );
-    addChild( status_, 0 );
-  }
-  StatusProperty::Level old_level = status_->getLevel();
-
-  status_->setStatus( (StatusProperty::Level) level, name, text );
-  if( model_ && old_level != status_->getLevel() )
+  status_table_.set( level, name, text );
+  if( !status_update_queued_.exchange( true ))
   {
-    model_->emitDataChanged( this );
+    QMetaObject::invokeMethod( this, "scheduleStatusUpdate", Qt::QueuedConnection );
   }
 }
 
 void Display::deleteStatus( const QString& name )
 {
-  QMetaObject::invokeMethod( this, "deleteStatusInternal", Qt::QueuedConnection,
-                             Q_ARG( QString, name ));
+  status_table_.remove( name );
+  if( !status_update_queued_.exchange( true ))
+  {
+    QMetaObject::invokeMethod( this, "scheduleStatusUpdate", Qt::QueuedConnection );
+  }
 }
 
-void Display::deleteStatusInternal( const QString& name )
+void Display::clearStatuses()
 {
-  if( status_ )
+  status_table_.clear();
+  if( !status_update_queued_.exchange( true ))
   {
-    status_->deleteStatus( name );
+    QMetaObject::invokeMethod( this, "scheduleStatusUpdate", Qt::QueuedConnection );
   }
 }
 
-void Display::clearStatuses()
+void Display::scheduleStatusUpdate()
 {
-  QMetaObject::invokeMethod( this, "clearStatusesInternal", Qt::QueuedConnection );
+  double since_last = ( ros::WallTime::now() - last_status_update_ ).toSec();
+  int delay_ms = std::max( 0, (int)( 1000 * ( STATUS_UPDATE_INTERVAL - since_last )));
+  QTimer::singleShot( delay_ms, this, SLOT( applyStatusUpdates() ));
 }
 
-void Display::clearStatusesInternal()
+void Display::applyStatusUpdates()
 {
-  if( status_ )
+  // Clear the flag first, so changes made while applying schedule
+  // another update.
+  status_update_queued_ = false;
+  last_status_update_ = ros::WallTime::now();
+
+  bool cleared;
+  std::vector<StatusTable::Update> updates;
+  status_table_.take( &cleared, updates );
+
+  StatusProperty::Level old_level = status_ ? status_->getLevel() : StatusProperty::Ok;
+  if( cleared && status_ )
   {
-    StatusProperty::Level old_level = status_->getLevel();
     status_->clear();
-    if( model_ && old_level != StatusProperty::Ok )
+  }
+
+  for( size_t i = 0; i < updates.size(); i++ )
+  {
+    const StatusTable::Update& update = updates[ i ];
+    if( update.deleted )
+    {
+      if( status_ )
+      {
+        status_->deleteStatus( update.name );
+      }
+      continue;
+    }
+    if( !status_ )
     {
-      model_->emitDataChanged( this );
+      status_ = new StatusList( "Status" );
+      addChild( status_, 0 );
     }
+    status_->setStatus( (StatusProperty::Level) update.level, update.name, update.text );
+  }
+
+  StatusProperty::Level new_level = status_ ? status_->getLevel() : StatusProperty::Ok;
+  if( model_ && old_level != new_level )
+  {
+    model_->emitDataChanged( this );
   }
 }
 
@@ -249,6 +346,13 @@ void Display::load( const Config& config )
 
 void Display::save( Config config ) const
 {
+  if( load_pending_ )
+  {
+    // Not loaded yet, so the properties still hold their defaults.
+    config.copy( pending_config_ );
+    return;
+  }
+
   // Base class saves sub-properties.
   BoolProperty::save( config );
 
@@ -294,6 +398,11 @@ void Display::reset()
 
 void Display::onEnableChanged()
 {
+  if( !initialized_ )
+  {
+    // Applied by initializeAndLoad() once a queued load has run.
+    return;
+  }
   QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
   queueRender();
   if( isEnabled() )
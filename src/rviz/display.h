@@ -29,12 +29,17 @@
 #ifndef DISPLAY_H
 #define DISPLAY_H
 
+#include <atomic>
 #include <string>
+#include <vector>
 
 #ifndef Q_MOC_RUN  // See: https://bugreports.qt-project.org/browse/QTBUG-22829
+# include <boost/function.hpp>
 # include <ros/ros.h>
 #endif
 
+#include "rviz/performance_monitor.h"
+#include "rviz/status_table.h"
 #include "rviz/properties/status_property.h"
 #include "rviz/properties/bool_property.h"
 #include "rviz/rviz_export.h"
@@ -71,6 +76,22 @@ public:
   /** @brief Main initialization, called after constructor, before load() or setEnabled(). */
   void initialize( DisplayContext* context );
 
+  /** @brief Initialize and load this display in a later frame.
+   *
+   * Used when loading a config, so that a config with many displays
+   * is built a few displays per frame instead of blocking the window
+   * until all of them are ready.  Until then the display is shown
+   * greyed out, and save() writes @a config back unchanged.  Without
+   * a DeferredWorkQueue in @a context, this initializes and loads
+   * right away. */
+  void queueInitializeAndLoad( DisplayContext* context, const Config& config );
+
+  /** @brief Returns true while a load queued with queueInitializeAndLoad() has not run yet. */
+  bool isLoadPending() const { return load_pending_; }
+
+  /** @brief Returns true if the display has been initialized */
+  bool initialized() const { return initialized_; }
+
   /** @brief Return data appropriate for the given column (0 or 1) and
    * role for this Display.
    */
@@ -126,6 +147,26 @@ public:
   /** @brief Set the fixed frame in this display. */
   void setFixedFrame( const QString& fixed_frame );
 
+  /** @brief Called by the visualization manager right before update(),
+   * possibly on a worker thread.
+   *
+   * If the Display has called setPrepareUpdateThreadSafe( true ),
+   * this runs in parallel with prepareUpdate() of other displays while
+   * the GUI thread waits for all of them.  It may read the Display's
+   * own properties and look up transforms, but must not touch Ogre or
+   * Qt objects; the results are applied to the scene in update().
+   * Otherwise it is called on the GUI thread.  By default, do nothing.
+   * @param wall_dt Wall-clock time, in seconds, since the last time the update list was run through.
+   * @param ros_dt ROS time, in seconds, since the last time the update list was run through. */
+  virtual void prepareUpdate( float wall_dt, float ros_dt )
+  {
+    (void) wall_dt;
+    (void) ros_dt;
+  }
+
+  /** @brief Return true if prepareUpdate() may run on a worker thread. */
+  bool isPrepareUpdateThreadSafe() const { return prepare_update_thread_safe_; }
+
   /** @brief Called periodically by the visualization manager.
    * @param wall_dt Wall-clock time, in seconds, since the last time the update list was run through.
    * @param ros_dt ROS time, in seconds, since the last time the update list was run through. */
@@ -139,6 +180,9 @@ public:
   virtual void reset();
 
   /** @brief Show status level and text.  This is thread-safe.
+   *
+   * Changes are collected in a StatusTable and shown a few times per
+   * second, so only the latest text per name reaches the GUI.
    * @param level One of StatusProperty::Ok, StatusProperty::Warn, or StatusProperty::Error.
    * @param name The name of the child entry to set.
    * @param text Description of the child's state.
@@ -203,6 +247,30 @@ public:
   /** @brief Emit a time signal that other Displays can synchronize to. */
   void emitTimeSignal( ros::Time time );
 
+  /** @brief Return the timing and message totals of this Display,
+   * shown by the PerformancePanel.  Subclasses which process messages
+   * report them here. */
+  DisplayStatistics& getStatistics() { return statistics_; }
+
+  /** @brief Called first when this Display uses more memory than the
+   * MemoryBudget allows, as reported to getStatistics().
+   *
+   * Subclasses which can show their data with less detail, like a
+   * coarser texture, lower it here and report the new usage.  Return
+   * true if that brought the usage down to @a max_bytes; otherwise
+   * reduceMemoryUsage() is called next.  The default returns false.
+   * Called from the main thread. */
+  virtual bool reduceDetail( uint64_t max_bytes ) { (void) max_bytes; return false; }
+
+  /** @brief Called when this Display still uses more memory than the
+   * MemoryBudget allows after reduceDetail().
+   *
+   * Subclasses which keep growing data should free some of it until
+   * they use at most @a max_bytes, like dropping their oldest data,
+   * and report the new usage.  The default does nothing.  Called from
+   * the main thread. */
+  virtual void reduceMemoryUsage( uint64_t max_bytes ) { (void) max_bytes; }
+
 Q_SIGNALS:
 
   void timeSignal( rviz::Display* display, ros::Time time );
@@ -244,8 +312,18 @@ protected:
   /** @brief Called by setFixedFrame().  Override to respond to changes to fixed_frame_. */
   virtual void fixedFrameChanged() {}
 
-  /** @brief Returns true if the display has been initialized */
-  bool initialized() const { return initialized_; }
+  /** @brief Schedule incremental work within the frame budget.
+   *
+   * @a work is called after the display updates of this or a later
+   * frame, and called again in later frames until it returns true.
+   * Pending work is dropped when the Display is destroyed.  Without a
+   * DeferredWorkQueue in the context, the work is finished right away.
+   * @sa DeferredWorkQueue */
+  void queueWork( const boost::function<bool ()>& work, int priority = 0 );
+
+  /** @brief Declare whether prepareUpdate() may run on a worker thread.
+   * Defaults to false. */
+  void setPrepareUpdateThreadSafe( bool thread_safe ) { prepare_update_thread_safe_ = thread_safe; }
 
   /** @brief This DisplayContext pointer is the main connection a
    * Display has into the rest of rviz.  This is how the FrameManager
@@ -274,6 +352,15 @@ protected:
    * This is configured after the constructor and before onInitialize() is called. */
   ros::NodeHandle threaded_nh_;
 
+  /** @brief A NodeHandle whose CallbackQueue is run by a pool of receiver threads.
+   *
+   * Subscribing a tf2_ros::MessageFilter's input through this handle
+   * moves receiving and deserializing messages off the GUI thread,
+   * while the filter still delivers its output on update_nh_.
+   *
+   * This is configured after the constructor and before onInitialize() is called. */
+  ros::NodeHandle receive_nh_;
+
   /** @brief A convenience variable equal to context_->getFixedFrame().
    *
    * This is set after the constructor and before onInitialize() is
@@ -285,19 +372,32 @@ public Q_SLOTS:
   virtual void onEnableChanged();
 
 private Q_SLOTS:
-  void setStatusInternal( int level, const QString& name, const QString& text );
-  void deleteStatusInternal( const QString& name );
-  void clearStatusesInternal();
+  /** @brief Start a timer for applyStatusUpdates(), keeping at least
+   * STATUS_UPDATE_INTERVAL between updates. */
+  void scheduleStatusUpdate();
+
+  /** @brief Apply the changes collected in status_table_ to the StatusList. */
+  void applyStatusUpdates();
   void associatedPanelVisibilityChange( bool visible );
   void disable();
 
 private:
+  /** @brief Work unit of queueInitializeAndLoad(). */
+  bool initializeAndLoad( DisplayContext* context, Config config );
+
   StatusList* status_;
   QString class_id_;
   bool initialized_;
   uint32_t visibility_bits_;
   QWidget* associated_widget_;
   PanelDockWidget* associated_widget_panel_;
+  DisplayStatistics statistics_;
+  bool prepare_update_thread_safe_;
+  StatusTable status_table_;
+  std::atomic<bool> status_update_queued_;
+  ros::WallTime last_status_update_;
+  bool load_pending_;
+  Config pending_config_;
 };
 
 } // end namespace rviz
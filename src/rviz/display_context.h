@@ -61,9 +61,11 @@ namespace rviz
 {
 
 class BitAllocator;
+class DeferredWorkQueue;
 class DisplayFactory;
 class DisplayGroup;
 class FrameManager;
+class PerformanceMonitor;
 class RenderPanel;
 class SelectionManager;
 class ToolManager;
@@ -112,15 +114,36 @@ public:
    * been rendered since the last time they did something. */
   virtual uint64_t getFrameCount() const = 0;
 
+  /** @brief Return the number of renders queued so far.
+   *
+   * The count increments on every call to queueRender().  Secondary
+   * views of the shared scene (like the CameraDisplay overlay) compare
+   * it against the value seen at their last render to decide whether
+   * the scene changed and they need to redraw. */
+  virtual uint64_t getRenderRequestCount() const = 0;
+
   /** @brief Return a factory for creating Display subclasses based on a class id string. */
   virtual DisplayFactory* getDisplayFactory() const = 0;
 
+  /** @brief Return the PerformanceMonitor collecting frame timings and trace events. */
+  virtual PerformanceMonitor* getPerformanceMonitor() const = 0;
+
+  /** @brief Return the queue of incremental work run within the frame budget. */
+  virtual DeferredWorkQueue* getDeferredWorkQueue() const = 0;
+
   /** @brief Return the CallbackQueue using the main GUI thread. */
   virtual ros::CallbackQueueInterface* getUpdateQueue() = 0;
 
   /** @brief Return a CallbackQueue using a different thread than the main GUI one. */
   virtual ros::CallbackQueueInterface* getThreadedQueue() = 0;
 
+  /** @brief Return a CallbackQueue served by a pool of receiver threads.
+   *
+   * Meant for subscriptions whose callbacks only deserialize a message
+   * and hand it on, like the input of a tf2_ros::MessageFilter which
+   * delivers its output on another queue. */
+  virtual ros::CallbackQueueInterface* getReceiveQueue() = 0;
+
   /** @brief Handle a single key event for a given RenderPanel. */
   virtual void handleChar( QKeyEvent* event, RenderPanel* panel ) = 0;
 
@@ -34,6 +34,7 @@
 #include "rviz/display_context.h"
 #include "rviz/display_factory.h"
 #include "rviz/failed_display.h"
+#include "rviz/performance_monitor.h"
 #include "rviz/properties/property_tree_model.h"
 
 #include "display_group.h"
@@ -74,7 +75,7 @@ void DisplayGroup::load( const Config& config )
     model_->beginInsert( this, Display::numChildren(), num_displays );
   }
 
-  std::map<Display*,Config> display_config_map;
+  std::vector<std::pair<Display*,Config> > display_configs;
 
   // The following two-step loading procedure was motivated by the
   // 'display group visibility' property, which needs all other displays
@@ -98,24 +99,41 @@ void DisplayGroup::load( const Config& config )
     display_config.mapGetString( "Name", &display_name );
     disp->setObjectName( display_name );
 
-    display_config_map[ disp ] = display_config;
+    display_configs.push_back( std::make_pair( disp, display_config ));
   }
 
-  // now, initialize all displays and load their properties.
-  for( std::map<Display*,Config>::iterator it = display_config_map.begin(); it != display_config_map.end(); ++it )
+  if( model_ )
   {
-    Config display_config = it->second;
-    Display* disp = it->first;
-    disp->initialize( context_ );
-    disp->load( display_config );
+    model_->endInsert();
   }
 
-  if( model_ )
+  // now, initialize all displays and load their properties, one
+  // display per work unit so a large config does not block the window.
+  for( size_t i = 0; i < display_configs.size(); i++ )
   {
-    model_->endInsert();
+    display_configs[ i ].first->queueInitializeAndLoad( context_, display_configs[ i ].second );
   }
 }
 
+bool DisplayGroup::isLoading() const
+{
+  if( isLoadPending() )
+  {
+    return true;
+  }
+  int num_children = displays_.size();
+  for( int i = 0; i < num_children; i++ )
+  {
+    Display* display = displays_.at( i );
+    DisplayGroup* group = qobject_cast<DisplayGroup*>( display );
+    if( display->isLoadPending() || ( group && group->isLoading() ))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
 Display* DisplayGroup::createDisplay( const QString& class_id )
 {
   DisplayFactory* factory = context_->getDisplayFactory();
@@ -140,6 +158,11 @@ void DisplayGroup::onEnableChanged()
 void DisplayGroup::save( Config config ) const
 {
   Display::save( config );
+  if( isLoadPending() )
+  {
+    // The pending config already includes the displays.
+    return;
+  }
 
   // Save Displays in a sequence under the key "Displays".
   Config display_list_config = config.mapMakeChild( "Displays" );
@@ -231,13 +254,22 @@ void DisplayGroup::fixedFrameChanged()
 
 void DisplayGroup::update( float wall_dt, float ros_dt )
 {
+  PerformanceMonitor* monitor = context_->getPerformanceMonitor();
   int num_children = displays_.size();
   for( int i = 0; i < num_children; i++ )
   {
     Display* display = displays_.at( i );
     if( display->isEnabled() )
     {
+      ros::WallTime start = ros::WallTime::now();
       display->update( wall_dt, ros_dt );
+      ros::WallDuration duration = ros::WallTime::now() - start;
+
+      display->getStatistics().addUpdate( duration );
+      if( monitor && monitor->isTracing() )
+      {
+        monitor->addTraceEvent( display->getNameStd(), "update", start, duration );
+      }
     }
   }  
 }
@@ -249,7 +281,13 @@ void DisplayGroup::reset()
   int num_children = displays_.size();
   for( int i = 0; i < num_children; i++ )
   {
-    displays_.at( i )->reset();
+    Display* display = displays_.at( i );
+    // Displays still waiting for their queued load have nothing to reset yet.
+    if( display->isLoadPending() || !display->initialized() )
+    {
+      continue;
+    }
+    display->reset();
   }  
 }
 
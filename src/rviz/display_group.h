@@ -98,6 +98,10 @@ public:
    * to the given Config node. */
   virtual void save( Config config ) const;
 
+  /** @brief Return true while this group or any display below it
+   * still has a queued load.  @sa Display::queueInitializeAndLoad() */
+  bool isLoading() const;
+
   /** @brief Add a child Display to the end of the list of Displays.
    *
    * This also tells the model that we are adding a child, so it can
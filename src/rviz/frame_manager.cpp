@@ -58,12 +58,15 @@ FrameManager::FrameManager(boost::shared_ptr<tf::TransformListener> tf)
   if (!tf) tf_.reset(new tf::TransformListener(ros::NodeHandle(), ros::Duration(10*60), true));
   else tf_ = tf;
 
+  transform_scheduler_ = new TransformScheduler( *tf_->getTF2BufferPtr() );
+
   setSyncMode( SyncOff );
   setPause(false);
 }
 
 FrameManager::~FrameManager()
 {
+  delete transform_scheduler_;
 }
 
 void FrameManager::update()
@@ -60,6 +60,8 @@
 #include <tf2_ros/message_filter.h>
 #endif
 
+#include "rviz/transform_message_filter.h"
+
 namespace tf
 {
 class TransformListener;
@@ -229,6 +231,44 @@ public:
     ));
   }
 
+  /** @brief Update the transform status of @a display for a message
+   * which passed a filter shared with other displays.
+   *
+   * Does what the success callback connected by
+   * registerFilterForTransformStatusCheck() does. */
+  template<class M>
+  void reportTransformOk(const ros::MessageEvent<M const>& msg_evt, Display* display)
+  {
+    messageCallback<M>(msg_evt, display);
+  }
+
+  /** @brief Update the transform status of @a display for a message
+   * which a filter shared with other displays dropped. */
+  template<class M>
+  void reportTransformFailure(
+    const ros::MessageEvent<M const>& msg_evt,
+    tf2_ros::FilterFailureReason reason,
+    Display* display)
+  {
+    failureCallback<M, tf2_ros::FilterFailureReason>(msg_evt, reason, display);
+  }
+
+  /** Connect success and failure callbacks to a TransformMessageFilter.
+   * @param filter The TransformMessageFilter to connect to.
+   * @param display The Display using the filter. */
+  template<class M>
+  void registerFilterForTransformStatusCheck(TransformMessageFilter<M>* filter, Display* display)
+  {
+    filter->registerCallback(boost::bind(&FrameManager::messageCallback<M>, this, _1, display));
+    filter->registerFailureCallback(boost::bind(
+      &FrameManager::failureCallback<M, tf2_ros::FilterFailureReason>, this, _1, _2, display
+    ));
+  }
+
+  /** @brief Return the scheduler waiting for transforms on behalf of
+   * all TransformMessageFilters. */
+  TransformScheduler* getTransformScheduler() { return transform_scheduler_; }
+
   /** @brief Return the current fixed frame name. */
   const std::string& getFixedFrame() { return fixed_frame_; }
 
@@ -368,6 +408,7 @@ private:
   M_Cache cache_;
 
   boost::shared_ptr<tf::TransformListener> tf_;
+  TransformScheduler* transform_scheduler_;
   std::string fixed_frame_;
 
   bool pause_;
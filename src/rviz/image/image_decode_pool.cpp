@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2012, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+
+#include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/weak_ptr.hpp>
+
+#include "rviz/image/image_decode_pool.h"
+
+namespace rviz
+{
+
+namespace
+{
+
+// Start time of the callback currently run by a pool thread.
+thread_local ros::WallTime g_callback_start;
+
+// Upper bound on decode threads, independent of the core count.
+const unsigned int MAX_DECODE_THREADS = 4;
+
+}
+
+/** @brief Wraps a callback to record when a pool thread starts calling it. */
+class ImageDecodePool::TimedCallback: public ros::CallbackInterface
+{
+public:
+  TimedCallback( const ros::CallbackInterfacePtr& callback )
+  : callback_( callback )
+  {}
+
+  virtual CallResult call()
+  {
+    g_callback_start = ros::WallTime::now();
+    CallResult result = callback_->call();
+    g_callback_start = ros::WallTime();
+    return result;
+  }
+
+  virtual bool ready()
+  {
+    return callback_->ready();
+  }
+
+private:
+  ros::CallbackInterfacePtr callback_;
+};
+
+boost::shared_ptr<ImageDecodePool> ImageDecodePool::get()
+{
+  static boost::mutex mutex;
+  static boost::weak_ptr<ImageDecodePool> instance;
+
+  boost::mutex::scoped_lock lock( mutex );
+  boost::shared_ptr<ImageDecodePool> pool = instance.lock();
+  if( !pool )
+  {
+    unsigned int num_threads = std::min( std::max( boost::thread::hardware_concurrency(), 1u ), MAX_DECODE_THREADS );
+    pool.reset( new ImageDecodePool( num_threads ));
+    instance = pool;
+  }
+  return pool;
+}
+
+ImageDecodePool::ImageDecodePool( unsigned int num_threads )
+: shutting_down_( false )
+{
+  for( unsigned int i = 0; i < num_threads; ++i )
+  {
+    threads_.create_thread( boost::bind( &ImageDecodePool::threadFunc, this ));
+  }
+}
+
+ImageDecodePool::~ImageDecodePool()
+{
+  shutting_down_ = true;
+  threads_.join_all();
+}
+
+void ImageDecodePool::addCallback( const ros::CallbackInterfacePtr& callback, uint64_t owner_id )
+{
+  queue_.addCallback( boost::make_shared<TimedCallback>( callback ), owner_id );
+}
+
+void ImageDecodePool::removeByID( uint64_t owner_id )
+{
+  queue_.removeByID( owner_id );
+}
+
+ros::WallDuration ImageDecodePool::getCallbackElapsed()
+{
+  if( g_callback_start.isZero() )
+  {
+    return ros::WallDuration();
+  }
+  return ros::WallTime::now() - g_callback_start;
+}
+
+void ImageDecodePool::threadFunc()
+{
+  while( !shutting_down_ )
+  {
+    queue_.callOne( ros::WallDuration( 0.1 ));
+  }
+}
+
+} // namespace rviz
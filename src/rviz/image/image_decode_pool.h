@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2012, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RVIZ_IMAGE_DECODE_POOL_H
+#define RVIZ_IMAGE_DECODE_POOL_H
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <ros/callback_queue.h>
+#include <ros/time.h>
+
+namespace rviz
+{
+
+/** @brief Bounded pool of worker threads which runs image subscription callbacks.
+ *
+ * ImageDisplayBase subscribes through image_transport with a
+ * NodeHandle using this pool as its CallbackQueue, so deserializing
+ * and decoding (e.g. JPEG or PNG for the "compressed" transport) of
+ * incoming images happens off the GUI thread, and images of several
+ * displays are decoded in parallel.
+ *
+ * One pool is shared by all image displays.  It is created by the
+ * first call to get() and its threads are joined when the last
+ * reference is released. */
+class ImageDecodePool: public ros::CallbackQueueInterface
+{
+public:
+  /** @brief Return the shared pool, creating it if necessary. */
+  static boost::shared_ptr<ImageDecodePool> get();
+
+  virtual ~ImageDecodePool();
+
+  // Overrides from ros::CallbackQueueInterface
+  virtual void addCallback( const ros::CallbackInterfacePtr& callback, uint64_t owner_id = 0 );
+  virtual void removeByID( uint64_t owner_id );
+
+  /** @brief Return the time since the callback running on the calling
+   * thread was started by the pool.
+   *
+   * Only meaningful when called from inside a callback run by a pool
+   * thread; returns zero otherwise.  Image displays use this to
+   * measure how long receiving and decoding an image took. */
+  static ros::WallDuration getCallbackElapsed();
+
+private:
+  explicit ImageDecodePool( unsigned int num_threads );
+
+  void threadFunc();
+
+  class TimedCallback;
+
+  ros::CallbackQueue queue_;
+  boost::thread_group threads_;
+  volatile bool shutting_down_;
+};
+
+} // namespace rviz
+
+#endif // RVIZ_IMAGE_DECODE_POOL_H
@@ -35,8 +35,12 @@
 
 #include <image_transport/subscriber_plugin.h>
 
+#include "rviz/performance_monitor.h"
+#include "rviz/plugin_index.h"
+#include "rviz/topic_cache.h"
 #include "rviz/validate_floats.h"
 
+#include "rviz/image/image_decode_pool.h"
 #include "rviz/image/image_display_base.h"
 
 namespace rviz
@@ -47,6 +51,10 @@ ImageDisplayBase::ImageDisplayBase() :
     , sub_()
     , tf_filter_()
     , messages_received_(0)
+    , frames_dropped_(0)
+    , decode_time_sum_(0.0)
+    , decode_count_(0)
+    , frames_shown_(0)
 {
   topic_property_ = new RosTopicProperty("Image Topic", "",
                                          QString::fromStdString(ros::message_traits::datatype<sensor_msgs::Image>()),
@@ -81,7 +89,9 @@ ImageDisplayBase::~ImageDisplayBase()
 
 void ImageDisplayBase::onInitialize()
 {
-  it_.reset( new image_transport::ImageTransport( update_nh_ ));
+  decode_pool_ = ImageDecodePool::get();
+  decode_nh_.setCallbackQueue( decode_pool_.get() );
+  it_.reset( new image_transport::ImageTransport( decode_nh_ ));
   scanForTransportSubscriberPlugins();
 }
 
@@ -112,6 +122,55 @@ void ImageDisplayBase::setTopic( const QString &topic, const QString &datatype )
 
 void ImageDisplayBase::incomingMessage(const sensor_msgs::Image::ConstPtr& msg)
 {
+  if (!msg)
+  {
+    return;
+  }
+
+  bool was_empty;
+  {
+    boost::mutex::scoped_lock lock(pending_mutex_);
+    was_empty = !pending_message_;
+    if (!was_empty)
+    {
+      ++frames_dropped_;
+    }
+    pending_message_ = msg;
+  }
+
+  if (!was_empty)
+  {
+    getStatistics().addDropped();
+  }
+
+  // Only one call is queued at a time; later images just replace the pending one.
+  if (was_empty)
+  {
+    QMetaObject::invokeMethod( this, "processPendingMessage", Qt::QueuedConnection );
+  }
+}
+
+void ImageDisplayBase::imageDecoded(const sensor_msgs::Image::ConstPtr& msg)
+{
+  ros::WallDuration elapsed = ImageDecodePool::getCallbackElapsed();
+  if (elapsed.isZero())
+  {
+    return;
+  }
+
+  boost::mutex::scoped_lock lock(pending_mutex_);
+  decode_time_sum_ += elapsed.toSec();
+  ++decode_count_;
+}
+
+void ImageDisplayBase::processPendingMessage()
+{
+  sensor_msgs::Image::ConstPtr msg;
+  {
+    boost::mutex::scoped_lock lock(pending_mutex_);
+    msg.swap(pending_message_);
+  }
+
   if (!msg || context_->getFrameManager()->getPause() )
   {
     return;
@@ -122,9 +181,67 @@ void ImageDisplayBase::incomingMessage(const sensor_msgs::Image::ConstPtr& msg)
 
   emitTimeSignal( msg->header.stamp );
 
+  ros::WallTime start = ros::WallTime::now();
   processMessage(msg);
+  ros::WallDuration duration = ros::WallTime::now() - start;
+
+  getStatistics().addMessage(duration, msg->data.size());
+  PerformanceMonitor* monitor = context_->getPerformanceMonitor();
+  if (monitor && monitor->isTracing())
+  {
+    monitor->addTraceEvent(getNameStd(), "message", start, duration);
+  }
+
+  ++frames_shown_;
+  updateDecodeStatus();
 }
 
+void ImageDisplayBase::resetDecodeStatistics()
+{
+  {
+    boost::mutex::scoped_lock lock(pending_mutex_);
+    pending_message_.reset();
+    frames_dropped_ = 0;
+    decode_time_sum_ = 0.0;
+    decode_count_ = 0;
+  }
+  frames_shown_ = 0;
+  statistics_start_ = ros::WallTime::now();
+}
+
+void ImageDisplayBase::updateDecodeStatus()
+{
+  // Refresh at most once per second, to keep the status list quiet.
+  double elapsed = (ros::WallTime::now() - statistics_start_).toSec();
+  if (elapsed < 1.0)
+  {
+    return;
+  }
+
+  uint32_t frames_dropped;
+  double decode_time_sum;
+  uint32_t decode_count;
+  {
+    boost::mutex::scoped_lock lock(pending_mutex_);
+    frames_dropped = frames_dropped_;
+    decode_time_sum = decode_time_sum_;
+    decode_count = decode_count_;
+    decode_time_sum_ = 0.0;
+    decode_count_ = 0;
+  }
+
+  if (decode_count > 0)
+  {
+    setStatus(StatusProperty::Ok, "Decode Latency",
+              QString::number(1000.0 * decode_time_sum / decode_count, 'f', 1) + " ms");
+  }
+  setStatus(StatusProperty::Ok, "Frame Rate", QString::number(frames_shown_ / elapsed, 'f', 1) + " fps");
+  setStatus(frames_dropped > 0 ? StatusProperty::Warn : StatusProperty::Ok, "Dropped Frames",
+            QString::number(frames_dropped) + " images replaced by newer ones before they were shown");
+
+  frames_shown_ = 0;
+  statistics_start_ = ros::WallTime::now();
+}
 
 void ImageDisplayBase::reset()
 {
@@ -132,6 +249,7 @@ void ImageDisplayBase::reset()
   if (tf_filter_)
     tf_filter_->clear();
   messages_received_ = 0;
+  resetDecodeStatistics();
 }
 
 void ImageDisplayBase::updateQueueSize()
@@ -170,19 +288,21 @@ void ImageDisplayBase::subscribe()
         }
 
 
+      sub_->registerCallback(boost::bind(&ImageDisplayBase::imageDecoded, this, _1));
+
       if (targetFrame_.empty())
       {
         sub_->registerCallback(boost::bind(&ImageDisplayBase::incomingMessage, this, _1));
       }
       else
       {
-        tf_filter_.reset(new tf2_ros::MessageFilter<sensor_msgs::Image>(
-          *sub_,
-          *context_->getTF2BufferPtr(),
+        tf_filter_.reset(new TransformMessageFilter<sensor_msgs::Image>(
+          *context_->getFrameManager()->getTransformScheduler(),
           targetFrame_,
           queue_size_property_->getInt(),
           update_nh_
         ));
+        tf_filter_->connectInput(*sub_);
         tf_filter_->registerCallback(boost::bind(&ImageDisplayBase::incomingMessage, this, _1));
       }
     }
@@ -198,6 +318,7 @@ void ImageDisplayBase::subscribe()
   }
 
   messages_received_ = 0;
+  resetDecodeStatistics();
   setStatus(StatusProperty::Warn, "Image", "No Image received");
 }
 
@@ -219,7 +340,8 @@ void ImageDisplayBase::fixedFrameChanged()
 void ImageDisplayBase::scanForTransportSubscriberPlugins()
 {
   pluginlib::ClassLoader<image_transport::SubscriberPlugin> sub_loader("image_transport",
-                                                                       "image_transport::SubscriberPlugin");
+                                                                       "image_transport::SubscriberPlugin", "plugin",
+                                                                       PluginIndex::instance()->getPluginXmlPaths( "image_transport" ));
 
   BOOST_FOREACH( const std::string& lookup_name, sub_loader.getDeclaredClasses() )
   {
@@ -265,8 +387,7 @@ void ImageDisplayBase::fillTransportOptionList(EnumProperty* property)
   choices.push_back("raw");
 
   // Loop over all current ROS topic names
-  ros::master::V_TopicInfo topics;
-  ros::master::getTopics(topics);
+  ros::master::V_TopicInfo topics = TopicCache::instance()->getTopics();
   ros::master::V_TopicInfo::iterator it = topics.begin();
   ros::master::V_TopicInfo::iterator end = topics.end();
   for (; it != end; ++it)
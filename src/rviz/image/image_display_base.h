@@ -32,8 +32,9 @@
 #include <QObject>
 
 #ifndef Q_MOC_RUN  // See: https://bugreports.qt-project.org/browse/QTBUG-22829
+# include <boost/thread/mutex.hpp>
+
 # include <message_filters/subscriber.h>
-# include <tf2_ros/message_filter.h>
 # include <sensor_msgs/Image.h>
 
 # include <image_transport/image_transport.h>
@@ -44,6 +45,7 @@
 # include "rviz/properties/ros_topic_property.h"
 # include "rviz/properties/enum_property.h"
 # include "rviz/properties/int_property.h"
+# include "rviz/transform_message_filter.h"
 
 # include "rviz/display.h"
 # include "rviz/rviz_export.h"
@@ -51,12 +53,20 @@
 
 namespace rviz
 {
+class ImageDecodePool;
+
 /** @brief Display subclass for subscribing and displaying to image messages.
  *
  * This class brings together some common things used for subscribing and displaying image messages in Display
- * types.  It has a tf2_ros::MessageFilter and image_tranport::SubscriberFilter to filter incoming image messages, and
+ * types.  It has a TransformMessageFilter and image_tranport::SubscriberFilter to filter incoming image messages, and
  * it handles subscribing and unsubscribing when the display is
- * enabled or disabled.  */
+ * enabled or disabled.
+ *
+ * Images are received and decoded by the shared ImageDecodePool.  Only
+ * the newest decoded image is kept; it is handed to processMessage()
+ * on the GUI thread.  Decode time, achieved frame rate and the number
+ * of images replaced before they could be shown are reported as
+ * status entries.  */
 
 class RVIZ_EXPORT ImageDisplayBase : public Display
 {
@@ -98,21 +108,28 @@ protected:
 
   virtual void fixedFrameChanged();
 
-  /** @brief Incoming message callback.  Checks if the message pointer
-   * is valid, increments messages_received_, then calls
-   * processMessage(). */
+  /** @brief Incoming message callback.  Can be called from any thread.
+   *
+   * Stores the message as the newest pending image, replacing (and
+   * counting as dropped) any image not yet processed, and schedules
+   * processPendingMessage() on the GUI thread. */
   void incomingMessage(const sensor_msgs::Image::ConstPtr& msg);
 
   /** @brief Implement this to process the contents of a message.
    *
-   * This is called by incomingMessage(). */
+   * This is called from the GUI thread by processPendingMessage(). */
   virtual void processMessage(const sensor_msgs::Image::ConstPtr& msg) = 0;
 
   void scanForTransportSubscriberPlugins();
 
+  boost::shared_ptr<ImageDecodePool> decode_pool_;
+
+  /** @brief NodeHandle whose callbacks run in decode_pool_. */
+  ros::NodeHandle decode_nh_;
+
   boost::scoped_ptr<image_transport::ImageTransport> it_;
   boost::shared_ptr<image_transport::SubscriberFilter> sub_;
-  boost::shared_ptr<tf2_ros::MessageFilter<sensor_msgs::Image> > tf_filter_;
+  boost::shared_ptr<TransformMessageFilter<sensor_msgs::Image> > tf_filter_;
 
   std::string targetFrame_;
 
@@ -127,6 +144,30 @@ protected:
   std::set<std::string> transport_plugin_types_;
 
   BoolProperty* unreliable_property_;
+
+private Q_SLOTS:
+  /** @brief Checks if the pending message is valid, increments
+   * messages_received_, then calls processMessage(). */
+  void processPendingMessage();
+
+private:
+  /** @brief Called on a decode thread for every image received, to
+   * measure decode time. */
+  void imageDecoded(const sensor_msgs::Image::ConstPtr& msg);
+
+  void resetDecodeStatistics();
+  void updateDecodeStatus();
+
+  boost::mutex pending_mutex_;
+  sensor_msgs::Image::ConstPtr pending_message_;
+
+  // Guarded by pending_mutex_
+  uint32_t frames_dropped_;
+  double decode_time_sum_;
+  uint32_t decode_count_;
+
+  uint32_t frames_shown_;
+  ros::WallTime statistics_start_;
 };
 
 } // end namespace rviz
@@ -35,7 +35,19 @@
 #include <boost/algorithm/string/erase.hpp>
 #include <boost/foreach.hpp>
 
+#include <OgreCamera.h>
+#include <OgreHardwarePixelBuffer.h>
+#include <OgreMaterialManager.h>
+#include <OgreRectangle2D.h>
+#include <OgreRenderSystem.h>
+#include <OgreRenderSystemCapabilities.h>
+#include <OgreRenderTexture.h>
+#include <OgreRoot.h>
+#include <OgreSceneManager.h>
+#include <OgreSceneNode.h>
+#include <OgreTechnique.h>
 #include <OgreTextureManager.h>
+#include <OgreViewport.h>
 
 #include <sensor_msgs/image_encodings.h>
 
@@ -49,6 +61,12 @@ ROSImageTexture::ROSImageTexture()
 , width_(0)
 , height_(0)
 , median_frames_(5)
+, gpu_decoding_(false)
+, gpu_float_textures_(false)
+, decode_scene_manager_(0)
+, decode_camera_(0)
+, decode_rect_(0)
+, decode_target_(0)
 {
   empty_image_.load("no_image.png", Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
 
@@ -56,19 +74,59 @@ ROSImageTexture::ROSImageTexture()
   std::stringstream ss;
   ss << "ROSImageTexture" << count++;
   texture_ = Ogre::TextureManager::getSingleton().loadImage(ss.str(), Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME, empty_image_, Ogre::TEX_TYPE_2D, 0);
+  default_usage_ = texture_->getUsage();
 
   setNormalizeFloatImage(true);
+
+  Ogre::MaterialPtr decode_material = Ogre::MaterialManager::getSingleton().getByName( "rviz/ImageDecode" );
+  if( !decode_material.isNull() )
+  {
+    decode_material->load();
+    gpu_decoding_ = decode_material->getNumSupportedTechniques() > 0;
+  }
+
+  if( gpu_decoding_ )
+  {
+    const Ogre::RenderSystemCapabilities* caps = Ogre::Root::getSingleton().getRenderSystem()->getCapabilities();
+    gpu_float_textures_ = caps && caps->hasCapability( Ogre::RSC_TEXTURE_FLOAT );
+
+    decode_material_ = decode_material->clone( ss.str() + "DecodeMaterial" );
+
+    decode_scene_manager_ = Ogre::Root::getSingleton().createSceneManager( Ogre::ST_GENERIC, ss.str() + "DecodeScene" );
+    decode_camera_ = decode_scene_manager_->createCamera( ss.str() + "DecodeCamera" );
+
+    decode_rect_ = new Ogre::Rectangle2D( true );
+    decode_rect_->setCorners( -1.0f, 1.0f, 1.0f, -1.0f );
+    Ogre::AxisAlignedBox aabInf;
+    aabInf.setInfinite();
+    decode_rect_->setBoundingBox( aabInf );
+    decode_rect_->setMaterial( decode_material_->getName() );
+    decode_scene_manager_->getRootSceneNode()->attachObject( decode_rect_ );
+  }
 }
 
 ROSImageTexture::~ROSImageTexture()
 {
   current_image_.reset();
+
+  if( decode_scene_manager_ )
+  {
+    releaseDecodeTarget();
+    delete decode_rect_;
+    Ogre::Root::getSingleton().destroySceneManager( decode_scene_manager_ );
+    Ogre::MaterialManager::getSingleton().remove( decode_material_->getName() );
+    if( !raw_texture_.isNull() )
+    {
+      Ogre::TextureManager::getSingleton().remove( raw_texture_->getName() );
+    }
+  }
 }
 
 void ROSImageTexture::clear()
 {
   boost::mutex::scoped_lock lock(mutex_);
 
+  releaseDecodeTarget();
   texture_->unload();
   texture_->loadImage(empty_image_);
 
@@ -111,14 +169,8 @@ void ROSImageTexture::setNormalizeFloatImage( bool normalize, double min, double
 
 
 template<typename T>
-void ROSImageTexture::normalize( T* image_data, size_t image_data_size, std::vector<uint8_t> &buffer  )
+void ROSImageTexture::getRange( T* image_data, size_t image_data_size, T& minValue, T& maxValue )
 {
-  // Prepare output buffer
-  buffer.resize(image_data_size, 0);
-
-  T minValue;
-  T maxValue;
-
   if ( normalize_ )
   {
     T* input_ptr = image_data;
@@ -152,6 +204,17 @@ void ROSImageTexture::normalize( T* image_data, size_t image_data_size, std::vec
     minValue = min_;
     maxValue = max_;
   }
+}
+
+template<typename T>
+void ROSImageTexture::normalize( T* image_data, size_t image_data_size, std::vector<uint8_t> &buffer  )
+{
+  // Prepare output buffer
+  buffer.resize(image_data_size, 0);
+
+  T minValue;
+  T maxValue;
+  getRange( image_data, image_data_size, minValue, maxValue );
 
   // Rescale floating point image and convert it to 8-bit
   double range = maxValue - minValue;
@@ -196,6 +259,23 @@ bool ROSImageTexture::update()
     return false;
   }
 
+  if ( gpu_decoding_ )
+  {
+    try
+    {
+      if ( decodeOnGpu( image ))
+      {
+        return true;
+      }
+    }
+    catch (Ogre::Exception& e)
+    {
+      ROS_ERROR("Error decoding image on the GPU, falling back to CPU conversion: %s", e.what());
+      releaseDecodeTarget();
+      gpu_decoding_ = false;
+    }
+  }
+
   Ogre::PixelFormat format = Ogre::PF_R8G8B8;
   Ogre::Image ogre_image;
   std::vector<uint8_t> buffer;
@@ -273,12 +353,173 @@ bool ROSImageTexture::update()
     return false;
   }
 
+  releaseDecodeTarget();
   texture_->unload();
   texture_->loadImage(ogre_image);
 
   return true;
 }
 
+bool ROSImageTexture::decodeOnGpu( const sensor_msgs::Image::ConstPtr& image )
+{
+  namespace enc = sensor_msgs::image_encodings;
+
+  // Values of the mode uniform in image_decode.frag
+  enum { MONO = 0, BAYER = 1, YUV422 = 2 };
+
+  int mode = MONO;
+  Ogre::PixelFormat raw_format;
+  uint32_t raw_width = image->width;
+  Ogre::Vector2 red_offset( 0, 0 );
+  double scale = 1.0;
+  double offset = 0.0;
+
+  const std::string& encoding = image->encoding;
+  if ( enc::isBayer( encoding ))
+  {
+    mode = BAYER;
+    raw_format = enc::bitDepth( encoding ) == 16 ? Ogre::PF_L16 : Ogre::PF_L8;
+
+    // Shift the red pixel of the 2x2 tile to (0,0)
+    if ( encoding.find( "bayer_bggr" ) == 0 )
+    {
+      red_offset = Ogre::Vector2( 1, 1 );
+    }
+    else if ( encoding.find( "bayer_grbg" ) == 0 )
+    {
+      red_offset = Ogre::Vector2( 1, 0 );
+    }
+    else if ( encoding.find( "bayer_gbrg" ) == 0 )
+    {
+      red_offset = Ogre::Vector2( 0, 1 );
+    }
+  }
+  else if ( encoding == enc::YUV422 )
+  {
+    // Each UYVY quadruple holds two pixels
+    mode = YUV422;
+    raw_format = Ogre::PF_BYTE_RGBA;
+    raw_width = (image->width + 1) / 2;
+  }
+  else if ( encoding == enc::TYPE_16UC1 || encoding == enc::MONO16 )
+  {
+    raw_format = Ogre::PF_L16;
+
+    uint16_t min_value, max_value;
+    getRange<uint16_t>( (uint16_t*)&image->data[0], image->data.size() / sizeof(uint16_t), min_value, max_value );
+    double range = double( max_value ) - double( min_value );
+    if ( range <= 0.0 )
+    {
+      range = 1.0;
+    }
+    // The shader sees 16 bit values scaled to [0..1]
+    scale = 65535.0 / range;
+    offset = -double( min_value ) / range;
+  }
+  else if ( encoding == enc::TYPE_32FC1 && gpu_float_textures_ )
+  {
+    raw_format = Ogre::PF_FLOAT32_R;
+
+    float min_value, max_value;
+    getRange<float>( (float*)&image->data[0], image->data.size() / sizeof(float), min_value, max_value );
+    double range = double( max_value ) - double( min_value );
+    if ( range <= 0.0 )
+    {
+      range = 1.0;
+    }
+    scale = 1.0 / range;
+    offset = -double( min_value ) / range;
+  }
+  else
+  {
+    return false;
+  }
+
+  width_ = image->width;
+  height_ = image->height;
+
+  if ( raw_texture_.isNull() ||
+       raw_texture_->getWidth() != raw_width ||
+       raw_texture_->getHeight() != height_ ||
+       raw_texture_->getFormat() != raw_format )
+  {
+    std::string name = texture_->getName() + "Raw";
+    if ( !raw_texture_.isNull() )
+    {
+      Ogre::TextureManager::getSingleton().remove( name );
+    }
+    raw_texture_ = Ogre::TextureManager::getSingleton().createManual(
+        name, Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME, Ogre::TEX_TYPE_2D,
+        raw_width, height_, 0, raw_format, Ogre::TU_DYNAMIC_WRITE_ONLY_DISCARDABLE );
+    decode_material_->getTechnique(0)->getPass(0)->getTextureUnitState(0)->setTextureName( name );
+  }
+
+  Ogre::PixelBox pixel_box( raw_width, height_, 1, raw_format, (void*)&image->data[0] );
+  size_t pixel_size = Ogre::PixelUtil::getNumElemBytes( raw_format );
+  if ( image->step >= raw_width * pixel_size )
+  {
+    pixel_box.rowPitch = image->step / pixel_size;
+  }
+  raw_texture_->getBuffer()->blitFromMemory( pixel_box );
+
+  Ogre::GpuProgramParametersSharedPtr params =
+      decode_material_->getTechnique(0)->getPass(0)->getFragmentProgramParameters();
+  float size[2] = { float( width_ ), float( height_ ) };
+  params->setNamedConstant( "mode", mode );
+  params->setNamedConstant( "size", size, 1, 2 );
+  params->setNamedConstant( "red_offset", red_offset.ptr(), 1, 2 );
+  params->setNamedConstant( "scale", Ogre::Real( scale ));
+  params->setNamedConstant( "offset", Ogre::Real( offset ));
+
+  prepareDecodeTarget( width_, height_ );
+  decode_target_->update();
+
+  return true;
+}
+
+void ROSImageTexture::prepareDecodeTarget( uint32_t width, uint32_t height )
+{
+  if ( decode_target_ && texture_->getWidth() == width && texture_->getHeight() == height )
+  {
+    return;
+  }
+
+  releaseDecodeTarget();
+
+  // Loading a blank image keeps texture_ in the "loaded" state, so
+  // materials referring to it never try to reload it from disk.
+  std::vector<uint8_t> blank( width * height * 4, 0 );
+  Ogre::Image blank_image;
+  blank_image.loadDynamicImage( &blank[0], width, height, 1, Ogre::PF_BYTE_RGBA );
+
+  texture_->unload();
+  texture_->setUsage( Ogre::TU_RENDERTARGET );
+  texture_->setNumMipmaps( 0 );
+  texture_->loadImage( blank_image );
+
+  decode_target_ = texture_->getBuffer()->getRenderTarget();
+  decode_target_->setAutoUpdated( false );
+  Ogre::Viewport* viewport = decode_target_->addViewport( decode_camera_ );
+  viewport->setClearEveryFrame( false );
+  viewport->setOverlaysEnabled( false );
+  viewport->setShadowsEnabled( false );
+  viewport->setSkiesEnabled( false );
+}
+
+void ROSImageTexture::releaseDecodeTarget()
+{
+  if ( !decode_target_ )
+  {
+    return;
+  }
+
+  decode_target_->removeAllViewports();
+  decode_target_ = 0;
+
+  texture_->unload();
+  texture_->setUsage( default_usage_ );
+}
+
 void ROSImageTexture::addMessage(const sensor_msgs::Image::ConstPtr& msg)
 {
   boost::mutex::scoped_lock lock(mutex_);
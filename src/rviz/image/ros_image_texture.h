@@ -34,6 +34,7 @@
 
 #include <OgreTexture.h>
 #include <OgreImage.h>
+#include <OgreMaterial.h>
 #include <OgreSharedPtr.h>
 
 #include <boost/shared_ptr.hpp>
@@ -43,6 +44,14 @@
 
 #include <stdexcept>
 
+namespace Ogre
+{
+class Camera;
+class Rectangle2D;
+class RenderTarget;
+class SceneManager;
+}
+
 namespace rviz
 {
 
@@ -78,9 +87,26 @@ private:
 
   double updateMedian( std::deque<double>& buffer, double new_value );
 
+  template<typename T>
+  void getRange( T* image_data, size_t image_data_size, T& min_value, T& max_value );
+
   template<typename T>
   void normalize( T* image_data, size_t image_data_size, std::vector<uint8_t> &buffer  );
 
+  /** @brief Upload @a image as-is and convert it with the rviz/ImageDecode shader.
+   *
+   * Handles Bayer (8 and 16 bit), YUV422 and single channel 16 bit
+   * images, and single channel float images if the render system has
+   * float textures.  Returns false if the encoding is not handled on
+   * the GPU, in which case the caller falls back to CPU conversion. */
+  bool decodeOnGpu( const sensor_msgs::Image::ConstPtr& image );
+
+  /** @brief Make texture_ a render target of the given size. */
+  void prepareDecodeTarget( uint32_t width, uint32_t height );
+
+  /** @brief Turn texture_ back into a plain texture after GPU decoding. */
+  void releaseDecodeTarget();
+
   sensor_msgs::Image::ConstPtr current_image_;
   boost::mutex mutex_;
   bool new_image_;
@@ -98,6 +124,18 @@ private:
   unsigned median_frames_;
   std::deque<double> min_buffer_;
   std::deque<double> max_buffer_;
+
+  // GPU decoding: raw_texture_ holds the image as received, which is
+  // rendered into texture_ through decode_material_.
+  bool gpu_decoding_;
+  bool gpu_float_textures_;  ///< 32FC1 images can be uploaded as float textures for decodeOnGpu()
+  Ogre::TexturePtr raw_texture_;
+  Ogre::MaterialPtr decode_material_;
+  Ogre::SceneManager* decode_scene_manager_;
+  Ogre::Camera* decode_camera_;
+  Ogre::Rectangle2D* decode_rect_;
+  Ogre::RenderTarget* decode_target_;
+  int default_usage_;
 };
 
 }
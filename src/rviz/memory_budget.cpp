@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2012, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <functional>
+
+#include "rviz/memory_budget.h"
+
+namespace rviz
+{
+
+MemoryBudget::MemoryBudget()
+  : budget_( 0 )
+  , display_cap_( 0 )
+{
+}
+
+std::vector<MemoryBudget::Eviction> MemoryBudget::plan( const std::vector<uint64_t>& usage ) const
+{
+  std::vector<uint64_t> allowed( usage );
+  uint64_t total = 0;
+  for( size_t i = 0; i < allowed.size(); i++ )
+  {
+    if( display_cap_ > 0 && allowed[ i ] > display_cap_ )
+    {
+      allowed[ i ] = display_cap_;
+    }
+    total += allowed[ i ];
+  }
+
+  if( budget_ > 0 && total > budget_ )
+  {
+    // Find the level which brings the total down to the budget when
+    // every display above it is cut to it.
+    std::vector<uint64_t> sorted( allowed );
+    std::sort( sorted.begin(), sorted.end(), std::greater<uint64_t>() );
+
+    uint64_t rest = total;
+    uint64_t level = 0;
+    for( size_t k = 1; k <= sorted.size(); k++ )
+    {
+      rest -= sorted[ k - 1 ];
+      if( rest > budget_ )
+      {
+        continue;
+      }
+      level = (budget_ - rest) / k;
+      if( k == sorted.size() || level >= sorted[ k ] )
+      {
+        break;
+      }
+    }
+
+    for( size_t i = 0; i < allowed.size(); i++ )
+    {
+      allowed[ i ] = std::min( allowed[ i ], level );
+    }
+  }
+
+  std::vector<Eviction> evictions;
+  for( size_t i = 0; i < usage.size(); i++ )
+  {
+    if( allowed[ i ] < usage[ i ] )
+    {
+      Eviction eviction;
+      eviction.index = i;
+      eviction.max_bytes = allowed[ i ];
+      evictions.push_back( eviction );
+    }
+  }
+  return evictions;
+}
+
+} // namespace rviz
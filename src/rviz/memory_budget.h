@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2012, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RVIZ_MEMORY_BUDGET_H
+#define RVIZ_MEMORY_BUDGET_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "rviz/rviz_export.h"
+
+namespace rviz
+{
+
+/** @brief Limits on the memory used by displays, and the choice of
+ * which displays have to give memory back.
+ *
+ * Displays report their CPU and GPU memory through
+ * DisplayStatistics::setMemoryUsage().  VisualizationManager collects
+ * the totals once per second and passes them to plan().  Each display
+ * named in the result gets Display::reduceDetail() called with the
+ * number of bytes it may keep, and Display::reduceMemoryUsage() if
+ * lowering its detail was not enough.
+ *
+ * A limit of 0 means unlimited.  Both limits are 0 by default. */
+class RVIZ_EXPORT MemoryBudget
+{
+public:
+  /** @brief The display at @a index must get down to @a max_bytes. */
+  struct Eviction
+  {
+    size_t index;
+    uint64_t max_bytes;
+  };
+
+  MemoryBudget();
+
+  /** @brief Set the limit for all displays together. */
+  void setBudget( uint64_t bytes ) { budget_ = bytes; }
+  uint64_t getBudget() const { return budget_; }
+
+  /** @brief Set the limit for each single display. */
+  void setDisplayCap( uint64_t bytes ) { display_cap_ = bytes; }
+  uint64_t getDisplayCap() const { return display_cap_; }
+
+  /** @brief Return which displays must reduce their usage to stay
+   * within the limits.
+   * @param usage The bytes used by each display.
+   *
+   * Displays above the per-display cap are cut to the cap.  If the
+   * total is still above the budget, the largest displays are cut to
+   * a common level, so small displays keep their data. */
+  std::vector<Eviction> plan( const std::vector<uint64_t>& usage ) const;
+
+private:
+  uint64_t budget_;
+  uint64_t display_cap_;
+};
+
+} // namespace rviz
+
+#endif // RVIZ_MEMORY_BUDGET_H
@@ -33,13 +33,17 @@
 #include <OgreSceneManager.h>
 #include <OgreSceneNode.h>
 
+#include <boost/thread/mutex.hpp>
+
 #include <message_filters/subscriber.h>
-#include <tf2_ros/message_filter.h>
 #endif
 
 #include "rviz/display_context.h"
 #include "rviz/frame_manager.h"
+#include "rviz/performance_monitor.h"
 #include "rviz/properties/ros_topic_property.h"
+#include "rviz/shared_message_filter.h"
+#include "rviz/transform_message_filter.h"
 
 #include "rviz/display.h"
 #include "rviz/rviz_export.h"
@@ -73,12 +77,16 @@ protected:
   BoolProperty* unreliable_property_;
 };
 
-/** @brief Display subclass using a tf2_ros::MessageFilter, templated on the ROS message type.
+/** @brief Display subclass using a TransformMessageFilter, templated on the ROS message type.
  *
  * This class brings together some common things used in many Display
- * types.  It has a tf2_ros::MessageFilter to filter incoming messages, and
+ * types.  It has a TransformMessageFilter to filter incoming messages, and
  * it handles subscribing and unsubscribing when the display is
- * enabled or disabled.  It also has an Ogre::SceneNode which  */
+ * enabled or disabled.  It also has an Ogre::SceneNode which
+ *
+ * Subclasses can call setSharedSubscription() to receive through a
+ * SharedMessageFilter instead, so displays showing the same topic in
+ * the same fixed frame subscribe and wait for transforms only once. */
 template<class MessageType>
 class MessageFilterDisplay: public _RosTopicDisplay
 {
@@ -90,7 +98,11 @@ public:
 
   MessageFilterDisplay()
     : tf_filter_( NULL )
+    , share_subscription_( false )
+    , queue_size_( 10 )
     , messages_received_( 0 )
+    , latency_sum_( 0.0 )
+    , latency_count_( 0 )
     {
       QString message_type = QString::fromStdString( ros::message_traits::datatype<MessageType>() );
       topic_property_->setMessageType( message_type );
@@ -99,14 +111,16 @@ public:
 
   virtual void onInitialize()
     {
-      tf_filter_ = new tf2_ros::MessageFilter<MessageType>(
-        *context_->getTF2BufferPtr(),
+      tf_filter_ = new TransformMessageFilter<MessageType>(
+        *context_->getFrameManager()->getTransformScheduler(),
         fixed_frame_.toStdString(),
-        10,
+        queue_size_,
         update_nh_);
 
       tf_filter_->connectInput( sub_ );
-      tf_filter_->registerCallback( boost::bind( &MessageFilterDisplay<MessageType>::incomingMessage, this, _1 ));
+      tf_filter_->registerCallback( boost::function<void( const ros::MessageEvent<MessageType const>& )>(
+          boost::bind( &MessageFilterDisplay<MessageType>::incomingMessageEvent, this, _1 )));
+      tf_filter_->registerFailureCallback( boost::bind( &MessageFilterDisplay<MessageType>::droppedMessage, this, _1, _2 ));
       context_->getFrameManager()->registerFilterForTransformStatusCheck( tf_filter_, this );
     }
 
@@ -119,7 +133,10 @@ public:
   virtual void reset()
     {
       Display::reset();
-      tf_filter_->clear();
+      if( tf_filter_ )
+      {
+        tf_filter_->clear();
+      }
       messages_received_ = 0;
     }
 
@@ -128,6 +145,47 @@ public:
       topic_property_->setString( topic );
     }
 
+  /** @brief Hand a message to the display directly, without going
+   * through ROS serialization and transport.
+   *
+   * For applications embedding rviz in the process which produces the
+   * data.  The message is not copied, so it must not be changed
+   * afterwards.  It still waits for its transform like a received
+   * message, and displays sharing the subscription get it too.  Can be
+   * called from any thread.
+   * @return false if the display is not initialized or not enabled. */
+  bool injectMessage( const ros::MessageEvent<MessageType const>& event )
+    {
+      if( !initialized() || !isEnabled() )
+      {
+        return false;
+      }
+      if( share_subscription_ )
+      {
+        // Hold on to the filter in case the display resubscribes meanwhile.
+        typename SharedMessageFilter<MessageType>::Ptr shared_filter;
+        {
+          boost::mutex::scoped_lock lock( shared_filter_mutex_ );
+          shared_filter = shared_filter_;
+        }
+        if( !shared_filter )
+        {
+          return false;
+        }
+        shared_filter->add( event );
+      }
+      else
+      {
+        tf_filter_->add( event );
+      }
+      return true;
+    }
+
+  bool injectMessage( const typename MessageType::ConstPtr& msg )
+    {
+      return injectMessage( ros::MessageEvent<MessageType const>( msg ));
+    }
+
 protected:
   virtual void updateTopic()
     {
@@ -144,6 +202,12 @@ protected:
         return;
       }
 
+      if( share_subscription_ )
+      {
+        subscribeShared();
+        return;
+      }
+
       try
       {
         ros::TransportHints transport_hint = ros::TransportHints().reliable();
@@ -152,7 +216,8 @@ protected:
         {
           transport_hint = ros::TransportHints().unreliable();
         }
-        sub_.subscribe( update_nh_, topic_property_->getTopicStd(), 10, transport_hint);
+        // Receive on the pool threads; tf_filter_ hands messages over to the update queue.
+        sub_.subscribe( receive_nh_, topic_property_->getTopicStd(), queue_size_, transport_hint);
         setStatus( StatusProperty::Ok, "Topic", "OK" );
       }
       catch( ros::Exception& e )
@@ -164,6 +229,52 @@ protected:
   virtual void unsubscribe()
     {
       sub_.unsubscribe();
+      typename SharedMessageFilter<MessageType>::Ptr shared_filter;
+      {
+        boost::mutex::scoped_lock lock( shared_filter_mutex_ );
+        shared_filter.swap( shared_filter_ );
+      }
+      if( shared_filter )
+      {
+        shared_filter->removeListener( this );
+      }
+    }
+
+  /** @brief Receive through a SharedMessageFilter if @a share is
+   * true.  Only for displays whose processMessage() depends on
+   * nothing but the message, since other displays get the same
+   * message pointer at the same time. */
+  void setSharedSubscription( bool share )
+    {
+      if( share != share_subscription_ )
+      {
+        share_subscription_ = share;
+        if( initialized() )
+        {
+          updateTopic();
+        }
+      }
+    }
+
+  /** @brief Set the number of messages waiting for their transform
+   * before the oldest is dropped. */
+  void setQueueSize( uint32_t queue_size )
+    {
+      if( queue_size == queue_size_ )
+      {
+        return;
+      }
+      queue_size_ = queue_size;
+      if( tf_filter_ )
+      {
+        tf_filter_->setQueueSize( queue_size );
+      }
+      if( shared_filter_ )
+      {
+        // The queue is part of the shared filter, get one of this size.
+        unsubscribe();
+        subscribe();
+      }
     }
 
   virtual void onEnable()
@@ -181,11 +292,54 @@ protected:
     {
       tf_filter_->setTargetFrame( fixed_frame_.toStdString() );
       reset();
+      if( shared_filter_ )
+      {
+        unsubscribe();
+        subscribe();
+      }
+    }
+
+  void subscribeShared()
+    {
+      try
+      {
+        typename SharedMessageFilter<MessageType>::Ptr shared_filter = SharedMessageFilter<MessageType>::get(
+          context_, topic_property_->getTopicStd(), fixed_frame_.toStdString(),
+          unreliable_property_->getBool(), queue_size_ );
+        shared_filter->addListener(
+          this, update_nh_.getCallbackQueue(),
+          boost::bind( &MessageFilterDisplay<MessageType>::incomingSharedMessage, this, _1 ),
+          boost::bind( &MessageFilterDisplay<MessageType>::droppedSharedMessage, this, _1, _2 ));
+        {
+          boost::mutex::scoped_lock lock( shared_filter_mutex_ );
+          shared_filter_ = shared_filter;
+        }
+        setStatus( StatusProperty::Ok, "Topic", "OK" );
+      }
+      catch( ros::Exception& e )
+      {
+        setStatus( StatusProperty::Error, "Topic", QString( "Error subscribing: " ) + e.what() );
+      }
+    }
+
+  /** @brief Success callback of shared_filter_, does what the
+   * callbacks of tf_filter_ do. */
+  void incomingSharedMessage( const ros::MessageEvent<MessageType const>& event )
+    {
+      context_->getFrameManager()->reportTransformOk( event, this );
+      incomingMessageEvent( event );
+    }
+
+  void droppedSharedMessage( const ros::MessageEvent<MessageType const>& event,
+                             tf2_ros::FilterFailureReason reason )
+    {
+      context_->getFrameManager()->reportTransformFailure( event, reason, this );
+      droppedMessage( event.getMessage(), reason );
     }
 
   /** @brief Incoming message callback.  Checks if the message pointer
-   * is valid, increments messages_received_, then calls
-   * processMessage(). */
+   * is valid, increments messages_received_, calls processMessage(),
+   * then queues a render to show the result. */
   void incomingMessage( const typename MessageType::ConstPtr& msg )
     {
       if( !msg )
@@ -197,6 +351,7 @@ protected:
       setStatus( StatusProperty::Ok, "Topic", QString::number( messages_received_ ) + " messages received" );
 
       processMessage( msg );
+      context_->queueRender();
     }
 
   /** @brief Implement this to process the contents of a message.
@@ -204,11 +359,78 @@ protected:
    * This is called by incomingMessage(). */
   virtual void processMessage( const typename MessageType::ConstPtr& msg ) = 0;
 
+  /** @brief Callback for tf_filter_.  Measures the time between
+   * receiving a message and processing it, then calls
+   * incomingMessage().  The average is shown as the "Latency" status,
+   * updated once per second.  Processing time and message size go to
+   * the DisplayStatistics. */
+  void incomingMessageEvent( const ros::MessageEvent<MessageType const>& event )
+    {
+      ros::WallTime start = ros::WallTime::now();
+      incomingMessage( event.getMessage() );
+      ros::WallDuration duration = ros::WallTime::now() - start;
+
+      getStatistics().addMessage( duration, ros::serialization::serializationLength( *event.getMessage() ));
+      PerformanceMonitor* monitor = context_->getPerformanceMonitor();
+      if( monitor && monitor->isTracing() )
+      {
+        monitor->addTraceEvent( getNameStd(), "message", start, duration );
+      }
+
+      latency_sum_ += (ros::Time::now() - event.getReceiptTime()).toSec();
+      ++latency_count_;
+
+      if( (start - latency_status_time_).toSec() >= 1.0 )
+      {
+        setStatus( StatusProperty::Ok, "Latency",
+                   QString::number( 1000.0 * latency_sum_ / latency_count_, 'f', 1 ) +
+                   " ms from receiving a message until it was processed" );
+        latency_sum_ = 0.0;
+        latency_count_ = 0;
+        latency_status_time_ = start;
+      }
+    }
+
+  /** @brief Failure callback for tf_filter_, counts the dropped message. */
+  void droppedMessage( const typename MessageType::ConstPtr& msg, tf2_ros::FilterFailureReason reason )
+    {
+      (void) msg;
+      (void) reason;
+      getStatistics().addDropped();
+    }
+
   message_filters::Subscriber<MessageType> sub_;
-  tf2_ros::MessageFilter<MessageType>* tf_filter_;
+  TransformMessageFilter<MessageType>* tf_filter_;
+  bool share_subscription_;
+  typename SharedMessageFilter<MessageType>::Ptr shared_filter_;
+  boost::mutex shared_filter_mutex_; // Guards shared_filter_ for injectMessage().
+  uint32_t queue_size_;
   uint32_t messages_received_;
+
+  double latency_sum_;
+  uint32_t latency_count_;
+  ros::WallTime latency_status_time_;
 };
 
+/** @brief Hand @a msg to @a display if it is a MessageFilterDisplay
+ * for this message type.  See MessageFilterDisplay::injectMessage().
+ *
+ * Example, with a display made by VisualizationManager::createDisplay():
+ * @code
+ * sensor_msgs::PointCloud2ConstPtr cloud = ...;
+ * rviz::injectMessage( display, cloud );
+ * @endcode */
+template<class MessageType>
+bool injectMessage( Display* display, const boost::shared_ptr<MessageType const>& msg )
+{
+  MessageFilterDisplay<MessageType>* mf_display = dynamic_cast<MessageFilterDisplay<MessageType>*>( display );
+  if( !mf_display )
+  {
+    return false;
+  }
+  return mf_display->injectMessage( msg );
+}
+
 } // end namespace rviz
 
 #endif // MESSAGE_FILTER_DISPLAY_H
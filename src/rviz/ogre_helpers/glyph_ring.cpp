@@ -0,0 +1,616 @@
+/*
+ * Copyright (c) 2012, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "glyph_ring.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+#include <OgreCamera.h>
+#include <OgreHardwareBufferManager.h>
+#include <OgreMaterialManager.h>
+#include <OgrePass.h>
+#include <OgreRoot.h>
+#include <OgreSceneManager.h>
+#include <OgreSceneNode.h>
+#include <OgreTechnique.h>
+
+namespace rviz
+{
+
+namespace
+{
+
+// position (3 floats), normal (3 floats), packed color
+const size_t VERTEX_SIZE = 6 * sizeof( float ) + sizeof( uint32_t );
+
+const int CIRCLE_SEGMENTS = 12;
+const int SPHERE_STACKS = 8;
+
+/**
+ * Append a truncated cone along +X from @a x0 (radius @a r0) to @a x1
+ * (radius @a r1), rotated by @a rotation.  r1 == 0 gives a cone, r0 == r1
+ * a cylinder.
+ */
+void addFrustum( GlyphRing::V_Vertex& out, const Ogre::Quaternion& rotation,
+                 float x0, float x1, float r0, float r1,
+                 const Ogre::ColourValue& color, bool cap0, bool cap1 )
+{
+  const float height = x1 - x0;
+  for( int i = 0; i < CIRCLE_SEGMENTS; i++ )
+  {
+    float a0 = Ogre::Math::TWO_PI * i / CIRCLE_SEGMENTS;
+    float a1 = Ogre::Math::TWO_PI * ( i + 1 ) / CIRCLE_SEGMENTS;
+    Ogre::Vector3 d0( 0, Ogre::Math::Cos( a0 ), Ogre::Math::Sin( a0 ));
+    Ogre::Vector3 d1( 0, Ogre::Math::Cos( a1 ), Ogre::Math::Sin( a1 ));
+
+    Ogre::Vector3 b0 = Ogre::Vector3( x0, 0, 0 ) + d0 * r0;
+    Ogre::Vector3 b1 = Ogre::Vector3( x0, 0, 0 ) + d1 * r0;
+    Ogre::Vector3 t0 = Ogre::Vector3( x1, 0, 0 ) + d0 * r1;
+    Ogre::Vector3 t1 = Ogre::Vector3( x1, 0, 0 ) + d1 * r1;
+    Ogre::Vector3 n0 = ( Ogre::Vector3( r0 - r1, 0, 0 ) + d0 * height ).normalisedCopy();
+    Ogre::Vector3 n1 = ( Ogre::Vector3( r0 - r1, 0, 0 ) + d1 * height ).normalisedCopy();
+
+    out.push_back( GlyphRing::Vertex( rotation * b0, rotation * n0, color ));
+    out.push_back( GlyphRing::Vertex( rotation * b1, rotation * n1, color ));
+    out.push_back( GlyphRing::Vertex( rotation * t1, rotation * n1, color ));
+    if( r1 > 0 )
+    {
+      out.push_back( GlyphRing::Vertex( rotation * b0, rotation * n0, color ));
+      out.push_back( GlyphRing::Vertex( rotation * t1, rotation * n1, color ));
+      out.push_back( GlyphRing::Vertex( rotation * t0, rotation * n0, color ));
+    }
+
+    if( cap0 && r0 > 0 )
+    {
+      Ogre::Vector3 n = rotation * Ogre::Vector3::NEGATIVE_UNIT_X;
+      out.push_back( GlyphRing::Vertex( rotation * Ogre::Vector3( x0, 0, 0 ), n, color ));
+      out.push_back( GlyphRing::Vertex( rotation * b1, n, color ));
+      out.push_back( GlyphRing::Vertex( rotation * b0, n, color ));
+    }
+    if( cap1 && r1 > 0 )
+    {
+      Ogre::Vector3 n = rotation * Ogre::Vector3::UNIT_X;
+      out.push_back( GlyphRing::Vertex( rotation * Ogre::Vector3( x1, 0, 0 ), n, color ));
+      out.push_back( GlyphRing::Vertex( rotation * t0, n, color ));
+      out.push_back( GlyphRing::Vertex( rotation * t1, n, color ));
+    }
+  }
+}
+
+} // namespace
+
+GlyphRingRenderable::GlyphRingRenderable()
+{
+  mRenderOp.operationType = Ogre::RenderOperation::OT_TRIANGLE_LIST;
+  mRenderOp.useIndexes = false;
+  mRenderOp.vertexData = new Ogre::VertexData;
+  mRenderOp.vertexData->vertexStart = 0;
+  mRenderOp.vertexData->vertexCount = 0;
+
+  Ogre::VertexDeclaration* decl = mRenderOp.vertexData->vertexDeclaration;
+  size_t offset = 0;
+  decl->addElement( 0, offset, Ogre::VET_FLOAT3, Ogre::VES_POSITION );
+  offset += Ogre::VertexElement::getTypeSize( Ogre::VET_FLOAT3 );
+  decl->addElement( 0, offset, Ogre::VET_FLOAT3, Ogre::VES_NORMAL );
+  offset += Ogre::VertexElement::getTypeSize( Ogre::VET_FLOAT3 );
+  decl->addElement( 0, offset, Ogre::VET_COLOUR, Ogre::VES_DIFFUSE );
+}
+
+GlyphRingRenderable::~GlyphRingRenderable()
+{
+  delete mRenderOp.vertexData;
+}
+
+Ogre::Real GlyphRingRenderable::getBoundingRadius() const
+{
+  if( mBox.isNull() )
+  {
+    return 0;
+  }
+  return Ogre::Math::Sqrt( std::max( mBox.getMaximum().squaredLength(), mBox.getMinimum().squaredLength() ));
+}
+
+Ogre::Real GlyphRingRenderable::getSquaredViewDepth( const Ogre::Camera* cam ) const
+{
+  Ogre::Vector3 center = mParentNode ? mParentNode->_getDerivedPosition() : Ogre::Vector3::ZERO;
+  if( !mBox.isNull() )
+  {
+    center += mBox.getCenter();
+  }
+  return ( cam->getDerivedPosition() - center ).squaredLength();
+}
+
+GlyphRing::GlyphRing( Ogre::SceneManager* scene_manager, Ogre::SceneNode* parent_node, size_t capacity )
+: scene_manager_( scene_manager )
+, transparent_( false )
+, glyph_radius_( 0 )
+, glyph_offset_radius_( 0 )
+, next_( 0 )
+, capacity_( capacity )
+, slots_( 0 )
+{
+  if( !parent_node )
+  {
+    parent_node = scene_manager_->getRootSceneNode();
+  }
+  scene_node_ = parent_node->createChildSceneNode();
+
+  static int count = 0;
+  std::stringstream ss;
+  ss << "GlyphRingMaterial" << count++;
+  material_ = Ogre::MaterialManager::getSingleton().create( ss.str(), Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME );
+  material_->setReceiveShadows( false );
+  material_->getTechnique( 0 )->setLightingEnabled( true );
+  material_->getTechnique( 0 )->getPass( 0 )->setVertexColourTracking( Ogre::TVC_AMBIENT | Ogre::TVC_DIFFUSE );
+
+  renderable_ = new GlyphRingRenderable();
+  renderable_->setMaterial( material_->getName() );
+  scene_node_->attachObject( renderable_ );
+}
+
+GlyphRing::~GlyphRing()
+{
+  scene_node_->detachAllObjects();
+  delete renderable_;
+  scene_manager_->destroySceneNode( scene_node_ );
+  Ogre::MaterialManager::getSingleton().remove( material_->getName() );
+}
+
+void GlyphRing::setGlyph( const V_Vertex& triangles )
+{
+  glyph_ = triangles;
+  glyph_radius_ = 0;
+  glyph_offset_radius_ = 0;
+  for( size_t i = 0; i < glyph_.size(); i++ )
+  {
+    glyph_radius_ = std::max( glyph_radius_, glyph_[ i ].position.length() );
+    glyph_offset_radius_ = std::max( glyph_offset_radius_, glyph_[ i ].offset.length() );
+  }
+  staging_.resize( glyph_.size() * VERTEX_SIZE );
+
+  // The slot size changed, so the old buffer cannot be reused.
+  releaseSlots();
+  writeAll();
+}
+
+void GlyphRing::setCapacity( size_t capacity )
+{
+  if( capacity == capacity_ )
+  {
+    return;
+  }
+  capacity_ = capacity;
+
+  // Put the instances back in chronological order, then drop the oldest.
+  std::rotate( instances_.begin(), instances_.begin() + next_, instances_.end() );
+  next_ = 0;
+  if( capacity_ > 0 && instances_.size() > capacity_ )
+  {
+    instances_.erase( instances_.begin(), instances_.end() - capacity_ );
+  }
+  if( capacity_ > 0 && slots_ > capacity_ )
+  {
+    releaseSlots();
+  }
+  writeAll();
+}
+
+void GlyphRing::push( const Ogre::Vector3& position, const Ogre::Quaternion& orientation,
+                      const Ogre::Vector3& scale, const Ogre::ColourValue& color )
+{
+  Instance instance;
+  instance.position = position;
+  instance.orientation = orientation;
+  instance.scale = scale;
+  instance.color = color;
+
+  size_t index;
+  bool wrapped = false;
+  if( capacity_ > 0 && instances_.size() >= capacity_ )
+  {
+    index = next_;
+    next_ = ( next_ + 1 ) % capacity_;
+    instances_[ index ] = instance;
+    wrapped = ( next_ == 0 );
+  }
+  else
+  {
+    index = instances_.size();
+    instances_.push_back( instance );
+  }
+
+  updateMaterial( color );
+  if( index >= slots_ )
+  {
+    // Growing the buffer re-bakes every slot, including the new one.
+    writeAll();
+    return;
+  }
+
+  writeSlot( index );
+  renderable_->mRenderOp.vertexData->vertexCount = instances_.size() * glyph_.size();
+  renderable_->setVisible( true );
+
+  // Bounds only grow while instances are overwritten; once every slot has
+  // been replaced, shrink them back to what is still shown.
+  if( wrapped )
+  {
+    resetBounds();
+  }
+  else
+  {
+    updateBounds( instance );
+  }
+}
+
+void GlyphRing::clear()
+{
+  instances_.clear();
+  next_ = 0;
+  writeAll();
+}
+
+void GlyphRing::setColor( const Ogre::ColourValue& color )
+{
+  for( size_t i = 0; i < instances_.size(); i++ )
+  {
+    instances_[ i ].color = color;
+  }
+  updateMaterial( color );
+  writeAll();
+}
+
+void GlyphRing::setVisible( bool visible )
+{
+  scene_node_->setVisible( visible, true );
+}
+
+void GlyphRing::reserveSlots( size_t slots )
+{
+  if( slots <= slots_ || glyph_.empty() )
+  {
+    return;
+  }
+
+  // Grow geometrically so that filling an unbounded ring stays amortized
+  // O(1), but never past the capacity.
+  size_t new_slots = std::max( slots, std::max( slots_ * 2, (size_t) 16 ));
+  if( capacity_ > 0 )
+  {
+    new_slots = std::max( slots, std::min( new_slots, capacity_ ));
+  }
+
+  Ogre::HardwareVertexBufferSharedPtr vbuf =
+    Ogre::HardwareBufferManager::getSingleton().createVertexBuffer(
+      VERTEX_SIZE, new_slots * glyph_.size(), Ogre::HardwareBuffer::HBU_DYNAMIC_WRITE_ONLY );
+  renderable_->mRenderOp.vertexData->vertexBufferBinding->setBinding( 0, vbuf );
+  slots_ = new_slots;
+}
+
+void GlyphRing::releaseSlots()
+{
+  renderable_->mRenderOp.vertexData->vertexBufferBinding->unsetAllBindings();
+  renderable_->mRenderOp.vertexData->vertexCount = 0;
+  slots_ = 0;
+}
+
+namespace
+{
+
+void bake( const GlyphRing::V_Vertex& glyph, const Ogre::Vector3& position, const Ogre::Quaternion& orientation,
+           const Ogre::Vector3& scale, const Ogre::ColourValue& color, uint8_t* dest )
+{
+  Ogre::Root* root = Ogre::Root::getSingletonPtr();
+  Ogre::Vector3 inverse_scale( scale.x != 0 ? 1 / scale.x : 0,
+                               scale.y != 0 ? 1 / scale.y : 0,
+                               scale.z != 0 ? 1 / scale.z : 0 );
+  // Collapse hidden instances onto their position, offsets included.
+  const bool hidden = ( scale == Ogre::Vector3::ZERO );
+  for( size_t i = 0; i < glyph.size(); i++ )
+  {
+    const GlyphRing::Vertex& v = glyph[ i ];
+    Ogre::Vector3 p = hidden ? position : position + orientation * ( scale * v.position + v.offset );
+    Ogre::Vector3 n = orientation * ( inverse_scale * v.normal );
+    n.normalise();
+    uint32_t c;
+    root->convertColourValue( v.color * color, &c );
+
+    float* f = reinterpret_cast<float*>( dest );
+    f[ 0 ] = p.x;
+    f[ 1 ] = p.y;
+    f[ 2 ] = p.z;
+    f[ 3 ] = n.x;
+    f[ 4 ] = n.y;
+    f[ 5 ] = n.z;
+    *reinterpret_cast<uint32_t*>( f + 6 ) = c;
+    dest += VERTEX_SIZE;
+  }
+}
+
+} // namespace
+
+void GlyphRing::writeSlot( size_t index )
+{
+  if( glyph_.empty() )
+  {
+    return;
+  }
+
+  const Instance& instance = instances_[ index ];
+  bake( glyph_, instance.position, instance.orientation, instance.scale, instance.color, &staging_[ 0 ] );
+
+  const size_t slot_size = staging_.size();
+  renderable_->mRenderOp.vertexData->vertexBufferBinding->getBuffer( 0 )->writeData(
+    index * slot_size, slot_size, &staging_[ 0 ] );
+}
+
+void GlyphRing::writeAll()
+{
+  bounds_.setNull();
+  renderable_->mRenderOp.vertexData->vertexCount = 0;
+
+  if( !glyph_.empty() && !instances_.empty() )
+  {
+    reserveSlots( instances_.size() );
+
+    Ogre::HardwareVertexBufferSharedPtr vbuf = renderable_->mRenderOp.vertexData->vertexBufferBinding->getBuffer( 0 );
+    uint8_t* dest = static_cast<uint8_t*>( vbuf->lock( Ogre::HardwareBuffer::HBL_DISCARD ));
+    for( size_t i = 0; i < instances_.size(); i++ )
+    {
+      const Instance& instance = instances_[ i ];
+      bake( glyph_, instance.position, instance.orientation, instance.scale, instance.color, dest );
+      dest += staging_.size();
+      bounds_.merge( getBounds( instance ));
+    }
+    vbuf->unlock();
+
+    renderable_->mRenderOp.vertexData->vertexCount = instances_.size() * glyph_.size();
+  }
+
+  // Nothing is bound while the ring is empty, so keep Ogre from drawing it.
+  renderable_->setVisible( renderable_->mRenderOp.vertexData->vertexCount > 0 );
+  renderable_->setBoundingBox( bounds_ );
+  scene_node_->needUpdate();
+}
+
+Ogre::AxisAlignedBox GlyphRing::getBounds( const Instance& instance ) const
+{
+  if( instance.scale == Ogre::Vector3::ZERO )
+  {
+    return Ogre::AxisAlignedBox( instance.position, instance.position );
+  }
+  float radius = glyph_radius_ * std::max( std::abs( instance.scale.x ),
+                                           std::max( std::abs( instance.scale.y ), std::abs( instance.scale.z )))
+               + glyph_offset_radius_;
+  return Ogre::AxisAlignedBox( instance.position - Ogre::Vector3( radius ), instance.position + Ogre::Vector3( radius ));
+}
+
+void GlyphRing::updateBounds( const Instance& instance )
+{
+  Ogre::AxisAlignedBox box = getBounds( instance );
+  if( bounds_.contains( box ))
+  {
+    return;
+  }
+  bounds_.merge( box );
+  renderable_->setBoundingBox( bounds_ );
+  scene_node_->needUpdate();
+}
+
+void GlyphRing::resetBounds()
+{
+  bounds_.setNull();
+  for( size_t i = 0; i < instances_.size(); i++ )
+  {
+    bounds_.merge( getBounds( instances_[ i ] ));
+  }
+  renderable_->setBoundingBox( bounds_ );
+  scene_node_->needUpdate();
+}
+
+void GlyphRing::updateMaterial( const Ogre::ColourValue& color )
+{
+  bool transparent = color.a < 0.9998;
+  if( transparent == transparent_ )
+  {
+    return;
+  }
+  transparent_ = transparent;
+
+  if( transparent_ )
+  {
+    material_->getTechnique( 0 )->setSceneBlending( Ogre::SBT_TRANSPARENT_ALPHA );
+    material_->getTechnique( 0 )->setDepthWriteEnabled( false );
+  }
+  else
+  {
+    material_->getTechnique( 0 )->setSceneBlending( Ogre::SBT_REPLACE );
+    material_->getTechnique( 0 )->setDepthWriteEnabled( true );
+  }
+}
+
+GlyphRing::V_Vertex GlyphRing::makeArrow( float shaft_length, float shaft_diameter, float head_length, float head_diameter )
+{
+  V_Vertex out;
+  if( shaft_length > 0 )
+  {
+    addFrustum( out, Ogre::Quaternion::IDENTITY, 0, shaft_length, shaft_diameter / 2, shaft_diameter / 2,
+                Ogre::ColourValue::White, true, false );
+  }
+  addFrustum( out, Ogre::Quaternion::IDENTITY, shaft_length, shaft_length + head_length, head_diameter / 2, 0,
+              Ogre::ColourValue::White, true, false );
+  return out;
+}
+
+GlyphRing::V_Vertex GlyphRing::makeAxes( float length, float diameter )
+{
+  V_Vertex out;
+  float r = diameter / 2;
+  addFrustum( out, Ogre::Quaternion::IDENTITY, 0, length, r, r,
+              Ogre::ColourValue( 1.0f, 0.0f, 0.0f, 1.0f ), true, true );
+  addFrustum( out, Ogre::Quaternion( Ogre::Degree( 90 ), Ogre::Vector3::UNIT_Z ), 0, length, r, r,
+              Ogre::ColourValue( 0.0f, 1.0f, 0.0f, 1.0f ), true, true );
+  addFrustum( out, Ogre::Quaternion( Ogre::Degree( -90 ), Ogre::Vector3::UNIT_Y ), 0, length, r, r,
+              Ogre::ColourValue( 0.0f, 0.0f, 1.0f, 1.0f ), true, true );
+  return out;
+}
+
+GlyphRing::V_Vertex GlyphRing::makeSphere( float diameter )
+{
+  const float r = diameter / 2;
+  V_Vertex out;
+  for( int i = 0; i < SPHERE_STACKS; i++ )
+  {
+    float p0 = Ogre::Math::PI * i / SPHERE_STACKS;
+    float p1 = Ogre::Math::PI * ( i + 1 ) / SPHERE_STACKS;
+    for( int j = 0; j < CIRCLE_SEGMENTS; j++ )
+    {
+      float t0 = Ogre::Math::TWO_PI * j / CIRCLE_SEGMENTS;
+      float t1 = Ogre::Math::TWO_PI * ( j + 1 ) / CIRCLE_SEGMENTS;
+      Ogre::Vector3 n00( Ogre::Math::Sin( p0 ) * Ogre::Math::Cos( t0 ), Ogre::Math::Sin( p0 ) * Ogre::Math::Sin( t0 ), Ogre::Math::Cos( p0 ));
+      Ogre::Vector3 n10( Ogre::Math::Sin( p1 ) * Ogre::Math::Cos( t0 ), Ogre::Math::Sin( p1 ) * Ogre::Math::Sin( t0 ), Ogre::Math::Cos( p1 ));
+      Ogre::Vector3 n11( Ogre::Math::Sin( p1 ) * Ogre::Math::Cos( t1 ), Ogre::Math::Sin( p1 ) * Ogre::Math::Sin( t1 ), Ogre::Math::Cos( p1 ));
+      Ogre::Vector3 n01( Ogre::Math::Sin( p0 ) * Ogre::Math::Cos( t1 ), Ogre::Math::Sin( p0 ) * Ogre::Math::Sin( t1 ), Ogre::Math::Cos( p0 ));
+
+      out.push_back( Vertex( n00 * r, n00 ));
+      out.push_back( Vertex( n10 * r, n10 ));
+      out.push_back( Vertex( n11 * r, n11 ));
+      out.push_back( Vertex( n00 * r, n00 ));
+      out.push_back( Vertex( n11 * r, n11 ));
+      out.push_back( Vertex( n01 * r, n01 ));
+    }
+  }
+  return out;
+}
+
+GlyphRing::V_Vertex GlyphRing::makeCylinder()
+{
+  V_Vertex out;
+  addFrustum( out, Ogre::Quaternion( Ogre::Degree( 90 ), Ogre::Vector3::UNIT_Z ), -0.5f, 0.5f, 0.5f, 0.5f,
+              Ogre::ColourValue::White, true, true );
+  return out;
+}
+
+GlyphRing::V_Vertex GlyphRing::makeCone()
+{
+  V_Vertex out;
+  addFrustum( out, Ogre::Quaternion( Ogre::Degree( 90 ), Ogre::Vector3::UNIT_Z ), -0.5f, 0.5f, 0.5f, 0,
+              Ogre::ColourValue::White, true, false );
+  return out;
+}
+
+GlyphRing::V_Vertex GlyphRing::makeArc( float radius, float diameter, float start_angle, float end_angle )
+{
+  // The circle goes into the vertex positions, which scale with the
+  // instance, and the tube around it into the offsets, which do not.
+  V_Vertex out;
+  const int segments = std::max( 1, (int) Ogre::Math::Ceil( 32 * std::abs( end_angle - start_angle ) / Ogre::Math::TWO_PI ));
+  const float tube_radius = diameter / 2;
+  // Direction of travel along the circle, for the cap normals.
+  const float sign = end_angle < start_angle ? -1 : 1;
+  for( int i = 0; i < segments; i++ )
+  {
+    float a0 = start_angle + ( end_angle - start_angle ) * i / segments;
+    float a1 = start_angle + ( end_angle - start_angle ) * ( i + 1 ) / segments;
+    Ogre::Vector3 r0( Ogre::Math::Cos( a0 ), Ogre::Math::Sin( a0 ), 0 );
+    Ogre::Vector3 r1( Ogre::Math::Cos( a1 ), Ogre::Math::Sin( a1 ), 0 );
+    for( int j = 0; j < CIRCLE_SEGMENTS; j++ )
+    {
+      float b0 = Ogre::Math::TWO_PI * j / CIRCLE_SEGMENTS;
+      float b1 = Ogre::Math::TWO_PI * ( j + 1 ) / CIRCLE_SEGMENTS;
+      Ogre::Vector3 d00 = r0 * Ogre::Math::Cos( b0 ) + Ogre::Vector3::UNIT_Z * Ogre::Math::Sin( b0 );
+      Ogre::Vector3 d01 = r0 * Ogre::Math::Cos( b1 ) + Ogre::Vector3::UNIT_Z * Ogre::Math::Sin( b1 );
+      Ogre::Vector3 d10 = r1 * Ogre::Math::Cos( b0 ) + Ogre::Vector3::UNIT_Z * Ogre::Math::Sin( b0 );
+      Ogre::Vector3 d11 = r1 * Ogre::Math::Cos( b1 ) + Ogre::Vector3::UNIT_Z * Ogre::Math::Sin( b1 );
+
+      out.push_back( Vertex( r0 * radius, d00, Ogre::ColourValue::White, d00 * tube_radius ));
+      out.push_back( Vertex( r1 * radius, d10, Ogre::ColourValue::White, d10 * tube_radius ));
+      out.push_back( Vertex( r1 * radius, d11, Ogre::ColourValue::White, d11 * tube_radius ));
+      out.push_back( Vertex( r0 * radius, d00, Ogre::ColourValue::White, d00 * tube_radius ));
+      out.push_back( Vertex( r1 * radius, d11, Ogre::ColourValue::White, d11 * tube_radius ));
+      out.push_back( Vertex( r0 * radius, d01, Ogre::ColourValue::White, d01 * tube_radius ));
+
+      if( i == 0 )
+      {
+        Ogre::Vector3 n = Ogre::Vector3( Ogre::Math::Sin( a0 ), -Ogre::Math::Cos( a0 ), 0 ) * sign;
+        out.push_back( Vertex( r0 * radius, n ));
+        out.push_back( Vertex( r0 * radius, n, Ogre::ColourValue::White, d00 * tube_radius ));
+        out.push_back( Vertex( r0 * radius, n, Ogre::ColourValue::White, d01 * tube_radius ));
+      }
+      if( i == segments - 1 )
+      {
+        Ogre::Vector3 n = Ogre::Vector3( -Ogre::Math::Sin( a1 ), Ogre::Math::Cos( a1 ), 0 ) * sign;
+        out.push_back( Vertex( r1 * radius, n ));
+        out.push_back( Vertex( r1 * radius, n, Ogre::ColourValue::White, d11 * tube_radius ));
+        out.push_back( Vertex( r1 * radius, n, Ogre::ColourValue::White, d10 * tube_radius ));
+      }
+    }
+  }
+
+  // The triangles above wind counter-clockwise seen from outside only for
+  // counter-clockwise arcs; flip them for clockwise ones.
+  if( sign < 0 )
+  {
+    for( size_t i = 0; i < out.size(); i += 3 )
+    {
+      std::swap( out[ i + 1 ], out[ i + 2 ] );
+    }
+  }
+  return out;
+}
+
+void GlyphRing::appendGlyph( V_Vertex& out, const V_Vertex& glyph,
+                             const Ogre::Vector3& position, const Ogre::Quaternion& orientation )
+{
+  out.reserve( out.size() + glyph.size() );
+  for( size_t i = 0; i < glyph.size(); i++ )
+  {
+    out.push_back( Vertex( position + orientation * glyph[ i ].position,
+                           orientation * glyph[ i ].normal,
+                           glyph[ i ].color,
+                           orientation * glyph[ i ].offset ));
+  }
+}
+
+void GlyphRing::appendUnscaledGlyph( V_Vertex& out, const V_Vertex& glyph,
+                                     const Ogre::Vector3& anchor, const Ogre::Quaternion& orientation )
+{
+  out.reserve( out.size() + glyph.size() );
+  for( size_t i = 0; i < glyph.size(); i++ )
+  {
+    out.push_back( Vertex( anchor,
+                           orientation * glyph[ i ].normal,
+                           glyph[ i ].color,
+                           orientation * ( glyph[ i ].position + glyph[ i ].offset )));
+  }
+}
+
+} // namespace rviz
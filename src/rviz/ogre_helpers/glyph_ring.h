@@ -0,0 +1,236 @@
+/*
+ * Copyright (c) 2012, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RVIZ_GLYPH_RING_H
+#define RVIZ_GLYPH_RING_H
+
+#include <stdint.h>
+
+#include <vector>
+
+#include <OgreAxisAlignedBox.h>
+#include <OgreColourValue.h>
+#include <OgreMaterial.h>
+#include <OgreQuaternion.h>
+#include <OgreSharedPtr.h>
+#include <OgreSimpleRenderable.h>
+#include <OgreVector3.h>
+
+#include "rviz/rviz_export.h"
+
+namespace Ogre
+{
+class SceneManager;
+class SceneNode;
+}
+
+namespace rviz
+{
+
+class GlyphRing;
+
+/** @brief Renderable holding every instance of a GlyphRing in one vertex buffer. */
+class GlyphRingRenderable : public Ogre::SimpleRenderable
+{
+public:
+  GlyphRingRenderable();
+  ~GlyphRingRenderable();
+
+  virtual Ogre::Real getBoundingRadius() const;
+  virtual Ogre::Real getSquaredViewDepth( const Ogre::Camera* cam ) const;
+
+private:
+  friend class GlyphRing;
+};
+
+/**
+ * \class GlyphRing
+ * \brief A fixed-capacity history of identical glyphs (arrows, axes,
+ * spheres, ...) drawn with a single draw call.
+ *
+ * Each instance is baked into its own slot of one dynamic vertex
+ * buffer: pushing a new sample overwrites the oldest slot in place, so
+ * push() is O(1) and does not create or destroy any Ogre objects once
+ * the buffer has reached its capacity.  The color of an instance is
+ * multiplied with the per-vertex color of the glyph template, which lets
+ * multi-colored glyphs like axes share the same code path as plain ones.
+ *
+ * Like the other ogre_helpers, GlyphRing must only be used from the
+ * render thread.
+ */
+class RVIZ_EXPORT GlyphRing
+{
+public:
+  /**
+   * @brief One vertex of a glyph template, in glyph-local coordinates.
+   *
+   * The instance scale applies to @a position only; @a offset is added
+   * after scaling, so parts built from offsets (like the tube of an arc)
+   * keep their size in world units however an instance is scaled.
+   */
+  struct Vertex
+  {
+    Vertex() {}
+    Vertex( const Ogre::Vector3& p, const Ogre::Vector3& n, const Ogre::ColourValue& c = Ogre::ColourValue::White,
+            const Ogre::Vector3& o = Ogre::Vector3::ZERO )
+    : position( p ), normal( n ), color( c ), offset( o ) {}
+
+    Ogre::Vector3 position;
+    Ogre::Vector3 normal;
+    Ogre::ColourValue color;
+    Ogre::Vector3 offset;
+  };
+  typedef std::vector<Vertex> V_Vertex;
+
+  /**
+   * @brief Constructor
+   * @param scene_manager The scene manager this object is associated with
+   * @param parent_node A scene node to use as the parent of this object.  If NULL, uses the root scene node.
+   * @param capacity The number of instances to keep.  0 means unlimited.
+   */
+  GlyphRing( Ogre::SceneManager* scene_manager, Ogre::SceneNode* parent_node = 0, size_t capacity = 0 );
+  ~GlyphRing();
+
+  /**
+   * @brief Set the glyph template as a triangle list (three vertices per
+   * triangle).  Existing instances are re-baked with the new glyph.
+   */
+  void setGlyph( const V_Vertex& triangles );
+
+  /**
+   * @brief Set the number of instances to keep.  If the ring holds more
+   * than that, only the newest ones are kept.  0 means unlimited.
+   */
+  void setCapacity( size_t capacity );
+  size_t getCapacity() const { return capacity_; }
+
+  /**
+   * @brief Add an instance, replacing the oldest one if the ring is full.
+   * A zero @a scale hides the instance while it still takes its slot.
+   */
+  void push( const Ogre::Vector3& position, const Ogre::Quaternion& orientation,
+             const Ogre::Vector3& scale, const Ogre::ColourValue& color );
+
+  /** @brief Remove all instances. */
+  void clear();
+
+  /** @brief Change the color of every instance. */
+  void setColor( const Ogre::ColourValue& color );
+
+  void setVisible( bool visible );
+
+  /** @brief Number of instances currently shown. */
+  size_t size() const { return instances_.size(); }
+
+  Ogre::SceneNode* getSceneNode() { return scene_node_; }
+
+  /**
+   * @brief Arrow pointing along +X, starting at the origin.  Like
+   * rviz::Arrow, the sizes given as "diameter" are full widths.
+   */
+  static V_Vertex makeArrow( float shaft_length, float shaft_diameter, float head_length, float head_diameter );
+
+  /** @brief Red, green and blue cylinders along X, Y and Z, like rviz::Axes. */
+  static V_Vertex makeAxes( float length, float diameter );
+
+  /** @brief Sphere centered on the origin. */
+  static V_Vertex makeSphere( float diameter = 1.0f );
+
+  /** @brief Cylinder of unit diameter and height along Y, centered on the origin, like Shape::Cylinder. */
+  static V_Vertex makeCylinder();
+
+  /** @brief Cone of unit diameter and height along Y with its tip at y = 0.5. */
+  static V_Vertex makeCone();
+
+  /**
+   * @brief Tube bent along a circle of @a radius around +Z, in the XY
+   * plane.  Angles are in radians, counter-clockwise from +X.  Only the
+   * circle scales with an instance; the tube keeps its @a diameter.
+   */
+  static V_Vertex makeArc( float radius, float diameter, float start_angle, float end_angle );
+
+  /** @brief Append @a glyph to @a out, moved to @a position and rotated by @a orientation. */
+  static void appendGlyph( V_Vertex& out, const V_Vertex& glyph,
+                           const Ogre::Vector3& position, const Ogre::Quaternion& orientation );
+
+  /**
+   * @brief Append @a glyph to @a out as a rigid part pinned at @a anchor:
+   * the anchor moves with the instance scale, but the part itself keeps
+   * its size, e.g. an arrow head at the end of an arc.
+   */
+  static void appendUnscaledGlyph( V_Vertex& out, const V_Vertex& glyph,
+                                   const Ogre::Vector3& anchor, const Ogre::Quaternion& orientation );
+
+private:
+  struct Instance
+  {
+    Ogre::Vector3 position;
+    Ogre::Quaternion orientation;
+    Ogre::Vector3 scale;
+    Ogre::ColourValue color;
+  };
+
+  /** @brief Make sure the vertex buffer holds at least @a slots instances. */
+  void reserveSlots( size_t slots );
+  /** @brief Drop the vertex buffer; the next writeAll() allocates a fitting one. */
+  void releaseSlots();
+  /** @brief Bake instance @a index into its slot of the vertex buffer. */
+  void writeSlot( size_t index );
+  /** @brief Re-bake every instance, e.g. after the glyph changed. */
+  void writeAll();
+  Ogre::AxisAlignedBox getBounds( const Instance& instance ) const;
+  void updateBounds( const Instance& instance );
+  /** @brief Recompute the bounds from the instances, dropping those of overwritten ones. */
+  void resetBounds();
+  void updateMaterial( const Ogre::ColourValue& color );
+
+  Ogre::SceneManager* scene_manager_;
+  Ogre::SceneNode* scene_node_;
+  GlyphRingRenderable* renderable_;
+  Ogre::MaterialPtr material_;
+  bool transparent_;
+
+  V_Vertex glyph_;
+  float glyph_radius_;          ///< Largest distance of a vertex position from the origin
+  float glyph_offset_radius_;   ///< Largest vertex offset
+
+  std::vector<Instance> instances_;
+  /** Index of the slot the next push() writes to once the ring is full. */
+  size_t next_;
+  size_t capacity_;
+  size_t slots_;
+
+  /** Staging area for one baked slot, reused across push() calls. */
+  std::vector<uint8_t> staging_;
+  Ogre::AxisAlignedBox bounds_;
+};
+
+} // namespace rviz
+
+#endif // RVIZ_GLYPH_RING_H
@@ -37,6 +37,8 @@
 #include <OgreManualObject.h>
 #include <OgreMaterialManager.h>
 #include <OgreTechnique.h>
+#include <OgrePass.h>
+#include <OgreGpuProgramParams.h>
 
 #include <sstream>
 
@@ -73,6 +75,16 @@ Grid::Grid( Ogre::SceneManager* scene_manager, Ogre::SceneNode* parent_node, Sty
   material_->setReceiveShadows(false);
   material_->getTechnique(0)->setLightingEnabled(false);
 
+  Ogre::MaterialPtr grid_material = Ogre::MaterialManager::getSingleton().getByName( "rviz/Grid" );
+  if ( !grid_material.isNull() )
+  {
+    grid_material->load();
+    if ( grid_material->getNumSupportedTechniques() > 0 )
+    {
+      plane_material_ = grid_material->clone( ss.str() + "Plane" );
+    }
+  }
+
   setColor(color_);
 }
 
@@ -84,6 +96,10 @@ Grid::~Grid()
   scene_manager_->destroyManualObject( manual_object_ );
 
   material_->unload();
+  if ( !plane_material_.isNull() )
+  {
+    plane_material_->unload();
+  }
 }
 
 void Grid::setCellCount(uint32_t count)
@@ -122,7 +138,14 @@ void Grid::setColor(const Ogre::ColourValue& color)
     material_->setDepthWriteEnabled( true );
   }
 
-  create();
+  if ( usePlane() )
+  {
+    updatePlaneParameters();
+  }
+  else
+  {
+    create();
+  }
 }
 
 void Grid::setStyle(Style style)
@@ -144,6 +167,12 @@ void Grid::create()
   manual_object_->clear();
   billboard_line_->clear();
 
+  if ( usePlane() )
+  {
+    createPlane();
+    return;
+  }
+
   float extent = (cell_length_*((double)cell_count_))/2;
 
   if (style_ == Billboards)
@@ -238,6 +267,46 @@ void Grid::create()
   }
 }
 
+bool Grid::usePlane() const
+{
+  // The quad only covers the horizontal layer, not the vertical lines of a 3D grid.
+  return !plane_material_.isNull() && height_ == 0;
+}
+
+void Grid::createPlane()
+{
+  updatePlaneParameters();
+
+  if ( cell_count_ == 0 || cell_length_ <= 0.0f )
+  {
+    return;
+  }
+
+  // Leave room for the outer lines, which straddle the edge of the grid.
+  float size = (cell_length_*((double)cell_count_))/2 + cell_length_/2 + line_width_;
+
+  manual_object_->estimateVertexCount( 4 );
+  manual_object_->begin( plane_material_->getName(), Ogre::RenderOperation::OT_TRIANGLE_STRIP );
+  manual_object_->position( -size, 0.0f, -size );
+  manual_object_->position( -size, 0.0f, size );
+  manual_object_->position( size, 0.0f, -size );
+  manual_object_->position( size, 0.0f, size );
+  manual_object_->end();
+}
+
+void Grid::updatePlaneParameters()
+{
+  // Unlike the line material, the plane keeps depth writes off even for an
+  // opaque color: its line edges and faded far cells are still blended.
+  Ogre::Pass* pass = plane_material_->getTechnique(0)->getPass(0);
+  Ogre::GpuProgramParametersSharedPtr params = pass->getFragmentProgramParameters();
+  params->setNamedConstant( "color", color_ );
+  params->setNamedConstant( "cell_length", Ogre::Real( cell_length_ ));
+  params->setNamedConstant( "extent", Ogre::Real( (cell_length_*((double)cell_count_))/2 ));
+  // Lines style draws hairlines, which the shader never lets get thinner than a pixel.
+  params->setNamedConstant( "line_width", Ogre::Real( style_ == Billboards ? line_width_ : 0.0f ));
+}
+
 void Grid::setUserData( const Ogre::Any& data )
 {
   manual_object_->getUserObjectBindings().setUserAny( data );
@@ -58,6 +58,9 @@ class BillboardLine;
  * \brief Displays a grid of cells, drawn with lines
  *
  * Displays a grid of cells, drawn with lines.  A grid with an identity orientation is drawn along the XZ plane.
+ *
+ * A flat grid is drawn as a single quad whose lines come from a fragment shader, so its cost does not depend
+ * on the number of cells.  Grids with a height, or without shader support, are built from lines or billboards.
  */
 class Grid
 {
@@ -114,6 +117,11 @@ public:
   uint32_t getHeight() { return height_; }
 
 private:
+  /** @brief Return true if the grid is drawn on the shader quad rather than from lines. */
+  bool usePlane() const;
+  void createPlane();
+  void updatePlaneParameters();
+
   Ogre::SceneManager* scene_manager_;
   Ogre::SceneNode* scene_node_;           ///< The scene node that this grid is attached to
   Ogre::ManualObject* manual_object_;     ///< The manual object used to draw the grid
@@ -121,6 +129,7 @@ private:
   BillboardLine* billboard_line_;
 
   Ogre::MaterialPtr material_;
+  Ogre::MaterialPtr plane_material_;      ///< Draws the lines on one quad, null if shaders are unsupported
 
   Style style_;
   uint32_t cell_count_;
@@ -43,6 +43,10 @@
 #include <OgreSharedPtr.h>
 #include <OgreTechnique.h>
 #include <OgreCamera.h>
+#include <OgreRoot.h>
+#include <OgreRenderSystem.h>
+#include <OgreRenderSystemCapabilities.h>
+#include <OgreHardwareBufferManager.h>
 
 #include <sstream>
 
@@ -129,13 +133,25 @@ static float g_box_vertices[6*6*3] =
 
 Ogre::String PointCloud::sm_Type = "PointCloud";
 
+static bool supportsInstancing()
+{
+#if OGRE_VERSION >= ((1 << 16) | (8 << 8))
+  Ogre::RenderSystem* render_system = Ogre::Root::getSingleton().getRenderSystem();
+  return render_system && render_system->getCapabilities()->hasCapability( Ogre::RSC_VERTEX_BUFFER_INSTANCE_DATA );
+#else
+  return false;
+#endif
+}
+
 PointCloud::PointCloud()
 : bounding_radius_( 0.0f )
 , point_count_( 0 )
+, reserved_points_( 0 )
 , common_direction_( Ogre::Vector3::NEGATIVE_UNIT_Z )
 , common_up_vector_( Ogre::Vector3::UNIT_Y )
 , color_by_index_(false)
 , current_mode_supports_geometry_shader_(false)
+, use_instancing_(false)
 {
   std::stringstream ss;
   static int count = 0;
@@ -198,6 +214,21 @@ const Ogre::AxisAlignedBox& PointCloud::getBoundingBox() const
   return bounding_box_;
 }
 
+size_t PointCloud::getCpuMemoryUsage() const
+{
+  return points_.capacity() * sizeof( Point );
+}
+
+size_t PointCloud::getGpuMemoryUsage() const
+{
+  size_t bytes = 0;
+  for( V_PointCloudRenderable::const_iterator it = renderables_.begin(); it != renderables_.end(); ++it )
+  {
+    bytes += (*it)->getBuffer()->getSizeInBytes();
+  }
+  return bytes;
+}
+
 float PointCloud::getBoundingRadius() const
 {
   return bounding_radius_;
@@ -211,6 +242,7 @@ void PointCloud::getWorldTransforms(Ogre::Matrix4* xform) const
 void PointCloud::clear()
 {
   point_count_ = 0;
+  reserved_points_ = 0;
   bounding_box_.setNull();
   bounding_radius_ = 0.0f;
 
@@ -328,6 +360,15 @@ void PointCloud::setRenderMode(RenderMode mode)
     ROS_ERROR("No techniques available for material [%s]", current_material_->getName().c_str());
   }
 
+  // Without geometry shaders, instance one mesh of corners per point if the
+  // render system can, instead of writing every corner of every point.
+  bool use_instancing = !current_mode_supports_geometry_shader_ && render_mode_ != RM_POINTS && supportsInstancing();
+  if (use_instancing != use_instancing_)
+  {
+    geom_support_changed = true;
+    use_instancing_ = use_instancing;
+  }
+
   if (geom_support_changed)
   {
     renderables_.clear();
@@ -443,14 +484,17 @@ void PointCloud::setAlpha(float alpha, bool per_point_alpha)
   }
 }
 
+void PointCloud::reserve( uint32_t num_points )
+{
+  reserved_points_ = num_points;
+}
+
 void PointCloud::addPoints(Point* points, uint32_t num_points)
 {
   if (num_points == 0)
   {
     return;
   }
-  Ogre::Root* root = Ogre::Root::getSingletonPtr();
-
   if ( points_.size() < point_count_ + num_points )
   {
     points_.resize( point_count_ + num_points );
@@ -477,38 +521,7 @@ void PointCloud::addPoints(Point* points, uint32_t num_points)
     }
   }
 
-  float* vertices = 0;
-  if (current_mode_supports_geometry_shader_)
-  {
-    vertices = g_point_vertices;
-  }
-  else
-  {
-    if (render_mode_ == RM_POINTS)
-    {
-      vertices = g_point_vertices;
-    }
-    else if (render_mode_ == RM_SQUARES)
-    {
-      vertices = g_billboard_vertices;
-    }
-    else if (render_mode_ == RM_FLAT_SQUARES)
-    {
-      vertices = g_billboard_vertices;
-    }
-    else if (render_mode_ == RM_SPHERES)
-    {
-      vertices = g_billboard_sphere_vertices;
-    }
-    else if (render_mode_ == RM_TILES)
-    {
-      vertices = g_billboard_vertices;
-    }
-    else if (render_mode_ == RM_BOXES)
-    {
-      vertices = g_box_vertices;
-    }
-  }
+  float* vertices = getVertices();
 
   PointCloudRenderablePtr rend;
   Ogre::HardwareVertexBufferSharedPtr vbuf;
@@ -519,9 +532,33 @@ void PointCloud::addPoints(Point* points, uint32_t num_points)
   Ogre::AxisAlignedBox aabb;
   aabb.setNull();
   uint32_t current_vertex_count = 0;
-  bounding_radius_ = 0.0f;
   uint32_t vertex_size = 0;
   uint32_t buffer_size = 0;
+
+  // Fill the room left at the end of the last renderable before creating new ones.
+  // popBackPoints() may have trimmed that room while a draw still reads it, so
+  // it is locked normally; only fresh buffers can be locked without a sync.
+  if (!renderables_.empty())
+  {
+    rend = renderables_.back();
+    op = rend->getRenderOperation();
+    vbuf = rend->getBuffer();
+    buffer_size = vbuf->getNumVertices();
+    current_vertex_count = op->vertexData->vertexStart + op->vertexData->vertexCount;
+    if (current_vertex_count < buffer_size)
+    {
+      vertex_size = op->vertexData->vertexDeclaration->getVertexSize(0);
+      vdata = vbuf->lock(current_vertex_count * vertex_size, (buffer_size - current_vertex_count) * vertex_size,
+                         Ogre::HardwareBuffer::HBL_NORMAL);
+      fptr = (float*)vdata;
+      aabb = rend->getBoundingBox();
+    }
+    else
+    {
+      rend.reset();
+    }
+  }
+
   for (uint32_t current_point = 0; current_point < num_points; ++current_point)
   {
     // if we didn't create a renderable yet,
@@ -540,7 +577,14 @@ void PointCloud::addPoints(Point* points, uint32_t num_points)
         bounding_box_.merge(aabb);
       }
 
-      buffer_size = std::min<int>( VERTEX_BUFFER_CAPACITY, (num_points - current_point)*vpp );
+      // Size the buffer for whatever was reserve()d beyond this batch, so
+      // later batches append to it instead of each getting a renderable.
+      uint32_t buffer_points = num_points - current_point;
+      if (reserved_points_ > point_count_ + num_points)
+      {
+        buffer_points += reserved_points_ - (point_count_ + num_points);
+      }
+      buffer_size = std::min<uint32_t>( VERTEX_BUFFER_CAPACITY, buffer_points*vpp );
 
       rend = createRenderable( buffer_size );
       vbuf = rend->getBuffer();
@@ -558,50 +602,13 @@ void PointCloud::addPoints(Point* points, uint32_t num_points)
 
     const Point& p = points[current_point];
 
-    uint32_t color;
-
-    if (color_by_index_)
-    {
-      // convert to ColourValue, so we can then convert to the rendersystem-specific color type
-      color = (current_point + point_count_ + 1);
-      Ogre::ColourValue c;
-      c.a = 1.0f;
-      c.r = ((color >> 16) & 0xff) / 255.0f;
-      c.g = ((color >> 8) & 0xff) / 255.0f;
-      c.b = (color & 0xff) / 255.0f;
-      root->convertColourValue(c, &color);
-    }
-    else
-    {
-      root->convertColourValue( p.color, &color );
-    }
-
     aabb.merge(p.position);
     bounding_radius_ = std::max( bounding_radius_, p.position.squaredLength() );
 
-    float x = p.position.x;
-    float y = p.position.y;
-    float z = p.position.z;
-
-    for (uint32_t j = 0; j < vpp; ++j, ++current_vertex_count)
-    {
-      *fptr++ = x;
-      *fptr++ = y;
-      *fptr++ = z;
-
-      if (!current_mode_supports_geometry_shader_)
-      {
-        *fptr++ = vertices[(j*3)];
-        *fptr++ = vertices[(j*3) + 1];
-        *fptr++ = vertices[(j*3) + 2];
-      }
-
-      uint32_t* iptr = (uint32_t*)fptr;
-      *iptr = color;
-      ++fptr;
+    fptr = writePoint( fptr, p, current_point + point_count_, vertices, vpp );
+    current_vertex_count += vpp;
 
-      ROS_ASSERT((uint8_t*)fptr <= (uint8_t*)vdata + rend->getBuffer()->getNumVertices() * vertex_size);
-    }
+    ROS_ASSERT(current_vertex_count <= buffer_size);
   }
 
   op->vertexData->vertexCount = current_vertex_count - op->vertexData->vertexStart;
@@ -621,6 +628,80 @@ void PointCloud::addPoints(Point* points, uint32_t num_points)
   }
 }
 
+void PointCloud::updatePoints( const uint32_t* indices, Point* points, uint32_t num_points )
+{
+  if ( num_points == 0 )
+  {
+    return;
+  }
+
+  for ( uint32_t i = 0; i < num_points; ++i )
+  {
+    ROS_ASSERT( indices[i] < point_count_ && ( i == 0 || indices[i - 1] < indices[i] ));
+    points_[indices[i]] = points[i];
+  }
+
+  uint32_t vpp = getVerticesPerPoint();
+  float* vertices = getVertices();
+
+  // Each renderable holds a consecutive run of the points, starting at its
+  // vertexStart.  Walk them once alongside the sorted indices and lock each
+  // renderable at most once, over the span from its first to its last update.
+  uint32_t current_point = 0;
+  uint32_t rend_first = 0;
+  for ( V_PointCloudRenderable::iterator it = renderables_.begin();
+        it != renderables_.end() && current_point < num_points; ++it )
+  {
+    const PointCloudRenderablePtr& rend = *it;
+    Ogre::RenderOperation* op = rend->getRenderOperation();
+    uint32_t rend_end = rend_first + op->vertexData->vertexCount / vpp;
+    if ( indices[current_point] >= rend_end )
+    {
+      rend_first = rend_end;
+      continue;
+    }
+
+    uint32_t last_point = current_point;
+    while ( last_point + 1 < num_points && indices[last_point + 1] < rend_end )
+    {
+      ++last_point;
+    }
+
+    uint32_t span_first = indices[current_point];
+    uint32_t span_count = indices[last_point] - span_first + 1;
+
+    Ogre::HardwareVertexBufferSharedPtr vbuf = rend->getBuffer();
+    size_t point_size = vbuf->getVertexSize() * vpp;
+    uint8_t* data = (uint8_t*)vbuf->lock( op->vertexData->vertexStart * vbuf->getVertexSize() + ( span_first - rend_first ) * point_size,
+                                          span_count * point_size,
+                                          Ogre::HardwareBuffer::HBL_NORMAL );
+
+    // The renderable's box only grows here, which stays correct for culling.
+    Ogre::AxisAlignedBox aabb = rend->getBoundingBox();
+    for ( uint32_t i = current_point; i <= last_point; ++i )
+    {
+      const Point& p = points[i];
+      aabb.merge( p.position );
+      writePoint( (float*)( data + ( indices[i] - span_first ) * point_size ), p, indices[i], vertices, vpp );
+    }
+
+    vbuf->unlock();
+    rend->setBoundingBox( aabb );
+
+    current_point = last_point + 1;
+    rend_first = rend_end;
+  }
+  ROS_ASSERT( current_point == num_points );
+
+  // The updated points may have defined the old bounds.
+  updateBounds();
+
+  if (getParentSceneNode())
+  {
+    getParentSceneNode()->needUpdate();
+  }
+}
+
 void PointCloud::popPoints(uint32_t num_points)
 {
   uint32_t vpp = getVerticesPerPoint();
@@ -630,6 +711,14 @@ void PointCloud::popPoints(uint32_t num_points)
 
   point_count_ -= num_points;
 
+  if (use_instancing_)
+  {
+    // Instances are always drawn from the start of their buffer, so there is
+    // no vertexStart to move; rebuild from the remaining points instead.
+    regenerateAll();
+    return;
+  }
+
   // Now clear out popped points
   uint32_t popped_count = 0;
   while (popped_count < num_points * vpp)
@@ -653,15 +742,43 @@ void PointCloud::popPoints(uint32_t num_points)
   }
   ROS_ASSERT(popped_count == num_points * vpp);
 
-  // reset bounds
-  bounding_box_.setNull();
-  bounding_radius_ = 0.0f;
-  for (uint32_t i = 0; i < point_count_; ++i)
+  updateBounds();
+
+  shrinkRenderables();
+
+  if (getParentSceneNode())
   {
-    Point& p = points_[i];
-    bounding_box_.merge(p.position);
-    bounding_radius_ = std::max(bounding_radius_, p.position.squaredLength());
+    getParentSceneNode()->needUpdate();
+  }
+}
+
+void PointCloud::popBackPoints( uint32_t num_points )
+{
+  if ( num_points == 0 )
+  {
+    return;
+  }
+
+  uint32_t vpp = getVerticesPerPoint();
+
+  ROS_ASSERT( num_points <= point_count_ );
+  point_count_ -= num_points;
+
+  // The live points end in the last renderable with vertices left, so trim backwards from there.
+  uint32_t popped_count = 0;
+  for ( V_PointCloudRenderable::reverse_iterator it = renderables_.rbegin();
+        it != renderables_.rend() && popped_count < num_points * vpp; ++it )
+  {
+    Ogre::RenderOperation* op = (*it)->getRenderOperation();
+
+    uint32_t popped = std::min( (size_t)( num_points * vpp - popped_count ), op->vertexData->vertexCount );
+    op->vertexData->vertexCount -= popped;
+
+    popped_count += popped;
   }
+  ROS_ASSERT( popped_count == num_points * vpp );
+
+  updateBounds();
 
   shrinkRenderables();
 
@@ -671,6 +788,18 @@ void PointCloud::popPoints(uint32_t num_points)
   }
 }
 
+void PointCloud::updateBounds()
+{
+  bounding_box_.setNull();
+  bounding_radius_ = 0.0f;
+  for (uint32_t i = 0; i < point_count_; ++i)
+  {
+    Point& p = points_[i];
+    bounding_box_.merge(p.position);
+    bounding_radius_ = std::max(bounding_radius_, p.position.squaredLength());
+  }
+}
+
 void PointCloud::shrinkRenderables()
 {
   while (!renderables_.empty())
@@ -710,11 +839,16 @@ void PointCloud::_notifyAttached(Ogre::Node *parent, bool isTagPoint)
 
 uint32_t PointCloud::getVerticesPerPoint()
 {
-  if (current_mode_supports_geometry_shader_)
+  if (current_mode_supports_geometry_shader_ || use_instancing_)
   {
     return 1;
   }
 
+  return getCornersPerPoint();
+}
+
+uint32_t PointCloud::getCornersPerPoint()
+{
   if (render_mode_ == RM_POINTS)
   {
     return 1;
@@ -748,6 +882,91 @@ uint32_t PointCloud::getVerticesPerPoint()
   return 1;
 }
 
+float* PointCloud::getVertices()
+{
+  if (current_mode_supports_geometry_shader_ || use_instancing_)
+  {
+    return g_point_vertices;
+  }
+
+  return getCorners();
+}
+
+float* PointCloud::getCorners()
+{
+  if (render_mode_ == RM_POINTS)
+  {
+    return g_point_vertices;
+  }
+  else if (render_mode_ == RM_SQUARES)
+  {
+    return g_billboard_vertices;
+  }
+  else if (render_mode_ == RM_FLAT_SQUARES)
+  {
+    return g_billboard_vertices;
+  }
+  else if (render_mode_ == RM_SPHERES)
+  {
+    return g_billboard_sphere_vertices;
+  }
+  else if (render_mode_ == RM_TILES)
+  {
+    return g_billboard_vertices;
+  }
+  else if (render_mode_ == RM_BOXES)
+  {
+    return g_box_vertices;
+  }
+
+  return g_point_vertices;
+}
+
+float* PointCloud::writePoint( float* fptr, const Point& p, uint32_t index, float* vertices, uint32_t vpp )
+{
+  uint32_t color;
+
+  if (color_by_index_)
+  {
+    // convert to ColourValue, so we can then convert to the rendersystem-specific color type
+    color = (index + 1);
+    Ogre::ColourValue c;
+    c.a = 1.0f;
+    c.r = ((color >> 16) & 0xff) / 255.0f;
+    c.g = ((color >> 8) & 0xff) / 255.0f;
+    c.b = (color & 0xff) / 255.0f;
+    Ogre::Root::getSingletonPtr()->convertColourValue(c, &color);
+  }
+  else
+  {
+    Ogre::Root::getSingletonPtr()->convertColourValue( p.color, &color );
+  }
+
+  float x = p.position.x;
+  float y = p.position.y;
+  float z = p.position.z;
+
+  for (uint32_t j = 0; j < vpp; ++j)
+  {
+    *fptr++ = x;
+    *fptr++ = y;
+    *fptr++ = z;
+
+    if (!current_mode_supports_geometry_shader_ && !use_instancing_)
+    {
+      *fptr++ = vertices[(j*3)];
+      *fptr++ = vertices[(j*3) + 1];
+      *fptr++ = vertices[(j*3) + 2];
+    }
+
+    uint32_t* iptr = (uint32_t*)fptr;
+    *iptr = color;
+    ++fptr;
+  }
+
+  return fptr;
+}
+
 void PointCloud::setPickColor(const Ogre::ColourValue& color)
 {
   pick_color_ = color;
@@ -764,7 +983,15 @@ void PointCloud::setPickColor(const Ogre::ColourValue& color)
 
 PointCloudRenderablePtr PointCloud::createRenderable( int num_points )
 {
-  PointCloudRenderablePtr rend(new PointCloudRenderable(this, num_points, !current_mode_supports_geometry_shader_));
+  PointCloudRenderablePtr rend;
+  if (use_instancing_)
+  {
+    rend.reset(new PointCloudRenderable(this, num_points, getCorners(), getCornersPerPoint()));
+  }
+  else
+  {
+    rend.reset(new PointCloudRenderable(this, num_points, !current_mode_supports_geometry_shader_));
+  }
   rend->setMaterial(current_material_->getName());
   Ogre::Vector4 size(width_, height_, depth_, 0.0f);
   Ogre::Vector4 alpha(alpha_, 0.0f, 0.0f, 0.0f);
@@ -799,6 +1026,7 @@ void PointCloud::visitRenderables(Ogre::Renderable::Visitor* visitor, bool debug
 
 PointCloudRenderable::PointCloudRenderable(PointCloud* parent, int num_points, bool use_tex_coords)
 : parent_(parent)
+, instance_data_(0)
 {
   // Initialize render operation
   mRenderOp.operationType = Ogre::RenderOperation::OT_POINT_LIST;
@@ -831,10 +1059,72 @@ PointCloudRenderable::PointCloudRenderable(PointCloud* parent, int num_points, b
   mRenderOp.vertexData->vertexBufferBinding->setBinding(0, vbuf);
 }
 
+PointCloudRenderable::PointCloudRenderable(PointCloud* parent, int num_points, float* corners, uint32_t num_corners)
+: parent_(parent)
+, instance_data_(0)
+{
+  // The buffer holds one position and color per point, like the geometry shader path.
+  // mRenderOp keeps count of the points in it; instance_data_ is what gets drawn.
+  mRenderOp.operationType = Ogre::RenderOperation::OT_TRIANGLE_LIST;
+  mRenderOp.useIndexes = false;
+  mRenderOp.vertexData = new Ogre::VertexData;
+  mRenderOp.vertexData->vertexStart = 0;
+  mRenderOp.vertexData->vertexCount = 0;
+
+  Ogre::VertexDeclaration *decl = mRenderOp.vertexData->vertexDeclaration;
+  decl->addElement(0, 0, Ogre::VET_FLOAT3, Ogre::VES_POSITION);
+  decl->addElement(0, Ogre::VertexElement::getTypeSize(Ogre::VET_FLOAT3), Ogre::VET_COLOUR, Ogre::VES_DIFFUSE);
+
+  Ogre::HardwareVertexBufferSharedPtr vbuf =
+    Ogre::HardwareBufferManager::getSingleton().createVertexBuffer(
+      decl->getVertexSize(0),
+      num_points,
+      Ogre::HardwareBuffer::HBU_DYNAMIC);
+#if OGRE_VERSION >= ((1 << 16) | (8 << 8))
+  vbuf->setIsInstanceData(true);
+  vbuf->setInstanceDataStepRate(1);
+#endif
+  mRenderOp.vertexData->vertexBufferBinding->setBinding(0, vbuf);
+
+  // The corners of one point, shared by all instances.  The nogp shaders
+  // read them as texture coordinates, as they do for expanded points.
+  Ogre::HardwareVertexBufferSharedPtr corner_buf =
+    Ogre::HardwareBufferManager::getSingleton().createVertexBuffer(
+      Ogre::VertexElement::getTypeSize(Ogre::VET_FLOAT3),
+      num_corners,
+      Ogre::HardwareBuffer::HBU_STATIC_WRITE_ONLY);
+  corner_buf->writeData(0, corner_buf->getSizeInBytes(), corners, true);
+
+  instance_data_ = new Ogre::VertexData;
+  instance_data_->vertexStart = 0;
+  instance_data_->vertexCount = num_corners;
+  Ogre::VertexDeclaration *instance_decl = instance_data_->vertexDeclaration;
+  instance_decl->addElement(0, 0, Ogre::VET_FLOAT3, Ogre::VES_POSITION);
+  instance_decl->addElement(0, Ogre::VertexElement::getTypeSize(Ogre::VET_FLOAT3), Ogre::VET_COLOUR, Ogre::VES_DIFFUSE);
+  instance_decl->addElement(1, 0, Ogre::VET_FLOAT3, Ogre::VES_TEXTURE_COORDINATES, 0);
+  instance_data_->vertexBufferBinding->setBinding(0, vbuf);
+  instance_data_->vertexBufferBinding->setBinding(1, corner_buf);
+}
+
 PointCloudRenderable::~PointCloudRenderable()
 {
   delete mRenderOp.vertexData;
   delete mRenderOp.indexData;
+  delete instance_data_;
+}
+
+void PointCloudRenderable::getRenderOperation(Ogre::RenderOperation& op)
+{
+  op = mRenderOp;
+
+#if OGRE_VERSION >= ((1 << 16) | (8 << 8))
+  if (instance_data_)
+  {
+    ROS_ASSERT(mRenderOp.vertexData->vertexStart == 0);
+    op.vertexData = instance_data_;
+    op.numberOfInstances = mRenderOp.vertexData->vertexCount;
+  }
+#endif
 }
 
 Ogre::HardwareVertexBufferSharedPtr PointCloudRenderable::getBuffer()
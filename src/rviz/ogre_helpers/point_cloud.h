@@ -80,6 +80,8 @@ class PointCloudRenderable : public Ogre::SimpleRenderable
 {
 public:
   PointCloudRenderable(PointCloud* parent, int num_points, bool use_tex_coords);
+  /** @brief Create a renderable drawing the mesh of @a num_corners @a corners once per point. */
+  PointCloudRenderable(PointCloud* parent, int num_points, float* corners, uint32_t num_corners);
   ~PointCloudRenderable();
 
 #ifndef _WIN32
@@ -88,6 +90,7 @@ public:
 #endif
 
   Ogre::RenderOperation* getRenderOperation() { return &mRenderOp; }
+  virtual void getRenderOperation(Ogre::RenderOperation& op);
 
 #ifndef _WIN32
 # pragma GCC diagnostic pop
@@ -105,6 +108,7 @@ public:
 private:
   Ogre::MaterialPtr material_;
   PointCloud* parent_;
+  Ogre::VertexData* instance_data_;     ///< Points and corners as drawn when instancing, otherwise null
 };
 typedef boost::shared_ptr<PointCloudRenderable> PointCloudRenderablePtr;
 typedef std::vector<PointCloudRenderablePtr> V_PointCloudRenderable;
@@ -163,12 +167,38 @@ public:
    */
   void addPoints( Point* points, uint32_t num_points );
 
+  /**
+   * \brief Make room for a total number of points
+   *
+   * The next renderable created by addPoints() is sized to hold up to @a num_points points in all, so clouds that grow
+   * in small batches append into it instead of creating a renderable per batch.  The reservation is dropped by clear().
+   * @param num_points The total number of points to make room for
+   */
+  void reserve( uint32_t num_points );
+
+  /**
+   * \brief Overwrite points already in this point cloud, in place
+   *
+   * Only the vertices of the given points are rewritten, locking each renderable at most once, so small changes to a
+   * large cloud stay cheap.  The cloud's bounds are recomputed from the stored points, without touching the buffers.
+   * @param indices Indices of the points to overwrite, in ascending order
+   * @param points An array of Point structures, one per index
+   * @param num_points The number of indices and points in the arrays
+   */
+  void updatePoints( const uint32_t* indices, Point* points, uint32_t num_points );
+
   /**
    * \brief Remove a number of points from this point cloud
    * \param num_points The number of points to pop
    */
   void popPoints( uint32_t num_points );
 
+  /**
+   * \brief Remove a number of points from the end of this point cloud
+   * \param num_points The number of points to pop
+   */
+  void popBackPoints( uint32_t num_points );
+
   /**
    * \brief Set what type of rendering primitives should be used, currently points, billboards and boxes are supported
    */
@@ -203,6 +233,11 @@ public:
 
   void setHighlightColor( float r, float g, float b );
 
+  /** @brief Return the bytes held in main memory for the points. */
+  size_t getCpuMemoryUsage() const;
+  /** @brief Return the bytes of the vertex buffers of the points. */
+  size_t getGpuMemoryUsage() const;
+
   virtual const Ogre::String& getMovableType() const { return sm_Type; }
   virtual const Ogre::AxisAlignedBox& getBoundingBox() const;
   virtual float getBoundingRadius() const;
@@ -220,8 +255,14 @@ public:
 private:
 
   uint32_t getVerticesPerPoint();
+  uint32_t getCornersPerPoint();
+  float* getVertices();
+  float* getCorners();
+  float* writePoint( float* fptr, const Point& p, uint32_t index, float* vertices, uint32_t vpp );
   PointCloudRenderablePtr createRenderable( int num_points );
   void regenerateAll();
+  /// Recompute bounding_box_ and bounding_radius_ from the live points.
+  void updateBounds();
   void shrinkRenderables();
 
   Ogre::AxisAlignedBox bounding_box_;       ///< The bounding box of this point cloud
@@ -230,6 +271,7 @@ private:
   typedef std::vector<Point> V_Point;
   V_Point points_;                          ///< The list of points we're displaying.  Allocates to a high-water-mark.
   uint32_t point_count_;                    ///< The number of points currently in #points_
+  uint32_t reserved_points_;                ///< See reserve()
 
   RenderMode render_mode_;
   float width_;                             ///< width
@@ -252,6 +294,7 @@ private:
   V_PointCloudRenderable renderables_;
 
   bool current_mode_supports_geometry_shader_;
+  bool use_instancing_;                     ///< Draw the corners of each point by instancing instead of per-point vertices
   Ogre::ColourValue pick_color_;
 
   static Ogre::String sm_Type;              ///< The "renderable type" used by Ogre
@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2012, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <QFile>
+#include <QTextStream>
+
+#include "rviz/performance_monitor.h"
+
+namespace rviz
+{
+
+// Recording stops growing once this many trace events are kept.
+static const size_t MAX_TRACE_EVENTS = 1000000;
+
+DisplayStatistics::Totals::Totals()
+  : updates( 0 )
+  , update_time( 0.0 )
+  , messages( 0 )
+  , message_time( 0.0 )
+  , messages_dropped( 0 )
+  , bytes( 0 )
+  , load_time( 0.0 )
+  , cpu_bytes( 0 )
+  , gpu_bytes( 0 )
+{
+}
+
+DisplayStatistics::MemoryUsage::MemoryUsage()
+  : cpu_bytes( 0 )
+  , gpu_bytes( 0 )
+{
+}
+
+void DisplayStatistics::addUpdate( ros::WallDuration duration )
+{
+  boost::mutex::scoped_lock lock( mutex_ );
+  totals_.updates++;
+  totals_.update_time += duration.toSec();
+}
+
+void DisplayStatistics::addPrepare( ros::WallDuration duration )
+{
+  boost::mutex::scoped_lock lock( mutex_ );
+  totals_.update_time += duration.toSec();
+}
+
+void DisplayStatistics::addMessage( ros::WallDuration duration, uint64_t bytes )
+{
+  boost::mutex::scoped_lock lock( mutex_ );
+  totals_.messages++;
+  totals_.message_time += duration.toSec();
+  totals_.bytes += bytes;
+}
+
+void DisplayStatistics::addDropped( uint64_t count )
+{
+  boost::mutex::scoped_lock lock( mutex_ );
+  totals_.messages_dropped += count;
+}
+
+void DisplayStatistics::setLoadTime( ros::WallDuration duration )
+{
+  boost::mutex::scoped_lock lock( mutex_ );
+  totals_.load_time = duration.toSec();
+}
+
+void DisplayStatistics::setMemoryUsage( const std::string& category, uint64_t cpu_bytes, uint64_t gpu_bytes )
+{
+  boost::mutex::scoped_lock lock( mutex_ );
+  MemoryUsage& usage = memory_usage_[ category ];
+  totals_.cpu_bytes += cpu_bytes - usage.cpu_bytes;
+  totals_.gpu_bytes += gpu_bytes - usage.gpu_bytes;
+  usage.cpu_bytes = cpu_bytes;
+  usage.gpu_bytes = gpu_bytes;
+}
+
+DisplayStatistics::M_MemoryUsage DisplayStatistics::getMemoryUsage() const
+{
+  boost::mutex::scoped_lock lock( mutex_ );
+  return memory_usage_;
+}
+
+DisplayStatistics::Totals DisplayStatistics::getTotals() const
+{
+  boost::mutex::scoped_lock lock( mutex_ );
+  return totals_;
+}
+
+PerformanceMonitor::FrameTotals::FrameTotals()
+  : updates( 0 )
+  , update_time( 0.0 )
+  , renders( 0 )
+  , render_time( 0.0 )
+  , triangles( 0 )
+  , batches( 0 )
+{
+}
+
+PerformanceMonitor::PerformanceMonitor()
+  : tracing_( false )
+{
+}
+
+void PerformanceMonitor::addUpdate( ros::WallDuration duration )
+{
+  boost::mutex::scoped_lock lock( mutex_ );
+  frame_totals_.updates++;
+  frame_totals_.update_time += duration.toSec();
+}
+
+void PerformanceMonitor::addRender( ros::WallDuration duration, size_t triangles, size_t batches )
+{
+  boost::mutex::scoped_lock lock( mutex_ );
+  frame_totals_.renders++;
+  frame_totals_.render_time += duration.toSec();
+  frame_totals_.triangles = triangles;
+  frame_totals_.batches = batches;
+}
+
+PerformanceMonitor::FrameTotals PerformanceMonitor::getFrameTotals() const
+{
+  boost::mutex::scoped_lock lock( mutex_ );
+  return frame_totals_;
+}
+
+void PerformanceMonitor::setTracing( bool tracing )
+{
+  boost::mutex::scoped_lock lock( mutex_ );
+  if( tracing && !tracing_ )
+  {
+    trace_events_.clear();
+    trace_threads_.clear();
+    trace_start_ = ros::WallTime::now();
+  }
+  tracing_ = tracing;
+}
+
+void PerformanceMonitor::addTraceEvent( const std::string& name, const char* category,
+                                        ros::WallTime start, ros::WallDuration duration )
+{
+  if( !tracing_ )
+  {
+    return;
+  }
+
+  boost::mutex::scoped_lock lock( mutex_ );
+  if( !tracing_ || trace_events_.size() >= MAX_TRACE_EVENTS )
+  {
+    return;
+  }
+
+  // Number threads in order of appearance to keep the trace readable.
+  std::map<boost::thread::id, int>::iterator thread_it =
+    trace_threads_.insert( std::make_pair( boost::this_thread::get_id(), (int)trace_threads_.size() )).first;
+
+  TraceEvent event;
+  event.name = name;
+  event.category = category;
+  event.start = start;
+  event.duration = duration;
+  event.thread = thread_it->second;
+  trace_events_.push_back( event );
+}
+
+static QString escapeJson( const std::string& str )
+{
+  QString escaped = QString::fromStdString( str );
+  escaped.replace( '\\', "\\\\" );
+  escaped.replace( '"', "\\\"" );
+  escaped.replace( '\n', "\\n" );
+  return escaped;
+}
+
+bool PerformanceMonitor::writeTrace( const QString& filename ) const
+{
+  QFile file( filename );
+  if( !file.open( QIODevice::WriteOnly | QIODevice::Text ))
+  {
+    return false;
+  }
+
+  boost::mutex::scoped_lock lock( mutex_ );
+
+  QTextStream out( &file );
+  out << "{\"traceEvents\":[\n";
+  for( size_t i = 0; i < trace_events_.size(); i++ )
+  {
+    const TraceEvent& event = trace_events_[ i ];
+    // Trace Event timestamps and durations are in microseconds.
+    out << "{\"name\":\"" << escapeJson( event.name )
+        << "\",\"cat\":\"" << event.category
+        << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.thread
+        << ",\"ts\":" << QString::number( (event.start - trace_start_).toSec() * 1e6, 'f', 1 )
+        << ",\"dur\":" << QString::number( event.duration.toSec() * 1e6, 'f', 1 )
+        << "}" << (i + 1 < trace_events_.size() ? ",\n" : "\n");
+  }
+  out << "]}\n";
+
+  return out.status() == QTextStream::Ok;
+}
+
+} // namespace rviz
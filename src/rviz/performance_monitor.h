@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2012, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RVIZ_PERFORMANCE_MONITOR_H
+#define RVIZ_PERFORMANCE_MONITOR_H
+
+#include <atomic>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <ros/time.h>
+
+#include <QString>
+
+#include "rviz/rviz_export.h"
+
+namespace rviz
+{
+
+/** @brief Running totals of the work done by one Display.
+ *
+ * Every Display owns one of these.  DisplayGroup::update() adds the
+ * time spent in each Display::update(), and message based displays
+ * add the time spent processing each message along with its size.
+ * All functions are thread-safe; the PerformancePanel reads the totals
+ * periodically and shows rates computed from the differences. */
+class RVIZ_EXPORT DisplayStatistics
+{
+public:
+  struct Totals
+  {
+    Totals();
+
+    uint64_t updates;
+    double update_time;       ///< Seconds spent in Display::prepareUpdate() and update().
+    uint64_t messages;
+    double message_time;      ///< Seconds spent processing messages.
+    uint64_t messages_dropped;
+    uint64_t bytes;
+    double load_time;         ///< Seconds spent in Display::initialize() and load() from a config.
+    uint64_t cpu_bytes;       ///< Memory in use, summed over the categories set with setMemoryUsage().
+    uint64_t gpu_bytes;
+  };
+
+  /** @brief Memory in use by one kind of data of a Display. */
+  struct MemoryUsage
+  {
+    MemoryUsage();
+
+    uint64_t cpu_bytes;
+    uint64_t gpu_bytes;
+  };
+  typedef std::map<std::string, MemoryUsage> M_MemoryUsage;
+
+  void addUpdate( ros::WallDuration duration );
+  /** @brief Add the time spent in Display::prepareUpdate() to the
+   * update time, without counting another update. */
+  void addPrepare( ros::WallDuration duration );
+  void addMessage( ros::WallDuration duration, uint64_t bytes );
+  void addDropped( uint64_t count = 1 );
+  void setLoadTime( ros::WallDuration duration );
+
+  /** @brief Set the memory currently used for one kind of data, like
+   * "points" or "textures".  Replaces the last value for @a category. */
+  void setMemoryUsage( const std::string& category, uint64_t cpu_bytes, uint64_t gpu_bytes );
+
+  /** @brief Return the memory in use per category. */
+  M_MemoryUsage getMemoryUsage() const;
+
+  /** @brief Return a consistent copy of the totals. */
+  Totals getTotals() const;
+
+private:
+  mutable boost::mutex mutex_;
+  Totals totals_;
+  M_MemoryUsage memory_usage_;
+};
+
+/** @brief Frame timings and trace recording shared by the whole visualizer.
+ *
+ * VisualizationManager records the duration of each update cycle and
+ * of each call to Ogre::Root::renderOneFrame(), along with the number
+ * of triangles and batches the main render window drew.
+ *
+ * While tracing is enabled, timed sections reported with
+ * addTraceEvent() are kept in memory and can be written out in the
+ * Trace Event format understood by chrome://tracing. */
+class RVIZ_EXPORT PerformanceMonitor
+{
+public:
+  struct FrameTotals
+  {
+    FrameTotals();
+
+    uint64_t updates;
+    double update_time;    ///< Seconds spent in VisualizationManager::onUpdate().
+    uint64_t renders;
+    double render_time;    ///< Seconds spent in renderOneFrame().
+    size_t triangles;      ///< Triangles drawn by the last render.
+    size_t batches;        ///< Batches drawn by the last render.
+  };
+
+  PerformanceMonitor();
+
+  void addUpdate( ros::WallDuration duration );
+  void addRender( ros::WallDuration duration, size_t triangles, size_t batches );
+
+  /** @brief Return a consistent copy of the frame totals. */
+  FrameTotals getFrameTotals() const;
+
+  /** @brief Start or stop recording trace events.  Starting discards
+   * events recorded before. */
+  void setTracing( bool tracing );
+  bool isTracing() const { return tracing_; }
+
+  /** @brief Record a timed section if tracing is enabled.  This is thread-safe.
+   * @param name Name shown for the section, like a Display name.
+   * @param category Coarse kind of work, like "update" or "message". */
+  void addTraceEvent( const std::string& name, const char* category,
+                      ros::WallTime start, ros::WallDuration duration );
+
+  /** @brief Write the recorded trace events to @a filename as JSON.
+   * @return false if the file could not be written. */
+  bool writeTrace( const QString& filename ) const;
+
+private:
+  struct TraceEvent
+  {
+    std::string name;
+    const char* category;
+    ros::WallTime start;
+    ros::WallDuration duration;
+    int thread;
+  };
+
+  mutable boost::mutex mutex_;
+  FrameTotals frame_totals_;
+
+  std::atomic<bool> tracing_;
+  ros::WallTime trace_start_;
+  std::vector<TraceEvent> trace_events_;
+  std::map<boost::thread::id, int> trace_threads_;
+};
+
+} // namespace rviz
+
+#endif // RVIZ_PERFORMANCE_MONITOR_H
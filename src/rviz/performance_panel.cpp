@@ -0,0 +1,299 @@
+/*
+ * Copyright (c) 2012, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+
+#include <QFile>
+#include <QFileDialog>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QTextStream>
+#include <QTimer>
+#include <QVBoxLayout>
+
+#include "rviz/display_group.h"
+#include "rviz/memory_budget.h"
+#include "rviz/visualization_manager.h"
+
+#include "rviz/performance_panel.h"
+
+namespace rviz
+{
+
+enum PerformanceColumn
+{
+  NameColumn,
+  UpdateColumn,
+  MessageRateColumn,
+  ProcessingColumn,
+  DroppedRateColumn,
+  BandwidthColumn,
+  LoadColumn,
+  MemoryColumn,
+  NumColumns
+};
+
+PerformancePanel::PerformancePanel( QWidget* parent )
+  : Panel( parent )
+{
+  frame_label_ = new QLabel;
+
+  trace_button_ = new QPushButton( "Record Trace" );
+  trace_button_->setToolTip( "Record update, message and render timings of all displays. "
+                             "When stopped, the trace is saved for viewing in chrome://tracing." );
+  trace_button_->setCheckable( true );
+
+  export_button_ = new QPushButton( "Export CSV" );
+  export_button_->setToolTip( "Save the current table as comma separated values." );
+
+  table_ = new QTableWidget( 0, NumColumns );
+  table_->setHorizontalHeaderLabels( QStringList()
+                                     << "Display"
+                                     << "Update (ms)"
+                                     << "Messages/s"
+                                     << "Processing (ms)"
+                                     << "Dropped/s"
+                                     << "KB/s"
+                                     << "Load (ms)"
+                                     << "Memory (MB)" );
+  table_->horizontalHeader()->setStretchLastSection( true );
+  table_->verticalHeader()->hide();
+  table_->setEditTriggers( QAbstractItemView::NoEditTriggers );
+  table_->setSelectionBehavior( QAbstractItemView::SelectRows );
+  table_->setSortingEnabled( true );
+  table_->sortByColumn( UpdateColumn, Qt::DescendingOrder );
+
+  QHBoxLayout* button_layout = new QHBoxLayout;
+  button_layout->addWidget( frame_label_ );
+  button_layout->addStretch();
+  button_layout->addWidget( trace_button_ );
+  button_layout->addWidget( export_button_ );
+
+  QVBoxLayout* layout = new QVBoxLayout;
+  layout->addLayout( button_layout );
+  layout->addWidget( table_ );
+  layout->setContentsMargins( 11, 5, 11, 5 );
+  setLayout( layout );
+
+  refresh_timer_ = new QTimer( this );
+
+  connect( trace_button_, SIGNAL( toggled( bool )), this, SLOT( traceToggled( bool )));
+  connect( export_button_, SIGNAL( clicked() ), this, SLOT( exportCsv() ));
+  connect( refresh_timer_, SIGNAL( timeout() ), this, SLOT( refresh() ));
+}
+
+void PerformancePanel::onInitialize()
+{
+  last_refresh_time_ = ros::WallTime::now();
+  last_frame_totals_ = vis_manager_->getPerformanceMonitor()->getFrameTotals();
+  refresh_timer_->start( 1000 );
+}
+
+void PerformancePanel::collectDisplays( Display* display, QList<Display*>& displays ) const
+{
+  DisplayGroup* display_group = qobject_cast<DisplayGroup*>( display );
+  if( display_group )
+  {
+    for( int i = 0; i < display_group->numDisplays(); i++ )
+    {
+      collectDisplays( display_group->getDisplayAt( i ), displays );
+    }
+  }
+  else
+  {
+    displays.append( display );
+  }
+}
+
+void PerformancePanel::setCell( int row, int column, double value, int precision )
+{
+  double scale = std::pow( 10.0, precision );
+  QTableWidgetItem* item = new QTableWidgetItem;
+  item->setData( Qt::DisplayRole, qRound64( value * scale ) / scale );
+  item->setTextAlignment( Qt::AlignRight | Qt::AlignVCenter );
+  table_->setItem( row, column, item );
+}
+
+void PerformancePanel::refresh()
+{
+  ros::WallTime now = ros::WallTime::now();
+  double dt = (now - last_refresh_time_).toSec();
+  last_refresh_time_ = now;
+  if( dt <= 0.0 )
+  {
+    return;
+  }
+
+  PerformanceMonitor::FrameTotals frame = vis_manager_->getPerformanceMonitor()->getFrameTotals();
+  uint64_t updates = frame.updates - last_frame_totals_.updates;
+  uint64_t renders = frame.renders - last_frame_totals_.renders;
+  double update_ms = updates ? 1000.0 * (frame.update_time - last_frame_totals_.update_time) / updates : 0.0;
+  double render_ms = renders ? 1000.0 * (frame.render_time - last_frame_totals_.render_time) / renders : 0.0;
+  last_frame_totals_ = frame;
+
+  QList<Display*> displays;
+  collectDisplays( vis_manager_->getRootDisplayGroup(), displays );
+
+  // Rows move around while sorted, so fill the table unsorted.
+  table_->setSortingEnabled( false );
+  table_->setRowCount( displays.size() );
+
+  QHash<Display*, DisplayStatistics::Totals> totals;
+  uint64_t memory_bytes = 0;
+  for( int row = 0; row < displays.size(); row++ )
+  {
+    Display* display = displays[ row ];
+    DisplayStatistics::Totals current = display->getStatistics().getTotals();
+    DisplayStatistics::Totals last = last_totals_.value( display );
+    if( current.updates < last.updates || current.messages < last.messages )
+    {
+      // A new display reusing the address of a removed one.
+      last = DisplayStatistics::Totals();
+    }
+    totals.insert( display, current );
+
+    uint64_t display_updates = current.updates - last.updates;
+    uint64_t messages = current.messages - last.messages;
+
+    QTableWidgetItem* name_item = new QTableWidgetItem( display->getName() );
+    name_item->setToolTip( display->getClassId() );
+    table_->setItem( row, NameColumn, name_item );
+    setCell( row, UpdateColumn,
+             display_updates ? 1000.0 * (current.update_time - last.update_time) / display_updates : 0.0, 3 );
+    setCell( row, MessageRateColumn, messages / dt, 1 );
+    setCell( row, ProcessingColumn,
+             messages ? 1000.0 * (current.message_time - last.message_time) / messages : 0.0, 3 );
+    setCell( row, DroppedRateColumn, (current.messages_dropped - last.messages_dropped) / dt, 1 );
+    setCell( row, BandwidthColumn, (current.bytes - last.bytes) / dt / 1024.0, 1 );
+    setCell( row, LoadColumn, 1000.0 * current.load_time, 1 );
+
+    uint64_t display_memory_bytes = current.cpu_bytes + current.gpu_bytes;
+    memory_bytes += display_memory_bytes;
+    setCell( row, MemoryColumn, display_memory_bytes / (1024.0 * 1024.0), 1 );
+    table_->item( row, MemoryColumn )->setToolTip( memoryToolTip( display->getStatistics().getMemoryUsage() ));
+  }
+  last_totals_.swap( totals );
+
+  table_->setSortingEnabled( true );
+
+  QString memory_text = QString::number( memory_bytes / (1024.0 * 1024.0), 'f', 1 );
+  uint64_t budget = vis_manager_->getMemoryBudget()->getBudget();
+  if( budget > 0 )
+  {
+    memory_text += QString( " / %1" ).arg( budget / (1024.0 * 1024.0), 0, 'f', 0 );
+  }
+
+  frame_label_->setText( QString( "Update: %1 ms  Render: %2 ms at %3 fps  Triangles: %4  Batches: %5  Memory: %6 MB" )
+                         .arg( update_ms, 0, 'f', 2 )
+                         .arg( render_ms, 0, 'f', 2 )
+                         .arg( renders / dt, 0, 'f', 1 )
+                         .arg( frame.triangles )
+                         .arg( frame.batches )
+                         .arg( memory_text ));
+}
+
+QString PerformancePanel::memoryToolTip( const DisplayStatistics::M_MemoryUsage& usage ) const
+{
+  QString tool_tip;
+  for( DisplayStatistics::M_MemoryUsage::const_iterator it = usage.begin(); it != usage.end(); ++it )
+  {
+    if( !tool_tip.isEmpty() )
+    {
+      tool_tip += "\n";
+    }
+    tool_tip += QString( "%1: %2 MB CPU, %3 MB GPU" )
+      .arg( QString::fromStdString( it->first ))
+      .arg( it->second.cpu_bytes / (1024.0 * 1024.0), 0, 'f', 1 )
+      .arg( it->second.gpu_bytes / (1024.0 * 1024.0), 0, 'f', 1 );
+  }
+  return tool_tip;
+}
+
+void PerformancePanel::traceToggled( bool checked )
+{
+  PerformanceMonitor* monitor = vis_manager_->getPerformanceMonitor();
+  monitor->setTracing( checked );
+  trace_button_->setText( checked ? "Stop Trace" : "Record Trace" );
+  if( checked )
+  {
+    return;
+  }
+
+  QString filename = QFileDialog::getSaveFileName( this, "Save trace", "rviz_trace.json",
+                                                   "Trace files (*.json)" );
+  if( !filename.isEmpty() && !monitor->writeTrace( filename ))
+  {
+    QMessageBox::critical( this, "Error", "Failed to write trace to " + filename + "." );
+  }
+}
+
+void PerformancePanel::exportCsv()
+{
+  QString filename = QFileDialog::getSaveFileName( this, "Export performance table", "rviz_performance.csv",
+                                                   "CSV files (*.csv)" );
+  if( filename.isEmpty() )
+  {
+    return;
+  }
+
+  QFile file( filename );
+  if( !file.open( QIODevice::WriteOnly | QIODevice::Text ))
+  {
+    QMessageBox::critical( this, "Error", "Failed to open " + filename + " for writing." );
+    return;
+  }
+
+  QTextStream out( &file );
+  for( int column = 0; column < NumColumns; column++ )
+  {
+    out << (column ? "," : "") << table_->horizontalHeaderItem( column )->text();
+  }
+  out << "\n";
+
+  for( int row = 0; row < table_->rowCount(); row++ )
+  {
+    for( int column = 0; column < NumColumns; column++ )
+    {
+      QTableWidgetItem* item = table_->item( row, column );
+      QString text = item ? item->text() : QString();
+      if( column == NameColumn )
+      {
+        text = "\"" + text.replace( "\"", "\"\"" ) + "\"";
+      }
+      out << (column ? "," : "") << text;
+    }
+    out << "\n";
+  }
+}
+
+} // namespace rviz
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2012, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RVIZ_PERFORMANCE_PANEL_H
+#define RVIZ_PERFORMANCE_PANEL_H
+
+#include <QHash>
+
+#include "rviz/panel.h"
+#include "rviz/performance_monitor.h"
+
+class QLabel;
+class QPushButton;
+class QTableWidget;
+class QTimer;
+
+namespace rviz
+{
+
+class Display;
+
+/**
+ * \class PerformancePanel
+ *
+ * Shows where the time goes: frame update and render times, the
+ * triangles and batches drawn, and a sortable table with the update
+ * time, message rate, message processing time, dropped messages,
+ * bandwidth and memory of each Display, refreshed once per second.  The table
+ * can be exported as CSV, and a trace of update, message and render
+ * sections can be recorded for chrome://tracing.
+ */
+class PerformancePanel: public Panel
+{
+Q_OBJECT
+public:
+  PerformancePanel( QWidget* parent = 0 );
+
+  virtual void onInitialize();
+
+protected Q_SLOTS:
+  /** Read the totals of all displays and fill the table with the rates since the last refresh. */
+  void refresh();
+
+  void traceToggled( bool checked );
+  void exportCsv();
+
+protected:
+  /** Append all non-group displays below @a display to @a displays. */
+  void collectDisplays( Display* display, QList<Display*>& displays ) const;
+
+  /** Put a numeric cell into the table, so it sorts by value. */
+  void setCell( int row, int column, double value, int precision );
+
+  /** List the memory used per category, one line each. */
+  QString memoryToolTip( const DisplayStatistics::M_MemoryUsage& usage ) const;
+
+  QLabel* frame_label_;
+  QPushButton* trace_button_;
+  QPushButton* export_button_;
+  QTableWidget* table_;
+  QTimer* refresh_timer_;
+
+  ros::WallTime last_refresh_time_;
+  PerformanceMonitor::FrameTotals last_frame_totals_;
+  QHash<Display*, DisplayStatistics::Totals> last_totals_;
+};
+
+} // namespace rviz
+
+#endif // RVIZ_PERFORMANCE_PANEL_H
@@ -0,0 +1,320 @@
+/*
+ * Copyright (c) 2012, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <ctime>
+#include <fstream>
+#include <set>
+#include <sstream>
+
+#include <boost/bind.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <ros/console.h>
+#include <ros/package.h>
+
+#include "rviz/plugin_index.h"
+
+namespace fs = boost::filesystem;
+
+namespace rviz
+{
+
+// First line of a cache file.  Change it when the format changes.
+static const char* CACHE_HEADER = "rviz plugin index 2";
+
+static std::string getPackagePath()
+{
+  const char* package_path = getenv( "ROS_PACKAGE_PATH" );
+  return package_path ? package_path : "";
+}
+
+// Same limit as rospack, against symlink loops.
+static const int MAX_CRAWL_DEPTH = 1000;
+
+/** @brief Add what a rospack crawl of @a dir looks at to @a watched:
+ * the manifest of a package, or else @a dir itself and, recursively,
+ * its subdirectories.  Adding a package anywhere below a package path
+ * root changes the time of one of these directories. */
+static void addCrawledPaths( const fs::path& dir, int depth, std::set<std::string>& watched )
+{
+  boost::system::error_code error;
+  if( depth > MAX_CRAWL_DEPTH || fs::exists( dir / "CATKIN_IGNORE", error ))
+  {
+    return;
+  }
+
+  fs::path manifest = dir / "package.xml";
+  if( !fs::exists( manifest, error ))
+  {
+    manifest = dir / "manifest.xml";
+  }
+  if( fs::exists( manifest, error ))
+  {
+    watched.insert( manifest.string() );
+    return;
+  }
+
+  watched.insert( dir.string() );
+  if( fs::exists( dir / "rospack_nosubdirs", error ))
+  {
+    return;
+  }
+  for( fs::directory_iterator it( dir, error ), end; !error && it != end; it.increment( error ))
+  {
+    std::string name = it->path().filename().string();
+    if( !name.empty() && name[ 0 ] != '.' && fs::is_directory( it->status() ))
+    {
+      addCrawledPaths( it->path(), depth + 1, watched );
+    }
+  }
+}
+
+static long long getModificationTime( const std::string& path )
+{
+  boost::system::error_code error;
+  std::time_t time = fs::last_write_time( path, error );
+  return error ? -1 : (long long)time;
+}
+
+PluginIndex* PluginIndex::instance()
+{
+  // Never deleted, a discovery thread may still be running at exit.
+  static PluginIndex* index = new PluginIndex();
+  return index;
+}
+
+PluginIndex::PluginIndex()
+  : worker_running_( false )
+{
+}
+
+void PluginIndex::setCacheDirectory( const std::string& directory )
+{
+  boost::mutex::scoped_lock lock( mutex_ );
+  cache_directory_ = directory;
+}
+
+void PluginIndex::discoverInBackground( const std::string& package, const std::string& attribute )
+{
+  Key key( package, attribute );
+  {
+    boost::mutex::scoped_lock lock( mutex_ );
+    Entry& entry = entries_[ key ];
+    if( entry.started )
+    {
+      return;
+    }
+    entry.started = true;
+
+    // roslib serializes all rospack calls, so one thread discovers the
+    // keys one after the other.
+    queue_.push_back( key );
+    if( worker_running_ )
+    {
+      return;
+    }
+    worker_running_ = true;
+  }
+  boost::thread( boost::bind( &PluginIndex::runQueue, this )).detach();
+}
+
+void PluginIndex::runQueue()
+{
+  while( true )
+  {
+    Key key;
+    {
+      boost::mutex::scoped_lock lock( mutex_ );
+      if( queue_.empty() )
+      {
+        worker_running_ = false;
+        return;
+      }
+      key = queue_.front();
+      queue_.pop_front();
+    }
+    discoverEntry( key );
+  }
+}
+
+std::vector<std::string> PluginIndex::getPluginXmlPaths( const std::string& package, const std::string& attribute )
+{
+  Key key( package, attribute );
+  {
+    boost::mutex::scoped_lock lock( mutex_ );
+    Entry& entry = entries_[ key ];
+    if( entry.started )
+    {
+      while( !entry.ready )
+      {
+        ready_.wait( lock );
+      }
+      return entry.paths;
+    }
+    entry.started = true;
+  }
+
+  // Nobody started it yet, so discover on this thread.
+  discoverEntry( key );
+
+  boost::mutex::scoped_lock lock( mutex_ );
+  return entries_[ key ].paths;
+}
+
+void PluginIndex::discoverEntry( const Key& key )
+{
+  std::vector<std::string> paths = discover( key );
+
+  boost::mutex::scoped_lock lock( mutex_ );
+  Entry& entry = entries_[ key ];
+  entry.paths = paths;
+  entry.ready = true;
+  ready_.notify_all();
+}
+
+std::vector<std::string> PluginIndex::discover( const Key& key )
+{
+  std::string cache_file = getCacheFile( key );
+  std::vector<std::string> paths;
+  if( !cache_file.empty() && readCache( cache_file, paths ))
+  {
+    ROS_DEBUG( "Using plugin index %s.", cache_file.c_str() );
+    return paths;
+  }
+
+  paths.clear();
+  ros::package::getPlugins( key.first, key.second, paths );
+  if( !cache_file.empty() )
+  {
+    writeCache( cache_file, paths );
+  }
+  return paths;
+}
+
+std::string PluginIndex::getCacheFile( const Key& key ) const
+{
+  boost::mutex::scoped_lock lock( mutex_ );
+  if( cache_directory_.empty() )
+  {
+    return "";
+  }
+  return ( fs::path( cache_directory_ ) / ( "plugin_index_" + key.first + "_" + key.second )).string();
+}
+
+bool PluginIndex::readCache( const std::string& file, std::vector<std::string>& paths ) const
+{
+  std::ifstream in( file.c_str() );
+  std::string line;
+  if( !std::getline( in, line ) || line != CACHE_HEADER )
+  {
+    return false;
+  }
+  if( !std::getline( in, line ) || line != "ROS_PACKAGE_PATH=" + getPackagePath() )
+  {
+    return false;
+  }
+
+  paths.clear();
+  while( std::getline( in, line ))
+  {
+    if( line.size() < 2 )
+    {
+      continue;
+    }
+    if( line[ 0 ] == 'P' )
+    {
+      paths.push_back( line.substr( 2 ));
+    }
+    else if( line[ 0 ] == 'M' )
+    {
+      // "M <time> <path>": the cache is stale if the time changed.
+      std::istringstream fields( line.substr( 2 ));
+      long long time;
+      fields >> time;
+      std::string path;
+      std::getline( fields, path );
+      if( path.empty() || getModificationTime( path.substr( 1 )) != time )
+      {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+void PluginIndex::writeCache( const std::string& file, const std::vector<std::string>& paths ) const
+{
+  // Walk the package path the way rospack does, instead of only
+  // looking at the packages found, so new packages in new directories
+  // are noticed too.
+  std::set<std::string> watched;
+  std::istringstream roots( getPackagePath() );
+  std::string root;
+  while( std::getline( roots, root, ':' ))
+  {
+    if( !root.empty() )
+    {
+      addCrawledPaths( fs::path( root ), 0, watched );
+    }
+  }
+
+  std::string temp_file = file + ".tmp";
+  {
+    std::ofstream out( temp_file.c_str() );
+    out << CACHE_HEADER << "\n";
+    out << "ROS_PACKAGE_PATH=" << getPackagePath() << "\n";
+    std::set<std::string>::const_iterator it;
+    for( it = watched.begin(); it != watched.end(); ++it )
+    {
+      out << "M " << getModificationTime( *it ) << " " << *it << "\n";
+    }
+    for( size_t i = 0; i < paths.size(); i++ )
+    {
+      out << "P " << paths[ i ] << "\n";
+    }
+    if( !out )
+    {
+      ROS_WARN( "Failed to write plugin index %s.", temp_file.c_str() );
+      return;
+    }
+  }
+
+  boost::system::error_code error;
+  fs::rename( temp_file, file, error );
+  if( error )
+  {
+    ROS_WARN( "Failed to write plugin index %s: %s", file.c_str(), error.message().c_str() );
+  }
+}
+
+} // end namespace rviz
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2012, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RVIZ_PLUGIN_INDEX_H
+#define RVIZ_PLUGIN_INDEX_H
+
+#include <deque>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifndef Q_MOC_RUN
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#endif
+
+#include "rviz/rviz_export.h"
+
+namespace rviz
+{
+
+/** @brief Finds plugin description files once per process, with a
+ * cache on disk.
+ *
+ * A pluginlib::ClassLoader constructed without a list of plugin
+ * description files crawls all package manifests for them, which takes
+ * seconds in large workspaces.  Every PluginlibFactory and every point
+ * cloud display used to do that.  PluginIndex does the crawl once per
+ * (package, attribute) and passes the result to the class loaders.
+ *
+ * The result is cached in a file, together with the modification
+ * times of all package manifests and of every directory the crawl
+ * descends through, starting at the ROS_PACKAGE_PATH roots.  The cache
+ * is used as long as ROS_PACKAGE_PATH and all of these times are
+ * unchanged, so adding, removing or changing a package causes a new
+ * crawl.
+ *
+ * Discoveries started with discoverInBackground() run one after the
+ * other on a single thread, since roslib serializes them anyway. */
+class RVIZ_EXPORT PluginIndex
+{
+public:
+  /** @brief Return the index shared by the whole process. */
+  static PluginIndex* instance();
+
+  /** @brief Set the directory for cache files.  Without one, nothing is cached. */
+  void setCacheDirectory( const std::string& directory );
+
+  /** @brief Start finding the plugin description files on a background
+   * thread, so they are ready when first needed. */
+  void discoverInBackground( const std::string& package, const std::string& attribute = "plugin" );
+
+  /** @brief Return the plugin description files exported for
+   * @a package, waiting for the discovery if it is running. */
+  std::vector<std::string> getPluginXmlPaths( const std::string& package, const std::string& attribute = "plugin" );
+
+private:
+  PluginIndex();
+
+  typedef std::pair<std::string, std::string> Key;
+
+  struct Entry
+  {
+    Entry() : started( false ), ready( false ) {}
+
+    bool started;
+    bool ready;
+    std::vector<std::string> paths;
+  };
+
+  /** @brief Run discoverEntry() for queued keys until none are left. */
+  void runQueue();
+
+  /** @brief Run discover() for @a key and publish the result. */
+  void discoverEntry( const Key& key );
+
+  /** @brief Read the cache for @a key, or crawl and write it. */
+  std::vector<std::string> discover( const Key& key );
+
+  std::string getCacheFile( const Key& key ) const;
+  bool readCache( const std::string& file, std::vector<std::string>& paths ) const;
+  void writeCache( const std::string& file, const std::vector<std::string>& paths ) const;
+
+  mutable boost::mutex mutex_;
+  boost::condition_variable ready_;
+  std::map<Key, Entry> entries_;
+  std::deque<Key> queue_;               ///< Keys waiting for the background thread
+  bool worker_running_;
+  std::string cache_directory_;
+};
+
+} // end namespace rviz
+
+#endif // RVIZ_PLUGIN_INDEX_H
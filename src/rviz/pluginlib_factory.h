@@ -42,6 +42,7 @@
 
 #include "rviz/class_id_recording_factory.h"
 #include "rviz/load_resource.h"
+#include "rviz/plugin_index.h"
 
 namespace rviz
 {
@@ -61,8 +62,10 @@ private:
 
 public:
   PluginlibFactory( const QString& package, const QString& base_class_type )
+    : package_( package.toStdString() )
+    , base_class_type_( base_class_type.toStdString() )
+    , class_loader_( NULL )
     {
-      class_loader_ = new pluginlib::ClassLoader<Type>( package.toStdString(), base_class_type.toStdString() );
     }
   virtual ~PluginlibFactory()
     {
@@ -72,7 +75,7 @@ public:
   virtual QStringList getDeclaredClassIds()
     {
       QStringList ids;
-      std::vector<std::string> std_ids = class_loader_->getDeclaredClasses();
+      std::vector<std::string> std_ids = getClassLoader()->getDeclaredClasses();
       for( size_t i = 0; i < std_ids.size(); i++ )
       {
         ids.push_back( QString::fromStdString( std_ids[ i ]));
@@ -92,7 +95,7 @@ public:
       {
         return iter->description_;
       }
-      return QString::fromStdString( class_loader_->getClassDescription( class_id.toStdString() ));
+      return QString::fromStdString( getClassLoader()->getClassDescription( class_id.toStdString() ));
     }
 
   virtual QString getClassName( const QString& class_id ) const
@@ -102,7 +105,7 @@ public:
       {
         return iter->name_;
       }
-      return QString::fromStdString( class_loader_->getName( class_id.toStdString() ));
+      return QString::fromStdString( getClassLoader()->getName( class_id.toStdString() ));
     }
 
   virtual QString getClassPackage( const QString& class_id ) const
@@ -112,7 +115,7 @@ public:
       {
         return iter->package_;
       }
-      return QString::fromStdString( class_loader_->getClassPackage( class_id.toStdString() ));
+      return QString::fromStdString( getClassLoader()->getClassPackage( class_id.toStdString() ));
     }
 
   virtual QString getPluginManifestPath( const QString& class_id ) const
@@ -122,7 +125,7 @@ public:
       {
         return "";
       }
-      return QString::fromStdString( class_loader_->getPluginManifestPath( class_id.toStdString() ));
+      return QString::fromStdString( getClassLoader()->getPluginManifestPath( class_id.toStdString() ));
     }
 
   virtual QIcon getIcon( const QString& class_id ) const
@@ -179,7 +182,7 @@ protected:
       }
       try
       {
-        return class_loader_->createUnmanagedInstance( class_id.toStdString() );
+        return getClassLoader()->createUnmanagedInstance( class_id.toStdString() );
       }
       catch( pluginlib::PluginlibException& ex )
       {
@@ -194,7 +197,23 @@ protected:
     }
 
 private:
-  pluginlib::ClassLoader<Type>* class_loader_;
+  /** @brief Return the class loader, creating it on first use.
+   *
+   * The plugin description files come from the PluginIndex, so
+   * factories do not crawl the package manifests themselves. */
+  pluginlib::ClassLoader<Type>* getClassLoader() const
+    {
+      if( !class_loader_ )
+      {
+        class_loader_ = new pluginlib::ClassLoader<Type>( package_, base_class_type_, "plugin",
+                                                          PluginIndex::instance()->getPluginXmlPaths( package_ ));
+      }
+      return class_loader_;
+    }
+
+  std::string package_;
+  std::string base_class_type_;
+  mutable pluginlib::ClassLoader<Type>* class_loader_;
   QHash<QString, BuiltInClassRecord> built_ins_;
 };
 
@@ -36,6 +36,8 @@ namespace rviz
 struct Preferences
 {
   bool prompt_save_on_exit = true;
+  int memory_budget_mb = 0;           ///< Memory limit for all displays together, 0 for unlimited.
+  int display_memory_cap_mb = 0;      ///< Memory limit for each display, 0 for unlimited.
 };
 
 } //namespace rviz
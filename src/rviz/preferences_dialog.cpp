@@ -29,6 +29,8 @@
 
 #include <QGroupBox>
 #include <QCheckBox>
+#include <QFormLayout>
+#include <QSpinBox>
 #include <QVBoxLayout>
 #include <QDialogButtonBox>
 #include <QPushButton>
@@ -57,6 +59,27 @@ PreferencesDialog::PreferencesDialog( Factory* factory,
   prompt_save_on_exit_checkbox_->setChecked(preferences_->prompt_save_on_exit);
   prompt_save_on_exit_checkbox_->setText(QString( "Prompt Save on Exit?"));
   preferences_layout->addWidget( prompt_save_on_exit_checkbox_ );
+
+  memory_budget_spin_box_ = new QSpinBox;
+  memory_budget_spin_box_->setRange( 0, 1024 * 1024 );
+  memory_budget_spin_box_->setSingleStep( 256 );
+  memory_budget_spin_box_->setSuffix( " MB" );
+  memory_budget_spin_box_->setSpecialValueText( "Unlimited" );
+  memory_budget_spin_box_->setValue( preferences_->memory_budget_mb );
+  memory_budget_spin_box_->setToolTip( "Memory all displays together may use.  Above this, "
+                                       "the displays using the most give back their oldest data." );
+  display_memory_cap_spin_box_ = new QSpinBox;
+  display_memory_cap_spin_box_->setRange( 0, 1024 * 1024 );
+  display_memory_cap_spin_box_->setSingleStep( 256 );
+  display_memory_cap_spin_box_->setSuffix( " MB" );
+  display_memory_cap_spin_box_->setSpecialValueText( "Unlimited" );
+  display_memory_cap_spin_box_->setValue( preferences_->display_memory_cap_mb );
+  display_memory_cap_spin_box_->setToolTip( "Memory a single display may use." );
+
+  QFormLayout* memory_layout = new QFormLayout;
+  memory_layout->addRow( "Display memory budget:", memory_budget_spin_box_ );
+  memory_layout->addRow( "Memory per display:", display_memory_cap_spin_box_ );
+  preferences_layout->addLayout( memory_layout );
   preferences_box->setLayout( preferences_layout );
 
   // Buttons
@@ -75,7 +98,7 @@ PreferencesDialog::PreferencesDialog( Factory* factory,
 
 QSize PreferencesDialog::sizeHint () const
 {
-  return( QSize(500,100) );
+  return( QSize(500,160) );
 }
 
 void PreferencesDialog::setError( const QString& error_text )
@@ -94,6 +117,8 @@ void PreferencesDialog::accept()
   if( isValid() )
   {
     preferences_->prompt_save_on_exit = prompt_save_on_exit_checkbox_->isChecked();
+    preferences_->memory_budget_mb = memory_budget_spin_box_->value();
+    preferences_->display_memory_cap_mb = display_memory_cap_spin_box_->value();
     QDialog::accept();
   }
 }
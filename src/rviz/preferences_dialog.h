@@ -36,6 +36,7 @@
 
 class QCheckBox;
 class QDialogButtonBox;
+class QSpinBox;
 
 namespace rviz
 {
@@ -72,6 +73,8 @@ private:
   Factory* factory_;
 
   QCheckBox* prompt_save_on_exit_checkbox_;
+  QSpinBox* memory_budget_spin_box_;
+  QSpinBox* display_memory_cap_spin_box_;
   Preferences* preferences_;
 
   /** Widget with OK and CANCEL buttons. */
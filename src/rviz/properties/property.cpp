@@ -371,6 +371,39 @@ void Property::addChild( Property* child, int index )
   Q_EMIT childListChanged( this );
 }
 
+void Property::addChildren( const QList<Property*>& children, int index )
+{
+  if( children.isEmpty() )
+  {
+    return;
+  }
+  int num_children = children_.size();
+  if( index < 0 || index > num_children )
+  {
+    index = num_children;
+  }
+  if( model_ )
+  {
+    model_->beginInsert( this, index, children.size() );
+  }
+
+  for( int i = 0; i < children.size(); i++ )
+  {
+    Property* child = children[ i ];
+    children_.insert( index + i, child );
+    child->setModel( model_ );
+    child->parent_ = this;
+  }
+  child_indexes_valid_ = false;
+
+  if( model_ )
+  {
+    model_->endInsert();
+  }
+
+  Q_EMIT childListChanged( this );
+}
+
 void Property::setModel( PropertyTreeModel* model )
 {
   model_ = model;
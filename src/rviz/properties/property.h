@@ -329,6 +329,14 @@ public:
    *   child will be added at the end. */
   virtual void addChild( Property* child, int index = -1 );
 
+  /** @brief Add several child properties at once.
+   *
+   * Like calling addChild() for each of @a children, but the model is
+   * notified of a single insert, so build large subtrees without a
+   * parent and add them with this.  Does not call addChild(), so it
+   * is not for subclasses which override addChild(). */
+  void addChildren( const QList<Property*>& children, int index = -1 );
+
   /** @brief Set the model managing this Property and all its child properties, recursively. */
   void setModel( PropertyTreeModel* model );
 
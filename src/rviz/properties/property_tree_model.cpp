@@ -29,6 +29,10 @@
 
 #include <stdio.h>
 
+#include <algorithm>
+#include <map>
+#include <vector>
+
 #include <QStringList>
 #include <QMimeData>
 
@@ -42,12 +46,14 @@ namespace rviz
 PropertyTreeModel::PropertyTreeModel( Property* root_property, QObject* parent )
   : QAbstractItemModel( parent )
   , root_property_( root_property )
+  , pending_changes_queued_( false )
 {
   root_property_->setModel( this );
 }
 
 PropertyTreeModel::~PropertyTreeModel()
 {
+  pending_changes_.clear();
   delete root_property_;
 }
 
@@ -297,13 +303,87 @@ void PropertyTreeModel::emitDataChanged( Property* property )
   {
     Q_EMIT configChanged();
   }
-  QModelIndex left_index = indexOf( property );
-  QModelIndex right_index = createIndex( left_index.row(), 1, left_index.internalPointer() );
-  Q_EMIT dataChanged( left_index, right_index );
+  if( property == root_property_ )
+  {
+    return;
+  }
+  pending_changes_.insert( property );
+  if( !pending_changes_queued_ )
+  {
+    pending_changes_queued_ = true;
+    QMetaObject::invokeMethod( this, "emitPendingDataChanged", Qt::QueuedConnection );
+  }
+}
+
+void PropertyTreeModel::emitPendingDataChanged()
+{
+  pending_changes_queued_ = false;
+  if( pending_changes_.isEmpty() )
+  {
+    return;
+  }
+
+  typedef std::map<Property*, std::vector<int> > M_Rows;
+  M_Rows rows_by_parent;
+  for( QSet<Property*>::const_iterator it = pending_changes_.begin(); it != pending_changes_.end(); ++it )
+  {
+    Property* property = *it;
+    if( property->getParent() )
+    {
+      rows_by_parent[ property->getParent() ].push_back( property->rowNumberInParent() );
+    }
+  }
+  pending_changes_.clear();
+
+  for( M_Rows::iterator it = rows_by_parent.begin(); it != rows_by_parent.end(); ++it )
+  {
+    Property* parent = it->first;
+    std::vector<int>& rows = it->second;
+    std::sort( rows.begin(), rows.end() );
+
+    size_t first = 0;
+    while( first < rows.size() )
+    {
+      size_t last = first;
+      while( last + 1 < rows.size() && rows[ last + 1 ] == rows[ last ] + 1 )
+      {
+        last++;
+      }
+      QModelIndex left_index = createIndex( rows[ first ], 0, parent->childAtUnchecked( rows[ first ] ));
+      QModelIndex right_index = createIndex( rows[ last ], 1, parent->childAtUnchecked( rows[ last ] ));
+      Q_EMIT dataChanged( left_index, right_index );
+      first = last + 1;
+    }
+  }
+}
+
+void PropertyTreeModel::dropPendingDataChanged( Property* parent_property, int first_row, int last_row )
+{
+  QSet<Property*>::iterator it = pending_changes_.begin();
+  while( it != pending_changes_.end() )
+  {
+    // Find the ancestor which is a child of parent_property, if any.
+    Property* ancestor = *it;
+    while( ancestor && ancestor->getParent() != parent_property )
+    {
+      ancestor = ancestor->getParent();
+    }
+    if( ancestor )
+    {
+      int row = ancestor->rowNumberInParent();
+      if( row >= first_row && row <= last_row )
+      {
+        it = pending_changes_.erase( it );
+        continue;
+      }
+    }
+    ++it;
+  }
 }
 
 void PropertyTreeModel::beginInsert( Property* parent_property, int row_within_parent, int count )
 {
+
   // printf( "PropertyTreeModel::beginInsert() into %s row %d, %d rows.  Persistent indices:\n",
   //         qPrintable( parent_property->getName()), row_within_parent, count );
   // printPersistentIndices();
@@ -323,6 +403,8 @@ void PropertyTreeModel::beginRemove( Property* parent_property, int row_within_p
   //         qPrintable( parent_property->getName()), row_within_parent, count );
   // printPersistentIndices();
 
+  dropPendingDataChanged( parent_property, row_within_parent, row_within_parent + count - 1 );
+
   beginRemoveRows( indexOf( parent_property ), row_within_parent, row_within_parent + count - 1 );
 }
 
@@ -30,6 +30,7 @@
 #define PROPERTY_MODEL_H
 
 #include <QAbstractItemModel>
+#include <QSet>
 
 namespace rviz
 {
@@ -108,6 +109,14 @@ public:
 
   QModelIndex indexOf( Property* property ) const;
 
+  /** @brief Notify views that the data of @a property changed.
+   *
+   * configChanged() is emitted right away, but dataChanged() is
+   * emitted once per event loop iteration, with one range per run of
+   * changed sibling rows, so displays which change thousands of
+   * properties per frame do not cause thousands of view updates.
+   * Rows are looked up when the signal is emitted, so inserts and
+   * moves in between are fine; removed properties are dropped. */
   void emitDataChanged( Property* property );
 
   void beginInsert( Property* parent_property, int row_within_parent, int count = 1 );
@@ -146,8 +155,18 @@ Q_SIGNALS:
   /** @brief Emitted when a Property wants to collapse (hide its children). */
   void collapse( const QModelIndex& index );
 
+private Q_SLOTS:
+  /** @brief Emit dataChanged() for the changes collected by emitDataChanged(). */
+  void emitPendingDataChanged();
+
 private:
+  /** @brief Forget pending changes of the given rows of
+   * @a parent_property and their descendants, before they are removed. */
+  void dropPendingDataChanged( Property* parent_property, int first_row, int last_row );
+
   Property* root_property_;
+  QSet<Property*> pending_changes_;
+  bool pending_changes_queued_;
   QString drag_drop_class_; ///< Identifier to add to mimeTypes() entry to keep drag/drops from crossing types.
 };
 
@@ -27,11 +27,8 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include "ros/master.h"
-
 #include "rviz/properties/ros_topic_property.h"
-
-#include <QApplication>
+#include "rviz/topic_cache.h"
 
 
 namespace rviz
@@ -58,28 +55,16 @@ void RosTopicProperty::setMessageType( const QString& message_type )
 
 void RosTopicProperty::fillTopicList()
 {
-  QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
   clearOptions();
 
-  std::string std_message_type = message_type_.toStdString();
-
-  ros::master::V_TopicInfo topics;
-  ros::master::getTopics( topics );
-
-  // Loop through all published topics
-  ros::master::V_TopicInfo::iterator it;
-  for( it = topics.begin(); it != topics.end(); ++it )
+  // Served from memory; ask for fresh topics for the next time.
+  TopicCache* cache = TopicCache::instance();
+  std::vector<std::string> topics = cache->getTopicsOfType( message_type_.toStdString() );
+  for( size_t i = 0; i < topics.size(); i++ )
   {
-    const ros::master::TopicInfo& topic = *it;
-
-    // Only add topics whose type matches.
-    if( topic.datatype == std_message_type )
-    {
-      addOptionStd( topic.name );
-    }
+    addOptionStd( topics[ i ] );
   }
-  sortOptions();
-  QApplication::restoreOverrideCursor();
+  cache->requestRefresh();
 }
 
 } // end namespace rviz
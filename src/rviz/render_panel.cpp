@@ -177,6 +177,24 @@ void RenderPanel::keyPressEvent( QKeyEvent* event )
   }
 }
 
+void RenderPanel::paintEvent( QPaintEvent* event )
+{
+  QtOgreRenderWindow::paintEvent( event );
+  if( context_ )
+  {
+    context_->queueRender();
+  }
+}
+
+void RenderPanel::resizeEvent( QResizeEvent* event )
+{
+  QtOgreRenderWindow::resizeEvent( event );
+  if( context_ )
+  {
+    context_->queueRender();
+  }
+}
+
 void RenderPanel::setViewController( ViewController* controller )
 {
   view_controller_ = controller;
@@ -127,6 +127,11 @@ protected:
 
   virtual void keyPressEvent( QKeyEvent* event );
 
+  // The window contents are only redrawn when a render is queued, so
+  // exposing or resizing the window has to queue one.
+  virtual void paintEvent( QPaintEvent* event );
+  virtual void resizeEvent( QResizeEvent* event );
+
   // Mouse handling
   int mouse_x_;                                           ///< X position of the last mouse event
   int mouse_y_;                                           ///< Y position of the last mouse event
@@ -0,0 +1,266 @@
+/*
+ * Copyright (c) 2012, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RVIZ_SHARED_MESSAGE_FILTER_H
+#define RVIZ_SHARED_MESSAGE_FILTER_H
+
+#include <map>
+#include <string>
+
+#ifndef Q_MOC_RUN
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/tuple/tuple.hpp>
+#include <boost/tuple/tuple_comparison.hpp>
+#include <boost/weak_ptr.hpp>
+
+#include <message_filters/subscriber.h>
+#include <ros/callback_queue_interface.h>
+#include <ros/node_handle.h>
+#endif
+
+#include "rviz/display_context.h"
+#include "rviz/frame_manager.h"
+#include "rviz/transform_message_filter.h"
+
+namespace rviz
+{
+
+/** @brief One subscription and transform filter per topic, shared by
+ * all displays showing the topic.
+ *
+ * Displays with the same topic, fixed frame, transport and queue size
+ * get the same SharedMessageFilter from get().  The message is
+ * received and deserialized once, waits for its transform once, and
+ * the same message pointer is handed to every listener, on the
+ * callback queue each listener asked for.  A display which derives
+ * data from the message only depending on the message, not on its
+ * own settings, can compute it once for all of them.
+ *
+ * The filter is unsubscribed when the last display releases it. */
+template<class MessageType>
+class SharedMessageFilter
+{
+public:
+  typedef boost::shared_ptr<SharedMessageFilter> Ptr;
+  typedef ros::MessageEvent<MessageType const> Event;
+  typedef boost::function<void ( const Event& )> Callback;
+  typedef boost::function<void ( const Event&, tf2_ros::FilterFailureReason )> FailureCallback;
+
+  /** @brief Return the filter for the given topic and settings,
+   * subscribing if no display uses it yet.  Throws ros::Exception if
+   * subscribing fails. */
+  static Ptr get( DisplayContext* context, const std::string& topic, const std::string& fixed_frame,
+                  bool unreliable, uint32_t queue_size )
+  {
+    Key key( context->getReceiveQueue(), topic, fixed_frame, unreliable, queue_size );
+
+    Registry& registry = getRegistry();
+    boost::mutex::scoped_lock lock( registry.mutex );
+    typename Registry::Map::iterator it = registry.filters.begin();
+    while( it != registry.filters.end() )
+    {
+      if( it->second.expired() )
+      {
+        registry.filters.erase( it++ );
+      }
+      else
+      {
+        ++it;
+      }
+    }
+
+    Ptr filter = registry.filters[ key ].lock();
+    if( !filter )
+    {
+      filter.reset( new SharedMessageFilter( context, topic, fixed_frame, unreliable, queue_size ));
+      registry.filters[ key ] = filter;
+    }
+    return filter;
+  }
+
+  ~SharedMessageFilter()
+  {
+    sub_.unsubscribe();
+  }
+
+  /** @brief Call @a callback on @a queue for each message which
+   * passed the filter, and @a failure_callback right away for each
+   * message which was dropped.  @a owner identifies the listener for
+   * removeListener(). */
+  void addListener( const void* owner, ros::CallbackQueueInterface* queue,
+                    const Callback& callback, const FailureCallback& failure_callback )
+  {
+    Listener listener;
+    listener.queue = queue;
+    listener.callback = callback;
+    listener.failure_callback = failure_callback;
+
+    boost::mutex::scoped_lock lock( mutex_ );
+    listeners_[ owner ] = listener;
+  }
+
+  /** @brief Stop calling the callbacks of @a owner, dropping messages
+   * queued for it.  When this returns, none of its callbacks is
+   * running anymore. */
+  void removeListener( const void* owner )
+  {
+    ros::CallbackQueueInterface* queue = NULL;
+    {
+      boost::mutex::scoped_lock lock( mutex_ );
+      typename std::map<const void*, Listener>::iterator it = listeners_.find( owner );
+      if( it == listeners_.end() )
+      {
+        return;
+      }
+      queue = it->second.queue;
+      listeners_.erase( it );
+    }
+    // Waits for a callback of this owner which is running.
+    queue->removeByID( (uint64_t) owner );
+  }
+
+  /** @brief Feed a message from this process into the filter, as if
+   * it had been received on the topic.  The message is not copied. */
+  void add( const Event& event )
+  {
+    filter_.add( event );
+  }
+
+  const std::string& getTopic() const { return topic_; }
+
+private:
+  typedef boost::tuple<ros::CallbackQueueInterface*, std::string, std::string, bool, uint32_t> Key;
+
+  struct Registry
+  {
+    typedef std::map<Key, boost::weak_ptr<SharedMessageFilter> > Map;
+    boost::mutex mutex;
+    Map filters;
+  };
+
+  static Registry& getRegistry()
+  {
+    static Registry registry;
+    return registry;
+  }
+
+  struct Listener
+  {
+    ros::CallbackQueueInterface* queue;
+    Callback callback;
+    FailureCallback failure_callback;
+  };
+
+  /** Calls one listener with one message on the listener's queue. */
+  class ListenerCall: public ros::CallbackInterface
+  {
+  public:
+    ListenerCall( const Callback& callback, const Event& event )
+      : callback_( callback )
+      , event_( event )
+    {}
+
+    virtual CallResult call()
+    {
+      callback_( event_ );
+      return Success;
+    }
+
+  private:
+    Callback callback_;
+    Event event_;
+  };
+
+  SharedMessageFilter( DisplayContext* context, const std::string& topic, const std::string& fixed_frame,
+                       bool unreliable, uint32_t queue_size )
+    : topic_( topic )
+    , nh_( makeNodeHandle( context->getReceiveQueue() ))
+    , filter_( *context->getFrameManager()->getTransformScheduler(), fixed_frame, queue_size, nh_ )
+  {
+    filter_.connectInput( sub_ );
+    filter_.registerCallback( boost::function<void ( const Event& )>(
+        boost::bind( &SharedMessageFilter::incomingMessage, this, _1 )));
+    filter_.registerFailureCallback( boost::bind( &SharedMessageFilter::failedMessage, this, _1, _2 ));
+
+    ros::TransportHints transport_hint = ros::TransportHints().reliable();
+    if( unreliable )
+    {
+      transport_hint = ros::TransportHints().unreliable();
+    }
+    sub_.subscribe( nh_, topic, queue_size, transport_hint );
+  }
+
+  /** Receive, filter and hand out on the receive threads; the
+   * listeners do their work on their own queues. */
+  static ros::NodeHandle makeNodeHandle( ros::CallbackQueueInterface* queue )
+  {
+    ros::NodeHandle nh;
+    nh.setCallbackQueue( queue );
+    return nh;
+  }
+
+  void incomingMessage( const Event& event )
+  {
+    boost::mutex::scoped_lock lock( mutex_ );
+    for( typename std::map<const void*, Listener>::iterator it = listeners_.begin(); it != listeners_.end(); ++it )
+    {
+      it->second.queue->addCallback( ros::CallbackInterfacePtr( new ListenerCall( it->second.callback, event )),
+                                     (uint64_t) it->first );
+    }
+  }
+
+  void failedMessage( const typename MessageType::ConstPtr& msg, tf2_ros::FilterFailureReason reason )
+  {
+    Event event( msg );
+    boost::mutex::scoped_lock lock( mutex_ );
+    for( typename std::map<const void*, Listener>::iterator it = listeners_.begin(); it != listeners_.end(); ++it )
+    {
+      it->second.failure_callback( event, reason );
+    }
+  }
+
+  std::string topic_;
+  ros::NodeHandle nh_;
+
+  // Declared before filter_, which is destroyed first and waits for
+  // its running callbacks, which use these.
+  boost::mutex mutex_;
+  std::map<const void*, Listener> listeners_;
+
+  message_filters::Subscriber<MessageType> sub_;
+  TransformMessageFilter<MessageType> filter_;
+};
+
+} // namespace rviz
+
+#endif // RVIZ_SHARED_MESSAGE_FILTER_H
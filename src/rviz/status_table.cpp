@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2012, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <QHash>
+
+#include "rviz/status_table.h"
+
+namespace rviz
+{
+
+StatusTable::StatusTable( size_t capacity )
+  : slots_( new Slot[ capacity ] )
+  , capacity_( capacity )
+  , clear_generation_( 0 )
+  , taken_generation_( 0 )
+{
+  for( size_t i = 0; i < capacity_; i++ )
+  {
+    slots_[ i ].name.store( NULL );
+    slots_[ i ].entry.store( NULL );
+  }
+}
+
+StatusTable::~StatusTable()
+{
+  for( size_t i = 0; i < capacity_; i++ )
+  {
+    delete slots_[ i ].name.load();
+    delete slots_[ i ].entry.load();
+  }
+  delete [] slots_;
+
+  std::map<QString, Entry*>::iterator it;
+  for( it = overflow_.begin(); it != overflow_.end(); ++it )
+  {
+    delete it->second;
+  }
+}
+
+void StatusTable::set( int level, const QString& name, const QString& text )
+{
+  Entry* entry = new Entry;
+  entry->deleted = false;
+  entry->level = level;
+  entry->text = text;
+  write( name, entry );
+}
+
+void StatusTable::remove( const QString& name )
+{
+  Entry* entry = new Entry;
+  entry->deleted = true;
+  entry->level = 0;
+  write( name, entry );
+}
+
+void StatusTable::clear()
+{
+  clear_generation_++;
+}
+
+void StatusTable::write( const QString& name, Entry* entry )
+{
+  entry->generation = clear_generation_.load();
+
+  Slot* slot = findSlot( name );
+  if( slot )
+  {
+    // Whoever exchanges an entry out of a slot owns it.
+    delete slot->entry.exchange( entry );
+    return;
+  }
+
+  boost::mutex::scoped_lock lock( overflow_mutex_ );
+  Entry*& overflow_entry = overflow_[ name ];
+  delete overflow_entry;
+  overflow_entry = entry;
+}
+
+StatusTable::Slot* StatusTable::findSlot( const QString& name )
+{
+  size_t start = qHash( name ) % capacity_;
+  for( size_t i = 0; i < capacity_; i++ )
+  {
+    Slot* slot = &slots_[ ( start + i ) % capacity_ ];
+    const QString* slot_name = slot->name.load();
+    if( !slot_name )
+    {
+      QString* new_name = new QString( name );
+      if( slot->name.compare_exchange_strong( slot_name, new_name ))
+      {
+        return slot;
+      }
+      // Another thread claimed the slot first, slot_name is its name now.
+      delete new_name;
+    }
+    if( *slot_name == name )
+    {
+      return slot;
+    }
+  }
+  return NULL;
+}
+
+void StatusTable::putBack( Slot* slot, Entry* entry )
+{
+  // If the slot got an even newer entry meanwhile, that one wins.
+  Entry* expected = NULL;
+  if( !slot->entry.compare_exchange_strong( expected, entry ))
+  {
+    delete entry;
+  }
+}
+
+void StatusTable::take( bool* cleared, std::vector<Update>& updates )
+{
+  uint64_t generation = clear_generation_.load();
+  *cleared = ( generation != taken_generation_ );
+  taken_generation_ = generation;
+
+  updates.clear();
+  Update update;
+  for( size_t i = 0; i < capacity_; i++ )
+  {
+    Slot* slot = &slots_[ i ];
+    const QString* name = slot->name.load();
+    if( !name )
+    {
+      continue;
+    }
+    Entry* entry = slot->entry.exchange( NULL );
+    if( !entry )
+    {
+      continue;
+    }
+    if( entry->generation > generation )
+    {
+      // Written after a clear() which this take() does not apply yet.
+      putBack( slot, entry );
+      continue;
+    }
+    // Entries older than the last clear() are dropped.
+    if( entry->generation == generation )
+    {
+      update.deleted = entry->deleted;
+      update.level = entry->level;
+      update.name = *name;
+      update.text = entry->text;
+      updates.push_back( update );
+    }
+    delete entry;
+  }
+
+  boost::mutex::scoped_lock lock( overflow_mutex_ );
+  std::map<QString, Entry*>::iterator it = overflow_.begin();
+  while( it != overflow_.end() )
+  {
+    Entry* entry = it->second;
+    if( entry->generation > generation )
+    {
+      ++it;
+      continue;
+    }
+    if( entry->generation == generation )
+    {
+      update.deleted = entry->deleted;
+      update.level = entry->level;
+      update.name = it->first;
+      update.text = entry->text;
+      updates.push_back( update );
+    }
+    delete entry;
+    overflow_.erase( it++ );
+  }
+}
+
+} // end namespace rviz
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2012, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RVIZ_STATUS_TABLE_H
+#define RVIZ_STATUS_TABLE_H
+
+#include <stdint.h>
+
+#include <atomic>
+#include <map>
+#include <vector>
+
+#include <QString>
+
+#ifndef Q_MOC_RUN
+#include <boost/thread/mutex.hpp>
+#endif
+
+namespace rviz
+{
+
+/** @brief Status changes of one Display, written by any thread and
+ * applied by the GUI thread.
+ *
+ * Each status name gets a slot holding only its latest change, so a
+ * status which is set for every message costs the GUI thread one
+ * update per take() instead of one per message.  Slots are claimed
+ * and written with atomic operations; only names past the slot
+ * capacity go to a map guarded by a mutex. */
+class StatusTable
+{
+public:
+  /** @brief One change to apply, the latest for its name. */
+  struct Update
+  {
+    bool deleted;       ///< True if the status was deleted.
+    int level;
+    QString name;
+    QString text;
+  };
+
+  explicit StatusTable( size_t capacity = 64 );
+  ~StatusTable();
+
+  /** @brief Set the status called @a name.  This is thread-safe. */
+  void set( int level, const QString& name, const QString& text );
+
+  /** @brief Delete the status called @a name.  This is thread-safe. */
+  void remove( const QString& name );
+
+  /** @brief Drop all statuses, including changes not taken yet.  This is thread-safe. */
+  void clear();
+
+  /** @brief Take the changes made since the last call.
+   *
+   * Only one thread may call this.
+   * @param cleared Set to true if clear() was called since the last
+   *        call, in which case all statuses must be dropped before
+   *        applying @a updates.
+   * @param updates Filled with the latest change of each changed name. */
+  void take( bool* cleared, std::vector<Update>& updates );
+
+private:
+  struct Entry
+  {
+    bool deleted;
+    int level;
+    QString text;
+    uint64_t generation;      ///< Value of clear_generation_ when written.
+  };
+
+  struct Slot
+  {
+    std::atomic<const QString*> name;   ///< Set once, when the slot is claimed.
+    std::atomic<Entry*> entry;          ///< Latest change not taken yet, or NULL.
+  };
+
+  void write( const QString& name, Entry* entry );
+
+  /** @brief Return the slot claimed for @a name, claiming a free one
+   * if needed.  Returns NULL if all slots are taken. */
+  Slot* findSlot( const QString& name );
+
+  /** @brief Return an entry taken out of @a slot, unless the slot has
+   * a newer one. */
+  void putBack( Slot* slot, Entry* entry );
+
+  Slot* slots_;
+  size_t capacity_;
+  std::atomic<uint64_t> clear_generation_;
+  uint64_t taken_generation_;
+
+  boost::mutex overflow_mutex_;
+  std::map<QString, Entry*> overflow_;
+};
+
+} // end namespace rviz
+
+#endif // RVIZ_STATUS_TABLE_H
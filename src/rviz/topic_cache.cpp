@@ -0,0 +1,293 @@
+/*
+ * Copyright (c) 2012, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+
+#include <boost/bind.hpp>
+
+#include "rviz/topic_cache.h"
+
+namespace rviz
+{
+
+// Seconds between background refreshes by default.
+static const double DEFAULT_REFRESH_INTERVAL = 2.0;
+
+struct LexicalTopicName
+{
+  bool operator()( const ros::master::TopicInfo& a, const ros::master::TopicInfo& b ) const
+  {
+    return a.name < b.name;
+  }
+};
+
+static bool fetchFromMaster( ros::master::V_TopicInfo& topics )
+{
+  return ros::master::getTopics( topics );
+}
+
+TopicCache* TopicCache::instance()
+{
+  // Never deleted, a refresh may still be waiting for the master at exit.
+  static TopicCache* cache = new TopicCache();
+  return cache;
+}
+
+TopicCache::TopicCache( const FetchFunction& fetch )
+  : fetch_( fetch ? fetch : FetchFunction( &fetchFromMaster ))
+  , valid_( false )
+  , revision_( 0 )
+  , refresh_interval_( DEFAULT_REFRESH_INTERVAL )
+  , refresh_requested_( false )
+  , running_( false )
+{
+}
+
+TopicCache::~TopicCache()
+{
+  stop();
+}
+
+void TopicCache::start()
+{
+  boost::mutex::scoped_lock lock( mutex_ );
+  if( running_ )
+  {
+    return;
+  }
+  running_ = true;
+  refresh_requested_ = true;
+  thread_ = boost::thread( boost::bind( &TopicCache::threadFunc, this ));
+}
+
+void TopicCache::stop()
+{
+  {
+    boost::mutex::scoped_lock lock( mutex_ );
+    if( !running_ )
+    {
+      return;
+    }
+    running_ = false;
+  }
+  wake_.notify_all();
+  thread_.join();
+}
+
+void TopicCache::setRefreshInterval( double seconds )
+{
+  {
+    boost::mutex::scoped_lock lock( mutex_ );
+    refresh_interval_ = std::max( seconds, 0.0 );
+  }
+  wake_.notify_all();
+}
+
+double TopicCache::getRefreshInterval() const
+{
+  boost::mutex::scoped_lock lock( mutex_ );
+  return refresh_interval_;
+}
+
+void TopicCache::requestRefresh()
+{
+  {
+    boost::mutex::scoped_lock lock( mutex_ );
+    if( running_ )
+    {
+      refresh_requested_ = true;
+      wake_.notify_all();
+      return;
+    }
+  }
+  refresh();
+}
+
+bool TopicCache::refresh()
+{
+  boost::mutex::scoped_lock refresh_lock( refresh_mutex_ );
+
+  ros::master::V_TopicInfo topics;
+  if( !fetch_( topics ))
+  {
+    return false;
+  }
+  std::sort( topics.begin(), topics.end(), LexicalTopicName() );
+
+  Diff diff;
+  {
+    boost::mutex::scoped_lock lock( mutex_ );
+    computeDiff( topics_, topics, diff );
+    topics_.swap( topics );
+    valid_ = true;
+    if( !diff.empty() )
+    {
+      revision_++;
+    }
+  }
+
+  if( !diff.empty() )
+  {
+    boost::mutex::scoped_lock listener_lock( listener_mutex_ );
+    for( std::list<ListenerEntry>::iterator it = listeners_.begin(); it != listeners_.end(); ++it )
+    {
+      it->listener( diff );
+    }
+  }
+  return true;
+}
+
+ros::master::V_TopicInfo TopicCache::getTopics()
+{
+  bool need_refresh;
+  {
+    boost::mutex::scoped_lock lock( mutex_ );
+    need_refresh = !valid_ && !running_;
+  }
+  if( need_refresh )
+  {
+    refresh();
+  }
+
+  boost::mutex::scoped_lock lock( mutex_ );
+  return topics_;
+}
+
+std::vector<std::string> TopicCache::getTopicsOfType( const std::string& datatype )
+{
+  ros::master::V_TopicInfo topics = getTopics();
+  std::vector<std::string> names;
+  for( size_t i = 0; i < topics.size(); i++ )
+  {
+    if( topics[ i ].datatype == datatype )
+    {
+      names.push_back( topics[ i ].name );
+    }
+  }
+  return names;
+}
+
+unsigned int TopicCache::getRevision() const
+{
+  boost::mutex::scoped_lock lock( mutex_ );
+  return revision_;
+}
+
+void TopicCache::addListener( const void* owner, const Listener& listener )
+{
+  ListenerEntry entry;
+  entry.owner = owner;
+  entry.listener = listener;
+
+  boost::mutex::scoped_lock lock( listener_mutex_ );
+  listeners_.push_back( entry );
+}
+
+void TopicCache::removeListener( const void* owner )
+{
+  boost::mutex::scoped_lock lock( listener_mutex_ );
+  for( std::list<ListenerEntry>::iterator it = listeners_.begin(); it != listeners_.end(); )
+  {
+    if( it->owner == owner )
+    {
+      it = listeners_.erase( it );
+    }
+    else
+    {
+      ++it;
+    }
+  }
+}
+
+void TopicCache::computeDiff( const ros::master::V_TopicInfo& old_topics,
+                              const ros::master::V_TopicInfo& new_topics,
+                              Diff& diff )
+{
+  diff.added.clear();
+  diff.removed.clear();
+
+  // Merge the two sorted lists.
+  size_t old_index = 0;
+  size_t new_index = 0;
+  while( old_index < old_topics.size() || new_index < new_topics.size() )
+  {
+    if( new_index == new_topics.size() ||
+        ( old_index < old_topics.size() && old_topics[ old_index ].name < new_topics[ new_index ].name ))
+    {
+      diff.removed.push_back( old_topics[ old_index++ ] );
+    }
+    else if( old_index == old_topics.size() ||
+             new_topics[ new_index ].name < old_topics[ old_index ].name )
+    {
+      diff.added.push_back( new_topics[ new_index++ ] );
+    }
+    else
+    {
+      if( old_topics[ old_index ].datatype != new_topics[ new_index ].datatype )
+      {
+        diff.removed.push_back( old_topics[ old_index ] );
+        diff.added.push_back( new_topics[ new_index ] );
+      }
+      old_index++;
+      new_index++;
+    }
+  }
+}
+
+void TopicCache::threadFunc()
+{
+  boost::mutex::scoped_lock lock( mutex_ );
+  while( running_ )
+  {
+    if( !refresh_requested_ )
+    {
+      if( refresh_interval_ > 0.0 )
+      {
+        boost::posix_time::time_duration timeout =
+            boost::posix_time::microseconds( (long long)( refresh_interval_ * 1e6 ));
+        if( !wake_.timed_wait( lock, timeout ))
+        {
+          refresh_requested_ = true;
+        }
+      }
+      else
+      {
+        wake_.wait( lock );
+      }
+      continue;
+    }
+
+    refresh_requested_ = false;
+    lock.unlock();
+    refresh();
+    lock.lock();
+  }
+}
+
+} // namespace rviz
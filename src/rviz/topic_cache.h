@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2012, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RVIZ_TOPIC_CACHE_H
+#define RVIZ_TOPIC_CACHE_H
+
+#include <list>
+#include <string>
+#include <vector>
+
+#ifndef Q_MOC_RUN
+#include <boost/function.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <ros/master.h>
+#endif
+
+#include "rviz/rviz_export.h"
+
+namespace rviz
+{
+
+/** @brief The list of published topics, refreshed in the background.
+ *
+ * Asking the master for the topics blocks until it answers, which on
+ * large systems or with a slow master takes seconds.  The dialogs and
+ * properties used to do that on the GUI thread each time they opened.
+ * TopicCache asks the master on its own thread, at an interval and
+ * when requestRefresh() is called, and serves the last answer from
+ * memory.
+ *
+ * Listeners are told which topics were added and removed by each
+ * refresh, so widgets can update instead of rebuilding everything.
+ * A topic whose type changed is reported as removed and added. */
+class RVIZ_EXPORT TopicCache
+{
+public:
+  /** @brief Topics added and removed by one refresh, sorted by name. */
+  struct Diff
+  {
+    ros::master::V_TopicInfo added;
+    ros::master::V_TopicInfo removed;
+
+    bool empty() const { return added.empty() && removed.empty(); }
+  };
+
+  /** @brief Asks the master for the topics; returns false on failure. */
+  typedef boost::function<bool ( ros::master::V_TopicInfo& )> FetchFunction;
+
+  /** @brief Called with each non-empty Diff, on the thread which did the refresh. */
+  typedef boost::function<void ( const Diff& )> Listener;
+
+  /** @brief Return the cache shared by the whole process. */
+  static TopicCache* instance();
+
+  /** @brief Create a cache which uses @a fetch instead of
+   * ros::master::getTopics(), e.g. to test against a stand-in master. */
+  explicit TopicCache( const FetchFunction& fetch = FetchFunction() );
+  ~TopicCache();
+
+  /** @brief Start refreshing on a background thread.  Does nothing if
+   * it is already running. */
+  void start();
+
+  /** @brief Stop the background thread, waiting for a running refresh. */
+  void stop();
+
+  /** @brief Set the seconds between background refreshes.  0 only
+   * refreshes when requestRefresh() is called. */
+  void setRefreshInterval( double seconds );
+  double getRefreshInterval() const;
+
+  /** @brief Wake the background thread to refresh now.  Without a
+   * running thread, this refreshes on the calling thread. */
+  void requestRefresh();
+
+  /** @brief Ask the master for the topics on the calling thread and
+   * notify the listeners of the changes.  Returns false if the master
+   * could not be reached; the cached topics are kept then. */
+  bool refresh();
+
+  /** @brief Return the cached topics, sorted by name.
+   *
+   * If the cache was never refreshed and no background thread is
+   * running, this refreshes first, so users without a running thread
+   * see the same topics as before. */
+  ros::master::V_TopicInfo getTopics();
+
+  /** @brief Return the names of the cached topics of type @a datatype, sorted. */
+  std::vector<std::string> getTopicsOfType( const std::string& datatype );
+
+  /** @brief Return the number of refreshes which changed the topics. */
+  unsigned int getRevision() const;
+
+  /** @brief Add a listener for changes.  @a owner identifies it for removeListener(). */
+  void addListener( const void* owner, const Listener& listener );
+
+  /** @brief Remove the listeners added by @a owner.  When this returns,
+   * none of them is running anymore. */
+  void removeListener( const void* owner );
+
+  /** @brief Compute the changes from @a old_topics to @a new_topics, both sorted by name. */
+  static void computeDiff( const ros::master::V_TopicInfo& old_topics,
+                           const ros::master::V_TopicInfo& new_topics,
+                           Diff& diff );
+
+private:
+  void threadFunc();
+
+  struct ListenerEntry
+  {
+    const void* owner;
+    Listener listener;
+  };
+
+  FetchFunction fetch_;
+
+  mutable boost::mutex mutex_;
+  boost::condition_variable wake_;
+  ros::master::V_TopicInfo topics_;
+  bool valid_;
+  unsigned int revision_;
+  double refresh_interval_;
+  bool refresh_requested_;
+  bool running_;
+  boost::thread thread_;
+
+  // Serializes refreshes, so listeners get the diffs in order.
+  boost::mutex refresh_mutex_;
+
+  // Protects listeners_.  Held while the listeners run, so
+  // removeListener() waits for them, but not while fetching.
+  boost::mutex listener_mutex_;
+  std::list<ListenerEntry> listeners_;
+};
+
+} // namespace rviz
+
+#endif // RVIZ_TOPIC_CACHE_H
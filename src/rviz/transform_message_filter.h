@@ -0,0 +1,395 @@
+/*
+ * Copyright (c) 2012, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RVIZ_TRANSFORM_MESSAGE_FILTER_H
+#define RVIZ_TRANSFORM_MESSAGE_FILTER_H
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#ifndef Q_MOC_RUN
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/signals2.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <message_filters/connection.h>
+#include <message_filters/simple_filter.h>
+#include <ros/callback_queue_interface.h>
+#include <ros/message_traits.h>
+#include <ros/node_handle.h>
+#include <tf2_ros/message_filter.h>
+#endif
+
+#include "rviz/transform_scheduler.h"
+
+namespace rviz
+{
+
+/** @brief Passes on messages once their transform into the target
+ * frames is available, like tf2_ros::MessageFilter.
+ *
+ * Instead of registering a request with the tf2 buffer for each
+ * message, the filter waits through the TransformScheduler shared by
+ * all filters, which checks pending messages only when transforms
+ * they need arrive.  Queue size, tolerance, and the failure reasons
+ * passed to failure callbacks are the same as with
+ * tf2_ros::MessageFilter: the oldest message is dropped with
+ * filter_failure_reasons::Unknown when the queue is full, messages too
+ * old for the buffer with OutTheBack, and messages without frame with
+ * EmptyFrameID.
+ *
+ * Callbacks are called on the callback queue of the NodeHandle given
+ * to the constructor. */
+template<class M>
+class TransformMessageFilter: public message_filters::SimpleFilter<M>
+{
+public:
+  typedef boost::shared_ptr<M const> MConstPtr;
+  typedef ros::MessageEvent<M const> MEvent;
+  typedef boost::function<void ( const MConstPtr&, tf2_ros::FilterFailureReason )> FailureCallback;
+  typedef boost::signals2::signal<void ( const MConstPtr&, tf2_ros::FilterFailureReason )> FailureSignal;
+
+  TransformMessageFilter( TransformScheduler& scheduler, const std::string& target_frame,
+                          uint32_t queue_size, const ros::NodeHandle& nh )
+    : scheduler_( scheduler )
+    , queue_size_( queue_size )
+    , callback_queue_( nh.getCallbackQueue() )
+    , next_id_( 1 )
+    , guard_( new Guard )
+  {
+    guard_->filter = this;
+    setTargetFrame( target_frame );
+  }
+
+  ~TransformMessageFilter()
+  {
+    message_connection_.disconnect();
+    {
+      // Wait for a scheduler callback running right now.
+      boost::mutex::scoped_lock lock( guard_->mutex );
+      guard_->filter = NULL;
+    }
+    clear();
+    callback_queue_->removeByID( (uint64_t) this );
+  }
+
+  /** @brief Take the messages of @a f as input. */
+  template<class F>
+  void connectInput( F& f )
+  {
+    message_connection_.disconnect();
+    message_connection_ = f.registerCallback( &TransformMessageFilter::incomingMessage, this );
+  }
+
+  void setTargetFrame( const std::string& target_frame )
+  {
+    std::vector<std::string> frames;
+    frames.push_back( target_frame );
+    setTargetFrames( frames );
+  }
+
+  /** @brief Wait for the transforms into all of @a target_frames.
+   * Messages already waiting keep waiting for the old frames. */
+  void setTargetFrames( const std::vector<std::string>& target_frames )
+  {
+    boost::mutex::scoped_lock lock( mutex_ );
+    target_frames_.clear();
+    for( size_t i = 0; i < target_frames.size(); i++ )
+    {
+      if( !target_frames[ i ].empty() )
+      {
+        target_frames_.push_back( target_frames[ i ] );
+      }
+    }
+  }
+
+  std::string getTargetFramesString()
+  {
+    boost::mutex::scoped_lock lock( mutex_ );
+    std::string frames;
+    for( size_t i = 0; i < target_frames_.size(); i++ )
+    {
+      frames += (i ? ", " : "") + target_frames_[ i ];
+    }
+    return frames;
+  }
+
+  /** @brief Wait until the transform is available this much later
+   * than the stamp of the message. */
+  void setTolerance( const ros::Duration& tolerance )
+  {
+    boost::mutex::scoped_lock lock( mutex_ );
+    tolerance_ = tolerance;
+  }
+
+  /** @brief Keep at most @a queue_size messages waiting, 0 for no limit. */
+  void setQueueSize( uint32_t queue_size )
+  {
+    boost::mutex::scoped_lock lock( mutex_ );
+    queue_size_ = queue_size;
+  }
+
+  /** @brief Drop all waiting messages, without calling callbacks. */
+  void clear()
+  {
+    boost::mutex::scoped_lock lock( mutex_ );
+    for( typename std::list<Pending>::iterator it = pending_.begin(); it != pending_.end(); ++it )
+    {
+      cancel( *it );
+    }
+    pending_.clear();
+    requests_.clear();
+  }
+
+  void add( const MConstPtr& message )
+  {
+    add( MEvent( message, ros::Time::now() ));
+  }
+
+  void add( const MEvent& event )
+  {
+    const MConstPtr& message = event.getMessage();
+    std::string frame_id = ros::message_traits::FrameId<M>::value( *message );
+    ros::Time stamp = ros::message_traits::TimeStamp<M>::value( *message );
+    if( frame_id.empty() || frame_id == "/" )
+    {
+      dispatch( event, false, tf2_ros::filter_failure_reasons::EmptyFrameID );
+      return;
+    }
+
+    std::vector<MEvent> dropped;
+    bool done = false;
+    bool available = true;
+    {
+      boost::mutex::scoped_lock lock( mutex_ );
+      while( queue_size_ > 0 && pending_.size() >= queue_size_ )
+      {
+        dropped.push_back( pending_.front().event );
+        cancel( pending_.front() );
+        pending_.pop_front();
+      }
+
+      pending_.push_back( Pending() );
+      Pending& pending = pending_.back();
+      typename std::list<Pending>::iterator pending_it = --pending_.end();
+      pending.event = event;
+
+      for( size_t i = 0; i < target_frames_.size() && available; i++ )
+      {
+        uint64_t id = next_id_++;
+        bool result = false;
+        TransformScheduler::Handle handle = scheduler_.add(
+          target_frames_[ i ], frame_id, stamp, tolerance_,
+          boost::bind( &TransformMessageFilter::transformable, guard_, id, _1 ), &result );
+        if( handle )
+        {
+          pending.requests.push_back( std::make_pair( id, handle ));
+          requests_[ id ] = pending_it;
+        }
+        else
+        {
+          available = result;
+        }
+      }
+
+      if( !available || pending.requests.empty() )
+      {
+        cancel( pending );
+        pending_.erase( pending_it );
+        done = true;
+      }
+    }
+
+    for( size_t i = 0; i < dropped.size(); i++ )
+    {
+      dispatch( dropped[ i ], false, tf2_ros::filter_failure_reasons::Unknown );
+    }
+    if( done )
+    {
+      dispatch( event, available, tf2_ros::filter_failure_reasons::OutTheBack );
+    }
+  }
+
+  message_filters::Connection registerFailureCallback( const FailureCallback& callback )
+  {
+    boost::mutex::scoped_lock lock( failure_signal_mutex_ );
+    return message_filters::Connection(
+      boost::bind( &TransformMessageFilter::disconnectFailure, this, _1 ),
+      failure_signal_.connect( callback ));
+  }
+
+private:
+  struct Pending
+  {
+    MEvent event;
+    std::vector<std::pair<uint64_t, TransformScheduler::Handle> > requests;  ///< Outstanding ones
+  };
+
+  /** Lets scheduler callbacks find out whether the filter still exists. */
+  struct Guard
+  {
+    boost::mutex mutex;
+    TransformMessageFilter* filter;
+  };
+
+  /** Calls the success or failure callbacks on the callback queue. */
+  class QueuedCallback: public ros::CallbackInterface
+  {
+  public:
+    QueuedCallback( TransformMessageFilter* filter, const MEvent& event,
+                    bool success, tf2_ros::FilterFailureReason reason )
+      : filter_( filter )
+      , event_( event )
+      , success_( success )
+      , reason_( reason )
+    {}
+
+    virtual CallResult call()
+    {
+      if( success_ )
+      {
+        filter_->signalMessage( event_ );
+      }
+      else
+      {
+        filter_->signalFailure( event_, reason_ );
+      }
+      return Success;
+    }
+
+  private:
+    TransformMessageFilter* filter_;
+    MEvent event_;
+    bool success_;
+    tf2_ros::FilterFailureReason reason_;
+  };
+
+  void incomingMessage( const MEvent& event )
+  {
+    add( event );
+  }
+
+  static void transformable( const boost::shared_ptr<Guard>& guard, uint64_t id, bool available )
+  {
+    boost::mutex::scoped_lock lock( guard->mutex );
+    if( guard->filter )
+    {
+      guard->filter->transformable( id, available );
+    }
+  }
+
+  void transformable( uint64_t id, bool available )
+  {
+    MEvent event;
+    {
+      boost::mutex::scoped_lock lock( mutex_ );
+      typename std::map<uint64_t, typename std::list<Pending>::iterator>::iterator it = requests_.find( id );
+      if( it == requests_.end() )
+      {
+        return;
+      }
+      typename std::list<Pending>::iterator pending_it = it->second;
+      requests_.erase( it );
+
+      std::vector<std::pair<uint64_t, TransformScheduler::Handle> >& requests = pending_it->requests;
+      for( size_t i = 0; i < requests.size(); i++ )
+      {
+        if( requests[ i ].first == id )
+        {
+          requests.erase( requests.begin() + i );
+          break;
+        }
+      }
+      if( available && !requests.empty() )
+      {
+        // Wait for the other target frames.
+        return;
+      }
+
+      event = pending_it->event;
+      cancel( *pending_it );
+      pending_.erase( pending_it );
+    }
+    dispatch( event, available, tf2_ros::filter_failure_reasons::OutTheBack );
+  }
+
+  /** Cancel the outstanding requests of @a pending.  Expects mutex_ locked. */
+  void cancel( Pending& pending )
+  {
+    for( size_t i = 0; i < pending.requests.size(); i++ )
+    {
+      scheduler_.cancel( pending.requests[ i ].second );
+      requests_.erase( pending.requests[ i ].first );
+    }
+    pending.requests.clear();
+  }
+
+  void dispatch( const MEvent& event, bool success, tf2_ros::FilterFailureReason reason )
+  {
+    callback_queue_->addCallback( ros::CallbackInterfacePtr( new QueuedCallback( this, event, success, reason )),
+                                  (uint64_t) this );
+  }
+
+  void signalFailure( const MEvent& event, tf2_ros::FilterFailureReason reason )
+  {
+    boost::mutex::scoped_lock lock( failure_signal_mutex_ );
+    failure_signal_( event.getMessage(), reason );
+  }
+
+  void disconnectFailure( const message_filters::Connection& c )
+  {
+    boost::mutex::scoped_lock lock( failure_signal_mutex_ );
+    c.getBoostConnection().disconnect();
+  }
+
+  TransformScheduler& scheduler_;
+
+  boost::mutex mutex_;
+  std::vector<std::string> target_frames_;
+  ros::Duration tolerance_;
+  uint32_t queue_size_;
+  std::list<Pending> pending_;
+  std::map<uint64_t, typename std::list<Pending>::iterator> requests_;
+
+  ros::CallbackQueueInterface* callback_queue_;
+  uint64_t next_id_;
+  boost::shared_ptr<Guard> guard_;
+  message_filters::Connection message_connection_;
+
+  boost::mutex failure_signal_mutex_;
+  FailureSignal failure_signal_;
+};
+
+} // namespace rviz
+
+#endif // RVIZ_TRANSFORM_MESSAGE_FILTER_H
@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2012, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <vector>
+
+#include <boost/bind.hpp>
+
+#include "rviz/transform_scheduler.h"
+
+namespace rviz
+{
+
+static std::string stripSlash( const std::string& frame )
+{
+  if( !frame.empty() && frame[ 0 ] == '/' )
+  {
+    return frame.substr( 1 );
+  }
+  return frame;
+}
+
+TransformScheduler::TransformScheduler( tf2::BufferCore& buffer )
+  : buffer_( buffer )
+  , next_handle_( 1 )
+{
+  transforms_changed_connection_ =
+    buffer_._addTransformsChangedListener( boost::bind( &TransformScheduler::check, this ));
+}
+
+TransformScheduler::~TransformScheduler()
+{
+  buffer_._removeTransformsChangedListener( transforms_changed_connection_ );
+}
+
+bool TransformScheduler::getLatestTime( const GroupKey& key, ros::Time& latest ) const
+{
+  // Cheap test first, lookupTransform() throws when it fails.
+  if( !buffer_.canTransform( key.first, key.second, ros::Time() ))
+  {
+    return false;
+  }
+  try
+  {
+    latest = buffer_.lookupTransform( key.first, key.second, ros::Time() ).header.stamp;
+  }
+  catch( tf2::TransformException& )
+  {
+    return false;
+  }
+  return true;
+}
+
+TransformScheduler::Handle TransformScheduler::add( const std::string& target_frame, const std::string& source_frame,
+                                                    const ros::Time& stamp, const ros::Duration& tolerance,
+                                                    const Callback& callback, bool* available_out )
+{
+  GroupKey key( stripSlash( target_frame ), stripSlash( source_frame ));
+  ros::Time ready_time = stamp + tolerance;
+
+  // Locked before the test, so a check() for transforms arriving
+  // right after it sees the request.
+  boost::mutex::scoped_lock lock( mutex_ );
+  ros::Time latest;
+  if( getLatestTime( key, latest ) && (latest.isZero() || ready_time <= latest ))
+  {
+    *available_out = buffer_.canTransform( key.first, key.second, stamp );
+    return 0;
+  }
+
+  Request request;
+  request.handle = next_handle_++;
+  request.stamp = stamp;
+  request.callback = callback;
+  M_Request::iterator it = groups_[ key ].insert( std::make_pair( ready_time, request ));
+  handles_[ request.handle ] = std::make_pair( key, it );
+  return request.handle;
+}
+
+void TransformScheduler::cancel( Handle handle )
+{
+  boost::mutex::scoped_lock lock( mutex_ );
+  std::map<Handle, std::pair<GroupKey, M_Request::iterator> >::iterator it = handles_.find( handle );
+  if( it == handles_.end() )
+  {
+    return;
+  }
+
+  M_Group::iterator group_it = groups_.find( it->second.first );
+  group_it->second.erase( it->second.second );
+  if( group_it->second.empty() )
+  {
+    groups_.erase( group_it );
+  }
+  handles_.erase( it );
+}
+
+void TransformScheduler::check()
+{
+  std::vector<std::pair<Callback, bool> > results;
+  {
+    boost::mutex::scoped_lock lock( mutex_ );
+    M_Group::iterator group_it = groups_.begin();
+    while( group_it != groups_.end() )
+    {
+      ros::Time latest;
+      if( !getLatestTime( group_it->first, latest ))
+      {
+        ++group_it;
+        continue;
+      }
+
+      const std::string& target_frame = group_it->first.first;
+      const std::string& source_frame = group_it->first.second;
+      M_Request& requests = group_it->second;
+      M_Request::iterator it = requests.begin();
+      while( it != requests.end() && (latest.isZero() || it->first <= latest ))
+      {
+        bool available = buffer_.canTransform( target_frame, source_frame, it->second.stamp );
+        results.push_back( std::make_pair( it->second.callback, available ));
+        handles_.erase( it->second.handle );
+        requests.erase( it++ );
+      }
+
+      if( requests.empty() )
+      {
+        groups_.erase( group_it++ );
+      }
+      else
+      {
+        ++group_it;
+      }
+    }
+  }
+
+  for( size_t i = 0; i < results.size(); i++ )
+  {
+    results[ i ].first( results[ i ].second );
+  }
+}
+
+size_t TransformScheduler::getNumPending() const
+{
+  boost::mutex::scoped_lock lock( mutex_ );
+  return handles_.size();
+}
+
+} // namespace rviz
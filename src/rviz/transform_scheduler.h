@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2012, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RVIZ_TRANSFORM_SCHEDULER_H
+#define RVIZ_TRANSFORM_SCHEDULER_H
+
+#include <map>
+#include <string>
+#include <utility>
+
+#ifndef Q_MOC_RUN
+#include <boost/function.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <ros/duration.h>
+#include <ros/time.h>
+#include <tf2/buffer_core.h>
+#endif
+
+#include "rviz/rviz_export.h"
+
+namespace rviz
+{
+
+/** @brief Waits for transforms on behalf of all message filters.
+ *
+ * A tf2_ros::MessageFilter per display has every pending message
+ * checked again whenever any transform arrives.  The scheduler keeps
+ * the pending requests of all filters grouped by target and source
+ * frame, ordered by stamp.  When transforms change, it looks up the
+ * latest time each group can be transformed at once, and only checks
+ * the requests up to that time.  Requests of groups whose frames are
+ * still not connected are not checked at all.
+ *
+ * Results are delivered by calling the callback of a request, without
+ * any lock of the scheduler held, from the thread which changed the
+ * transforms. */
+class RVIZ_EXPORT TransformScheduler
+{
+public:
+  /** @brief Called with true when the transform is available, or
+   * false if it never will be, because the stamp is older than the
+   * data in the buffer. */
+  typedef boost::function<void ( bool available )> Callback;
+  typedef uint64_t Handle;
+
+  explicit TransformScheduler( tf2::BufferCore& buffer );
+  ~TransformScheduler();
+
+  /** @brief Request a call of @a callback when the transform from
+   * @a source_frame to @a target_frame at @a stamp is available.
+   * @param tolerance Wait until the transform is available this much
+   *        later than @a stamp.
+   * @param available_out Set to the result if it is known right away.
+   * @return A handle for cancel(), or 0 if the result is known right
+   *         away.  The callback is not called then. */
+  Handle add( const std::string& target_frame, const std::string& source_frame,
+              const ros::Time& stamp, const ros::Duration& tolerance,
+              const Callback& callback, bool* available_out );
+
+  /** @brief Drop the request, if it is still pending.  Its callback
+   * may still be running in another thread. */
+  void cancel( Handle handle );
+
+  /** @brief Check the pending requests against the buffer.  Called
+   * whenever the transforms in the buffer change. */
+  void check();
+
+  /** @brief Return the number of pending requests. */
+  size_t getNumPending() const;
+
+private:
+  typedef std::pair<std::string, std::string> GroupKey;  ///< Target and source frame
+
+  struct Request
+  {
+    Handle handle;
+    ros::Time stamp;
+    Callback callback;
+  };
+  /** Requests of one group by the time the transform has to be
+   * available at, the stamp plus the tolerance. */
+  typedef std::multimap<ros::Time, Request> M_Request;
+  typedef std::map<GroupKey, M_Request> M_Group;
+
+  /** @brief Return true and the latest time the frames of @a key can
+   * be transformed at, which is 0 for static transforms.  Return false
+   * if they can not be transformed at all yet. */
+  bool getLatestTime( const GroupKey& key, ros::Time& latest ) const;
+
+  tf2::BufferCore& buffer_;
+  tf2::TransformsChangedConnection transforms_changed_connection_;
+
+  mutable boost::mutex mutex_;
+  M_Group groups_;
+  std::map<Handle, std::pair<GroupKey, M_Request::iterator> > handles_;
+  Handle next_handle_;
+};
+
+} // namespace rviz
+
+#endif // RVIZ_TRANSFORM_SCHEDULER_H
@@ -0,0 +1,560 @@
+/*
+ * Copyright (c) 2012, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <deque>
+
+#include <QDir>
+#include <QFile>
+#include <QImage>
+#include <QTimer>
+#include <QtGlobal>
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <OgreRenderSystem.h>
+#include <OgreRenderWindow.h>
+#include <OgreRoot.h>
+
+#if !defined(Q_OS_MAC) && !defined(Q_OS_WIN)
+#define GL_GLEXT_PROTOTYPES
+#include <GL/gl.h>
+#include <GL/glext.h>
+#define RVIZ_VIDEO_RECORDER_PIXEL_BUFFERS
+#endif
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#endif
+
+#include "rviz/display_context.h"
+#include "rviz/render_panel.h"
+
+#include "rviz/video_recorder.h"
+
+namespace rviz
+{
+
+// Frames waiting to be written before new frames are dropped.
+static const size_t MAX_QUEUED_FRAMES = 16;
+
+/** @brief Writes recorded frames on its own thread. */
+class VideoWriter
+{
+public:
+  VideoWriter( VideoRecorder::Output output, const QString& target, int width, int height, int fps )
+    : output_( output )
+    , target_( target )
+    , width_( width )
+    , height_( height )
+    , fps_( fps )
+    , pipe_( NULL )
+    , next_index_( 0 )
+    , written_( 0 )
+    , dropped_( 0 )
+    , done_( false )
+  {}
+
+  ~VideoWriter()
+  {
+    finish();
+  }
+
+  /** @brief Open the output and start the thread.  Returns false and
+   * sets @a error if the output can not be opened. */
+  bool open( QString& error )
+  {
+    if( output_ == VideoRecorder::ImageSequence )
+    {
+      if( !QDir().mkpath( target_ ))
+      {
+        error = "Could not create directory " + target_;
+        return false;
+      }
+    }
+    else
+    {
+      QString command = target_;
+      command.replace( "%w", QString::number( width_ ));
+      command.replace( "%h", QString::number( height_ ));
+      command.replace( "%r", QString::number( fps_ ));
+      pipe_ = popen( command.toLocal8Bit().constData(), "w" );
+      if( !pipe_ )
+      {
+        error = "Could not run " + command;
+        return false;
+      }
+    }
+    thread_ = boost::thread( &VideoWriter::threadFunc, this );
+    return true;
+  }
+
+  /** @brief Queue a frame to be written @a repeat times.  Drops it if
+   * the queue is full. */
+  void add( const QImage& image, bool bottom_up, int repeat )
+  {
+    boost::mutex::scoped_lock lock( mutex_ );
+    if( queue_.size() >= MAX_QUEUED_FRAMES || !error_.isEmpty() )
+    {
+      dropped_ += repeat;
+      return;
+    }
+    Frame frame;
+    frame.image = image;
+    frame.bottom_up = bottom_up;
+    frame.repeat = repeat;
+    queue_.push_back( frame );
+    cond_.notify_one();
+  }
+
+  /** @brief Write the queued frames, then stop the thread and close the output. */
+  void finish()
+  {
+    {
+      boost::mutex::scoped_lock lock( mutex_ );
+      done_ = true;
+      cond_.notify_one();
+    }
+    if( thread_.joinable() )
+    {
+      thread_.join();
+    }
+    if( pipe_ )
+    {
+      pclose( pipe_ );
+      pipe_ = NULL;
+    }
+  }
+
+  int getWritten() const { boost::mutex::scoped_lock lock( mutex_ ); return written_; }
+  int getDropped() const { boost::mutex::scoped_lock lock( mutex_ ); return dropped_; }
+  QString getError() const { boost::mutex::scoped_lock lock( mutex_ ); return error_; }
+
+private:
+  struct Frame
+  {
+    QImage image;
+    bool bottom_up;
+    int repeat;
+  };
+
+  void threadFunc()
+  {
+    while( true )
+    {
+      Frame frame;
+      {
+        boost::mutex::scoped_lock lock( mutex_ );
+        while( queue_.empty() && !done_ )
+        {
+          cond_.wait( lock );
+        }
+        if( queue_.empty() )
+        {
+          return;
+        }
+        frame = queue_.front();
+        queue_.pop_front();
+      }
+
+      QString error = write( frame );
+
+      boost::mutex::scoped_lock lock( mutex_ );
+      if( error.isEmpty() )
+      {
+        written_ += frame.repeat;
+      }
+      else
+      {
+        error_ = error;
+        dropped_ += frame.repeat;
+        for( size_t i = 0; i < queue_.size(); i++ )
+        {
+          dropped_ += queue_[ i ].repeat;
+        }
+        queue_.clear();
+        return;
+      }
+    }
+  }
+
+  /** @brief Write one frame, return an error message on failure. */
+  QString write( const Frame& frame )
+  {
+    QImage image = frame.bottom_up ? frame.image.mirrored() : frame.image;
+
+    if( output_ == VideoRecorder::ImageSequence )
+    {
+      QString first_file;
+      for( int i = 0; i < frame.repeat; i++ )
+      {
+        QString file = QDir( target_ ).filePath( QString( "frame_%1.png" ).arg( next_index_++, 6, 10, QChar( '0' )));
+        // Write repeated frames once and copy the file.
+        bool ok = first_file.isEmpty() ? image.save( file, "PNG" ) : QFile::copy( first_file, file );
+        if( !ok )
+        {
+          return "Failed to write " + file;
+        }
+        if( first_file.isEmpty() )
+        {
+          first_file = file;
+        }
+      }
+      return QString();
+    }
+
+    // The encoder expects every frame at the size it was started with.
+    if( image.width() != width_ || image.height() != height_ )
+    {
+      image = image.scaled( width_, height_, Qt::IgnoreAspectRatio, Qt::SmoothTransformation );
+    }
+    image = image.convertToFormat( QImage::Format_RGB888 );
+    for( int i = 0; i < frame.repeat; i++ )
+    {
+      for( int y = 0; y < height_; y++ )
+      {
+        if( fwrite( image.constScanLine( y ), 3, width_, pipe_ ) != (size_t)width_ )
+        {
+          return "Failed to write frame to the encoder";
+        }
+      }
+    }
+    return QString();
+  }
+
+  VideoRecorder::Output output_;
+  QString target_;
+  int width_;
+  int height_;
+  int fps_;
+  FILE* pipe_;
+  int next_index_;
+
+  mutable boost::mutex mutex_;
+  boost::condition_variable cond_;
+  std::deque<Frame> queue_;
+  int written_;
+  int dropped_;
+  bool done_;
+  QString error_;
+  boost::thread thread_;
+};
+
+#ifdef RVIZ_VIDEO_RECORDER_PIXEL_BUFFERS
+/** @brief Deletes pixel buffers after the next render of a window,
+ * while its GL context is current, then deletes itself.  If the window
+ * goes away first, the buffers go with its context. */
+class PixelBufferReleaser: public Ogre::RenderTargetListener
+{
+public:
+  PixelBufferReleaser( Ogre::RenderWindow* window, const unsigned int* buffers )
+    : window_( window )
+  {
+    buffers_[ 0 ] = buffers[ 0 ];
+    buffers_[ 1 ] = buffers[ 1 ];
+    window_->addListener( this );
+  }
+
+  virtual void postRenderTargetUpdate( const Ogre::RenderTargetEvent& )
+  {
+    glDeleteBuffers( 2, buffers_ );
+    window_->removeListener( this );
+    delete this;
+  }
+
+private:
+  Ogre::RenderWindow* window_;
+  GLuint buffers_[2];
+};
+#endif
+
+VideoRecorder::VideoRecorder( RenderPanel* render_panel, DisplayContext* context, QObject* parent )
+  : QObject( parent )
+  , render_panel_( render_panel )
+  , context_( context )
+  , render_window_( NULL )
+  , tick_timer_( new QTimer( this ))
+  , writer_( NULL )
+  , recording_( false )
+  , stopping_( false )
+  , fps_( 30 )
+  , frames_recorded_( 0 )
+  , frames_written_( 0 )
+  , frames_dropped_( 0 )
+  , use_pixel_buffers_( false )
+  , buffer_index_( 0 )
+{
+  for( int i = 0; i < 2; i++ )
+  {
+    pixel_buffers_[ i ] = 0;
+    pending_repeat_[ i ] = 0;
+    pending_width_[ i ] = 0;
+    pending_height_[ i ] = 0;
+  }
+  connect( tick_timer_, SIGNAL( timeout() ), this, SLOT( onTick() ));
+}
+
+VideoRecorder::~VideoRecorder()
+{
+  if( recording_ )
+  {
+    // No GL context is current outside of rendering, so the frame
+    // still in flight is lost and the pixel buffers are deleted after
+    // the next render.
+    finish( false );
+  }
+}
+
+bool VideoRecorder::start( Output output, const QString& target, int fps )
+{
+  if( recording_ )
+  {
+    return false;
+  }
+
+  error_.clear();
+  render_window_ = render_panel_->getRenderWindow();
+  if( !render_window_ )
+  {
+    error_ = "The render window does not exist.";
+    return false;
+  }
+
+  fps_ = std::max( fps, 1 );
+  writer_ = new VideoWriter( output, target, render_window_->getWidth(), render_window_->getHeight(), fps_ );
+  if( !writer_->open( error_ ))
+  {
+    delete writer_;
+    writer_ = NULL;
+    return false;
+  }
+
+#ifdef RVIZ_VIDEO_RECORDER_PIXEL_BUFFERS
+  use_pixel_buffers_ = Ogre::Root::getSingleton().getRenderSystem()->getName().find( "OpenGL" ) != std::string::npos;
+#else
+  use_pixel_buffers_ = false;
+#endif
+  buffer_index_ = 0;
+  pending_repeat_[ 0 ] = pending_repeat_[ 1 ] = 0;
+
+  start_time_ = ros::WallTime::now();
+  frames_recorded_ = 0;
+  frames_written_ = 0;
+  frames_dropped_ = 0;
+  stopping_ = false;
+  recording_ = true;
+
+  render_window_->addListener( this );
+  tick_timer_->start( 1000 / fps_ );
+  context_->queueRender();
+  return true;
+}
+
+void VideoRecorder::stop()
+{
+  if( recording_ && !stopping_ )
+  {
+    // Finish with the next render, when the GL context is current.
+    stopping_ = true;
+    context_->queueRender();
+  }
+}
+
+int VideoRecorder::getFramesDropped() const
+{
+  return writer_ ? writer_->getDropped() : frames_dropped_;
+}
+
+int VideoRecorder::getFramesWritten() const
+{
+  return writer_ ? writer_->getWritten() : frames_written_;
+}
+
+void VideoRecorder::onTick()
+{
+  if( writer_ && !writer_->getError().isEmpty() )
+  {
+    error_ = writer_->getError();
+    stop();
+  }
+  // Render at the recording rate even when nothing changed.
+  context_->queueRender();
+}
+
+void VideoRecorder::postRenderTargetUpdate( const Ogre::RenderTargetEvent& event )
+{
+  if( !recording_ || event.source != render_window_ )
+  {
+    return;
+  }
+
+  if( stopping_ )
+  {
+    // Hand over the frame read last.
+    flush( 1 - buffer_index_ );
+    finish( true );
+    return;
+  }
+
+  // Number of frames the recording should have by now.  More than one
+  // new frame means rendering fell behind, so the frame is repeated.
+  int frames_due = (int)(( ros::WallTime::now() - start_time_ ).toSec() * fps_ ) + 1;
+  if( frames_due > frames_recorded_ )
+  {
+    int repeat = frames_due - frames_recorded_;
+    frames_recorded_ = frames_due;
+    capture( repeat );
+  }
+}
+
+void VideoRecorder::capture( int repeat )
+{
+  int width = render_window_->getWidth();
+  int height = render_window_->getHeight();
+
+#ifdef RVIZ_VIDEO_RECORDER_PIXEL_BUFFERS
+  if( use_pixel_buffers_ )
+  {
+    createPixelBuffers();
+
+    // Start an asynchronous read of this frame into the free buffer.
+    int index = buffer_index_;
+    glBindBuffer( GL_PIXEL_PACK_BUFFER, pixel_buffers_[ index ] );
+    if( width != pending_width_[ index ] || height != pending_height_[ index ] )
+    {
+      glBufferData( GL_PIXEL_PACK_BUFFER, width * height * 4, NULL, GL_STREAM_READ );
+      pending_width_[ index ] = width;
+      pending_height_[ index ] = height;
+    }
+    glReadBuffer( GL_BACK );
+    glReadPixels( 0, 0, width, height, GL_BGRA, GL_UNSIGNED_BYTE, 0 );
+    glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+    pending_repeat_[ index ] = repeat;
+
+    // The read of the frame before this one has had a whole frame to
+    // finish, so mapping its buffer does not stall.
+    buffer_index_ = 1 - index;
+    flush( buffer_index_ );
+    return;
+  }
+#endif
+
+  QImage image( width, height, QImage::Format_RGB32 );
+  Ogre::PixelBox box( width, height, 1, Ogre::PF_BYTE_BGRA, image.bits() );
+  render_window_->copyContentsToMemory( box );
+  writer_->add( image, false, repeat );
+}
+
+void VideoRecorder::flush( int index )
+{
+#ifdef RVIZ_VIDEO_RECORDER_PIXEL_BUFFERS
+  if( !use_pixel_buffers_ || pending_repeat_[ index ] == 0 )
+  {
+    return;
+  }
+
+  int width = pending_width_[ index ];
+  int height = pending_height_[ index ];
+  glBindBuffer( GL_PIXEL_PACK_BUFFER, pixel_buffers_[ index ] );
+  const void* data = glMapBuffer( GL_PIXEL_PACK_BUFFER, GL_READ_ONLY );
+  if( data )
+  {
+    QImage image( width, height, QImage::Format_RGB32 );
+    memcpy( image.bits(), data, width * height * 4 );
+    glUnmapBuffer( GL_PIXEL_PACK_BUFFER );
+    writer_->add( image, true, pending_repeat_[ index ] );
+  }
+  glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+  pending_repeat_[ index ] = 0;
+#else
+  (void) index;
+#endif
+}
+
+void VideoRecorder::finish( bool gl_context_current )
+{
+  tick_timer_->stop();
+  render_window_->removeListener( this );
+  destroyPixelBuffers( gl_context_current );
+
+  writer_->finish();
+  frames_written_ = writer_->getWritten();
+  frames_dropped_ = writer_->getDropped();
+  if( error_.isEmpty() )
+  {
+    error_ = writer_->getError();
+  }
+  delete writer_;
+  writer_ = NULL;
+
+  recording_ = false;
+  stopping_ = false;
+  Q_EMIT recordingStopped( error_ );
+}
+
+void VideoRecorder::createPixelBuffers()
+{
+#ifdef RVIZ_VIDEO_RECORDER_PIXEL_BUFFERS
+  if( pixel_buffers_[ 0 ] == 0 )
+  {
+    glGenBuffers( 2, pixel_buffers_ );
+    pending_width_[ 0 ] = pending_width_[ 1 ] = 0;
+    pending_height_[ 0 ] = pending_height_[ 1 ] = 0;
+  }
+#endif
+}
+
+void VideoRecorder::destroyPixelBuffers( bool gl_context_current )
+{
+#ifdef RVIZ_VIDEO_RECORDER_PIXEL_BUFFERS
+  if( pixel_buffers_[ 0 ] != 0 )
+  {
+    if( gl_context_current )
+    {
+      glDeleteBuffers( 2, pixel_buffers_ );
+    }
+    else
+    {
+      new PixelBufferReleaser( render_window_, pixel_buffers_ );
+    }
+    pixel_buffers_[ 0 ] = pixel_buffers_[ 1 ] = 0;
+  }
+  pending_repeat_[ 0 ] = pending_repeat_[ 1 ] = 0;
+#else
+  (void) gl_context_current;
+#endif
+}
+
+} // end namespace rviz
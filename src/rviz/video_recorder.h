@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2012, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RVIZ_VIDEO_RECORDER_H
+#define RVIZ_VIDEO_RECORDER_H
+
+#include <QObject>
+#include <QString>
+
+#ifndef Q_MOC_RUN
+#include <OgreRenderTargetListener.h>
+
+#include <ros/time.h>
+#endif
+
+class QTimer;
+
+namespace Ogre
+{
+class RenderWindow;
+}
+
+namespace rviz
+{
+
+class DisplayContext;
+class RenderPanel;
+class VideoWriter;
+
+/** @brief Records the frames of a RenderPanel at a fixed rate.
+ *
+ * Frames are read back right after Ogre rendered them.  With OpenGL
+ * the readback goes through two pixel buffer objects: each frame is
+ * read into one buffer while the frame before it is copied out of the
+ * other, so the GUI thread never waits for the GPU.  Other render
+ * systems fall back to a synchronous copy.
+ *
+ * Frames are encoded and written by a VideoWriter on its own thread,
+ * either as a numbered PNG sequence or as raw RGB frames written to
+ * the standard input of an encoder command.  If the writer falls
+ * behind, frames are dropped rather than slowing down rendering.
+ *
+ * To keep the output at a constant rate, a frame is repeated when
+ * rendering did not keep up with the recording rate. */
+class VideoRecorder: public QObject, public Ogre::RenderTargetListener
+{
+Q_OBJECT
+public:
+  enum Output
+  {
+    ImageSequence,  ///< PNG files in a directory
+    Pipe            ///< Raw rgb24 frames to the standard input of a command
+  };
+
+  VideoRecorder( RenderPanel* render_panel, DisplayContext* context, QObject* parent = 0 );
+  virtual ~VideoRecorder();
+
+  /** @brief Start recording.
+   * @param output How to write frames.
+   * @param target The directory for ImageSequence, the command for
+   *        Pipe.  In a command, %w, %h and %r are replaced by the frame
+   *        width, height and rate.
+   * @param fps Frames per second of the recording.
+   * @return false if the output could not be opened; see getError(). */
+  bool start( Output output, const QString& target, int fps );
+
+  /** @brief Stop recording.  The last frame still in flight is written
+   * with the next render, then recordingStopped() is emitted. */
+  void stop();
+
+  bool isRecording() const { return recording_; }
+
+  /** @brief Frames handed to the writer so far, including repeats. */
+  int getFramesRecorded() const { return frames_recorded_; }
+
+  /** @brief Frames dropped because the writer was busy. */
+  int getFramesDropped() const;
+
+  /** @brief Frames written so far. */
+  int getFramesWritten() const;
+
+  /** @brief The last error, or an empty string. */
+  QString getError() const { return error_; }
+
+  /** @brief Overridden from Ogre::RenderTargetListener. */
+  virtual void postRenderTargetUpdate( const Ogre::RenderTargetEvent& event );
+
+Q_SIGNALS:
+  /** @brief Emitted when recording stopped, with an error message if
+   * it stopped because of an error. */
+  void recordingStopped( const QString& error );
+
+private Q_SLOTS:
+  /** @brief Request renders at the recording rate and watch for writer errors. */
+  void onTick();
+
+private:
+  /** @brief Start reading the current frame, hand the frame read
+   * before it to the writer. */
+  void capture( int repeat );
+
+  /** @brief Hand the frame being read into pixel buffer @a index to
+   * the writer, if any. */
+  void flush( int index );
+
+  /** @brief Stop recording and close the writer.
+   * @param gl_context_current False if the GL context of the render
+   * window may not be current, so GL calls are left to the next render. */
+  void finish( bool gl_context_current );
+  void createPixelBuffers();
+  /** @brief Delete the pixel buffers, right away or, if
+   * @a gl_context_current is false, after the next render. */
+  void destroyPixelBuffers( bool gl_context_current );
+
+  RenderPanel* render_panel_;
+  DisplayContext* context_;
+  Ogre::RenderWindow* render_window_;
+  QTimer* tick_timer_;
+  VideoWriter* writer_;
+
+  bool recording_;
+  bool stopping_;
+  int fps_;
+  ros::WallTime start_time_;
+  int frames_recorded_;
+  int frames_written_;                    ///< Writer totals, kept after the writer is gone
+  int frames_dropped_;
+  QString error_;
+
+  // Double-buffered readback.  pending_repeat_[i] is the repeat count
+  // of the frame being read into pixel_buffers_[i], 0 if none.
+  bool use_pixel_buffers_;
+  unsigned int pixel_buffers_[2];
+  int pending_repeat_[2];
+  int pending_width_[2];
+  int pending_height_[2];
+  int buffer_index_;
+};
+
+} // end namespace rviz
+
+#endif // RVIZ_VIDEO_RECORDER_H
@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2012, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <QCloseEvent>
+#include <QComboBox>
+#include <QDateTime>
+#include <QDir>
+#include <QFormLayout>
+#include <QLabel>
+#include <QLineEdit>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QTimer>
+#include <QVBoxLayout>
+
+#include "rviz/video_recorder.h"
+
+#include "rviz/video_recorder_dialog.h"
+
+namespace rviz
+{
+
+VideoRecorderDialog::VideoRecorderDialog( RenderPanel* render_panel, DisplayContext* context, const QString& default_save_dir )
+  : QWidget( NULL ) // This should be a top-level window to act like a dialog.
+  , recorder_( new VideoRecorder( render_panel, context, this ))
+  , status_timer_( new QTimer( this ))
+  , default_save_dir_( default_save_dir.isEmpty() ? QDir::homePath() : default_save_dir )
+{
+  setWindowTitle( "Record Video" );
+
+  output_combo_ = new QComboBox;
+  output_combo_->addItem( "PNG image sequence" );
+  output_combo_->addItem( "Raw frames to command" );
+
+  target_label_ = new QLabel;
+  target_edit_ = new QLineEdit;
+  target_edit_->setMinimumWidth( 400 );
+
+  fps_spin_ = new QSpinBox;
+  fps_spin_->setRange( 1, 120 );
+  fps_spin_->setValue( 30 );
+
+  start_button_ = new QPushButton( "Start" );
+  status_label_ = new QLabel;
+
+  QFormLayout* form = new QFormLayout;
+  form->addRow( "Output:", output_combo_ );
+  form->addRow( target_label_, target_edit_ );
+  form->addRow( "Frame rate:", fps_spin_ );
+
+  QVBoxLayout* main_layout = new QVBoxLayout;
+  main_layout->addLayout( form );
+  main_layout->addWidget( new QLabel( "In a command, %w, %h and %r are replaced by the width, height and frame rate." ));
+  main_layout->addWidget( status_label_ );
+  main_layout->addWidget( start_button_ );
+  setLayout( main_layout );
+
+  onOutputChanged( 0 );
+
+  connect( output_combo_, SIGNAL( currentIndexChanged( int )), this, SLOT( onOutputChanged( int )));
+  connect( start_button_, SIGNAL( clicked() ), this, SLOT( onStartStop() ));
+  connect( recorder_, SIGNAL( recordingStopped( const QString& )), this, SLOT( onRecordingStopped( const QString& )));
+  connect( status_timer_, SIGNAL( timeout() ), this, SLOT( updateStatus() ));
+}
+
+void VideoRecorderDialog::onOutputChanged( int index )
+{
+  QString stamp = QDateTime::currentDateTime().toString( "yyyy_MM_dd-hh_mm_ss" );
+  if( index == VideoRecorder::ImageSequence )
+  {
+    target_label_->setText( "Directory:" );
+    target_edit_->setText( QDir( default_save_dir_ ).filePath( "rviz_recording_" + stamp ));
+  }
+  else
+  {
+    target_label_->setText( "Command:" );
+    target_edit_->setText( "ffmpeg -f rawvideo -pix_fmt rgb24 -s %wx%h -r %r -i - -pix_fmt yuv420p " +
+                           QDir( default_save_dir_ ).filePath( "rviz_recording_" + stamp + ".mp4" ));
+  }
+}
+
+void VideoRecorderDialog::onStartStop()
+{
+  if( recorder_->isRecording() )
+  {
+    start_button_->setEnabled( false );
+    recorder_->stop();
+    return;
+  }
+
+  if( !recorder_->start( (VideoRecorder::Output) output_combo_->currentIndex(), target_edit_->text(), fps_spin_->value() ))
+  {
+    QMessageBox::critical( this, "Error", recorder_->getError() );
+    return;
+  }
+  setRecording( true );
+}
+
+void VideoRecorderDialog::onRecordingStopped( const QString& error )
+{
+  setRecording( false );
+  if( !error.isEmpty() )
+  {
+    QMessageBox::critical( this, "Error", error );
+  }
+}
+
+void VideoRecorderDialog::updateStatus()
+{
+  status_label_->setText( QString( "%1 frames recorded, %2 written, %3 dropped." )
+                          .arg( recorder_->getFramesRecorded() )
+                          .arg( recorder_->getFramesWritten() )
+                          .arg( recorder_->getFramesDropped() ));
+}
+
+void VideoRecorderDialog::setRecording( bool recording )
+{
+  output_combo_->setEnabled( !recording );
+  target_edit_->setEnabled( !recording );
+  fps_spin_->setEnabled( !recording );
+  start_button_->setEnabled( true );
+  start_button_->setText( recording ? "Stop" : "Start" );
+  if( recording )
+  {
+    status_timer_->start( 500 );
+  }
+  else
+  {
+    status_timer_->stop();
+  }
+  updateStatus();
+}
+
+void VideoRecorderDialog::closeEvent( QCloseEvent* event )
+{
+  recorder_->stop();
+  QWidget::closeEvent( event );
+}
+
+} // end namespace rviz
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2012, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RVIZ_VIDEO_RECORDER_DIALOG_H
+#define RVIZ_VIDEO_RECORDER_DIALOG_H
+
+#include <QWidget>
+
+class QComboBox;
+class QLabel;
+class QLineEdit;
+class QPushButton;
+class QSpinBox;
+class QTimer;
+
+namespace rviz
+{
+
+class DisplayContext;
+class RenderPanel;
+class VideoRecorder;
+
+/** @brief A dialog for recording the 3D view with a VideoRecorder. */
+class VideoRecorderDialog: public QWidget
+{
+Q_OBJECT
+public:
+  VideoRecorderDialog( RenderPanel* render_panel, DisplayContext* context, const QString& default_save_dir = QString() );
+  virtual ~VideoRecorderDialog() {}
+
+protected Q_SLOTS:
+  void onOutputChanged( int index );
+  void onStartStop();
+  void onRecordingStopped( const QString& error );
+  void updateStatus();
+
+protected:
+  virtual void closeEvent( QCloseEvent* event );
+
+private:
+  /** @brief Enable the settings while not recording. */
+  void setRecording( bool recording );
+
+  VideoRecorder* recorder_;
+  QComboBox* output_combo_;
+  QLabel* target_label_;
+  QLineEdit* target_edit_;
+  QSpinBox* fps_spin_;
+  QPushButton* start_button_;
+  QLabel* status_label_;
+  QTimer* status_timer_;
+  QString default_save_dir_;
+};
+
+} // namespace rviz
+
+#endif // RVIZ_VIDEO_RECORDER_DIALOG_H
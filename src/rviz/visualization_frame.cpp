@@ -27,15 +27,18 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <algorithm>
 #include <fstream>
 
 #include <QAction>
 #include <QShortcut>
 #include <QApplication>
 #include <QCloseEvent>
+#include <QCryptographicHash>
 #include <QDesktopServices>
 #include <QDockWidget>
 #include <QDir>
+#include <QFile>
 #include <QFileDialog>
 #include <QMenu>
 #include <QMenuBar>
@@ -54,6 +57,7 @@
 #include <boost/algorithm/string/trim.hpp>
 #include <boost/bind.hpp>
 #include <boost/filesystem.hpp>
+#include <boost/thread/thread.hpp>
 
 #include <ros/console.h>
 #include <ros/package.h>
@@ -64,18 +68,22 @@
 
 #include <ogre_helpers/initialization.h>
 
+#include "rviz/binary_config.h"
 #include "rviz/displays_panel.h"
 #include "rviz/env_config.h"
 #include "rviz/failed_panel.h"
 #include "rviz/help_panel.h"
 #include "rviz/loading_dialog.h"
+#include "rviz/memory_budget.h"
 #include "rviz/new_object_dialog.h"
 #include "rviz/preferences.h"
 #include "rviz/preferences_dialog.h"
 #include "rviz/panel_dock_widget.h"
 #include "rviz/panel_factory.h"
 #include "rviz/render_panel.h"
+#include "rviz/plugin_index.h"
 #include "rviz/screenshot_dialog.h"
+#include "rviz/video_recorder_dialog.h"
 #include "rviz/selection/selection_manager.h"
 #include "rviz/selection_panel.h"
 #include "rviz/splash_screen.h"
@@ -83,6 +91,7 @@
 #include "rviz/tool.h"
 #include "rviz/tool_manager.h"
 #include "rviz/tool_properties_panel.h"
+#include "rviz/topic_cache.h"
 #include "rviz/views_panel.h"
 #include "rviz/visualization_manager.h"
 #include "rviz/widget_geometry_change_detector.h"
@@ -96,6 +105,8 @@ namespace fs = boost::filesystem;
 
 #define CONFIG_EXTENSION "rviz"
 #define CONFIG_EXTENSION_WILDCARD "*." CONFIG_EXTENSION
+#define BINARY_CONFIG_EXTENSION "rvizb"
+#define CONFIG_FILE_FILTER "RViz config files (" CONFIG_EXTENSION_WILDCARD " *." BINARY_CONFIG_EXTENSION ")"
 #define RECENT_CONFIG_COUNT 10
 
 #if BOOST_FILESYSTEM_VERSION == 3
@@ -109,6 +120,108 @@ namespace fs = boost::filesystem;
 namespace rviz
 {
 
+/** @brief Return the binary cache file for the YAML config @a path
+ * with the text @a content.
+ *
+ * The name includes a hash of the text, so an edited config file
+ * never uses an old cache, however soon after loading it changed. */
+static std::string getConfigCacheFile( const std::string& cache_dir, const std::string& path, const QByteArray& content )
+{
+  QString absolute_path = QString::fromStdString( fs::system_complete( path ).BOOST_FILE_STRING() );
+  QByteArray digest = QCryptographicHash::hash( content, QCryptographicHash::Sha1 ).toHex();
+  QString name = QString( "%1_%2." BINARY_CONFIG_EXTENSION )
+    .arg( qHash( absolute_path ), 8, 16, QChar( '0' ))
+    .arg( QString::fromLatin1( digest ));
+  return ( fs::path( cache_dir ) / name.toStdString() ).BOOST_FILE_STRING();
+}
+
+/** @brief Read all of @a path into @a content.  Returns false if it can not be opened. */
+static bool readFileContent( const std::string& path, QByteArray* content )
+{
+  QFile file( QString::fromStdString( path ));
+  if( !file.open( QIODevice::ReadOnly ))
+  {
+    return false;
+  }
+  *content = file.readAll();
+  return true;
+}
+
+/** @brief Write the binary cache @a cache_file for @a config, and
+ * remove the caches of older versions of the same config file. */
+static void writeConfigCache( const Config& config, const std::string& cache_file )
+{
+  fs::path cache_path( cache_file );
+  boost::system::error_code error;
+  fs::create_directories( cache_path.parent_path(), error );
+
+  std::string name = cache_path.BOOST_FILENAME_STRING();
+  std::string prefix = name.substr( 0, name.find( '_' ) + 1 );
+  for( fs::directory_iterator it( cache_path.parent_path(), error ), end; !error && it != end; it.increment( error ))
+  {
+    std::string other = it->path().BOOST_FILENAME_STRING();
+    if( other != name && other.compare( 0, prefix.size(), prefix ) == 0 )
+    {
+      fs::remove( it->path(), error );
+    }
+  }
+
+  BinaryConfigWriter writer;
+  writer.writeFile( config, QString::fromStdString( cache_file ));
+  if( writer.error() )
+  {
+    ROS_DEBUG( "%s", qPrintable( writer.errorMessage() ));
+  }
+}
+
+/** @brief Read a YAML or binary config file.  For YAML files, use the
+ * binary cache in @a cache_dir if there is one for the same text,
+ * otherwise write it. */
+static void readConfigFile( Config* config, const std::string& path, const std::string& cache_dir,
+                            QString* error_message )
+{
+  QString filename = QString::fromStdString( path );
+  if( BinaryConfigReader::isBinaryConfigFile( filename ))
+  {
+    BinaryConfigReader reader;
+    reader.readFile( *config, filename );
+    *error_message = reader.errorMessage();
+    return;
+  }
+
+  // Hash and parse the same bytes, so the cache always matches the text it came from.
+  QByteArray content;
+  if( !readFileContent( path, &content ))
+  {
+    YamlConfigReader reader;
+    reader.readFile( *config, filename );
+    *error_message = reader.errorMessage();
+    return;
+  }
+  std::string cache_file = getConfigCacheFile( cache_dir, path, content );
+
+  if( fs::exists( cache_file ))
+  {
+    BinaryConfigReader reader;
+    Config cached;
+    reader.readFile( cached, QString::fromStdString( cache_file ));
+    if( !reader.error() )
+    {
+      *config = cached;
+      error_message->clear();
+      return;
+    }
+  }
+
+  YamlConfigReader reader;
+  reader.readString( *config, QString::fromUtf8( content ), filename );
+  *error_message = reader.errorMessage();
+  if( !reader.error() )
+  {
+    writeConfigCache( *config, cache_file );
+  }
+}
+
 VisualizationFrame::VisualizationFrame( QWidget* parent )
   : QMainWindow( parent )
   , app_(NULL)
@@ -119,6 +232,7 @@ VisualizationFrame::VisualizationFrame( QWidget* parent )
   , recent_configs_menu_(NULL)
   , toolbar_(NULL)
   , manager_(NULL)
+  , video_recorder_dialog_(NULL)
   , splash_( NULL )
   , toolbar_actions_( NULL )
   , show_choose_new_master_option_( false )
@@ -164,6 +278,8 @@ VisualizationFrame::VisualizationFrame( QWidget* parent )
 
 VisualizationFrame::~VisualizationFrame()
 {
+  // The recorder reads from the render panel.
+  delete video_recorder_dialog_;
   delete render_panel_;
   delete manager_;
 
@@ -253,6 +369,14 @@ void VisualizationFrame::initialize(const QString& display_config_file )
 {
   initConfigs();
 
+  // Find plugins while the window and render system are set up.
+  PluginIndex::instance()->setCacheDirectory( config_dir_ );
+  PluginIndex::instance()->discoverInBackground( "rviz" );
+  PluginIndex::instance()->discoverInBackground( "image_transport" );
+
+  // Keep the list of topics for dialogs and topic properties up to date.
+  TopicCache::instance()->start();
+
   loadPersistentSettings();
 
   QIcon app_icon( QString::fromStdString( (fs::path(package_path_) / "icons/package.png").BOOST_FILE_STRING() ) );
@@ -384,6 +508,7 @@ void VisualizationFrame::initConfigs()
 
   config_dir_ = (fs::path(home_dir_) / ".rviz").BOOST_FILE_STRING();
   persistent_settings_file_ = (fs::path(config_dir_) / "persistent_settings").BOOST_FILE_STRING();
+  config_cache_dir_ = (fs::path(config_dir_) / "config_cache").BOOST_FILE_STRING();
   default_display_config_file_ = (fs::path(config_dir_) / "default." CONFIG_EXTENSION).BOOST_FILE_STRING();
 
   if( fs::is_regular_file( config_dir_ ))
@@ -462,6 +587,7 @@ void VisualizationFrame::initMenus()
 
   recent_configs_menu_ = file_menu_->addMenu( "&Recent Configs" );
   file_menu_->addAction( "Save &Image", this, SLOT( onSaveImage() ));
+  file_menu_->addAction( "Record &Video", this, SLOT( onRecordVideo() ));
   if( show_choose_new_master_option_ )
   {
     file_menu_->addSeparator();
@@ -622,6 +748,7 @@ void VisualizationFrame::openPreferencesDialog()
   if( dialog->exec() == QDialog::Accepted ) {
     // Apply preferences.
     preferences_ = boost::make_shared<Preferences>( temp_preferences );
+    applyPreferences();
   }
   manager_->startUpdate();
 }
@@ -740,6 +867,7 @@ void VisualizationFrame::loadDisplayConfig( const QString& qpath )
 
   setWindowModified( false );
   loading_ = true;
+  load_start_time_ = ros::WallTime::now();
 
   LoadingDialog* dialog = NULL;
   if( initialized_ )
@@ -749,13 +877,25 @@ void VisualizationFrame::loadDisplayConfig( const QString& qpath )
     connect( this, SIGNAL( statusUpdate( const QString& )), dialog, SLOT( showMessage( const QString& )));
   }
 
-  YamlConfigReader reader;
+  // Parse on a separate thread, so the window keeps repainting while
+  // a large config file is read.
   Config config;
-  reader.readFile( config, QString::fromStdString( actual_load_path ));
-  if( !reader.error() )
+  QString error_message;
+  boost::thread read_thread( boost::bind( &readConfigFile, &config, actual_load_path,
+                                          config_cache_dir_,
+                                          &error_message ));
+  while( !read_thread.timed_join( boost::posix_time::milliseconds( 20 )))
+  {
+    QCoreApplication::processEvents( QEventLoop::ExcludeUserInputEvents );
+  }
+  if( error_message.isEmpty() )
   {
     load( config );
   }
+  else
+  {
+    ROS_ERROR( "%s", qPrintable( error_message ));
+  }
 
   markRecentConfig( path );
 
@@ -770,7 +910,16 @@ void VisualizationFrame::loadDisplayConfig( const QString& qpath )
 
 void VisualizationFrame::markLoadingDone()
 {
+  // Displays are loaded a few per frame after load() returns, and
+  // property changes made while doing so must not mark the config
+  // as modified.
+  if( manager_ && manager_->isLoading() )
+  {
+    post_load_timer_->start( 200 );
+    return;
+  }
   loading_ = false;
+  ROS_INFO( "Loaded display config in %.2f s", ( ros::WallTime::now() - load_start_time_ ).toSec() );
 }
 
 void VisualizationFrame::setImageSaveDirectory( const QString& directory )
@@ -810,13 +959,33 @@ bool VisualizationFrame::saveDisplayConfig( const QString& path )
   Config config;
   save( config );
 
-  YamlConfigWriter writer;
-  writer.writeFile( config, path );
+  QString write_error;
+  if( fs::path( path.toStdString() ).extension() == "." BINARY_CONFIG_EXTENSION )
+  {
+    BinaryConfigWriter writer;
+    writer.writeFile( config, path );
+    write_error = writer.errorMessage();
+  }
+  else
+  {
+    YamlConfigWriter writer;
+    writer.writeFile( config, path );
+    write_error = writer.errorMessage();
+    if( !writer.error() )
+    {
+      // Reloading this config reads the binary copy.
+      QByteArray content;
+      if( readFileContent( path.toStdString(), &content ))
+      {
+        writeConfigCache( config, getConfigCacheFile( config_cache_dir_, path.toStdString(), content ));
+      }
+    }
+  }
 
-  if( writer.error() )
+  if( !write_error.isEmpty() )
   {
-    ROS_ERROR( "%s", qPrintable( writer.errorMessage() ));
-    error_message_ = writer.errorMessage();
+    ROS_ERROR( "%s", qPrintable( write_error ));
+    error_message_ = write_error;
     return false;
   }
   else
@@ -977,11 +1146,23 @@ void VisualizationFrame::savePanels( Config config )
 void VisualizationFrame::loadPreferences( const Config& config )
 {
   config.mapGetBool( "PromptSaveOnExit", &(preferences_->prompt_save_on_exit) );
+  config.mapGetInt( "MemoryBudgetMB", &(preferences_->memory_budget_mb) );
+  config.mapGetInt( "DisplayMemoryCapMB", &(preferences_->display_memory_cap_mb) );
+  applyPreferences();
 }
 
 void VisualizationFrame::savePreferences( Config config )
 {
   config.mapSetValue( "PromptSaveOnExit", preferences_->prompt_save_on_exit );
+  config.mapSetValue( "MemoryBudgetMB", preferences_->memory_budget_mb );
+  config.mapSetValue( "DisplayMemoryCapMB", preferences_->display_memory_cap_mb );
+}
+
+void VisualizationFrame::applyPreferences()
+{
+  MemoryBudget* memory_budget = manager_->getMemoryBudget();
+  memory_budget->setBudget( (uint64_t) std::max( preferences_->memory_budget_mb, 0 ) * 1024 * 1024 );
+  memory_budget->setDisplayCap( (uint64_t) std::max( preferences_->display_memory_cap_mb, 0 ) * 1024 * 1024 );
 }
 
 bool VisualizationFrame::prepareToExit()
@@ -1048,7 +1229,7 @@ void VisualizationFrame::onOpen()
   manager_->stopUpdate();
   QString filename = QFileDialog::getOpenFileName( this, "Choose a file to open",
                                                    QString::fromStdString( last_config_dir_ ),
-                                                   "RViz config files (" CONFIG_EXTENSION_WILDCARD ")" );
+                                                   CONFIG_FILE_FILTER );
   manager_->startUpdate();
 
   if( !filename.isEmpty() )
@@ -1097,14 +1278,14 @@ void VisualizationFrame::onSaveAs()
   manager_->stopUpdate();
   QString q_filename = QFileDialog::getSaveFileName( this, "Choose a file to save to",
                                                      QString::fromStdString( last_config_dir_ ),
-                                                     "RViz config files (" CONFIG_EXTENSION_WILDCARD ")" );
+                                                     CONFIG_FILE_FILTER );
   manager_->startUpdate();
 
   if( !q_filename.isEmpty() )
   {
     std::string filename = q_filename.toStdString();
     fs::path path( filename );
-    if( path.extension() != "." CONFIG_EXTENSION )
+    if( path.extension() != "." CONFIG_EXTENSION && path.extension() != "." BINARY_CONFIG_EXTENSION )
     {
       filename += "." CONFIG_EXTENSION;
     }
@@ -1128,6 +1309,17 @@ void VisualizationFrame::onSaveImage()
   dialog->show();
 }
 
+void VisualizationFrame::onRecordVideo()
+{
+  if( !video_recorder_dialog_ )
+  {
+    video_recorder_dialog_ = new VideoRecorderDialog( render_panel_, manager_, QString::fromStdString( last_image_dir_ ));
+  }
+  video_recorder_dialog_->show();
+  video_recorder_dialog_->raise();
+  video_recorder_dialog_->activateWindow();
+}
+
 void VisualizationFrame::onRecentConfigSelected()
 {
   QAction* action = dynamic_cast<QAction*>( sender() );
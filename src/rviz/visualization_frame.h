@@ -59,6 +59,7 @@ namespace rviz
 class PanelFactory;
 class Preferences;
 class RenderPanel;
+class VideoRecorderDialog;
 class VisualizationManager;
 class Tool;
 class WidgetGeometryChangeDetector;
@@ -185,6 +186,7 @@ protected Q_SLOTS:
   void onSave();
   void onSaveAs();
   void onSaveImage();
+  void onRecordVideo();
   void onRecentConfigSelected();
   void onHelpWiki();
   void onHelpAbout();
@@ -243,7 +245,8 @@ protected Q_SLOTS:
   void exitFullScreen();
 
 protected Q_SLOTS:
-  /** @brief Set loading_ to false. */
+  /** @brief Set loading_ to false once the displays of the loaded
+   * config are all loaded; check again later if they are not. */
   void markLoadingDone();
 
   /** @brief Set the default directory in which to save screenshot images. */
@@ -297,6 +300,10 @@ protected:
   void loadPreferences( const Config& config );
   void savePreferences( Config config );
 
+  /** @brief Pass the preferences which are settings of the
+   * VisualizationManager on to it. */
+  void applyPreferences();
+
   void loadWindowGeometry( const Config& config );
   void saveWindowGeometry( Config config );
 
@@ -316,6 +323,7 @@ protected:
 
   std::string config_dir_;
   std::string persistent_settings_file_;
+  std::string config_cache_dir_; ///< Binary copies of YAML config files, for fast reloading.
   std::string display_config_file_;
   std::string default_display_config_file_;
   std::string last_config_dir_;
@@ -334,6 +342,8 @@ protected:
 
   VisualizationManager* manager_;
 
+  VideoRecorderDialog* video_recorder_dialog_;
+
   std::string package_path_;
   QString help_path_;
   QString splash_path_;
@@ -371,6 +381,7 @@ protected:
   WidgetGeometryChangeDetector* geom_change_detector_;
   bool loading_; ///< True just when loading a display config file, false all other times.
   QTimer* post_load_timer_; ///< Single-shot timer for calling postLoad() a short time after loadDisplayConfig() finishes.
+  ros::WallTime load_start_time_; ///< When the current loadDisplayConfig() started.
 
   QLabel* status_label_;
   QLabel* fps_label_;
@@ -28,6 +28,7 @@
  */
 
 #include <algorithm>
+#include <vector>
 
 #include <QApplication>
 #include <QCursor>
@@ -38,6 +39,7 @@
 #endif
 
 #include <boost/bind.hpp>
+#include <boost/thread/condition_variable.hpp>
 
 #include <OgreRoot.h>
 #include <OgreSceneManager.h>
@@ -57,23 +59,29 @@
 #include <ros/package.h>
 #include <ros/callback_queue.h>
 
+#include "rviz/deferred_work_queue.h"
 #include "rviz/display.h"
 #include "rviz/display_factory.h"
 #include "rviz/display_group.h"
 #include "rviz/displays_panel.h"
 #include "rviz/frame_manager.h"
+#include "rviz/memory_budget.h"
+#include "rviz/performance_monitor.h"
 #include "rviz/ogre_helpers/qt_ogre_render_window.h"
+#include "rviz/properties/bool_property.h"
 #include "rviz/properties/color_property.h"
 #include "rviz/properties/parse_color.h"
 #include "rviz/properties/property.h"
 #include "rviz/properties/property_tree_model.h"
 #include "rviz/properties/status_list.h"
 #include "rviz/properties/tf_frame_property.h"
+#include "rviz/properties/float_property.h"
 #include "rviz/properties/int_property.h"
 #include "rviz/render_panel.h"
 #include "rviz/selection/selection_manager.h"
 #include "rviz/tool.h"
 #include "rviz/tool_manager.h"
+#include "rviz/topic_cache.h"
 #include "rviz/viewport_mouse_event.h"
 #include "rviz/view_controller.h"
 #include "rviz/view_manager.h"
@@ -87,6 +95,23 @@
 namespace rviz
 {
 
+// Minimum update timer rate while idle, so ROS callbacks and tools stay responsive.
+static const int MIN_IDLE_UPDATE_RATE = 10;
+
+// Seconds without queued renders before the update timer slows down.
+static const double IDLE_TIMEOUT = 1.0;
+
+// Upper bound on threads serving the receive queue.
+static const unsigned int MAX_RECEIVE_THREADS = 4;
+
+// Upper bound on threads running Display::prepareUpdate().
+static const unsigned int MAX_PREPARE_THREADS = 8;
+
+// Time in seconds spent loading displays per frame while a config is
+// loading, when the frame budget is not limited.  Keeps the window
+// responsive while a large config is built.
+static const double LOAD_FRAME_BUDGET = 0.03;
+
 //helper class needed to display an icon besides "Global Options"
 class IconizedProperty: public Property {
 public:
@@ -107,11 +132,103 @@ private:
   QIcon icon_;
 };
 
+/** @brief Counts the prepareUpdate() calls of one frame which are still running. */
+class PrepareBarrier
+{
+public:
+  PrepareBarrier() : pending_( 0 ) {}
+
+  void add() { boost::mutex::scoped_lock lock( mutex_ ); pending_++; }
+
+  void done()
+  {
+    boost::mutex::scoped_lock lock( mutex_ );
+    if( --pending_ == 0 )
+    {
+      done_.notify_all();
+    }
+  }
+
+  void wait()
+  {
+    boost::mutex::scoped_lock lock( mutex_ );
+    while( pending_ > 0 )
+    {
+      done_.wait( lock );
+    }
+  }
+
+private:
+  boost::mutex mutex_;
+  boost::condition_variable done_;
+  int pending_;
+};
+
+/** @brief Calls Display::prepareUpdate() and records its timing. */
+static void prepareDisplay( Display* display, float wall_dt, float ros_dt, PerformanceMonitor* monitor )
+{
+  ros::WallTime start = ros::WallTime::now();
+  display->prepareUpdate( wall_dt, ros_dt );
+  ros::WallDuration duration = ros::WallTime::now() - start;
+
+  display->getStatistics().addPrepare( duration );
+  if( monitor->isTracing() )
+  {
+    monitor->addTraceEvent( display->getNameStd(), "prepare", start, duration );
+  }
+}
+
+/** @brief Runs prepareDisplay() for one Display on the prepare queue. */
+class PrepareCallback: public ros::CallbackInterface
+{
+public:
+  PrepareCallback( Display* display, float wall_dt, float ros_dt, PerformanceMonitor* monitor, PrepareBarrier* barrier )
+    : display_( display ), wall_dt_( wall_dt ), ros_dt_( ros_dt ), monitor_( monitor ), barrier_( barrier )
+  {}
+
+  virtual CallResult call()
+  {
+    prepareDisplay( display_, wall_dt_, ros_dt_, monitor_ );
+    barrier_->done();
+    return Success;
+  }
+
+private:
+  Display* display_;
+  float wall_dt_;
+  float ros_dt_;
+  PerformanceMonitor* monitor_;
+  PrepareBarrier* barrier_;
+};
+
+/** @brief Append the enabled displays below @a group, skipping disabled groups. */
+static void collectEnabledDisplays( DisplayGroup* group, std::vector<Display*>& displays )
+{
+  int num_displays = group->numDisplays();
+  for( int i = 0; i < num_displays; i++ )
+  {
+    Display* display = group->getDisplayAt( i );
+    if( !display->isEnabled() )
+    {
+      continue;
+    }
+    displays.push_back( display );
+    if( DisplayGroup* child_group = qobject_cast<DisplayGroup*>( display ))
+    {
+      collectEnabledDisplays( child_group, displays );
+    }
+  }
+}
+
 class VisualizationManagerPrivate
 {
 public:
   ros::CallbackQueue threaded_queue_;
   boost::thread_group threaded_queue_threads_;
+  ros::CallbackQueue receive_queue_;
+  boost::thread_group receive_queue_threads_;
+  ros::CallbackQueue prepare_queue_;
+  boost::thread_group prepare_queue_threads_;
   ros::NodeHandle update_nh_;
   ros::NodeHandle threaded_nh_;
   boost::mutex render_mutex_;
@@ -139,7 +256,9 @@ VisualizationManager::VisualizationManager(
 , time_update_timer_(0.0f)
 , frame_update_timer_(0.0f)
 , render_requested_(1)
+, render_request_count_(0)
 , frame_count_(0)
+, update_idle_(false)
 , window_manager_(wm)
 , private_( new VisualizationManagerPrivate )
 {
@@ -198,8 +317,35 @@ VisualizationManager::VisualizationManager(
                                                   global_options_, SLOT( updateBackgroundColor() ), this );
 
   fps_property_ = new IntProperty( "Frame Rate", 30,
-                                   "RViz will try to render this many frames per second.",
+                                   "Maximum number of frames per second.  RViz only renders when something "
+                                   "changed, up to this rate.",
                                    global_options_, SLOT( updateFps() ), this );
+  fps_property_->setMin( 1 );
+
+  idle_fps_property_ = new IntProperty( "Idle Frame Rate", 1,
+                                        "Frames per second rendered when nothing reported a change.  "
+                                        "0 disables rendering while idle.",
+                                        global_options_, SLOT( updateIdleFps() ), this );
+  idle_fps_property_->setMin( 0 );
+
+  frame_budget_property_ = new FloatProperty( "Frame Budget", 0,
+                                              "Milliseconds per frame for display updates and deferred work, "
+                                              "like uploading large point clouds.  Work which does not fit is "
+                                              "continued in the next frames.  0 finishes all work every frame.",
+                                              global_options_ );
+  frame_budget_property_->setMin( 0 );
+
+  parallel_updates_property_ = new BoolProperty( "Parallel Updates", true,
+                                                 "Let displays which support it prepare their updates, "
+                                                 "like tf lookups, on worker threads in parallel.",
+                                                 global_options_ );
+
+  topic_refresh_property_ = new FloatProperty( "Topic Refresh Interval", 2.0,
+                                               "Seconds between background updates of the list of topics "
+                                               "shown in dialogs and topic properties.  0 only updates it "
+                                               "when one of them is opened.",
+                                               global_options_, SLOT( updateTopicRefreshInterval() ), this );
+  topic_refresh_property_->setMin( 0 );
 
   default_light_enabled_property_ = new BoolProperty( "Default Light", true,
                                                       "Light source attached to the current 3D view.",
@@ -219,7 +365,22 @@ VisualizationManager::VisualizationManager(
 
   private_->threaded_queue_threads_.create_thread(boost::bind(&VisualizationManager::threadedQueueThreadFunc, this));
 
+  unsigned int receive_threads = std::min( std::max( boost::thread::hardware_concurrency(), 1u ), MAX_RECEIVE_THREADS );
+  for( unsigned int i = 0; i < receive_threads; ++i )
+  {
+    private_->receive_queue_threads_.create_thread(boost::bind(&VisualizationManager::receiveQueueThreadFunc, this));
+  }
+
+  unsigned int prepare_threads = std::min( std::max( boost::thread::hardware_concurrency(), 1u ), MAX_PREPARE_THREADS );
+  for( unsigned int i = 0; i < prepare_threads; ++i )
+  {
+    private_->prepare_queue_threads_.create_thread(boost::bind(&VisualizationManager::prepareQueueThreadFunc, this));
+  }
+
   display_factory_ = new DisplayFactory();
+  performance_monitor_ = new PerformanceMonitor();
+  memory_budget_ = new MemoryBudget();
+  deferred_work_queue_ = new DeferredWorkQueue();
 
   ogre_render_queue_clearer_ = new OgreRenderQueueClearer();
   Ogre::Root::getSingletonPtr()->addFrameListener( ogre_render_queue_clearer_ );
@@ -234,6 +395,8 @@ VisualizationManager::~VisualizationManager()
 
   shutting_down_ = true;
   private_->threaded_queue_threads_.join_all();
+  private_->receive_queue_threads_.join_all();
+  private_->prepare_queue_threads_.join_all();
 
   if(selection_manager_)
   {
@@ -251,6 +414,9 @@ VisualizationManager::~VisualizationManager()
     ogre_root_->destroySceneManager( scene_manager_ );
   }
   delete frame_manager_;
+  delete performance_monitor_;
+  delete memory_budget_;
+  delete deferred_work_queue_;
   delete private_;
 
   Ogre::Root::getSingletonPtr()->removeFrameListener( ogre_render_queue_clearer_ );
@@ -274,6 +440,11 @@ ros::CallbackQueueInterface* VisualizationManager::getThreadedQueue()
   return &private_->threaded_queue_;
 }
 
+ros::CallbackQueueInterface* VisualizationManager::getReceiveQueue()
+{
+  return &private_->receive_queue_;
+}
+
 void VisualizationManager::lockRender()
 {
   private_->render_mutex_.lock();
@@ -291,10 +462,38 @@ ros::CallbackQueueInterface* VisualizationManager::getUpdateQueue()
 
 void VisualizationManager::startUpdate()
 {
+  update_idle_ = false;
   float interval = 1000.0 / float(fps_property_->getInt());
   update_timer_->start( interval );
 }
 
+void VisualizationManager::setUpdateIdle( bool idle )
+{
+  if( idle == update_idle_ || !update_timer_->isActive() )
+  {
+    return;
+  }
+
+  if( !idle )
+  {
+    startUpdate();
+    return;
+  }
+
+  update_idle_ = true;
+  int rate = std::max( idle_fps_property_->getInt(), MIN_IDLE_UPDATE_RATE );
+  rate = std::min( rate, fps_property_->getInt() );
+  update_timer_->start( 1000.0 / float(rate) );
+}
+
+void VisualizationManager::wakeUpdate()
+{
+  if( update_timer_->isActive() )
+  {
+    startUpdate();
+  }
+}
+
 void VisualizationManager::stopUpdate()
 {
   update_timer_->stop();
@@ -328,10 +527,18 @@ void VisualizationManager::createColorMaterials()
 void VisualizationManager::queueRender()
 {
   render_requested_ = 1;
+  ++render_request_count_;
+
+  // Only the first request after going idle has to wake the timer.
+  if( update_idle_.exchange( false ))
+  {
+    QMetaObject::invokeMethod( this, "wakeUpdate", Qt::QueuedConnection );
+  }
 }
 
 void VisualizationManager::onUpdate()
 {
+  ros::WallTime update_start = ros::WallTime::now();
   ros::WallDuration wall_diff = ros::WallTime::now() - last_update_wall_time_;
   ros::Duration ros_diff = ros::Time::now() - last_update_ros_time_;
   float wall_dt = wall_diff.toSec();
@@ -350,8 +557,33 @@ void VisualizationManager::onUpdate()
 
   frame_manager_->update();
 
+  prepareDisplays( wall_dt, ros_dt );
   root_display_group_->update( wall_dt, ros_dt );
 
+  // Continue deferred work with what is left of the frame budget.
+  // The queue always runs at least one unit, so work does not starve.
+  if( !deferred_work_queue_->empty() )
+  {
+    ros::WallTime work_start = ros::WallTime::now();
+    double budget = 0.001 * frame_budget_property_->getFloat();
+    if( budget == 0.0 && isLoading() )
+    {
+      budget = LOAD_FRAME_BUDGET;
+    }
+    if( budget > 0.0 )
+    {
+      budget = std::max( budget - (work_start - update_start).toSec(), 1e-6 );
+    }
+    deferred_work_queue_->run( ros::WallDuration( budget ));
+    performance_monitor_->addTraceEvent( "deferred work", "update", work_start, ros::WallTime::now() - work_start );
+
+    if( !deferred_work_queue_->empty() )
+    {
+      // Keep updating at full rate until the work is done.
+      queueRender();
+    }
+  }
+
   view_manager_->update(wall_dt, ros_dt);
 
   time_update_timer_ += wall_dt;
@@ -370,6 +602,7 @@ void VisualizationManager::onUpdate()
     frame_update_timer_ = 0.0f;
 
     updateFrames();
+    enforceMemoryBudget();
   }
 
   selection_manager_->update();
@@ -388,12 +621,38 @@ void VisualizationManager::onUpdate()
 
   frame_count_++;
 
-  if ( render_requested_ || wall_dt > 0.01 )
+  ros::WallTime now = ros::WallTime::now();
+  int idle_fps = idle_fps_property_->getInt();
+  bool idle_render_due = idle_fps > 0 && (now - last_render_wall_time_).toSec() >= 1.0 / idle_fps;
+
+  if ( render_requested_ )
+  {
+    last_render_request_wall_time_ = now;
+  }
+
+  if ( render_requested_ || idle_render_due )
   {
     render_requested_ = 0;
+    last_render_wall_time_ = now;
     boost::mutex::scoped_lock lock(private_->render_mutex_);
+    ros::WallTime render_start = ros::WallTime::now();
     ogre_root_->renderOneFrame();
+    ros::WallDuration render_duration = ros::WallTime::now() - render_start;
+
+    Ogre::RenderWindow* window = render_panel_->getRenderWindow();
+    performance_monitor_->addRender( render_duration,
+                                     window ? window->getTriangleCount() : 0,
+                                     window ? window->getBatchCount() : 0 );
+    performance_monitor_->addTraceEvent( "renderOneFrame", "render", render_start, render_duration );
   }
+
+  // Slow the update timer down when nothing asked for a render in a
+  // while.  queueRender() speeds it up again.
+  setUpdateIdle( (now - last_render_request_wall_time_).toSec() > IDLE_TIMEOUT );
+
+  ros::WallDuration update_duration = ros::WallTime::now() - update_start;
+  performance_monitor_->addUpdate( update_duration );
+  performance_monitor_->addTraceEvent( "onUpdate", "update", update_start, update_duration );
 }
 
 void VisualizationManager::updateTime()
@@ -413,6 +672,55 @@ void VisualizationManager::updateTime()
   wall_clock_elapsed_ = ros::WallTime::now() - wall_clock_begin_;
 }
 
+static void collectDisplays( Display* display, std::vector<Display*>& displays )
+{
+  DisplayGroup* display_group = qobject_cast<DisplayGroup*>( display );
+  if( display_group )
+  {
+    for( int i = 0; i < display_group->numDisplays(); i++ )
+    {
+      collectDisplays( display_group->getDisplayAt( i ), displays );
+    }
+  }
+  else
+  {
+    displays.push_back( display );
+  }
+}
+
+void VisualizationManager::enforceMemoryBudget()
+{
+  if( memory_budget_->getBudget() == 0 && memory_budget_->getDisplayCap() == 0 )
+  {
+    return;
+  }
+
+  std::vector<Display*> displays;
+  collectDisplays( root_display_group_, displays );
+
+  std::vector<uint64_t> usage( displays.size() );
+  for( size_t i = 0; i < displays.size(); i++ )
+  {
+    DisplayStatistics::Totals totals = displays[ i ]->getStatistics().getTotals();
+    usage[ i ] = totals.cpu_bytes + totals.gpu_bytes;
+  }
+
+  std::vector<MemoryBudget::Eviction> evictions = memory_budget_->plan( usage );
+  for( size_t i = 0; i < evictions.size(); i++ )
+  {
+    // Lower the detail first and drop data only if that is not enough.
+    Display* display = displays[ evictions[ i ].index ];
+    if( !display->reduceDetail( evictions[ i ].max_bytes ))
+    {
+      display->reduceMemoryUsage( evictions[ i ].max_bytes );
+    }
+  }
+  if( !evictions.empty() )
+  {
+    queueRender();
+  }
+}
+
 void VisualizationManager::updateFrames()
 {
   typedef std::vector<std::string> V_string;
@@ -518,6 +826,11 @@ void VisualizationManager::load( const Config& config )
   startUpdate();
 }
 
+bool VisualizationManager::isLoading() const
+{
+  return root_display_group_->isLoading();
+}
+
 void VisualizationManager::save( Config config ) const
 {
   root_display_group_->save( config );
@@ -564,6 +877,11 @@ void VisualizationManager::updateBackgroundColor()
   queueRender();
 }
 
+void VisualizationManager::updateTopicRefreshInterval()
+{
+  TopicCache::instance()->setRefreshInterval( topic_refresh_property_->getFloat() );
+}
+
 void VisualizationManager::updateFps()
 {
   if ( update_timer_->isActive() )
@@ -572,6 +890,16 @@ void VisualizationManager::updateFps()
   }
 }
 
+void VisualizationManager::updateIdleFps()
+{
+  // Re-arm the idle timer at the new rate; the active rate is unchanged.
+  if ( update_idle_ && update_timer_->isActive() )
+  {
+    update_idle_ = false;
+    setUpdateIdle( true );
+  }
+}
+
 void VisualizationManager::updateDefaultLightVisible()
 {
   directional_light_->setVisible(default_light_enabled_property_->getBool());
@@ -629,6 +957,53 @@ void VisualizationManager::threadedQueueThreadFunc()
   }
 }
 
+void VisualizationManager::receiveQueueThreadFunc()
+{
+  while (!shutting_down_)
+  {
+    private_->receive_queue_.callOne(ros::WallDuration(0.1));
+  }
+}
+
+void VisualizationManager::prepareQueueThreadFunc()
+{
+  while (!shutting_down_)
+  {
+    private_->prepare_queue_.callOne(ros::WallDuration(0.1));
+  }
+}
+
+void VisualizationManager::prepareDisplays( float wall_dt, float ros_dt )
+{
+  std::vector<Display*> displays;
+  collectEnabledDisplays( root_display_group_, displays );
+
+  bool parallel = parallel_updates_property_->getBool();
+  PrepareBarrier barrier;
+  std::vector<Display*> serial;
+  for( size_t i = 0; i < displays.size(); i++ )
+  {
+    if( parallel && displays[ i ]->isPrepareUpdateThreadSafe() )
+    {
+      barrier.add();
+      private_->prepare_queue_.addCallback( ros::CallbackInterfacePtr(
+        new PrepareCallback( displays[ i ], wall_dt, ros_dt, performance_monitor_, &barrier )));
+    }
+    else
+    {
+      serial.push_back( displays[ i ] );
+    }
+  }
+
+  // The rest is prepared here while the workers run.
+  for( size_t i = 0; i < serial.size(); i++ )
+  {
+    prepareDisplay( serial[ i ], wall_dt, ros_dt, performance_monitor_ );
+  }
+
+  barrier.wait();
+}
+
 void VisualizationManager::notifyConfigChanged()
 {
   Q_EMIT configChanged();
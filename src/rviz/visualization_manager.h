@@ -31,6 +31,7 @@
 #ifndef RVIZ_VISUALIZATION_MANAGER_H_
 #define RVIZ_VISUALIZATION_MANAGER_H_
 
+#include <atomic>
 #include <deque>
 
 #include <ros/time.h>
@@ -66,11 +67,13 @@ namespace rviz
 
 class ColorProperty;
 class Display;
+class DeferredWorkQueue;
 class DisplayFactory;
 class DisplayGroup;
 class FrameManager;
 class Property;
 class BoolProperty;
+class FloatProperty;
 class IntProperty;
 class PropertyTreeModel;
 class RenderPanel;
@@ -81,6 +84,8 @@ class ViewportMouseEvent;
 class WindowManagerInterface;
 class Tool;
 class OgreRenderQueueClearer;
+class PerformanceMonitor;
+class MemoryBudget;
 
 class VisualizationManagerPrivate;
 
@@ -143,8 +148,9 @@ public:
   void initialize();
 
   /**
-   * \brief Start timers.
-   * Creates and starts the update and idle timers, both set to 30Hz (33ms).
+   * \brief Start the update timer.
+   * The timer runs at the "Frame Rate" property value while renders are
+   * being queued, and slows down after a second without any.
    */
   void startUpdate();
 
@@ -184,6 +190,10 @@ public:
    */
   void load( const Config& config );
 
+  /** @brief Return true while displays of the last loaded config are
+   * still being initialized and loaded in the frame loop. */
+  bool isLoading() const;
+
   /**
    * \brief Save the properties of each Display and most editable rviz
    *        data.
@@ -290,6 +300,11 @@ public:
 
   /**
    * \brief Queues a render.  Multiple calls before a render happens will only cause a single render.
+   *
+   * Frames are only rendered when a render was queued (or the "Idle
+   * Frame Rate" is due), so displays, tools and view controllers must
+   * call this whenever they change something visible.  Also brings the
+   * update timer back to full rate if it slowed down.
    * \note This function can be called from any thread.
    */
   void queueRender();
@@ -309,6 +324,11 @@ public:
    */
   ros::CallbackQueueInterface* getThreadedQueue();
 
+  /**
+   * @brief Return a CallbackQueue served by a pool of receiver threads.
+   */
+  ros::CallbackQueueInterface* getReceiveQueue();
+
   /** @brief Return the FrameManager instance. */
   FrameManager* getFrameManager() const { return frame_manager_; }
 
@@ -319,6 +339,12 @@ public:
    * been rendered since the last time they did something. */
   uint64_t getFrameCount() const { return frame_count_; }
 
+  /** @brief Return the number of renders queued so far.
+   *
+   * Incremented by every queueRender() call, so secondary render
+   * panels can tell whether the scene changed since they last drew. */
+  uint64_t getRenderRequestCount() const { return render_request_count_; }
+
   /** @brief Notify this VisualizationManager that something about its
    * display configuration has changed. */
   void notifyConfigChanged();
@@ -326,6 +352,15 @@ public:
   /** @brief Return a factory for creating Display subclasses based on a class id string. */
   virtual DisplayFactory* getDisplayFactory() const { return display_factory_; }
 
+  /** @brief Return the PerformanceMonitor collecting frame timings and trace events. */
+  virtual PerformanceMonitor* getPerformanceMonitor() const { return performance_monitor_; }
+
+  /** @brief Return the limits on the memory used by displays. */
+  MemoryBudget* getMemoryBudget() const { return memory_budget_; }
+
+  /** @brief Return the queue of incremental work run within the frame budget. */
+  virtual DeferredWorkQueue* getDeferredWorkQueue() const { return deferred_work_queue_; }
+
   PropertyTreeModel* getDisplayTreeModel() const { return display_property_tree_model_; }
 
   /** @brief Emits statusUpdate() signal with the given @a message. */
@@ -362,7 +397,11 @@ protected Q_SLOTS:
    * calls ros::spinOnce(), so any callbacks on the global
    * CallbackQueue get called from here as well.
    *
-   * It is called at 30Hz from the update timer. */
+   * Renders a frame if queueRender() was called since the last frame,
+   * or if the "Idle Frame Rate" interval passed.
+   *
+   * It is called from the update timer, at the "Frame Rate" while
+   * renders are being queued and at a lower rate when idle. */
   void onUpdate();
 
   void onToolChanged( Tool* );
@@ -371,9 +410,22 @@ protected:
   void updateTime();
   void updateFrames();
 
+  /** @brief Ask the displays using more memory than the MemoryBudget
+   * allows to reduce their usage. */
+  void enforceMemoryBudget();
+
   void createColorMaterials();
 
   void threadedQueueThreadFunc();
+  void receiveQueueThreadFunc();
+  void prepareQueueThreadFunc();
+
+  /** @brief Call Display::prepareUpdate() on all enabled displays.
+   *
+   * Displays which declared it thread-safe are prepared on the
+   * prepare thread pool when "Parallel Updates" is on, the others on
+   * this thread.  Returns once all of them are done. */
+  void prepareDisplays( float wall_dt, float ros_dt );
 
   Ogre::Root* ogre_root_;                                 ///< Ogre Root
   Ogre::SceneManager* scene_manager_;                     ///< Ogre scene manager associated with this panel
@@ -394,6 +446,10 @@ protected:
   TfFrameProperty* fixed_frame_property_;          ///< Frame to transform fixed data to
   StatusList* global_status_;
   IntProperty* fps_property_;
+  IntProperty* idle_fps_property_;
+  FloatProperty* frame_budget_property_;
+  BoolProperty* parallel_updates_property_;
+  FloatProperty* topic_refresh_property_;
   BoolProperty* default_light_enabled_property_;
 
   RenderPanel* render_panel_;
@@ -411,8 +467,13 @@ protected:
   SelectionManager* selection_manager_;
 
   uint32_t render_requested_;
+  std::atomic<uint64_t> render_request_count_;
   uint64_t frame_count_;
 
+  ros::WallTime last_render_wall_time_;                   ///< When the last frame was rendered
+  ros::WallTime last_render_request_wall_time_;           ///< When the last frame rendered on request was rendered
+  std::atomic<bool> update_idle_;                         ///< True while the update timer runs at the idle rate
+
   WindowManagerInterface* window_manager_;
   
   FrameManager* frame_manager_;
@@ -423,10 +484,21 @@ private Q_SLOTS:
   void updateFixedFrame();
   void updateBackgroundColor();
   void updateFps();
+  void updateIdleFps();
+  void updateTopicRefreshInterval();
+
+  /** @brief Switch the update timer back to full rate. */
+  void wakeUpdate();
   void updateDefaultLightVisible();
 
 private:
+  /** @brief Set the update timer interval for active or idle updates. */
+  void setUpdateIdle( bool idle );
+
   DisplayFactory* display_factory_;
+  PerformanceMonitor* performance_monitor_;
+  MemoryBudget* memory_budget_;
+  DeferredWorkQueue* deferred_work_queue_;
   VisualizationManagerPrivate* private_;
   uint32_t default_visibility_bit_;
   BitAllocator visibility_bit_allocator_;
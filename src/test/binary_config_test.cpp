@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) 2012, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include <rviz/binary_config.h>
+#include <rviz/yaml_config_reader.h>
+#include <rviz/yaml_config_writer.h>
+
+using rviz::Config;
+
+static QByteArray roundTrip( const Config& config, Config& result )
+{
+  rviz::BinaryConfigWriter writer;
+  QByteArray data = writer.writeData( config );
+  EXPECT_FALSE( writer.error() );
+
+  rviz::BinaryConfigReader reader;
+  reader.readData( result, data );
+  EXPECT_FALSE( reader.error() ) << qPrintable( reader.errorMessage() );
+  return data;
+}
+
+TEST( BinaryConfig, keeps_values_and_types )
+{
+  Config config;
+  config.mapSetValue( "string", "hello" );
+  config.mapSetValue( "empty", "" );
+  config.mapSetValue( "bool", true );
+  config.mapSetValue( "int", -42 );
+  config.mapSetValue( "float", 1.2f );
+  config.mapSetValue( "double", 0.1 );
+  config.mapMakeChild( "nothing" );
+  Config list = config.mapMakeChild( "list" );
+  list.listAppendNew().setValue( "a" );
+  list.listAppendNew().mapSetValue( "b", 2 );
+  list.listAppendNew();
+
+  Config result;
+  roundTrip( config, result );
+
+  ASSERT_EQ( Config::Map, result.getType() );
+  EXPECT_EQ( QVariant( "hello" ), result.mapGetChild( "string" ).getValue() );
+  EXPECT_EQ( QVariant( "" ), result.mapGetChild( "empty" ).getValue() );
+  EXPECT_EQ( QVariant( true ), result.mapGetChild( "bool" ).getValue() );
+  EXPECT_EQ( QVariant( -42 ), result.mapGetChild( "int" ).getValue() );
+  EXPECT_EQ( QVariant( 1.2f ), result.mapGetChild( "float" ).getValue() );
+  EXPECT_EQ( QVariant( 0.1 ), result.mapGetChild( "double" ).getValue() );
+  EXPECT_EQ( Config::Empty, result.mapGetChild( "nothing" ).getType() );
+
+  Config result_list = result.mapGetChild( "list" );
+  ASSERT_EQ( Config::List, result_list.getType() );
+  ASSERT_EQ( 3, result_list.listLength() );
+  EXPECT_EQ( QVariant( "a" ), result_list.listChildAt( 0 ).getValue() );
+  int b;
+  EXPECT_TRUE( result_list.listChildAt( 1 ).mapGetInt( "b", &b ));
+  EXPECT_EQ( 2, b );
+  EXPECT_EQ( Config::Empty, result_list.listChildAt( 2 ).getType() );
+}
+
+TEST( BinaryConfig, interns_strings )
+{
+  Config config;
+  Config list = config.mapMakeChild( "Frames" );
+  for( int i = 0; i < 1000; i++ )
+  {
+    Config frame = list.listAppendNew();
+    frame.mapSetValue( "Name", "a_frame_name_which_repeats" );
+    frame.mapSetValue( "Value", "a_value_which_repeats_too" );
+  }
+
+  // 3002 nodes of 16 bytes, plus each string only once.
+  rviz::BinaryConfigWriter writer;
+  EXPECT_LT( writer.writeData( config ).size(), 3002 * 16 + 200 );
+}
+
+TEST( BinaryConfig, round_trips_with_yaml )
+{
+  QString yaml =
+    "Panels:\n"
+    "  - Class: rviz/Displays\n"
+    "    Splitter Ratio: 0.5\n"
+    "Visualization Manager:\n"
+    "  Displays:\n"
+    "    - Class: rviz/TF\n"
+    "      Enabled: true\n"
+    "      Frames:\n"
+    "        All Enabled: false\n"
+    "        base_link:\n"
+    "          Value: true\n"
+    "      Name: \"\"\n"
+    "  Global Options:\n"
+    "    Fixed Frame: map\n"
+    "    Frame Rate: 30\n"
+    "  Empty List: []\n";
+
+  Config from_yaml;
+  rviz::YamlConfigReader yaml_reader;
+  yaml_reader.readString( from_yaml, yaml );
+  ASSERT_FALSE( yaml_reader.error() );
+
+  Config from_binary;
+  roundTrip( from_yaml, from_binary );
+
+  rviz::YamlConfigWriter yaml_writer;
+  EXPECT_EQ( yaml_writer.writeString( from_yaml ), yaml_writer.writeString( from_binary ));
+
+  // Typed values, as saved by properties, give the same YAML too.
+  Config typed;
+  typed.mapSetValue( "Alpha", 0.7f );
+  typed.mapSetValue( "Scale", 1e-5 );
+  typed.mapSetValue( "Enabled", false );
+  Config typed_result;
+  roundTrip( typed, typed_result );
+  EXPECT_EQ( yaml_writer.writeString( typed ), yaml_writer.writeString( typed_result ));
+}
+
+TEST( BinaryConfig, reads_files )
+{
+  Config config;
+  config.mapSetValue( "Name", "file test" );
+
+  char filename[] = "/tmp/binary_config_testXXXXXX";
+  int fd = mkstemp( filename );
+  ASSERT_NE( -1, fd );
+  close( fd );
+
+  rviz::BinaryConfigWriter writer;
+  writer.writeFile( config, filename );
+  ASSERT_FALSE( writer.error() ) << qPrintable( writer.errorMessage() );
+  EXPECT_TRUE( rviz::BinaryConfigReader::isBinaryConfigFile( filename ));
+
+  Config result;
+  rviz::BinaryConfigReader reader;
+  reader.readFile( result, filename );
+  ASSERT_FALSE( reader.error() ) << qPrintable( reader.errorMessage() );
+  QString name;
+  EXPECT_TRUE( result.mapGetString( "Name", &name ));
+  EXPECT_EQ( "file test", name );
+
+  remove( filename );
+}
+
+TEST( BinaryConfig, rejects_bad_data )
+{
+  Config config;
+  config.mapMakeChild( "list" ).listAppendNew().setValue( "x" );
+  rviz::BinaryConfigWriter writer;
+  QByteArray data = writer.writeData( config );
+
+  rviz::BinaryConfigReader reader;
+  Config result;
+  reader.readData( result, "not a config" );
+  EXPECT_TRUE( reader.error() );
+
+  // Every truncation is detected.
+  for( int size = 0; size < data.size(); size++ )
+  {
+    Config truncated;
+    reader.readData( truncated, data.left( size ));
+    EXPECT_TRUE( reader.error() ) << "size " << size;
+  }
+
+  reader.readData( result, data );
+  EXPECT_FALSE( reader.error() );
+}
+
+int main( int argc, char** argv )
+{
+  testing::InitGoogleTest( &argc, argv );
+  return RUN_ALL_TESTS();
+}
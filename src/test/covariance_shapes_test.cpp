@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2012, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <rviz/default_plugin/covariance_shapes.h>
+
+using rviz::CovarianceShapes;
+
+static boost::array<double, 36> diagonal( double x, double y, double z, double roll, double pitch, double yaw )
+{
+  boost::array<double, 36> covariance;
+  covariance.fill( 0 );
+  covariance[ 0 ] = x;
+  covariance[ 7 ] = y;
+  covariance[ 14 ] = z;
+  covariance[ 21 ] = roll;
+  covariance[ 28 ] = pitch;
+  covariance[ 35 ] = yaw;
+  return covariance;
+}
+
+TEST( CovarianceShapes, diagonal_3d )
+{
+  CovarianceShapes shapes;
+  rviz::computeCovarianceShapes( diagonal( 1, 4, 9, 0.01, 0.01, 0.01 ), shapes );
+  ASSERT_TRUE( shapes.valid );
+  EXPECT_FALSE( shapes.pose_2d );
+
+  // The scales are two standard deviations along the principal axes,
+  // whatever order the solver returns them in.
+  CovarianceShapes::Vector3 world_scale =
+    ( shapes.position_orientation.toRotationMatrix() * shapes.position_scale.asDiagonal() ).cwiseAbs().rowwise().sum();
+  EXPECT_NEAR( 2.0, world_scale.x(), 1e-4 );
+  EXPECT_NEAR( 4.0, world_scale.y(), 1e-4 );
+  EXPECT_NEAR( 6.0, world_scale.z(), 1e-4 );
+
+  // Right-handed rotation
+  EXPECT_NEAR( 1.0, shapes.position_orientation.toRotationMatrix().determinant(), 1e-4 );
+
+  // Only the 3D orientation shapes are shown.
+  EXPECT_NEAR( 0.2, shapes.orientation_scale[ CovarianceShapes::kRoll ].x(), 1e-4 );
+  EXPECT_NEAR( 0.001, shapes.orientation_scale[ CovarianceShapes::kRoll ].y(), 1e-6 );
+  EXPECT_EQ( 0, shapes.orientation_scale[ CovarianceShapes::kYaw2D ].norm() );
+}
+
+TEST( CovarianceShapes, rotated_2d )
+{
+  // Variance 4 along the diagonal x == y, 1 across it.
+  boost::array<double, 36> covariance = diagonal( 2.5, 2.5, 0, 0, 0, 0.04 );
+  covariance[ 1 ] = covariance[ 6 ] = 1.5;
+
+  CovarianceShapes shapes;
+  rviz::computeCovarianceShapes( covariance, shapes );
+  ASSERT_TRUE( shapes.valid );
+  EXPECT_TRUE( shapes.pose_2d );
+  EXPECT_NEAR( 0.001, shapes.position_scale.z(), 1e-6 );
+
+  int major = shapes.position_scale.x() > shapes.position_scale.y() ? 0 : 1;
+  EXPECT_NEAR( 4.0, shapes.position_scale[ major ], 1e-4 );
+  EXPECT_NEAR( 2.0, shapes.position_scale[ 1 - major ], 1e-4 );
+
+  CovarianceShapes::Vector3 axis = shapes.position_orientation * CovarianceShapes::Vector3::Unit( major );
+  EXPECT_NEAR( std::sqrt( 0.5 ), std::abs( axis.x() ), 1e-4 );
+  EXPECT_NEAR( std::sqrt( 0.5 ), std::abs( axis.y() ), 1e-4 );
+  EXPECT_NEAR( 0, axis.z(), 1e-4 );
+
+  EXPECT_NEAR( 0.4, shapes.orientation_scale[ CovarianceShapes::kYaw2D ].x(), 1e-4 );
+  EXPECT_EQ( 0, shapes.orientation_scale[ CovarianceShapes::kRoll ].norm() );
+}
+
+TEST( CovarianceShapes, nan_is_invalid )
+{
+  CovarianceShapes shapes;
+  rviz::computeCovarianceShapes( diagonal( std::numeric_limits<double>::quiet_NaN(), 1, 1, 1, 1, 1 ), shapes );
+  EXPECT_FALSE( shapes.valid );
+}
+
+TEST( CovarianceShapes, batch_matches_single )
+{
+  std::vector<boost::array<double, 36> > covariances;
+  covariances.push_back( diagonal( 1, 2, 3, 0.1, 0.2, 0.3 ));
+  covariances.push_back( diagonal( 1, 1, 0, 0, 0, 0.5 ));
+  covariances.push_back( diagonal( 0.5, 3, 1, 0.3, 0.1, 0.2 ));
+
+  std::vector<CovarianceShapes> batch( covariances.size() );
+  rviz::computeCovarianceShapes( &covariances[ 0 ], covariances.size(), &batch[ 0 ] );
+
+  for( size_t i = 0; i < covariances.size(); i++ )
+  {
+    CovarianceShapes single;
+    rviz::computeCovarianceShapes( covariances[ i ], single );
+    EXPECT_EQ( single.pose_2d, batch[ i ].pose_2d );
+    EXPECT_TRUE( single.position_scale.isApprox( batch[ i ].position_scale ));
+    EXPECT_TRUE( single.position_orientation.isApprox( batch[ i ].position_orientation ));
+  }
+}
+
+TEST( CovarianceShapes, orientation_scale_is_bounded )
+{
+  EXPECT_NEAR( 2.0 * std::tan( 0.05 ), rviz::radianScaleToMetricScaleBounded( 0.1, 89 ), 1e-6 );
+  EXPECT_NEAR( 2.0 * std::tan( 89 * M_PI / 180 ), rviz::radianScaleToMetricScaleBounded( 10, 89 ), 1e-3 );
+}
+
+int main( int argc, char** argv )
+{
+  testing::InitGoogleTest( &argc, argv );
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,399 @@
+/*
+ * Copyright (c) 2012, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Headless benchmark of the display pipeline.
+//
+// Creates a VisualizationManager without showing any window and
+// renders into an offscreen render texture, so it runs under a virtual
+// X server with software GL.  Displays based on MessageFilterDisplay
+// get their messages through injectMessage(), so the timings do not
+// depend on topic connections; the others get them published from
+// inside this process, so roscpp hands them over without serializing or
+// going through the network.  Each scenario renders a number of frames
+// and prints the frame, render, update and message processing timings.
+//
+// Run it standalone with a ROS master:
+//
+//   rosrun rviz display_benchmark _frames:=50 _points:=5000000
+//
+// or as a regression test with display_benchmark.test, where the
+// <scenario>/max_frame_ms parameters set the allowed mean frame time.
+
+#include <cstdio>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/make_shared.hpp>
+
+#include <QApplication>
+
+#include <OgreHardwarePixelBuffer.h>
+#include <OgreRenderTexture.h>
+#include <OgreTextureManager.h>
+
+#include <gtest/gtest.h>
+
+#include <ros/ros.h>
+#include <ros/callback_queue.h>
+
+#include <geometry_msgs/TransformStamped.h>
+#include <nav_msgs/OccupancyGrid.h>
+#include <sensor_msgs/PointCloud2.h>
+#include <sensor_msgs/point_cloud2_iterator.h>
+#include <tf2_ros/buffer.h>
+#include <visualization_msgs/MarkerArray.h>
+
+#include "rviz/display.h"
+#include "rviz/display_group.h"
+#include "rviz/frame_manager.h"
+#include "rviz/message_filter_display.h"
+#include "rviz/performance_monitor.h"
+#include "rviz/render_panel.h"
+#include "rviz/view_controller.h"
+#include "rviz/view_manager.h"
+#include "rviz/visualization_manager.h"
+
+using namespace rviz;
+
+class DisplayBenchmark: public testing::Test
+{
+protected:
+  static void SetUpTestCase()
+  {
+    nh_ = new ros::NodeHandle( "~" );
+
+    render_panel_ = new RenderPanel();
+    manager_ = new VisualizationManager( render_panel_ );
+    render_panel_->initialize( manager_->getSceneManager(), manager_ );
+    manager_->initialize();
+    manager_->setFixedFrame( "map" );
+
+    // The panel is never shown; render only into the offscreen target.
+    render_panel_->getRenderWindow()->setAutoUpdated( false );
+
+    int width, height;
+    nh_->param( "width", width, 1280 );
+    nh_->param( "height", height, 720 );
+    texture_ = Ogre::TextureManager::getSingleton().createManual(
+      "DisplayBenchmarkTarget", Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME,
+      Ogre::TEX_TYPE_2D, width, height, 0, Ogre::PF_R8G8B8A8, Ogre::TU_RENDERTARGET );
+    target_ = texture_->getBuffer()->getRenderTarget();
+    target_->addViewport( manager_->getViewManager()->getCurrent()->getCamera() );
+    target_->setAutoUpdated( true );
+  }
+
+  static void TearDownTestCase()
+  {
+    target_->removeAllViewports();
+    Ogre::TextureManager::getSingleton().remove( texture_->getName() );
+    texture_.setNull();
+    delete manager_;
+    delete render_panel_;
+    delete nh_;
+  }
+
+  virtual void TearDown()
+  {
+    manager_->getRootDisplayGroup()->removeAllDisplays();
+  }
+
+  template<class T>
+  static T param( const std::string& name, T default_value )
+  {
+    T value;
+    nh_->param( name, value, default_value );
+    return value;
+  }
+
+  /** Create a display of @a class_id subscribed to @a topic. */
+  Display* createDisplay( const QString& class_id, const std::string& topic, const std::string& type )
+  {
+    Display* display = manager_->createDisplay( class_id, class_id, true );
+    display->setTopic( QString::fromStdString( topic ), QString::fromStdString( type ));
+    return display;
+  }
+
+  /** Hand @a msg to @a display directly, without a topic. */
+  template<class M>
+  void inject( Display* display, const boost::shared_ptr<M const>& msg )
+  {
+    MessageFilterDisplay<M>* filter_display = dynamic_cast<MessageFilterDisplay<M>*>( display );
+    ASSERT_TRUE( filter_display != NULL ) << "display does not take " << ros::message_traits::datatype<M>();
+    ASSERT_TRUE( filter_display->injectMessage( msg ));
+  }
+
+  /** Publish @a msg once @a pub is connected to its intra-process subscriber. */
+  template<class M>
+  void publish( ros::Publisher& pub, const boost::shared_ptr<M const>& msg )
+  {
+    ros::WallTime deadline = ros::WallTime::now() + ros::WallDuration( 10.0 );
+    while( pub.getNumSubscribers() == 0 && ros::WallTime::now() < deadline )
+    {
+      ros::WallDuration( 0.01 ).sleep();
+    }
+    ASSERT_GT( pub.getNumSubscribers(), 0u ) << "no subscriber on " << pub.getTopic();
+    pub.publish( msg );
+  }
+
+  /** Run one update cycle, forcing a render, and return its duration. */
+  ros::WallDuration frame()
+  {
+    manager_->queueRender();
+    ros::WallTime start = ros::WallTime::now();
+    QMetaObject::invokeMethod( manager_, "onUpdate", Qt::DirectConnection );
+    return ros::WallTime::now() - start;
+  }
+
+  /** Call @a feed @a steps times, rendering frames after each call
+   * until @a display processed the message it published (unless
+   * @a wait_for_message is false), then print the timings and check
+   * them against the <scenario>/max_frame_ms parameter. */
+  void run( const std::string& scenario, Display* display, bool wait_for_message,
+            std::function<void( int )> feed )
+  {
+    int steps = param( "frames", 30 );
+
+    // Let the display settle, e.g. finish subscribing.
+    frame();
+
+    PerformanceMonitor::FrameTotals frame_start = manager_->getPerformanceMonitor()->getFrameTotals();
+    DisplayStatistics::Totals display_start = display->getStatistics().getTotals();
+
+    int frames = 0;
+    double frame_sum = 0.0;
+    double frame_max = 0.0;
+    for( int i = 0; i < steps; i++ )
+    {
+      feed( i );
+
+      // Messages reach the display asynchronously through the receive
+      // threads, even injected ones, so keep rendering until it got this one.
+      ros::WallTime deadline = ros::WallTime::now() + ros::WallDuration( 10.0 );
+      do
+      {
+        double frame_time = frame().toSec();
+        frame_sum += frame_time;
+        frame_max = std::max( frame_max, frame_time );
+        frames++;
+      }
+      while( wait_for_message &&
+             display->getStatistics().getTotals().messages < display_start.messages + i + 1 &&
+             ros::WallTime::now() < deadline );
+    }
+
+    PerformanceMonitor::FrameTotals frame_end = manager_->getPerformanceMonitor()->getFrameTotals();
+    DisplayStatistics::Totals display_end = display->getStatistics().getTotals();
+
+    uint64_t renders = frame_end.renders - frame_start.renders;
+    uint64_t updates = display_end.updates - display_start.updates;
+    uint64_t messages = display_end.messages - display_start.messages;
+    double frame_ms = 1000.0 * frame_sum / frames;
+
+    printf( "[%s] %d frames: frame %.2f ms (max %.2f), render %.2f ms, display update %.2f ms, "
+            "%lu messages processed in %.2f ms each, %lu triangles, %lu batches\n",
+            scenario.c_str(), frames, frame_ms, 1000.0 * frame_max,
+            renders ? 1000.0 * (frame_end.render_time - frame_start.render_time) / renders : 0.0,
+            updates ? 1000.0 * (display_end.update_time - display_start.update_time) / updates : 0.0,
+            (unsigned long) messages,
+            messages ? 1000.0 * (display_end.message_time - display_start.message_time) / messages : 0.0,
+            (unsigned long) target_->getTriangleCount(),
+            (unsigned long) target_->getBatchCount() );
+
+    if( wait_for_message )
+    {
+      EXPECT_EQ( messages, (uint64_t) steps ) << scenario << " display missed messages";
+    }
+
+    double max_frame_ms = param( scenario + "/max_frame_ms", 0.0 );
+    if( max_frame_ms > 0.0 )
+    {
+      EXPECT_LE( frame_ms, max_frame_ms ) << scenario << " mean frame time regressed";
+    }
+  }
+
+  static ros::NodeHandle* nh_;
+  static RenderPanel* render_panel_;
+  static VisualizationManager* manager_;
+  static Ogre::TexturePtr texture_;
+  static Ogre::RenderTexture* target_;
+};
+
+ros::NodeHandle* DisplayBenchmark::nh_ = NULL;
+RenderPanel* DisplayBenchmark::render_panel_ = NULL;
+VisualizationManager* DisplayBenchmark::manager_ = NULL;
+Ogre::TexturePtr DisplayBenchmark::texture_;
+Ogre::RenderTexture* DisplayBenchmark::target_ = NULL;
+
+/** A flat, colored cloud of @a num_points points in the "map" frame. */
+static sensor_msgs::PointCloud2::ConstPtr makeCloud( int num_points )
+{
+  sensor_msgs::PointCloud2::Ptr cloud( new sensor_msgs::PointCloud2 );
+  cloud->header.frame_id = "map";
+  sensor_msgs::PointCloud2Modifier modifier( *cloud );
+  modifier.setPointCloud2FieldsByString( 2, "xyz", "rgb" );
+  modifier.resize( num_points );
+
+  sensor_msgs::PointCloud2Iterator<float> xyz( *cloud, "x" );
+  sensor_msgs::PointCloud2Iterator<uint8_t> rgb( *cloud, "rgb" );
+  int side = std::max( 1, (int) std::sqrt( (double) num_points ));
+  for( int i = 0; i < num_points; ++i, ++xyz, ++rgb )
+  {
+    xyz[ 0 ] = 0.01f * (i % side);
+    xyz[ 1 ] = 0.01f * (i / side);
+    xyz[ 2 ] = 0.1f * std::sin( 0.01f * i );
+    rgb[ 0 ] = i % 256;
+    rgb[ 1 ] = (i / 256) % 256;
+    rgb[ 2 ] = 128;
+  }
+  return cloud;
+}
+
+TEST_F( DisplayBenchmark, point_cloud )
+{
+  sensor_msgs::PointCloud2::ConstPtr msg = makeCloud( param( "points", 1000000 ));
+
+  Display* display = manager_->createDisplay( "rviz/PointCloud2", "rviz/PointCloud2", true );
+
+  run( "point_cloud", display, true, [&]( int ) { inject( display, msg ); } );
+}
+
+// The same cloud as point_cloud, but going through an intra-process
+// subscription, to compare against handing it over with injectMessage().
+TEST_F( DisplayBenchmark, point_cloud_subscribed )
+{
+  sensor_msgs::PointCloud2::ConstPtr msg = makeCloud( param( "points", 1000000 ));
+
+  ros::Publisher pub = nh_->advertise<sensor_msgs::PointCloud2>( "benchmark/cloud", 1 );
+  Display* display = createDisplay( "rviz/PointCloud2", pub.getTopic(), "sensor_msgs/PointCloud2" );
+
+  run( "point_cloud_subscribed", display, true, [&]( int ) { publish( pub, msg ); } );
+}
+
+TEST_F( DisplayBenchmark, markers )
+{
+  int num_markers = param( "markers", 50000 );
+  int side = std::max( 1, (int) std::sqrt( (double) num_markers ));
+
+  visualization_msgs::MarkerArray::Ptr array( new visualization_msgs::MarkerArray );
+  array->markers.resize( num_markers );
+  for( int i = 0; i < num_markers; i++ )
+  {
+    visualization_msgs::Marker& marker = array->markers[ i ];
+    marker.header.frame_id = "map";
+    marker.ns = "benchmark";
+    marker.id = i;
+    marker.type = visualization_msgs::Marker::CUBE;
+    marker.action = visualization_msgs::Marker::ADD;
+    marker.pose.position.x = 0.2 * (i % side);
+    marker.pose.position.y = 0.2 * (i / side);
+    marker.pose.orientation.w = 1.0;
+    marker.scale.x = marker.scale.y = marker.scale.z = 0.1;
+    marker.color.r = (i % 256) / 255.0f;
+    marker.color.g = 0.5f;
+    marker.color.a = 1.0f;
+  }
+  visualization_msgs::MarkerArray::ConstPtr msg = array;
+
+  ros::Publisher pub = nh_->advertise<visualization_msgs::MarkerArray>( "benchmark/markers", 1 );
+  Display* display = createDisplay( "rviz/MarkerArray", pub.getTopic(), "visualization_msgs/MarkerArray" );
+  display->subProp( "Queue Size" )->setValue( num_markers );
+
+  run( "markers", display, true, [&]( int ) { publish( pub, msg ); } );
+}
+
+TEST_F( DisplayBenchmark, map )
+{
+  int size = param( "map_size", 4096 );
+
+  nav_msgs::OccupancyGrid::Ptr map( new nav_msgs::OccupancyGrid );
+  map->header.frame_id = "map";
+  map->info.resolution = 0.05;
+  map->info.width = size;
+  map->info.height = size;
+  map->info.origin.orientation.w = 1.0;
+  map->data.resize( size * size );
+  for( int i = 0; i < size * size; i++ )
+  {
+    map->data[ i ] = ((i % size) / 16 + (i / size) / 16) % 2 ? 100 : 0;
+  }
+
+  ros::Publisher pub = nh_->advertise<nav_msgs::OccupancyGrid>( "benchmark/map", 1 );
+  Display* display = createDisplay( "rviz/Map", pub.getTopic(), "nav_msgs/OccupancyGrid" );
+
+  // Each frame gets a new map, so the display rebuilds its texture every time.
+  run( "map", display, true, [&]( int i ) {
+    map->header.stamp = ros::Time::now();
+    map->data[ i % map->data.size() ] = 50;
+    publish( pub, nav_msgs::OccupancyGrid::ConstPtr( new nav_msgs::OccupancyGrid( *map )));
+  } );
+}
+
+TEST_F( DisplayBenchmark, tf )
+{
+  int num_frames = param( "tf_frames", 1000 );
+  std::shared_ptr<tf2_ros::Buffer> buffer = manager_->getFrameManager()->getTF2BufferPtr();
+
+  // A binary tree of frames below "map", all moving every frame.
+  std::vector<geometry_msgs::TransformStamped> transforms( num_frames );
+  for( int i = 0; i < num_frames; i++ )
+  {
+    geometry_msgs::TransformStamped& transform = transforms[ i ];
+    transform.header.frame_id = i == 0 ? "map" : "frame_" + std::to_string( (i - 1) / 2 );
+    transform.child_frame_id = "frame_" + std::to_string( i );
+    transform.transform.translation.x = 0.5;
+    transform.transform.translation.y = i % 2 ? 0.5 : -0.5;
+    transform.transform.rotation.w = 1.0;
+  }
+
+  Display* display = manager_->createDisplay( "rviz/TF", "TF", true );
+
+  run( "tf", display, false, [&]( int i ) {
+    ros::Time now = ros::Time::now();
+    for( size_t j = 0; j < transforms.size(); j++ )
+    {
+      transforms[ j ].header.stamp = now;
+      transforms[ j ].transform.translation.z = 0.01 * (i % 10);
+      buffer->setTransform( transforms[ j ], "display_benchmark" );
+    }
+  } );
+}
+
+int main( int argc, char** argv )
+{
+  QApplication app( argc, argv );
+  ros::init( argc, argv, "display_benchmark", ros::init_options::AnonymousName );
+  testing::InitGoogleTest( &argc, argv );
+
+  return RUN_ALL_TESTS();
+}
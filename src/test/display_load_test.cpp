@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2012, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <ros/ros.h>
+
+#include <geometry_msgs/PointStamped.h>
+
+#include <rviz/config.h>
+#include <rviz/deferred_work_queue.h>
+#include <rviz/display_context.h>
+#include <rviz/display_group.h>
+#include <rviz/message_filter_display.h>
+
+using namespace rviz;
+
+/** @brief A DisplayContext with nothing but a DeferredWorkQueue, so
+ * displays queued for loading stay pending until the queue runs. */
+class QueueContext: public DisplayContext
+{
+public:
+  virtual Ogre::SceneManager* getSceneManager() const { return 0; }
+  virtual WindowManagerInterface* getWindowManager() const { return 0; }
+  virtual SelectionManager* getSelectionManager() const { return 0; }
+  virtual FrameManager* getFrameManager() const { return 0; }
+  virtual tf::TransformListener* getTFClient() const { return 0; }
+  virtual std::shared_ptr<tf2_ros::Buffer> getTF2BufferPtr() const { return std::shared_ptr<tf2_ros::Buffer>(); }
+  virtual QString getFixedFrame() const { return ""; }
+  virtual uint64_t getFrameCount() const { return 0; }
+  virtual uint64_t getRenderRequestCount() const { return 0; }
+  virtual DisplayFactory* getDisplayFactory() const { return 0; }
+  virtual PerformanceMonitor* getPerformanceMonitor() const { return 0; }
+  virtual DeferredWorkQueue* getDeferredWorkQueue() const { return &queue_; }
+  virtual ros::CallbackQueueInterface* getUpdateQueue() { return 0; }
+  virtual ros::CallbackQueueInterface* getThreadedQueue() { return 0; }
+  virtual ros::CallbackQueueInterface* getReceiveQueue() { return 0; }
+  virtual void handleChar( QKeyEvent* event, RenderPanel* panel ) {}
+  virtual void handleMouseEvent( const ViewportMouseEvent& event ) {}
+  virtual ToolManager* getToolManager() const { return 0; }
+  virtual ViewManager* getViewManager() const { return 0; }
+  virtual DisplayGroup* getRootDisplayGroup() const { return 0; }
+  virtual uint32_t getDefaultVisibilityBit() const { return 0; }
+  virtual BitAllocator* visibilityBits() { return 0; }
+  virtual void setStatus( const QString & message ) {}
+  virtual void queueRender() {}
+
+private:
+  mutable DeferredWorkQueue queue_;
+};
+
+class CountingDisplay: public Display
+{
+public:
+  CountingDisplay() : resets( 0 ) {}
+
+  virtual void reset()
+  {
+    Display::reset();
+    resets++;
+  }
+
+  int resets;
+};
+
+class PointDisplay: public MessageFilterDisplay<geometry_msgs::PointStamped>
+{
+protected:
+  virtual void processMessage( const geometry_msgs::PointStamped::ConstPtr& msg ) {}
+};
+
+TEST( DisplayLoad, group_reset_skips_pending_displays )
+{
+  QueueContext context;
+  DisplayGroup group;
+  CountingDisplay* display = new CountingDisplay;
+  group.addDisplay( display );
+
+  display->queueInitializeAndLoad( &context, Config() );
+  ASSERT_TRUE( display->isLoadPending() );
+
+  // Pressing Reset while the config is still loading.
+  group.reset();
+  EXPECT_EQ( 0, display->resets );
+}
+
+TEST( DisplayLoad, reset_before_initialize )
+{
+  // Has no tf filter until onInitialize() runs.
+  PointDisplay display;
+  display.reset();
+  EXPECT_FALSE( display.initialized() );
+}
+
+int main( int argc, char** argv )
+{
+  ros::init( argc, argv, "display_load_test", ros::init_options::AnonymousName );
+  testing::InitGoogleTest( &argc, argv );
+  return RUN_ALL_TESTS();
+}
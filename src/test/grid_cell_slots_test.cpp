@@ -0,0 +1,249 @@
+/*
+ * Copyright (c) 2012, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <rviz/default_plugin/grid_cell_slots.h>
+
+using rviz::GridCellSlots;
+
+typedef std::vector<GridCellSlots::Cell> V_Cell;
+
+static GridCellSlots::Cell cell( double x, double y = 0 )
+{
+  GridCellSlots::Cell c = { x, y, 0 };
+  return c;
+}
+
+static V_Cell row( int first, int count )
+{
+  V_Cell cells;
+  for( int i = 0; i < count; i++ )
+  {
+    cells.push_back( cell( first + i ));
+  }
+  return cells;
+}
+
+// Applies an update the way GridCellsDisplay applies it to its point cloud.
+static void apply( const GridCellSlots& slots, const GridCellSlots::Update& update, V_Cell& cloud )
+{
+  if( update.rebuild )
+  {
+    cloud.clear();
+  }
+  else
+  {
+    ASSERT_LE( update.removed, cloud.size() );
+    cloud.resize( cloud.size() - update.removed );
+    for( size_t i = 0; i < update.changed.size(); i++ )
+    {
+      ASSERT_TRUE( i == 0 || update.changed[ i - 1 ] < update.changed[ i ] );
+      ASSERT_LT( update.changed[ i ], cloud.size() );
+      cloud[ update.changed[ i ]] = slots[ update.changed[ i ]];
+    }
+  }
+  ASSERT_EQ( cloud.size(), update.first_added );
+  for( uint32_t i = update.first_added; i < slots.size(); i++ )
+  {
+    cloud.push_back( slots[ i ] );
+  }
+}
+
+static std::set<std::pair<double, double> > keys( const V_Cell& cells )
+{
+  std::set<std::pair<double, double> > result;
+  for( size_t i = 0; i < cells.size(); i++ )
+  {
+    result.insert( std::make_pair( cells[ i ].x, cells[ i ].y ));
+  }
+  return result;
+}
+
+static void expectDrawn( const GridCellSlots& slots, const V_Cell& cloud, const V_Cell& cells )
+{
+  ASSERT_EQ( slots.size(), cloud.size() );
+  for( uint32_t i = 0; i < slots.size(); i++ )
+  {
+    EXPECT_TRUE( slots[ i ] == cloud[ i ] );
+  }
+  EXPECT_EQ( keys( cells ).size(), cloud.size() );
+  EXPECT_TRUE( keys( cells ) == keys( cloud ));
+}
+
+TEST( GridCellSlots, first_message_is_a_rebuild )
+{
+  GridCellSlots slots;
+  GridCellSlots::Update update = slots.assign( row( 0, 10 ));
+  EXPECT_TRUE( update.rebuild );
+  EXPECT_EQ( 0u, update.first_added );
+  EXPECT_EQ( 10u, slots.size() );
+}
+
+TEST( GridCellSlots, same_cells_write_nothing )
+{
+  GridCellSlots slots;
+  slots.assign( row( 0, 10 ));
+  GridCellSlots::Update update = slots.assign( row( 0, 10 ));
+  EXPECT_FALSE( update.rebuild );
+  EXPECT_EQ( 0u, update.removed );
+  EXPECT_TRUE( update.changed.empty() );
+  EXPECT_EQ( 10u, update.first_added );
+}
+
+TEST( GridCellSlots, replaced_cell_reuses_its_slot )
+{
+  GridCellSlots slots;
+  V_Cell cells = row( 0, 10 );
+  slots.assign( cells );
+
+  cells[ 3 ] = cell( 100 );
+  GridCellSlots::Update update = slots.assign( cells );
+  EXPECT_FALSE( update.rebuild );
+  EXPECT_EQ( 0u, update.removed );
+  ASSERT_EQ( 1u, update.changed.size() );
+  EXPECT_EQ( 3u, update.changed[ 0 ] );
+  EXPECT_EQ( 100, slots[ 3 ].x );
+}
+
+TEST( GridCellSlots, removed_cell_is_filled_from_the_end )
+{
+  GridCellSlots slots;
+  V_Cell cells = row( 0, 10 );
+  slots.assign( cells );
+
+  cells.erase( cells.begin() + 2 );
+  GridCellSlots::Update update = slots.assign( cells );
+  EXPECT_FALSE( update.rebuild );
+  EXPECT_EQ( 1u, update.removed );
+  ASSERT_EQ( 1u, update.changed.size() );
+  EXPECT_EQ( 2u, update.changed[ 0 ] );
+  EXPECT_EQ( 9, slots[ 2 ].x );
+  EXPECT_EQ( 9u, slots.size() );
+}
+
+TEST( GridCellSlots, removed_last_cell_only_pops )
+{
+  GridCellSlots slots;
+  slots.assign( row( 0, 10 ));
+  GridCellSlots::Update update = slots.assign( row( 0, 9 ));
+  EXPECT_FALSE( update.rebuild );
+  EXPECT_EQ( 1u, update.removed );
+  EXPECT_TRUE( update.changed.empty() );
+}
+
+TEST( GridCellSlots, added_cells_go_at_the_end )
+{
+  GridCellSlots slots;
+  slots.assign( row( 0, 10 ));
+  GridCellSlots::Update update = slots.assign( row( 0, 12 ));
+  EXPECT_FALSE( update.rebuild );
+  EXPECT_EQ( 0u, update.removed );
+  EXPECT_TRUE( update.changed.empty() );
+  EXPECT_EQ( 10u, update.first_added );
+  EXPECT_EQ( 12u, slots.size() );
+}
+
+TEST( GridCellSlots, large_change_is_a_rebuild )
+{
+  GridCellSlots slots;
+  slots.assign( row( 0, 10 ));
+  GridCellSlots::Update update = slots.assign( row( 6, 10 ));
+  EXPECT_TRUE( update.rebuild );
+  EXPECT_EQ( 10u, update.removed );
+  EXPECT_EQ( 0u, update.first_added );
+  for( uint32_t i = 0; i < slots.size(); i++ )
+  {
+    EXPECT_EQ( 6 + i, slots[ i ].x );
+  }
+}
+
+TEST( GridCellSlots, duplicates_are_drawn_once )
+{
+  GridCellSlots slots;
+  V_Cell cells = row( 0, 10 );
+  cells.push_back( cell( 4 ));
+  slots.assign( cells );
+  EXPECT_EQ( 10u, slots.size() );
+
+  cells.push_back( cell( 10 ));
+  cells.push_back( cell( 10 ));
+  GridCellSlots::Update update = slots.assign( cells );
+  EXPECT_FALSE( update.rebuild );
+  EXPECT_EQ( 11u, slots.size() );
+}
+
+TEST( GridCellSlots, updates_keep_the_cloud_in_sync )
+{
+  GridCellSlots slots;
+  V_Cell cloud;
+  V_Cell cells = row( 0, 200 );
+  srand( 42 );
+  for( int message = 0; message < 500; message++ )
+  {
+    // Drop, replace and add a few cells at random, sometimes many.
+    int changes = ( message % 50 == 0 ) ? 150 : rand() % 20;
+    for( int i = 0; i < changes; i++ )
+    {
+      int action = rand() % 3;
+      if( action == 0 && !cells.empty() )
+      {
+        cells.erase( cells.begin() + rand() % cells.size() );
+      }
+      else if( action == 1 && !cells.empty() )
+      {
+        cells[ rand() % cells.size() ] = cell( rand() % 400, rand() % 2 );
+      }
+      else
+      {
+        cells.push_back( cell( rand() % 400, rand() % 2 ));
+      }
+    }
+
+    GridCellSlots::Update update = slots.assign( cells );
+    apply( slots, update, cloud );
+    expectDrawn( slots, cloud, cells );
+    if( HasFailure() )
+    {
+      FAIL() << "after message " << message;
+    }
+  }
+}
+
+int main( int argc, char** argv )
+{
+  testing::InitGoogleTest( &argc, argv );
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2012, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <rviz/memory_budget.h>
+
+using rviz::MemoryBudget;
+
+static std::vector<uint64_t> usage( uint64_t a, uint64_t b, uint64_t c )
+{
+  std::vector<uint64_t> result;
+  result.push_back( a );
+  result.push_back( b );
+  result.push_back( c );
+  return result;
+}
+
+TEST( MemoryBudget, unlimited_by_default )
+{
+  MemoryBudget budget;
+  EXPECT_TRUE( budget.plan( usage( 100, 1000, 10000 )).empty() );
+}
+
+TEST( MemoryBudget, display_cap )
+{
+  MemoryBudget budget;
+  budget.setDisplayCap( 500 );
+
+  std::vector<MemoryBudget::Eviction> evictions = budget.plan( usage( 100, 1000, 10000 ));
+  ASSERT_EQ( 2u, evictions.size() );
+  EXPECT_EQ( 1u, evictions[ 0 ].index );
+  EXPECT_EQ( 500u, evictions[ 0 ].max_bytes );
+  EXPECT_EQ( 2u, evictions[ 1 ].index );
+  EXPECT_EQ( 500u, evictions[ 1 ].max_bytes );
+}
+
+TEST( MemoryBudget, within_budget )
+{
+  MemoryBudget budget;
+  budget.setBudget( 1000 );
+  EXPECT_TRUE( budget.plan( usage( 100, 400, 500 )).empty() );
+}
+
+TEST( MemoryBudget, largest_display_gives_back_first )
+{
+  MemoryBudget budget;
+  budget.setBudget( 1000 );
+
+  std::vector<MemoryBudget::Eviction> evictions = budget.plan( usage( 100, 300, 2000 ));
+  ASSERT_EQ( 1u, evictions.size() );
+  EXPECT_EQ( 2u, evictions[ 0 ].index );
+  EXPECT_EQ( 600u, evictions[ 0 ].max_bytes );
+}
+
+TEST( MemoryBudget, large_displays_cut_to_common_level )
+{
+  MemoryBudget budget;
+  budget.setBudget( 1000 );
+
+  std::vector<MemoryBudget::Eviction> evictions = budget.plan( usage( 800, 100, 900 ));
+  ASSERT_EQ( 2u, evictions.size() );
+  EXPECT_EQ( 0u, evictions[ 0 ].index );
+  EXPECT_EQ( 450u, evictions[ 0 ].max_bytes );
+  EXPECT_EQ( 2u, evictions[ 1 ].index );
+  EXPECT_EQ( 450u, evictions[ 1 ].max_bytes );
+}
+
+TEST( MemoryBudget, cap_and_budget )
+{
+  MemoryBudget budget;
+  budget.setDisplayCap( 600 );
+  budget.setBudget( 900 );
+
+  std::vector<MemoryBudget::Eviction> evictions = budget.plan( usage( 300, 300, 5000 ));
+  ASSERT_EQ( 1u, evictions.size() );
+  EXPECT_EQ( 2u, evictions[ 0 ].index );
+  EXPECT_EQ( 300u, evictions[ 0 ].max_bytes );
+}
+
+TEST( MemoryBudget, budget_smaller_than_displays )
+{
+  MemoryBudget budget;
+  budget.setBudget( 90 );
+
+  std::vector<MemoryBudget::Eviction> evictions = budget.plan( usage( 100, 200, 300 ));
+  ASSERT_EQ( 3u, evictions.size() );
+  for( size_t i = 0; i < evictions.size(); i++ )
+  {
+    EXPECT_EQ( 30u, evictions[ i ].max_bytes );
+  }
+}
+
+int main( int argc, char** argv )
+{
+  testing::InitGoogleTest( &argc, argv );
+  return RUN_ALL_TESTS();
+}
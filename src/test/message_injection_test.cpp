@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2012, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string>
+#include <vector>
+
+#include <QApplication>
+
+#include <OgreRoot.h>
+#include <OgreSceneManager.h>
+
+#include <gtest/gtest.h>
+
+#include <ros/ros.h>
+#include <ros/callback_queue.h>
+
+#include <geometry_msgs/PointStamped.h>
+
+#include <rviz/display_context.h>
+#include <rviz/frame_manager.h>
+#include <rviz/message_filter_display.h>
+
+using namespace rviz;
+
+/** @brief A DisplayContext with a scene manager, a frame manager and
+ * callback queues the test spins by hand; nothing is rendered. */
+class InjectionContext: public DisplayContext
+{
+public:
+  InjectionContext()
+    : root_( "", "", "" )
+  {
+    scene_manager_ = root_.createSceneManager( Ogre::ST_GENERIC );
+    frame_manager_ = new FrameManager();
+    frame_manager_->setFixedFrame( "map" );
+  }
+
+  ~InjectionContext()
+  {
+    delete frame_manager_;
+    root_.destroySceneManager( scene_manager_ );
+  }
+
+  /** @brief Run the receive and update queues until nothing is left to do. */
+  void spin()
+  {
+    for( int i = 0; i < 10; i++ )
+    {
+      receive_queue_.callAvailable();
+      update_queue_.callAvailable();
+    }
+  }
+
+  virtual Ogre::SceneManager* getSceneManager() const { return scene_manager_; }
+  virtual WindowManagerInterface* getWindowManager() const { return 0; }
+  virtual SelectionManager* getSelectionManager() const { return 0; }
+  virtual FrameManager* getFrameManager() const { return frame_manager_; }
+  virtual tf::TransformListener* getTFClient() const { return 0; }
+  virtual std::shared_ptr<tf2_ros::Buffer> getTF2BufferPtr() const { return frame_manager_->getTF2BufferPtr(); }
+  virtual QString getFixedFrame() const { return "map"; }
+  virtual uint64_t getFrameCount() const { return 0; }
+  virtual uint64_t getRenderRequestCount() const { return 0; }
+  virtual DisplayFactory* getDisplayFactory() const { return 0; }
+  virtual PerformanceMonitor* getPerformanceMonitor() const { return 0; }
+  virtual DeferredWorkQueue* getDeferredWorkQueue() const { return 0; }
+  virtual ros::CallbackQueueInterface* getUpdateQueue() { return &update_queue_; }
+  virtual ros::CallbackQueueInterface* getThreadedQueue() { return &update_queue_; }
+  virtual ros::CallbackQueueInterface* getReceiveQueue() { return &receive_queue_; }
+  virtual void handleChar( QKeyEvent* event, RenderPanel* panel ) {}
+  virtual void handleMouseEvent( const ViewportMouseEvent& event ) {}
+  virtual ToolManager* getToolManager() const { return 0; }
+  virtual ViewManager* getViewManager() const { return 0; }
+  virtual DisplayGroup* getRootDisplayGroup() const { return 0; }
+  virtual uint32_t getDefaultVisibilityBit() const { return 0; }
+  virtual BitAllocator* visibilityBits() { return 0; }
+  virtual void setStatus( const QString & message ) {}
+  virtual void queueRender() {}
+
+private:
+  Ogre::Root root_;
+  Ogre::SceneManager* scene_manager_;
+  FrameManager* frame_manager_;
+  ros::CallbackQueue update_queue_;
+  ros::CallbackQueue receive_queue_;
+};
+
+/** @brief Receives through a shared filter, like the point cloud displays. */
+class SharedPointDisplay: public MessageFilterDisplay<geometry_msgs::PointStamped>
+{
+public:
+  SharedPointDisplay()
+  {
+    setSharedSubscription( true );
+  }
+
+  std::vector<geometry_msgs::PointStamped::ConstPtr> processed;
+
+protected:
+  virtual void processMessage( const geometry_msgs::PointStamped::ConstPtr& msg )
+  {
+    processed.push_back( msg );
+  }
+};
+
+static geometry_msgs::PointStamped::ConstPtr makePoint( const std::string& frame_id )
+{
+  geometry_msgs::PointStamped::Ptr msg( new geometry_msgs::PointStamped );
+  msg->header.frame_id = frame_id;
+  msg->point.x = 1.0;
+  return msg;
+}
+
+TEST( MessageInjection, reaches_process_message_through_shared_filter )
+{
+  InjectionContext context;
+  SharedPointDisplay display;
+  display.initialize( &context );
+  display.setEnabled( true );
+
+  // No topic is set, so nothing is subscribed; injecting is the only way in.
+  geometry_msgs::PointStamped::ConstPtr msg = makePoint( "map" );
+  ASSERT_TRUE( display.injectMessage( msg ));
+  context.spin();
+
+  ASSERT_EQ( 1u, display.processed.size() );
+  // Handed over without a copy.
+  EXPECT_EQ( msg.get(), display.processed[ 0 ].get() );
+}
+
+TEST( MessageInjection, displays_sharing_a_filter_get_the_same_message )
+{
+  InjectionContext context;
+  SharedPointDisplay first;
+  SharedPointDisplay second;
+  first.initialize( &context );
+  second.initialize( &context );
+  first.setEnabled( true );
+  second.setEnabled( true );
+
+  geometry_msgs::PointStamped::ConstPtr msg = makePoint( "map" );
+  ASSERT_TRUE( first.injectMessage( msg ));
+  context.spin();
+
+  ASSERT_EQ( 1u, first.processed.size() );
+  ASSERT_EQ( 1u, second.processed.size() );
+  EXPECT_EQ( msg.get(), second.processed[ 0 ].get() );
+}
+
+TEST( MessageInjection, disabled_display_rejects_messages )
+{
+  InjectionContext context;
+  SharedPointDisplay display;
+  EXPECT_FALSE( display.injectMessage( makePoint( "map" )));
+
+  display.initialize( &context );
+  EXPECT_FALSE( display.injectMessage( makePoint( "map" )));
+  context.spin();
+  EXPECT_TRUE( display.processed.empty() );
+}
+
+int main( int argc, char** argv )
+{
+  QApplication app( argc, argv );
+  ros::init( argc, argv, "message_injection_test", ros::init_options::AnonymousName );
+  testing::InitGoogleTest( &argc, argv );
+  return RUN_ALL_TESTS();
+}
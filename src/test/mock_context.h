@@ -46,9 +46,13 @@ public:
   virtual tf::TransformListener* getTFClient() const { return 0; }
   virtual QString getFixedFrame() const { return ""; }
   virtual uint64_t getFrameCount() const { return 0; }
+  virtual uint64_t getRenderRequestCount() const { return 0; }
   virtual DisplayFactory* getDisplayFactory() const { return display_factory_; }
+  virtual PerformanceMonitor* getPerformanceMonitor() const { return 0; }
+  virtual DeferredWorkQueue* getDeferredWorkQueue() const { return 0; }
   virtual ros::CallbackQueueInterface* getUpdateQueue() { return 0; }
   virtual ros::CallbackQueueInterface* getThreadedQueue() { return 0; }
+  virtual ros::CallbackQueueInterface* getReceiveQueue() { return 0; }
   virtual void handleChar( QKeyEvent* event, RenderPanel* panel ) {}
   virtual void handleMouseEvent( const ViewportMouseEvent& event ) {}
   virtual ToolManager* getToolManager() const { return 0; }
@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2012, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <set>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <rviz/status_table.h>
+
+using rviz::StatusTable;
+
+TEST( StatusTable, keeps_latest_per_name )
+{
+  StatusTable table;
+  table.set( 0, "Topic", "1 message" );
+  table.set( 1, "Topic", "2 messages" );
+  table.set( 2, "Transform", "No transform" );
+
+  bool cleared;
+  std::vector<StatusTable::Update> updates;
+  table.take( &cleared, updates );
+  EXPECT_FALSE( cleared );
+  ASSERT_EQ( 2u, updates.size() );
+  for( size_t i = 0; i < updates.size(); i++ )
+  {
+    EXPECT_FALSE( updates[ i ].deleted );
+    if( updates[ i ].name == "Topic" )
+    {
+      EXPECT_EQ( 1, updates[ i ].level );
+      EXPECT_EQ( "2 messages", updates[ i ].text );
+    }
+    else
+    {
+      EXPECT_EQ( "Transform", updates[ i ].name );
+    }
+  }
+
+  // Nothing changed since.
+  table.take( &cleared, updates );
+  EXPECT_FALSE( cleared );
+  EXPECT_EQ( 0u, updates.size() );
+}
+
+TEST( StatusTable, remove )
+{
+  StatusTable table;
+  table.set( 0, "Topic", "OK" );
+  table.remove( "Topic" );
+
+  bool cleared;
+  std::vector<StatusTable::Update> updates;
+  table.take( &cleared, updates );
+  ASSERT_EQ( 1u, updates.size() );
+  EXPECT_TRUE( updates[ 0 ].deleted );
+  EXPECT_EQ( "Topic", updates[ 0 ].name );
+}
+
+TEST( StatusTable, clear_drops_earlier_changes )
+{
+  StatusTable table;
+  table.set( 0, "Before", "OK" );
+  table.clear();
+  table.set( 0, "After", "OK" );
+
+  bool cleared;
+  std::vector<StatusTable::Update> updates;
+  table.take( &cleared, updates );
+  EXPECT_TRUE( cleared );
+  ASSERT_EQ( 1u, updates.size() );
+  EXPECT_EQ( "After", updates[ 0 ].name );
+
+  table.take( &cleared, updates );
+  EXPECT_FALSE( cleared );
+}
+
+TEST( StatusTable, overflow )
+{
+  StatusTable table( 4 );
+  for( int i = 0; i < 10; i++ )
+  {
+    table.set( 0, QString::number( i ), "first" );
+    table.set( 0, QString::number( i ), "second" );
+  }
+
+  bool cleared;
+  std::vector<StatusTable::Update> updates;
+  table.take( &cleared, updates );
+  ASSERT_EQ( 10u, updates.size() );
+  for( size_t i = 0; i < updates.size(); i++ )
+  {
+    EXPECT_EQ( "second", updates[ i ].text );
+  }
+}
+
+static void writeStatuses( StatusTable* table, int thread )
+{
+  for( int i = 0; i < 10000; i++ )
+  {
+    table->set( 0, QString::number( i % 20 ), QString::number( thread ));
+  }
+}
+
+TEST( StatusTable, concurrent_writers )
+{
+  StatusTable table( 16 );
+  bool cleared;
+  std::vector<StatusTable::Update> updates;
+  std::set<QString> names;
+
+  boost::thread_group threads;
+  for( int i = 0; i < 4; i++ )
+  {
+    threads.create_thread( boost::bind( &writeStatuses, &table, i ));
+  }
+  while( names.size() < 20 )
+  {
+    table.take( &cleared, updates );
+    for( size_t i = 0; i < updates.size(); i++ )
+    {
+      names.insert( updates[ i ].name );
+    }
+  }
+  threads.join_all();
+
+  table.take( &cleared, updates );
+  EXPECT_FALSE( cleared );
+  EXPECT_EQ( 20u, names.size() );
+}
+
+int main(int argc, char **argv){
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
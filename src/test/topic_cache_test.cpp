@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2012, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <boost/bind.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <rviz/topic_cache.h>
+
+using rviz::TopicCache;
+
+// Stands in for the ROS master: serves a settable list of topics and
+// counts how often it was asked.
+class FakeMaster
+{
+public:
+  FakeMaster() : online_( true ), calls_( 0 ) {}
+
+  void advertise( const std::string& name, const std::string& datatype )
+  {
+    boost::mutex::scoped_lock lock( mutex_ );
+    for( size_t i = 0; i < topics_.size(); i++ )
+    {
+      if( topics_[ i ].name == name )
+      {
+        topics_[ i ].datatype = datatype;
+        return;
+      }
+    }
+    topics_.push_back( ros::master::TopicInfo( name, datatype ));
+  }
+
+  void unadvertise( const std::string& name )
+  {
+    boost::mutex::scoped_lock lock( mutex_ );
+    for( size_t i = 0; i < topics_.size(); i++ )
+    {
+      if( topics_[ i ].name == name )
+      {
+        topics_.erase( topics_.begin() + i );
+        return;
+      }
+    }
+  }
+
+  void setOnline( bool online )
+  {
+    boost::mutex::scoped_lock lock( mutex_ );
+    online_ = online;
+  }
+
+  bool getTopics( ros::master::V_TopicInfo& topics )
+  {
+    boost::mutex::scoped_lock lock( mutex_ );
+    calls_++;
+    called_.notify_all();
+    if( !online_ )
+    {
+      return false;
+    }
+    topics = topics_;
+    return true;
+  }
+
+  /** Wait until the master was asked more than @a calls times. */
+  bool waitForCalls( int calls )
+  {
+    boost::mutex::scoped_lock lock( mutex_ );
+    while( calls_ <= calls )
+    {
+      if( !called_.timed_wait( lock, boost::posix_time::seconds( 5 )))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  int calls()
+  {
+    boost::mutex::scoped_lock lock( mutex_ );
+    return calls_;
+  }
+
+  TopicCache::FetchFunction fetchFunction()
+  {
+    return boost::bind( &FakeMaster::getTopics, this, _1 );
+  }
+
+private:
+  boost::mutex mutex_;
+  boost::condition_variable called_;
+  ros::master::V_TopicInfo topics_;
+  bool online_;
+  int calls_;
+};
+
+struct DiffRecorder
+{
+  void operator()( const TopicCache::Diff& diff ) { diffs.push_back( diff ); }
+  std::vector<TopicCache::Diff> diffs;
+};
+
+TEST( TopicCache, serves_sorted_topics_from_memory )
+{
+  FakeMaster master;
+  master.advertise( "/scan", "sensor_msgs/LaserScan" );
+  master.advertise( "/image", "sensor_msgs/Image" );
+  master.advertise( "/image/compressed", "sensor_msgs/CompressedImage" );
+
+  TopicCache cache( master.fetchFunction() );
+  ros::master::V_TopicInfo topics = cache.getTopics();
+  ASSERT_EQ( 3u, topics.size() );
+  EXPECT_EQ( "/image", topics[ 0 ].name );
+  EXPECT_EQ( "/image/compressed", topics[ 1 ].name );
+  EXPECT_EQ( "/scan", topics[ 2 ].name );
+  EXPECT_EQ( 1, master.calls() );
+
+  // Served from memory until refreshed.
+  master.advertise( "/map", "nav_msgs/OccupancyGrid" );
+  EXPECT_EQ( 3u, cache.getTopics().size() );
+  EXPECT_EQ( 1, master.calls() );
+
+  EXPECT_TRUE( cache.refresh() );
+  EXPECT_EQ( 4u, cache.getTopics().size() );
+
+  std::vector<std::string> images = cache.getTopicsOfType( "sensor_msgs/Image" );
+  ASSERT_EQ( 1u, images.size() );
+  EXPECT_EQ( "/image", images[ 0 ] );
+}
+
+TEST( TopicCache, reports_diffs )
+{
+  FakeMaster master;
+  master.advertise( "/a", "std_msgs/String" );
+  master.advertise( "/b", "std_msgs/String" );
+
+  TopicCache cache( master.fetchFunction() );
+  DiffRecorder recorder;
+  cache.addListener( &recorder, boost::ref( recorder ));
+
+  ASSERT_TRUE( cache.refresh() );
+  ASSERT_EQ( 1u, recorder.diffs.size() );
+  EXPECT_EQ( 2u, recorder.diffs[ 0 ].added.size() );
+  EXPECT_EQ( 0u, recorder.diffs[ 0 ].removed.size() );
+  EXPECT_EQ( 1u, cache.getRevision() );
+
+  // Nothing changed: no diff, same revision.
+  ASSERT_TRUE( cache.refresh() );
+  EXPECT_EQ( 1u, recorder.diffs.size() );
+  EXPECT_EQ( 1u, cache.getRevision() );
+
+  master.unadvertise( "/a" );
+  master.advertise( "/b", "std_msgs/Int32" );
+  master.advertise( "/c", "std_msgs/String" );
+  ASSERT_TRUE( cache.refresh() );
+  ASSERT_EQ( 2u, recorder.diffs.size() );
+  const TopicCache::Diff& diff = recorder.diffs[ 1 ];
+  ASSERT_EQ( 2u, diff.added.size() );
+  EXPECT_EQ( "/b", diff.added[ 0 ].name );
+  EXPECT_EQ( "std_msgs/Int32", diff.added[ 0 ].datatype );
+  EXPECT_EQ( "/c", diff.added[ 1 ].name );
+  ASSERT_EQ( 2u, diff.removed.size() );
+  EXPECT_EQ( "/a", diff.removed[ 0 ].name );
+  EXPECT_EQ( "/b", diff.removed[ 1 ].name );
+  EXPECT_EQ( "std_msgs/String", diff.removed[ 1 ].datatype );
+
+  cache.removeListener( &recorder );
+  master.unadvertise( "/c" );
+  ASSERT_TRUE( cache.refresh() );
+  EXPECT_EQ( 2u, recorder.diffs.size() );
+}
+
+TEST( TopicCache, keeps_topics_when_master_is_down )
+{
+  FakeMaster master;
+  master.advertise( "/a", "std_msgs/String" );
+
+  TopicCache cache( master.fetchFunction() );
+  ASSERT_TRUE( cache.refresh() );
+
+  master.setOnline( false );
+  EXPECT_FALSE( cache.refresh() );
+  EXPECT_EQ( 1u, cache.getTopics().size() );
+}
+
+TEST( TopicCache, refreshes_in_background )
+{
+  FakeMaster master;
+  master.advertise( "/a", "std_msgs/String" );
+
+  TopicCache cache( master.fetchFunction() );
+  cache.setRefreshInterval( 0 );
+  cache.start();
+  ASSERT_TRUE( master.waitForCalls( 0 ));
+
+  // With no interval, only requests cause refreshes.
+  int calls = master.calls();
+  master.advertise( "/b", "std_msgs/String" );
+  cache.requestRefresh();
+  ASSERT_TRUE( master.waitForCalls( calls ));
+  cache.stop();
+  EXPECT_EQ( 2u, cache.getTopics().size() );
+
+  // Periodic refreshes.
+  cache.setRefreshInterval( 0.01 );
+  cache.start();
+  calls = master.calls();
+  ASSERT_TRUE( master.waitForCalls( calls + 2 ));
+  cache.stop();
+}
+
+int main( int argc, char** argv )
+{
+  testing::InitGoogleTest( &argc, argv );
+  return RUN_ALL_TESTS();
+}
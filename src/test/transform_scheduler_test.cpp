@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2012, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <boost/bind.hpp>
+
+#include <geometry_msgs/TransformStamped.h>
+#include <tf2/buffer_core.h>
+
+#include <rviz/transform_scheduler.h>
+
+using rviz::TransformScheduler;
+
+static void setTransform( tf2::BufferCore& buffer, const std::string& parent, const std::string& child,
+                          double stamp, bool is_static = false )
+{
+  geometry_msgs::TransformStamped transform;
+  transform.header.frame_id = parent;
+  transform.header.stamp = ros::Time( stamp );
+  transform.child_frame_id = child;
+  transform.transform.rotation.w = 1.0;
+  buffer.setTransform( transform, "test", is_static );
+}
+
+// Records the results delivered to request callbacks.
+struct Results
+{
+  void add( int id, bool available )
+  {
+    ids.push_back( id );
+    available_flags.push_back( available );
+  }
+
+  std::vector<int> ids;
+  std::vector<bool> available_flags;
+};
+
+TEST( TransformScheduler, available_right_away )
+{
+  tf2::BufferCore buffer;
+  TransformScheduler scheduler( buffer );
+  setTransform( buffer, "map", "base", 10.0 );
+  setTransform( buffer, "map", "base", 11.0 );
+
+  Results results;
+  bool available = false;
+  EXPECT_EQ( 0u, scheduler.add( "map", "base", ros::Time( 10.5 ), ros::Duration(),
+                                boost::bind( &Results::add, &results, 1, _1 ), &available ));
+  EXPECT_TRUE( available );
+  EXPECT_EQ( 0u, scheduler.getNumPending() );
+  EXPECT_TRUE( results.ids.empty() );
+}
+
+TEST( TransformScheduler, waits_for_transform )
+{
+  tf2::BufferCore buffer;
+  TransformScheduler scheduler( buffer );
+  setTransform( buffer, "map", "base", 10.0 );
+
+  Results results;
+  bool available = false;
+  EXPECT_NE( 0u, scheduler.add( "map", "base", ros::Time( 11.5 ), ros::Duration(),
+                                boost::bind( &Results::add, &results, 1, _1 ), &available ));
+  EXPECT_NE( 0u, scheduler.add( "map", "base", ros::Time( 12.5 ), ros::Duration(),
+                                boost::bind( &Results::add, &results, 2, _1 ), &available ));
+  EXPECT_EQ( 2u, scheduler.getNumPending() );
+
+  // Only the first request can be served.
+  setTransform( buffer, "map", "base", 12.0 );
+  ASSERT_EQ( 1u, results.ids.size() );
+  EXPECT_EQ( 1, results.ids[ 0 ] );
+  EXPECT_TRUE( results.available_flags[ 0 ] );
+
+  setTransform( buffer, "map", "base", 13.0 );
+  ASSERT_EQ( 2u, results.ids.size() );
+  EXPECT_EQ( 2, results.ids[ 1 ] );
+  EXPECT_TRUE( results.available_flags[ 1 ] );
+  EXPECT_EQ( 0u, scheduler.getNumPending() );
+}
+
+TEST( TransformScheduler, waits_for_connection )
+{
+  tf2::BufferCore buffer;
+  TransformScheduler scheduler( buffer );
+
+  Results results;
+  bool available = false;
+  EXPECT_NE( 0u, scheduler.add( "map", "/laser", ros::Time( 1.0 ), ros::Duration(),
+                                boost::bind( &Results::add, &results, 1, _1 ), &available ));
+
+  setTransform( buffer, "map", "base", 0.5 );
+  setTransform( buffer, "map", "base", 2.0 );
+  EXPECT_TRUE( results.ids.empty() );
+
+  setTransform( buffer, "base", "laser", 0.0, true );
+  ASSERT_EQ( 1u, results.ids.size() );
+  EXPECT_TRUE( results.available_flags[ 0 ] );
+}
+
+TEST( TransformScheduler, tolerance )
+{
+  tf2::BufferCore buffer;
+  TransformScheduler scheduler( buffer );
+  setTransform( buffer, "map", "base", 10.0 );
+  setTransform( buffer, "map", "base", 11.0 );
+
+  Results results;
+  bool available = false;
+  EXPECT_NE( 0u, scheduler.add( "map", "base", ros::Time( 10.5 ), ros::Duration( 1.0 ),
+                                boost::bind( &Results::add, &results, 1, _1 ), &available ));
+
+  setTransform( buffer, "map", "base", 11.2 );
+  EXPECT_TRUE( results.ids.empty() );
+
+  setTransform( buffer, "map", "base", 11.6 );
+  ASSERT_EQ( 1u, results.ids.size() );
+  EXPECT_TRUE( results.available_flags[ 0 ] );
+}
+
+TEST( TransformScheduler, too_old )
+{
+  tf2::BufferCore buffer( ros::Duration( 5.0 ));
+  TransformScheduler scheduler( buffer );
+  setTransform( buffer, "map", "base", 100.0 );
+
+  Results results;
+  bool available = true;
+  EXPECT_EQ( 0u, scheduler.add( "map", "base", ros::Time( 50.0 ), ros::Duration(),
+                                boost::bind( &Results::add, &results, 1, _1 ), &available ));
+  EXPECT_FALSE( available );
+}
+
+TEST( TransformScheduler, cancel )
+{
+  tf2::BufferCore buffer;
+  TransformScheduler scheduler( buffer );
+  setTransform( buffer, "map", "base", 10.0 );
+
+  Results results;
+  bool available = false;
+  TransformScheduler::Handle handle =
+    scheduler.add( "map", "base", ros::Time( 11.0 ), ros::Duration(),
+                   boost::bind( &Results::add, &results, 1, _1 ), &available );
+  ASSERT_NE( 0u, handle );
+  scheduler.cancel( handle );
+  EXPECT_EQ( 0u, scheduler.getNumPending() );
+
+  setTransform( buffer, "map", "base", 12.0 );
+  EXPECT_TRUE( results.ids.empty() );
+}
+
+int main( int argc, char** argv )
+{
+  testing::InitGoogleTest( &argc, argv );
+  return RUN_ALL_TESTS();
+}